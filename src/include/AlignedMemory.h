@@ -0,0 +1,55 @@
+/**
+ *  @file    AlignedMemory.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief helpers for allocating cache line aligned memory
+ *
+ *  @section DESCRIPTION
+ *
+ *  This static class wraps the platform specific aligned allocation
+ *  functions so that large buffers (datasets, matrices, batches) start
+ *  on a cache line and can be read with aligned SIMD loads. It also
+ *  counts the allocations, which lets a training loop check that its
+ *  steady state no longer reaches the heap.
+ *
+ */
+
+#ifndef ALIGNED_MEMORY_H
+#define ALIGNED_MEMORY_H
+
+// cpp
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+/**
+ *  @brief Class that handles aligned allocations
+ */
+class AlignedMemory {
+public:
+	// static method that allocates bytes aligned to alignment (Note: throws bad_alloc on failure)
+	static void* allocate(size_t bytes, size_t alignment = CACHE_LINE);
+
+	// static method that frees memory returned by allocate
+	static void release(void* ptr);
+
+	// static method that pins memory so it is never paged out (Note: best effort)
+	static bool lock(void* ptr, size_t bytes);
+
+	// static method that undoes lock
+	static void unlock(void* ptr, size_t bytes);
+
+	// static method that returns how many blocks allocate has handed out so far
+	static uint64_t getAllocationCount();
+
+	// static method that rounds bytes up to a multiple of alignment
+	static size_t roundUp(size_t bytes, size_t alignment = CACHE_LINE);
+
+	// the size of a cache line (and of an AVX-512 register) in bytes
+	static const size_t CACHE_LINE = 64;
+};
+
+#endif // !ALIGNED_MEMORY_H
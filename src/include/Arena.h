@@ -0,0 +1,118 @@
+/**
+ *  @file    Arena.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief a bump allocator for the temporaries of one training or inference step
+ *
+ *  @section DESCRIPTION
+ *
+ *  An Arena hands out aligned pieces of large blocks by moving an
+ *  offset forward, and gives them all back at once with reset() or,
+ *  for nested temporaries, when an Arena::Scope ends. When a step
+ *  needs more than the arena holds, another block is added; the next
+ *  reset() then merges the blocks into one that fits the whole step,
+ *  so after the first step a loop no longer touches the heap.
+ *
+ *  Every thread also has its own arena (getLocal) that the math
+ *  kernels use for scratch space such as the gemm packing buffers.
+ *
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+// cpp
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "AlignedMemory.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that allocates by bumping an offset and frees everything at once
+ */
+class Arena {
+private:
+	// one contiguous piece of memory the arena carves allocations out of
+	struct Block {
+		char* data;
+		size_t size;
+	};
+
+	vector<Block> blocks; // the blocks in the order they were added
+	size_t current = 0; // the block allocations are taken from
+	size_t offset = 0; // the first unused byte of the current block
+	size_t used = 0; // the bytes handed out since the last reset (including padding)
+	size_t highWater = 0; // the most bytes in use at once since the last reset
+	size_t blockSize; // the size of the first block
+
+	// frees every block
+	void releaseBlocks(void);
+
+public:
+	/**
+	 *  @brief Class that returns the memory allocated while it was alive to its arena
+	 */
+	class Scope {
+	private:
+		Arena& arena; // the arena to rewind
+		size_t current; // the block in use when the scope began
+		size_t offset; // the offset in that block when the scope began
+		size_t used; // the bytes in use when the scope began
+
+	public:
+		// Constructor that remembers the position of arena
+		Scope(Arena& arena);
+
+		// Destructor that rewinds arena to that position
+		~Scope(void);
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	// Constructor (Note: no memory is allocated until the first allocate)
+	Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+	// Destructor (Note: frees every block)
+	~Arena(void);
+
+	// The arena owns its blocks so it cannot be copied
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// returns bytes of memory aligned to alignment (a power of two up to 4096)
+	void* allocate(size_t bytes, size_t alignment = AlignedMemory::CACHE_LINE);
+
+	// returns uninitialized room for count elements of T
+	template <typename T>
+	T* allocate(size_t count) {
+		const size_t alignment = alignof(T) > AlignedMemory::CACHE_LINE ? alignof(T) : AlignedMemory::CACHE_LINE;
+		return static_cast<T*>(allocate(count * sizeof(T), alignment));
+	}
+
+	// gives back every allocation (Note: if the step needed more than one block they
+	// are replaced by a single block large enough for all of it)
+	void reset(void);
+
+	// returns the bytes handed out since the last reset
+	size_t getUsed() const;
+
+	// returns the most bytes in use at once since the last reset
+	size_t getHighWater() const;
+
+	// returns the bytes held in blocks
+	size_t getCapacity() const;
+
+	// returns the arena of the calling thread, used for kernel scratch space
+	static Arena& getLocal(void);
+
+	// the size of the first block when none is given
+	static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+};
+
+#endif // !ARENA_H
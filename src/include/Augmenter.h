@@ -0,0 +1,109 @@
+/**
+ *  @file    Augmenter.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief random geometric variants of images, computed while batches are gathered
+ *
+ *  @section DESCRIPTION
+ *
+ *  An Augmenter maps every output pixel back into the source image
+ *  through a random rotation, scale and shift plus a smooth random
+ *  elastic displacement, and reads the source there with bilinear
+ *  interpolation. The gathers of the interpolation run at the
+ *  instruction set level Kernels picks for the host.
+ *
+ *  The variant is chosen by a key: the random numbers come from a
+ *  counter based generator, so the same key always gives the same
+ *  image on any thread. BatchLoader keys each row by its position in
+ *  the batch stream, so every epoch sees fresh variants and nothing
+ *  but the original images is ever stored.
+ *
+ *  The elastic field is a grid of random displacements spaced
+ *  elasticSpacing pixels apart and upsampled bilinearly, a cheap
+ *  stand in for the Gaussian smoothed noise of Simard et al., "Best
+ *  Practices for Convolutional Neural Networks Applied to Visual
+ *  Document Analysis" (ICDAR 2003).
+ *
+ */
+
+#ifndef AUGMENTER_H
+#define AUGMENTER_H
+
+// cpp
+#include <string>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+#include "Philox.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when an augmenter is built or used incorrectly
+ */
+class AugmenterException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	AugmenterException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Struct that bounds the random transformations (a range of 0 disables one)
+ */
+struct AugmentationParams {
+	float maxShift = 2.0f; // the largest shift along each axis in pixels
+	float maxRotation = 12.0f; // the largest rotation either way in degrees
+	float minScale = 0.9f; // the smallest zoom factor
+	float maxScale = 1.1f; // the largest zoom factor
+	float elasticMagnitude = 1.5f; // the largest elastic displacement in pixels
+	float elasticSpacing = 7.0f; // the distance between the random displacements in pixels
+};
+
+/**
+ *  @brief Class that writes random variants of width x height float images
+ */
+class Augmenter {
+private:
+	uint32_t width; // the width of the images in pixels
+	uint32_t height; // the height of the images in pixels
+	AugmentationParams params; // the bounds of the transformations
+	Philox generator; // turns a key into the random numbers of one variant
+	uint32_t gridWidth; // the number of elastic control points per row
+	uint32_t gridHeight; // the number of elastic control points per column
+
+	// reads padded at every (x[i], y[i]) with bilinear interpolation into out
+	static void sample(const float* padded, uint32_t paddedWidth, const float* x, const float* y, float* out, size_t count);
+
+public:
+	// Constructor
+	Augmenter(uint32_t width, uint32_t height, const AugmentationParams& params = AugmentationParams(), uint64_t seed = 0);
+
+	// writes the variant of src picked by key to dst (Note: src and dst may be the
+	// same; pixels that come from outside the image get background, the value a
+	// blank pixel has after normalization)
+	void apply(const float* src, float* dst, float background, uint64_t key) const;
+
+	// returns the width of the images in pixels
+	uint32_t getWidth() const;
+
+	// returns the height of the images in pixels
+	uint32_t getHeight() const;
+
+	// returns the bounds of the transformations
+	const AugmentationParams& getParams() const;
+
+	// the Philox counters reserved for the random numbers of one variant
+	static const uint64_t COUNTERS_PER_KEY = 1 << 12;
+};
+
+#endif // !AUGMENTER_H
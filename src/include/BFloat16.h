@@ -0,0 +1,65 @@
+/**
+ *  @file    BFloat16.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief 16 bit brain floating point storage type
+ *
+ *  @section DESCRIPTION
+ *
+ *  A bfloat16 is the upper half of an IEEE float: same sign and
+ *  exponent, 7 bits of mantissa. It halves the memory traffic of
+ *  weights and activations while keeping the float range, and it is
+ *  only used for storage; all arithmetic widens to float first.
+ *
+ */
+
+#ifndef BFLOAT16_H
+#define BFLOAT16_H
+
+// cpp
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+/**
+ *  @brief Struct that stores a float rounded to 16 bits
+ */
+struct BFloat16 {
+	uint16_t bits; // the upper 16 bits of the rounded float
+
+	// Empty constructor (Note: trivial so arrays of BFloat16 can live in raw memory;
+	// BFloat16() holds +0)
+	BFloat16(void) = default;
+
+	// Constructor that rounds a float to nearest even
+	explicit BFloat16(float val) : bits(fromFloat(val)) {}
+
+	// widens back to float (exact)
+	operator float() const { return toFloat(bits); }
+
+	// static method that rounds a float to the nearest bfloat16 bit pattern
+	static uint16_t fromFloat(float val) {
+		uint32_t word;
+		memcpy(&word, &val, sizeof(word));
+
+		// keep NaNs quiet instead of letting the rounding carry into infinity
+		if ((word & 0x7fffffff) > 0x7f800000) {
+			return static_cast<uint16_t>((word >> 16) | 0x40);
+		}
+		word += 0x7fff + ((word >> 16) & 1);
+		return static_cast<uint16_t>(word >> 16);
+	}
+
+	// static method that widens a bfloat16 bit pattern to float
+	static float toFloat(uint16_t bits) {
+		const uint32_t word = static_cast<uint32_t>(bits) << 16;
+		float val;
+		memcpy(&val, &word, sizeof(val));
+		return val;
+	}
+};
+
+#endif // !BFLOAT16_H
@@ -0,0 +1,163 @@
+/**
+ *  @file    BatchLoader.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief prefetches shuffled minibatches on background threads
+ *
+ *  @section DESCRIPTION
+ *
+ *  This class sits between a Dataset and the math code. Every epoch
+ *  a Sampler orders the image indices (shuffled, stratified or class
+ *  balanced), and worker threads gather the
+ *  images of upcoming batches into pinned, aligned float buffers
+ *  while the consumer works on the current one. Batches are handed
+ *  out strictly in order, so a given seed always produces the same
+ *  sequence no matter how many workers run.
+ *
+ *  An optional Augmenter turns every gathered row into a random variant
+ *  on the worker that gathered it. The variant is keyed by the row's
+ *  position in the stream, so each epoch sees new variants while the
+ *  sequence stays reproducible.
+ *
+ */
+
+#ifndef BATCH_LOADER_H
+#define BATCH_LOADER_H
+
+// cpp
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <exception>
+#include <cstdint>
+
+#include "Dataset.h"
+#include "Augmenter.h"
+#include "Sampler.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when a loader cannot serve a dataset
+ */
+class BatchLoaderException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	BatchLoaderException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Struct that holds one gathered minibatch
+ */
+struct Batch {
+	float* pixels = nullptr; // count rows of stride floats (the dataset's features, or pixels scaled to [0, 1])
+	uint8_t* labels = nullptr; // count labels
+	uint32_t* indices = nullptr; // the dataset index of every row
+	uint32_t count = 0; // the number of rows in the batch
+	size_t stride = 0; // the distance in floats between two rows
+	uint32_t epoch = 0; // the epoch this batch belongs to
+	uint64_t sequence = 0; // the position of this batch in the stream
+
+	// returns the pixels of the ith row
+	const float* getRow(uint32_t i) const { return pixels + stride * i; }
+};
+
+/**
+ *  @brief Class that prefetches shuffled minibatches from a Dataset
+ */
+class BatchLoader {
+private:
+	// the life cycle of a batch buffer
+	enum class SlotState { FREE, FILLING, READY, IN_USE };
+
+	// a batch buffer and its state
+	struct Slot {
+		Batch batch;
+		SlotState state = SlotState::FREE;
+	};
+
+	const Dataset& dataset; // the images being served
+	const uint32_t batchSize; // the maximum number of rows per batch
+	const uint32_t batchesPerEpoch; // the number of batches in one epoch
+	const Augmenter* augmenter; // distorts every gathered row (may be null)
+	float background = 0.0f; // the value of a blank pixel in the gathered rows
+	vector<Slot> slots; // prefetch + 1 batch buffers used as a ring
+	void* block = nullptr; // the single allocation backing every slot
+	size_t blockBytes = 0; // the size of block in bytes
+	bool pinned = false; // true if block was pinned
+
+	Sampler sampler; // orders the indices of every epoch (Note: only used by the worker that shuffles)
+	vector<uint32_t> order; // the order of the epoch whose batches are being claimed
+	vector<uint32_t> shuffled; // the next epoch's order, written without the lock by the worker that shuffles
+	uint32_t orderEpoch = 0; // the epoch order belongs to
+	bool shuffling = false; // true while a worker writes shuffled
+	uint64_t nextSequence = 0; // the next batch a worker will claim
+	uint64_t consumed = 0; // the next batch the consumer will receive
+	Slot* current = nullptr; // the slot the consumer is holding
+
+	double waitSeconds = 0.0; // the total time the consumer spent blocked
+	uint64_t waits = 0; // the number of calls to next that had to block
+
+	mutex lock; // guards everything above
+	condition_variable changed; // signalled whenever a slot changes state
+	bool stopping = false; // tells the workers to exit
+	vector<thread> workers; // the gathering threads
+
+	// the body of every worker thread
+	void work(void);
+
+	// copies, scales and augments the rows listed in batch.indices
+	void gather(Batch& batch) const;
+
+public:
+	// Constructor (Note: the dataset and the augmenter must outlive the loader; throws
+	// BatchLoaderException if the dataset is empty, since no batch would ever arrive)
+	BatchLoader(
+		const Dataset& dataset,
+		uint32_t batchSize,
+		uint32_t prefetch = 2,
+		uint32_t numThreads = 1,
+		uint64_t seed = 0,
+		const Augmenter* augmenter = nullptr,
+		SamplingMode mode = SamplingMode::SHUFFLE
+	);
+
+	// Destructor (Note: joins the workers)
+	~BatchLoader(void);
+
+	// The loader owns threads and buffers so it cannot be copied
+	BatchLoader(const BatchLoader&) = delete;
+	BatchLoader& operator=(const BatchLoader&) = delete;
+
+	// returns the next batch, blocking until it is ready
+	// (Note: the previous batch is handed back to the workers)
+	const Batch& next(void);
+
+	// returns the number of batches in one epoch
+	uint32_t getBatchesPerEpoch() const;
+
+	// returns the total time in seconds next() spent waiting on the workers
+	double getWaitSeconds();
+
+	// returns the number of calls to next() that had to wait
+	uint64_t getWaitCount();
+
+	// returns the number of batches handed out so far
+	uint64_t getBatchesServed();
+
+	// returns true if the batch buffers are pinned in memory
+	bool isPinned() const;
+};
+
+#endif // !BATCH_LOADER_H
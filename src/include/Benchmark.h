@@ -0,0 +1,112 @@
+/**
+ *  @file    Benchmark.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief times the parser, the math kernels and the bmp encoder
+ *
+ *  @section DESCRIPTION
+ *
+ *  A Benchmark repeats an operation until it has run for a minimum
+ *  time and records the nanoseconds per call, the bytes moved per
+ *  second and the heap allocations per call. run() measures any
+ *  operation, and runAll() runs the standard suite: it writes
+ *  synthetic IDX files, so it needs no MNIST download, and then times
+ *  the parser, dot, randn, exp, zeroes and the bmp encoder at a few
+ *  sizes each.
+ *
+ *  The results can be printed as a table or written as JSON, which
+ *  lets two builds be compared to catch regressions.
+ *
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// cpp
+#include <vector>
+#include <string>
+#include <functional>
+#include <iostream>
+#include <exception>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when the synthetic files or the results cannot be written
+ */
+class BenchmarkException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	BenchmarkException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Struct that holds the measurements of one benchmark
+ */
+struct BenchmarkResult {
+	string name; // what was measured
+	uint64_t size = 0; // the problem size (elements, images or pixels)
+	uint64_t iterations = 0; // the number of calls timed
+	double nsPerOp = 0.0; // the mean time of one call in nanoseconds
+	double gbPerSecond = 0.0; // the bytes read and written per second, in 10^9 bytes
+	double allocationsPerOp = 0.0; // the mean heap allocations of one call
+};
+
+/**
+ *  @brief Class that times operations and collects the results
+ */
+class Benchmark {
+private:
+	string directory; // where the synthetic files are written
+	double minSeconds; // the least time every benchmark runs for
+	vector<BenchmarkResult> results; // the measurements so far
+
+	// writes count random width x height images as an IDX image file
+	static void writeImageFile(string name, uint32_t count, uint32_t width, uint32_t height, uint64_t seed);
+
+	// writes count random digits as an IDX label file
+	static void writeLabelFile(string name, uint32_t count, uint64_t seed);
+
+	// times the MNIST parser on synthetic files
+	void runParser(void);
+
+	// times the MathUtils kernels
+	void runMath(void);
+
+	// times the bmp encoder
+	void runBitMap(void);
+
+public:
+	// Constructor (Note: directory must exist)
+	Benchmark(string directory = ".", double minSeconds = 0.25);
+
+	// times op and records the result (Note: bytes is what one call reads and writes)
+	const BenchmarkResult& run(string name, uint64_t size, uint64_t bytes, const function<void()>& op);
+
+	// runs the standard suite
+	void runAll(void);
+
+	// returns the measurements so far
+	const vector<BenchmarkResult>& getResults() const;
+
+	// prints the measurements as a table
+	void print(ostream& out) const;
+
+	// writes the measurements as JSON
+	void writeJson(string filename) const;
+
+	// static method that returns how many times the global operator new has run
+	static uint64_t getHeapAllocationCount();
+};
+
+#endif // !BENCHMARK_H
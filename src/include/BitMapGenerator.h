@@ -11,6 +11,16 @@
  *  This static class contains one useful function for writing
  *  a ImageData object to a bmp file.
  *
+ *  Every bmp is encoded into a memory buffer and written with a
+ *  single call. Whole sets of images can be exported to a directory
+ *  in parallel, or tiled into one mosaic bmp for a quick look at
+ *  thousands of samples at once.
+ *
+ *  Images can be encoded as 8 bit indexed bmps, whose palette holds
+ *  the colors, or as 24 bit BGR bmps, in either case through a color
+ *  map. Encoding targets a caller provided buffer or a vector, so
+ *  previews can be streamed or embedded without touching the disk.
+ *
  */
 
 #ifndef BIT_MAP_GENERATOR_H
@@ -20,23 +30,107 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <bitset>
+#include <exception>
 
 #include "ImageData.h"
+#include "Dataset.h"
 
 using namespace std;
 
+/**
+ *  @brief Class that gets thrown when a bmp file cannot be written
+ */
+class BitMapGeneratorException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	BitMapGeneratorException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief The pixel layouts a bmp can be encoded in
+ */
+enum class BitMapFormat : uint8_t {
+	INDEXED, // 8 bits per pixel that index a 256 color palette (a third of the size of BGR)
+	BGR // 24 bits per pixel
+};
+
+/**
+ *  @brief The colors gray values are drawn with
+ */
+enum class ColorMap : uint8_t {
+	INVERTED_GRAY, // dark strokes on white, the look of the original generator
+	GRAY, // 0 is black and 255 is white
+	HEAT, // black through red and yellow to white
+	DIVERGING // blue for 0, white for 128 and red for 255 (e.g. for weights)
+};
+
 /**
  *  @brief Class that handles writing ImageData objects as bmp files
  */
 class BitMapGenerator {
 public:
-	// static method for generating a bmp file
-	static void generate(ImageData*& img, string filename);
+	// static method for generating a bmp file from an image or image view
+	static void generate(const ImageData& img, string filename,
+		BitMapFormat format = BitMapFormat::BGR, ColorMap colors = ColorMap::INVERTED_GRAY);
+
+	// static method that encodes width x height row major gray pixels as a bmp into
+	// buffer and returns the number of bytes written (Note: 0 if capacity is smaller
+	// than getEncodedSize, in which case buffer is left untouched)
+	static size_t encode(const uint8_t* pixels, uint32_t width, uint32_t height, uint8_t* buffer, size_t capacity,
+		BitMapFormat format = BitMapFormat::BGR, ColorMap colors = ColorMap::INVERTED_GRAY);
+
+	// static method that encodes an image as a bmp into a caller provided buffer
+	static size_t encode(const ImageData& img, uint8_t* buffer, size_t capacity,
+		BitMapFormat format = BitMapFormat::BGR, ColorMap colors = ColorMap::INVERTED_GRAY);
+
+	// static method that encodes an image as a bmp into buffer (resized to fit)
+	static void encode(const ImageData& img, vector<uint8_t>& buffer,
+		BitMapFormat format = BitMapFormat::BGR, ColorMap colors = ColorMap::INVERTED_GRAY);
+
+	// static method that returns the size in bytes of the bmp encode produces
+	static size_t getEncodedSize(uint32_t width, uint32_t height, BitMapFormat format = BitMapFormat::BGR);
+
+	// static method that fills palette with the blue, green and red of every gray value
+	static void getPalette(ColorMap colors, uint8_t palette[256][3]);
+
+	// static method that writes every image to directory as prefix_<index>_<label>.bmp
+	// on the shared ThreadPool and returns the number of files written (Note: the
+	// directory must exist; throws BitMapGeneratorException if a file cannot be written)
+	static uint32_t exportImages(const vector<ImageData>& images, string directory, string prefix = "image",
+		BitMapFormat format = BitMapFormat::BGR);
+
+	// static method that exports the listed images of a dataset the same way
+	// (e.g. the misclassified part of a test set)
+	static uint32_t exportImages(const Dataset& dataset, const vector<uint32_t>& indices, string directory, string prefix = "image",
+		BitMapFormat format = BitMapFormat::BGR);
+
+	// static method that tiles the images row by row into a grid with columns cells per
+	// row, separated by spacing pixel wide grid lines, and writes it as one bmp
+	static void generateMosaic(const vector<ImageData>& images, uint32_t columns, string filename, uint32_t spacing = 1,
+		BitMapFormat format = BitMapFormat::BGR);
+
+	// static method that tiles the listed images of a dataset the same way
+	static void generateMosaic(const Dataset& dataset, const vector<uint32_t>& indices, uint32_t columns, string filename, uint32_t spacing = 1,
+		BitMapFormat format = BitMapFormat::BGR);
 
 private:
-	// static helper method used to write n number of bytes to out
-	static void write(ofstream& out, uint8_t n, uint32_t val);
+	// static helper method used to write n bytes of val in little endian order to out
+	static uint8_t* write(uint8_t* out, uint8_t n, uint32_t val);
+
+	// static helper method that writes a finished buffer to a file in one call
+	static void save(const vector<uint8_t>& buffer, const string& filename);
+
+	// static helper method that joins a directory and a file name
+	static string join(const string& directory, const string& name);
 	
 	// BMP FILE HEADER constants
 	static const uint8_t BFTYPE = 2;
@@ -64,6 +158,10 @@ private:
 	static const uint8_t RGBRED = 1;
 	static const uint8_t RGBRESERVED = 1;
 	static const uint8_t HEADERSIZE = 54;
+	static const uint16_t PALETTESIZE = 256 * 4;
+
+	// the value of the grid lines between mosaic cells (before the colors are inverted)
+	static const uint8_t MOSAICGRID = 128;
 };
 
 #endif // !BIT_MAP_GENERATOR_H
\ No newline at end of file
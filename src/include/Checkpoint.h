@@ -0,0 +1,230 @@
+/**
+ *  @file    Checkpoint.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief a versioned binary file of named weight matrices that loads by mmap
+ *
+ *  @section DESCRIPTION
+ *
+ *  A checkpoint starts with a 64 byte header, followed by one 64 byte
+ *  entry per tensor holding its name, element type, shape and the
+ *  offset of its elements. Every tensor starts on a 64 byte boundary,
+ *  so once the file is mapped the entries and the weights are used in
+ *  place: opening a checkpoint only checks that the header and the
+ *  entries are consistent, it never parses or copies the data.
+ *
+ *  Files are written to a temporary name and renamed over the target,
+ *  so a reader only ever sees a complete checkpoint.
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// cpp
+#include <vector>
+#include <string>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+#include "Matrix.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when a checkpoint cannot be written, read or matched
+ */
+class CheckpointException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	CheckpointException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief The element types a checkpoint can hold
+ */
+enum class CheckpointType : uint32_t {
+	FLOAT64 = 1,
+	FLOAT32 = 2,
+	BFLOAT16 = 3
+};
+
+/**
+ *  @brief Struct that maps an element type onto its CheckpointType
+ */
+template <typename T>
+struct CheckpointTypeOf;
+
+template <>
+struct CheckpointTypeOf<double> {
+	static const CheckpointType value = CheckpointType::FLOAT64;
+};
+
+template <>
+struct CheckpointTypeOf<float> {
+	static const CheckpointType value = CheckpointType::FLOAT32;
+};
+
+template <>
+struct CheckpointTypeOf<BFloat16> {
+	static const CheckpointType value = CheckpointType::BFLOAT16;
+};
+
+/**
+ *  @brief Struct that describes one named matrix to save or one found in a checkpoint
+ */
+struct CheckpointTensor {
+	string name; // at most MAX_NAME characters
+	CheckpointType type = CheckpointType::FLOAT64; // the element type
+	uint32_t rows = 0; // the number of rows
+	uint32_t cols = 0; // the number of columns
+	const void* data = nullptr; // rows * cols elements stored row after row
+
+	// returns the size of the elements in bytes
+	size_t getBytes() const;
+
+	// returns the elements reinterpreted as T (T must match type)
+	template <typename T>
+	const T* as() const { return static_cast<const T*>(data); }
+
+	// returns a description of a matrix (Note: the matrix must outlive the description)
+	template <typename T>
+	static CheckpointTensor from(const string& name, const BasicMatrix<T>& mat) {
+		return from(name, mat.getData(), mat.getRows(), mat.getCols());
+	}
+
+	// returns a description of a raw buffer such as the ones MathUtils::randn returns
+	template <typename T>
+	static CheckpointTensor from(const string& name, const T* data, uint32_t rows, uint32_t cols) {
+		CheckpointTensor tensor;
+		tensor.name = name;
+		tensor.type = CheckpointTypeOf<T>::value;
+		tensor.rows = rows;
+		tensor.cols = cols;
+		tensor.data = data;
+		return tensor;
+	}
+
+	// the longest name an entry can hold
+	static const uint32_t MAX_NAME = 39;
+};
+
+/**
+ *  @brief Struct that is the first 64 bytes of every checkpoint file
+ */
+struct CheckpointHeader {
+	char magic[8]; // MAGIC padded with zeroes
+	uint32_t version; // the format version
+	uint32_t tensorCount; // the number of entries that follow the header
+	uint64_t fileSize; // the size of the whole file in bytes
+	uint64_t step; // a caller chosen counter (e.g. the training step)
+	uint64_t checksum; // FNV-1a of every byte after the header
+	uint32_t endianTag; // ENDIAN_TAG as written, to reject files from big endian hosts
+	uint32_t alignment; // the alignment of every tensor in bytes
+	uint8_t reserved[16]; // zero
+};
+
+/**
+ *  @brief Struct that describes one tensor inside a checkpoint file
+ */
+struct CheckpointEntry {
+	char name[40]; // the name, padded with zeroes
+	uint32_t type; // a CheckpointType
+	uint32_t rows; // the number of rows
+	uint32_t cols; // the number of columns
+	uint32_t reserved; // zero
+	uint64_t offset; // the position of the first element from the start of the file
+};
+
+/**
+ *  @brief Class that maps a checkpoint file and hands out its tensors in place
+ */
+class Checkpoint {
+private:
+	MappedFile file; // the mapping the tensors point into
+	const CheckpointHeader* header = nullptr; // the header at the start of the mapping
+	const CheckpointEntry* entries = nullptr; // the entries that follow it
+
+	// throws unless the header and entries describe a well formed file
+	void validate(const string& name) const;
+
+public:
+	// Empty constructor (Note: use open to map a file afterwards)
+	Checkpoint(void);
+
+	// Constructor that maps a checkpoint (Note: throws CheckpointException if it is invalid)
+	Checkpoint(string name);
+
+	// The mapping is owned by exactly one object
+	Checkpoint(const Checkpoint&) = delete;
+	Checkpoint& operator=(const Checkpoint&) = delete;
+
+	// maps a checkpoint, replacing any previous one
+	void open(string name);
+
+	// returns true if a checkpoint is mapped
+	bool isOpen() const;
+
+	// returns the format version of the file
+	uint32_t getVersion() const;
+
+	// returns the counter the checkpoint was saved with
+	uint64_t getStep() const;
+
+	// returns the number of tensors
+	uint32_t getTensorCount() const;
+
+	// returns the ith tensor (Note: data points into the mapping and lives as long as it)
+	CheckpointTensor getTensor(uint32_t i) const;
+
+	// returns the tensor called name (Note: throws if there is none)
+	CheckpointTensor getTensor(const string& name) const;
+
+	// returns true if a tensor is called name
+	bool contains(const string& name) const;
+
+	// copies the tensor called name into mat (Note: throws if the type or shape differ)
+	template <typename T>
+	void load(const string& name, BasicMatrix<T>& mat) const;
+
+	// recomputes the checksum of the file and returns true if it matches the header
+	bool verify() const;
+
+	// static method that lays out a whole checkpoint file in image (resized to fit)
+	static void encode(const vector<CheckpointTensor>& tensors, uint64_t step, vector<uint8_t>& image);
+
+	// static method that writes image to name + ".tmp", flushes it to disk and renames it
+	// over name, so readers never see a partial file (Note: throws CheckpointException)
+	static void write(const vector<uint8_t>& image, const string& name);
+
+	// static method that encodes and writes a checkpoint on the calling thread
+	static void save(const vector<CheckpointTensor>& tensors, uint64_t step, const string& name);
+
+	// static method that returns the size of one element of type in bytes
+	static size_t getElementSize(CheckpointType type);
+
+	// the first bytes of every checkpoint
+	static constexpr const char* MAGIC = "NNFCKPT";
+
+	// the version written by this code
+	static const uint32_t VERSION = 1;
+
+	// the alignment of the entries and of every tensor
+	static const uint32_t ALIGNMENT = 64;
+
+	// the value endianTag holds when read on a host with the writer's byte order
+	static const uint32_t ENDIAN_TAG = 0x01020304;
+};
+
+#endif // !CHECKPOINT_H
@@ -0,0 +1,84 @@
+/**
+ *  @file    CheckpointWriter.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief saves checkpoints on a background thread
+ *
+ *  @section DESCRIPTION
+ *
+ *  save() only copies the tensors into a file image in memory and
+ *  returns; a thread owned by the writer then writes the image to
+ *  disk and renames it into place, so the training loop never waits
+ *  on the disk. The writer keeps two images: the one being written
+ *  and the newest one waiting. When a save arrives while another one
+ *  is still waiting, the waiting one is replaced, since only the
+ *  latest weights are worth keeping.
+ *
+ */
+
+#ifndef CHECKPOINT_WRITER_H
+#define CHECKPOINT_WRITER_H
+
+// cpp
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdint>
+
+#include "Checkpoint.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that writes checkpoints to disk without blocking the caller
+ */
+class CheckpointWriter {
+private:
+	vector<uint8_t> pending; // the newest image waiting to be written
+	vector<uint8_t> writing; // the image the thread is writing
+	string pendingName; // the file the pending image goes to
+	bool hasPending = false; // true if pending holds an image
+	bool busy = false; // true while the thread is writing
+	bool stopping = false; // tells the thread to exit once nothing is pending
+	uint64_t saved = 0; // the number of files written
+	uint64_t skipped = 0; // the number of images replaced before they were written
+	exception_ptr error; // the first failure since the last wait
+	mutex lock; // guards everything above except writing
+	condition_variable wake; // signalled when an image is queued or stopping is set
+	condition_variable idle; // signalled when the thread finishes an image
+	thread worker; // the thread that writes the images
+
+	// the body of the thread
+	void work(void);
+
+public:
+	// Constructor (Note: starts the thread)
+	CheckpointWriter(void);
+
+	// Destructor (Note: writes the pending image, if any, before returning)
+	~CheckpointWriter(void);
+
+	// The writer owns a thread so it cannot be copied
+	CheckpointWriter(const CheckpointWriter&) = delete;
+	CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+	// copies tensors into an image and queues it for name, then returns (Note: the
+	// tensors may change as soon as this returns; an image still waiting is dropped)
+	void save(const vector<CheckpointTensor>& tensors, uint64_t step, const string& name);
+
+	// blocks until every queued image is on disk and rethrows the first failure
+	void wait(void);
+
+	// returns the number of files written
+	uint64_t getSavedCount();
+
+	// returns the number of images that were replaced by a newer one before being written
+	uint64_t getSkippedCount();
+};
+
+#endif // !CHECKPOINT_WRITER_H
@@ -0,0 +1,220 @@
+/**
+ *  @file    Dataset.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief a contiguous container for a whole set of images and labels
+ *
+ *  @section DESCRIPTION
+ *
+ *  This container keeps every image of a dataset in one aligned
+ *  N x H x W block of pixels and every label in a separate contiguous
+ *  array. Rows and minibatches are handed out as pointer plus stride
+ *  views so nothing has to chase per-image heap allocations.
+ *
+ *  Next to (or instead of) the raw pixels a dataset can hold its
+ *  images already converted to normalized floats, one padded row per
+ *  image, so training reads network inputs straight from memory
+ *  instead of converting every image again each epoch.
+ *
+ *  The blocks can also live inside a mapped file (see DatasetCache),
+ *  in which case the dataset keeps the mapping alive instead of owning
+ *  heap blocks.
+ *
+ */
+
+#ifndef DATASET_H
+#define DATASET_H
+
+// cpp
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <exception>
+
+#include "ImageData.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+/**
+ *  @brief Struct that describes how pixels are turned into network inputs
+ *
+ *  Every pixel p becomes p * scale + offset.
+ */
+struct Normalization {
+	float scale = 1.0f / 255.0f; // the factor every pixel is multiplied by
+	float offset = 0.0f; // the value added after scaling
+
+	// returns the map onto [0, 1]
+	static Normalization unit(void);
+
+	// returns the map (p / 255 - mean) / deviation (mean and deviation are in [0, 1] units)
+	static Normalization standard(float mean, float deviation);
+
+	// the mean and standard deviation of the MNIST training pixels in [0, 1] units
+	static constexpr float MNIST_MEAN = 0.1307f;
+	static constexpr float MNIST_DEVIATION = 0.3081f;
+};
+
+/**
+ *  @brief Class that gets thrown when a dataset is asked for a form it does not keep
+ */
+class DatasetException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	DatasetException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief The forms in which a Dataset keeps its images
+ */
+enum class DatasetStorage : uint8_t {
+	PIXELS, // the raw bytes only
+	FEATURES, // the normalized floats only
+	BOTH // both forms
+};
+
+/**
+ *  @brief Struct that views a run of consecutive images in a Dataset
+ */
+struct DatasetBatch {
+	const uint8_t* pixels = nullptr; // the first pixel of the first image (nullptr without pixels)
+	const float* features = nullptr; // the first feature of the first image (nullptr without features)
+	const uint8_t* labels = nullptr; // the label of the first image
+	uint32_t count = 0; // the number of images in the batch
+	uint32_t width = 0; // the width of each image in pixels
+	uint32_t height = 0; // the height of each image in pixels
+	size_t stride = 0; // the distance in bytes between two images
+	size_t featureStride = 0; // the distance in floats between two feature rows
+
+	// returns the pixels of the ith image in the batch
+	const uint8_t* getRow(uint32_t i) const { return pixels + stride * i; }
+
+	// returns the features of the ith image in the batch
+	const float* getFeatureRow(uint32_t i) const { return features + featureStride * i; }
+};
+
+/**
+ *  @brief Class that stores a dataset as structure of arrays
+ */
+class Dataset {
+private:
+	uint8_t* pixels = nullptr; // count * stride pixels, 64 byte aligned
+	float* features = nullptr; // count * featureStride normalized pixels, 64 byte aligned
+	uint8_t* labels = nullptr; // count labels
+	uint32_t count = 0; // the number of images
+	uint32_t width = 0; // the width of each image in pixels
+	uint32_t height = 0; // the height of each image in pixels
+	Normalization normalization; // how the features were made from the pixels
+	shared_ptr<MappedFile> mapping; // the file attached blocks live in (Note: those are freed with it, not one by one)
+
+	// frees the pixel, feature and label blocks
+	void release(void);
+
+	// returns true if block was allocated by this dataset rather than attached from the mapping
+	bool ownsBlock(const void* block) const;
+
+public:
+	// Empty constructor (Note: call resize before filling it)
+	Dataset(void);
+
+	// Constructor that allocates room for count images of width x height
+	Dataset(uint32_t count, uint32_t width, uint32_t height, DatasetStorage storage = DatasetStorage::PIXELS);
+
+	// Destructor
+	~Dataset(void);
+
+	// A dataset owns its blocks so it can only be moved
+	Dataset(const Dataset&) = delete;
+	Dataset& operator=(const Dataset&) = delete;
+	Dataset(Dataset&& other) noexcept;
+	Dataset& operator=(Dataset&& other) noexcept;
+
+	// reallocates room for count images of width x height in the given forms
+	// (contents are zeroed)
+	void resize(uint32_t count, uint32_t width, uint32_t height, DatasetStorage storage = DatasetStorage::PIXELS);
+
+	// replaces the contents with blocks that live inside a mapped file (Note: pixels or features
+	// may be nullptr, and the blocks stay valid as long as the dataset holds the mapping; map the
+	// file copy-on-write if the blocks will be written)
+	void attach(shared_ptr<MappedFile> file, uint32_t count, uint32_t width, uint32_t height,
+		uint8_t* pixels, float* features, uint8_t* labels, const Normalization& normalization);
+
+	// returns true if the blocks live inside a mapped file
+	bool isMapped() const;
+
+	// fills the features from the pixels (Note: with keepPixels false the pixels are
+	// freed afterwards, which cuts the memory of a loaded dataset by a fifth)
+	void normalize(const Normalization& normalization, bool keepPixels = true);
+
+	// records how the features were produced by whoever filled them
+	void setNormalization(const Normalization& normalization);
+
+	// returns how the features were produced
+	const Normalization& getNormalization() const;
+
+	// returns the number of images
+	uint32_t getCount() const;
+
+	// returns the width of each image
+	uint32_t getWidth() const;
+
+	// returns the height of each image
+	uint32_t getHeight() const;
+
+	// returns the number of pixels in each image
+	size_t getImageSize() const;
+
+	// returns the distance in bytes between two images
+	size_t getStride() const;
+
+	// returns the distance in floats between two feature rows (the image size rounded
+	// up to a cache line)
+	size_t getFeatureStride() const;
+
+	// returns true if the raw pixels are kept
+	bool hasPixels() const;
+
+	// returns true if the normalized features are kept
+	bool hasFeatures() const;
+
+	// returns true if the dataset holds no images
+	bool empty() const;
+
+	// returns the pixels of the ith image (Note: nullptr if only features are kept)
+	const uint8_t* getPixels(uint32_t i) const;
+	uint8_t* getPixels(uint32_t i);
+
+	// returns the features of the ith image (Note: nullptr if only pixels are kept)
+	const float* getFeatures(uint32_t i) const;
+	float* getFeatures(uint32_t i);
+
+	// returns the whole label array
+	const uint8_t* getLabels() const;
+	uint8_t* getLabels();
+
+	// returns the label of the ith image
+	uint8_t getLabel(uint32_t i) const;
+
+	// sets the label of the ith image
+	void setLabel(uint32_t i, uint8_t label);
+
+	// returns a view over count images starting at start (clamped to the end)
+	DatasetBatch getBatch(uint32_t start, uint32_t count) const;
+
+	// returns a non-owning ImageData view of the ith image (Note: throws DatasetException
+	// if the pixels are not kept)
+	ImageData getImage(uint32_t i) const;
+};
+
+#endif // !DATASET_H
@@ -0,0 +1,131 @@
+/**
+ *  @file    DatasetCache.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief a preprocessed binary copy of a dataset that loads by mapping it
+ *
+ *  @section DESCRIPTION
+ *
+ *  Parsing MNIST means inflating the .gz files, byte swapping headers
+ *  and normalizing every pixel on every start. This static class does
+ *  that work once: the first load parses the source files the usual
+ *  way and writes the resulting Dataset blocks into a cache file laid
+ *  out exactly as they sit in memory, each block page aligned. Every
+ *  later load maps that file copy-on-write and hands the blocks to the
+ *  Dataset in place, so nothing is parsed or copied.
+ *
+ *  The header records the sizes and modification times of the source
+ *  files together with the storage and normalization, and a cache that
+ *  no longer matches them is rebuilt. A checksum over everything after
+ *  the header catches corrupt files. Files are written to a temporary
+ *  name and renamed into place, so a crash never leaves a partial
+ *  cache behind.
+ *
+ */
+
+#ifndef DATASET_CACHE_H
+#define DATASET_CACHE_H
+
+// cpp
+#include <cstdio>
+#include <string>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+#include "Dataset.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when a dataset cache cannot be written, read or matched
+ */
+class DatasetCacheException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	DatasetCacheException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Struct that is the first 128 bytes of every dataset cache file
+ */
+struct DatasetCacheHeader {
+	char magic[8]; // MAGIC padded with zeroes
+	uint32_t version; // the format version
+	uint32_t endianTag; // ENDIAN_TAG as written, to reject files from big endian hosts
+	uint64_t fileSize; // the size of the whole file in bytes
+	uint64_t checksum; // FNV-1a of every byte after the first ALIGNMENT bytes
+	uint64_t sourceKey; // identifies the source files and settings the cache was built from
+	uint32_t count; // the number of images
+	uint32_t width; // the width of each image in pixels
+	uint32_t height; // the height of each image in pixels
+	uint32_t storage; // a DatasetStorage
+	float scale; // the normalization scale of the features
+	float offset; // the normalization offset of the features
+	uint64_t labelOffset; // the position of the labels from the start of the file
+	uint64_t pixelOffset; // the position of the pixels (0 without pixels)
+	uint64_t featureOffset; // the position of the features (0 without features)
+	uint32_t alignment; // the alignment of every block in bytes
+	uint32_t featureStride; // the distance in floats between two feature rows
+	uint8_t reserved[32]; // zero
+};
+
+/**
+ *  @brief Class that saves datasets to cache files and maps them back
+ */
+class DatasetCache {
+public:
+	// static method that fills dataset from the cache if it matches the source files, and
+	// otherwise parses the source files (plain or gzip IDX) and writes the cache for next
+	// time (Note: like MNISTParser it prints what went wrong and leaves the dataset empty)
+	static void load(Dataset& dataset, string imageName, string labelName, string cacheName,
+		DatasetStorage storage = DatasetStorage::PIXELS, const Normalization& normalization = Normalization(),
+		bool verify = true);
+
+	// static method that maps a cache into dataset (Note: throws DatasetCacheException if the
+	// file is invalid, corrupt when verify is true, or was built from different sources; a
+	// sourceKey of 0 accepts any sources)
+	static void open(Dataset& dataset, string name, uint64_t sourceKey = 0, bool verify = true);
+
+	// static method that writes dataset to name + ".tmp", flushes it to disk and renames it
+	// over name (Note: throws DatasetCacheException)
+	static void save(const Dataset& dataset, string name, uint64_t sourceKey = 0);
+
+	// static method that identifies the source files by size and modification time plus the
+	// settings the dataset is built with (Note: 0 if either file is missing)
+	static uint64_t getSourceKey(string imageName, string labelName, DatasetStorage storage,
+		const Normalization& normalization);
+
+	// the first bytes of every dataset cache
+	static constexpr const char* MAGIC = "NNFDSET";
+
+	// the version written by this code
+	static const uint32_t VERSION = 1;
+
+	// the alignment of every block (a page, so each block starts its own pages)
+	static const uint32_t ALIGNMENT = 4096;
+
+	// the value endianTag holds when read on a host with the writer's byte order
+	static const uint32_t ENDIAN_TAG = 0x01020304;
+
+private:
+	// static helper method that throws unless the header describes a well formed file of size bytes
+	static void validate(const DatasetCacheHeader& header, uint64_t size, const string& name);
+
+	// static helper method that writes a block padded to ALIGNMENT and extends hash over it
+	static bool writeBlock(FILE* out, const void* data, size_t bytes, uint64_t& hash);
+
+	// static helper method that extends an FNV-1a hash over 64 bit words
+	static uint64_t checksum(uint64_t hash, const uint8_t* data, size_t bytes);
+};
+
+#endif // !DATASET_CACHE_H
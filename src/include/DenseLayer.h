@@ -0,0 +1,117 @@
+/**
+ *  @file    DenseLayer.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief a fully connected layer that works on whole minibatches
+ *
+ *  @section DESCRIPTION
+ *
+ *  A dense layer computes activation(input * weights^T + bias) for
+ *  every row of a batch with one gemm, and its backward pass turns the
+ *  gradient of the loss with respect to its output into gradients for
+ *  the weights, the bias and the input with two more. The output and
+ *  gradient matrices are kept between calls so a training loop does
+ *  not allocate once the batch size settles.
+ *
+ */
+
+#ifndef DENSE_LAYER_H
+#define DENSE_LAYER_H
+
+// cpp
+#include <cstdint>
+#include <cstddef>
+
+#include "Matrix.h"
+
+using namespace std;
+
+/**
+ *  @brief The nonlinearity applied to the output of a layer
+ */
+enum class Activation : uint8_t {
+	LINEAR, // identity (used for the logits that feed the softmax head)
+	RELU, // max(0, x)
+	SIGMOID // 1 / (1 + e^-x)
+};
+
+/**
+ *  @brief Struct that holds the per batch buffers of one dense layer
+ *
+ *  A layer owns one workspace for plain use; data parallel training
+ *  gives every shard of a batch its own so the shards never share a
+ *  buffer.
+ */
+struct DenseWorkspace {
+	MatrixF output; // batch x outputs, the activations of the last forward pass
+	MatrixF inputGradient; // batch x inputs, from the last backward pass
+	MatrixF weightGradient; // outputs x inputs, from the last backward pass
+	MatrixF biasGradient; // 1 x outputs, from the last backward pass
+};
+
+/**
+ *  @brief Class that holds the parameters and buffers of one dense layer
+ */
+class DenseLayer {
+private:
+	uint32_t inputs = 0; // the number of inputs per row
+	uint32_t outputs = 0; // the number of outputs per row
+	Activation activation = Activation::LINEAR; // applied after the affine part
+
+	MatrixF weights; // outputs x inputs
+	MatrixF bias; // 1 x outputs
+	DenseWorkspace workspace; // the buffers used when no workspace is given
+
+public:
+	// Constructor (Note: weights are drawn from N(0, 2 / inputs) for RELU and
+	// N(0, 1 / inputs) otherwise, and the bias starts at 0)
+	DenseLayer(uint32_t inputs, uint32_t outputs, Activation activation, uint64_t seed);
+
+	// computes the activations of count rows of input spaced stride floats apart
+	const MatrixF& forward(const float* input, uint32_t count, size_t stride);
+	const MatrixF& forward(const float* input, uint32_t count, size_t stride, DenseWorkspace& buffers) const;
+
+	// takes the gradient of the loss with respect to the output of the last forward
+	// pass (overwritten with the gradient before the activation), fills the weight and
+	// bias gradients and, if propagate is true, returns the gradient with respect to
+	// the input (Note: input must be the same rows forward was given)
+	MatrixF& backward(const float* input, size_t stride, MatrixF& outputGradient, bool propagate);
+	MatrixF& backward(const float* input, size_t stride, MatrixF& outputGradient, bool propagate, DenseWorkspace& buffers) const;
+
+	// takes one gradient descent step with the gradients of the last backward pass
+	void update(float learningRate);
+
+	// adds the weight and bias gradients of from into into
+	static void accumulate(DenseWorkspace& into, const DenseWorkspace& from);
+
+	// returns the number of inputs per row
+	uint32_t getInputs() const;
+
+	// returns the number of outputs per row
+	uint32_t getOutputs() const;
+
+	// returns the nonlinearity
+	Activation getActivation() const;
+
+	// returns the parameters
+	MatrixF& getWeights();
+	const MatrixF& getWeights() const;
+	MatrixF& getBias();
+	const MatrixF& getBias() const;
+
+	// returns the gradients of the last backward pass
+	MatrixF& getWeightGradient();
+	const MatrixF& getWeightGradient() const;
+	MatrixF& getBiasGradient();
+	const MatrixF& getBiasGradient() const;
+
+	// returns the activations of the last forward pass
+	const MatrixF& getOutput() const;
+
+	// returns the buffers used when no workspace is given
+	DenseWorkspace& getWorkspace();
+};
+
+#endif // !DENSE_LAYER_H
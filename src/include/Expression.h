@@ -0,0 +1,434 @@
+/**
+ *  @file    Expression.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief lazy element-wise arithmetic over BasicMatrix
+ *
+ *  @section DESCRIPTION
+ *
+ *  Arithmetic on matrices (+, -, *, /, unary -, exp, sigmoid, relu
+ *  and keepPositive) does not compute anything. It builds a small
+ *  expression object that only remembers its operands. The work
+ *  happens when the expression is assigned to a matrix (=, +=, -=,
+ *  *=, /=), in one loop that reads every operand once and writes the
+ *  destination once, e.g.
+ *
+ *      weights -= learningRate * gradient;
+ *      delta *= activated * (1.0f - activated);
+ *
+ *  are each a single pass with no temporary matrix. The loop is
+ *  written against Simd<T> (see Simd.h), so it runs at the level the
+ *  compiler was told it may use. Expressions are instantiated wherever
+ *  they are assigned, so unlike the Kernels tables this level is fixed
+ *  at build time: the project builds for the baseline target, and
+ *  wider registers need e.g. /arch:AVX2 and hosts that all have them.
+ *
+ *  Every element of the result only depends on the elements at the
+ *  same position, so the destination may also appear in the
+ *  expression. The operands must all have the same shape, except
+ *  plain numbers, which apply to every element. An expression holds
+ *  pointers into its matrices, so it should be assigned before they
+ *  are resized or destroyed.
+ *
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+// cpp
+#include <string>
+#include <exception>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#include "Matrix.h"
+#include "Simd.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when the operands of an expression differ in shape
+ */
+class ExpressionException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	ExpressionException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Class every lazy expression derives from (E is the expression itself)
+ *
+ *  Every expression also provides type (the element type), getRows(),
+ *  getCols(), isBroadcast() (true for plain numbers, which have no
+ *  shape) and load<S>(index), which computes the register of
+ *  elements starting at index for S = Simd<type> or ScalarOps<type>.
+ */
+template <typename E>
+class Expression {
+public:
+	// returns the expression as its own type
+	const E& self() const { return static_cast<const E&>(*this); }
+};
+
+/**
+ *  @brief Class that reads the elements of a matrix
+ */
+template <typename T>
+class MatrixOperand : public Expression<MatrixOperand<T> > {
+private:
+	const T* data; // the first element
+	uint32_t rows; // the number of rows
+	uint32_t cols; // the number of columns
+
+public:
+	typedef T type;
+
+	// Constructor
+	MatrixOperand(const T* data, uint32_t rows, uint32_t cols) : data(data), rows(rows), cols(cols) {}
+
+	uint32_t getRows() const { return rows; }
+	uint32_t getCols() const { return cols; }
+	bool isBroadcast() const { return false; }
+
+	template <typename S>
+	typename S::reg load(size_t index) const { return S::load(data + index); }
+};
+
+/**
+ *  @brief Class that repeats one number for every element
+ */
+template <typename T>
+class ScalarOperand : public Expression<ScalarOperand<T> > {
+private:
+	T value; // the number
+
+public:
+	typedef T type;
+
+	// Constructor
+	ScalarOperand(T value) : value(value) {}
+
+	uint32_t getRows() const { return 0; }
+	uint32_t getCols() const { return 0; }
+	bool isBroadcast() const { return true; }
+
+	template <typename S>
+	typename S::reg load(size_t) const { return S::set1(value); }
+};
+
+// the element-wise operations, each written once for every register type
+struct AddOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a, typename S::reg b) { return S::add(a, b); }
+};
+
+struct SubtractOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a, typename S::reg b) { return S::sub(a, b); }
+};
+
+struct MultiplyOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a, typename S::reg b) { return S::mul(a, b); }
+};
+
+struct DivideOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a, typename S::reg b) { return S::div(a, b); }
+};
+
+// a where b > 0 and 0 elsewhere (the relu gradient given the relu output)
+struct KeepPositiveOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a, typename S::reg b) { return S::keepPositive(a, b); }
+};
+
+struct NegateOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a) { return S::sub(S::zero(), a); }
+};
+
+struct ExpOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a) { return expApprox<S>(a); }
+};
+
+// the same approximation as MathUtils::sigmoid
+struct SigmoidOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a) {
+		const typename S::reg one = S::set1(typename S::type(1));
+		return S::div(one, S::add(one, expApprox<S>(S::sub(S::zero(), a))));
+	}
+};
+
+struct ReluOp {
+	template <typename S>
+	static typename S::reg apply(typename S::reg a) { return S::max(S::zero(), a); }
+};
+
+/**
+ *  @brief Class that applies an operation to the elements of two expressions
+ */
+template <typename Op, typename L, typename R>
+class BinaryExpression : public Expression<BinaryExpression<Op, L, R> > {
+	static_assert(is_same<typename L::type, typename R::type>::value, "the operands of an expression must have the same element type");
+
+private:
+	L left; // the left operand
+	R right; // the right operand
+
+public:
+	typedef typename L::type type;
+
+	// Constructor (Note: throws ExpressionException if the operands differ in shape)
+	BinaryExpression(const L& left, const R& right) : left(left), right(right) {
+		if (!left.isBroadcast() && !right.isBroadcast() &&
+			(left.getRows() != right.getRows() || left.getCols() != right.getCols())) {
+			throw ExpressionException(
+				"Cannot combine a " + to_string(left.getRows()) + " x " + to_string(left.getCols()) +
+				" operand with a " + to_string(right.getRows()) + " x " + to_string(right.getCols()) + " operand!"
+			);
+		}
+	}
+
+	uint32_t getRows() const { return left.isBroadcast() ? right.getRows() : left.getRows(); }
+	uint32_t getCols() const { return left.isBroadcast() ? right.getCols() : left.getCols(); }
+	bool isBroadcast() const { return left.isBroadcast() && right.isBroadcast(); }
+
+	template <typename S>
+	typename S::reg load(size_t index) const {
+		return Op::template apply<S>(left.template load<S>(index), right.template load<S>(index));
+	}
+};
+
+/**
+ *  @brief Class that applies an operation to the elements of one expression
+ */
+template <typename Op, typename A>
+class UnaryExpression : public Expression<UnaryExpression<Op, A> > {
+private:
+	A operand; // the operand
+
+public:
+	typedef typename A::type type;
+
+	// Constructor
+	UnaryExpression(const A& operand) : operand(operand) {}
+
+	uint32_t getRows() const { return operand.getRows(); }
+	uint32_t getCols() const { return operand.getCols(); }
+	bool isBroadcast() const { return operand.isBroadcast(); }
+
+	template <typename S>
+	typename S::reg load(size_t index) const {
+		return Op::template apply<S>(operand.template load<S>(index));
+	}
+};
+
+// tells which types take part in expressions (LAZY) and their element type
+template <typename X, typename Enable = void>
+struct ElementOf {
+	static const bool LAZY = false;
+};
+
+template <typename T>
+struct ElementOf<BasicMatrix<T>, typename enable_if<is_floating_point<T>::value>::type> {
+	static const bool LAZY = true;
+	typedef T type;
+};
+
+template <typename X>
+struct ElementOf<X, typename enable_if<is_base_of<Expression<X>, X>::value>::type> {
+	static const bool LAZY = true;
+	typedef typename X::type type;
+};
+
+// turns a matrix, an expression or a number into an operand with elements of type T
+template <typename T, typename X, typename Enable = void>
+struct OperandOf {
+	typedef X type;
+	static const X& wrap(const X& expression) { return expression; }
+};
+
+template <typename T, typename U>
+struct OperandOf<T, BasicMatrix<U>, void> {
+	typedef MatrixOperand<U> type;
+	static type wrap(const BasicMatrix<U>& mat) { return type(mat.getData(), mat.getRows(), mat.getCols()); }
+};
+
+template <typename T, typename X>
+struct OperandOf<T, X, typename enable_if<is_arithmetic<X>::value>::type> {
+	typedef ScalarOperand<T> type;
+	static type wrap(X value) { return type(static_cast<T>(value)); }
+};
+
+// the expression an operation on L and R builds (Note: has no type, and so takes the
+// operators out of overload resolution, unless one side is lazy and the other is
+// lazy or a number)
+template <typename Op, typename L, typename R, typename Enable = void>
+struct BinaryResult {
+};
+
+template <typename Op, typename L, typename R>
+struct BinaryResult<Op, L, R, typename enable_if<
+	(ElementOf<L>::LAZY || ElementOf<R>::LAZY) &&
+	(ElementOf<L>::LAZY || is_arithmetic<L>::value) &&
+	(ElementOf<R>::LAZY || is_arithmetic<R>::value)>::type> {
+	typedef typename ElementOf<typename conditional<ElementOf<L>::LAZY, L, R>::type>::type element;
+	typedef OperandOf<element, L> Left;
+	typedef OperandOf<element, R> Right;
+	typedef BinaryExpression<Op, typename Left::type, typename Right::type> type;
+
+	static type make(const L& left, const R& right) { return type(Left::wrap(left), Right::wrap(right)); }
+};
+
+// the expression an operation on X builds (Note: has no type unless X is lazy)
+template <typename Op, typename X, typename Enable = void>
+struct UnaryResult {
+};
+
+template <typename Op, typename X>
+struct UnaryResult<Op, X, typename enable_if<ElementOf<X>::LAZY>::type> {
+	typedef OperandOf<typename ElementOf<X>::type, X> Operand;
+	typedef UnaryExpression<Op, typename Operand::type> type;
+
+	static type make(const X& operand) { return type(Operand::wrap(operand)); }
+};
+
+template <typename L, typename R>
+typename BinaryResult<AddOp, L, R>::type operator+(const L& left, const R& right) {
+	return BinaryResult<AddOp, L, R>::make(left, right);
+}
+
+template <typename L, typename R>
+typename BinaryResult<SubtractOp, L, R>::type operator-(const L& left, const R& right) {
+	return BinaryResult<SubtractOp, L, R>::make(left, right);
+}
+
+template <typename L, typename R>
+typename BinaryResult<MultiplyOp, L, R>::type operator*(const L& left, const R& right) {
+	return BinaryResult<MultiplyOp, L, R>::make(left, right);
+}
+
+template <typename L, typename R>
+typename BinaryResult<DivideOp, L, R>::type operator/(const L& left, const R& right) {
+	return BinaryResult<DivideOp, L, R>::make(left, right);
+}
+
+// returns value where x > 0 and 0 elsewhere
+template <typename L, typename R>
+typename BinaryResult<KeepPositiveOp, L, R>::type keepPositive(const L& value, const R& x) {
+	return BinaryResult<KeepPositiveOp, L, R>::make(value, x);
+}
+
+template <typename X>
+typename UnaryResult<NegateOp, X>::type operator-(const X& operand) {
+	return UnaryResult<NegateOp, X>::make(operand);
+}
+
+template <typename X>
+typename UnaryResult<ExpOp, X>::type exp(const X& operand) {
+	return UnaryResult<ExpOp, X>::make(operand);
+}
+
+template <typename X>
+typename UnaryResult<SigmoidOp, X>::type sigmoid(const X& operand) {
+	return UnaryResult<SigmoidOp, X>::make(operand);
+}
+
+template <typename X>
+typename UnaryResult<ReluOp, X>::type relu(const X& operand) {
+	return UnaryResult<ReluOp, X>::make(operand);
+}
+
+/**
+ *  @brief computes an expression into an array in one pass
+ *
+ *  @param dst receives the elements (may be read by the expression itself)
+ *  @param expression the expression
+ *  @param length the number of elements
+ *  @return void
+ */
+template <typename T, typename E>
+static inline void evaluate(T* dst, const Expression<E>& expression, size_t length) {
+	static_assert(is_same<T, typename E::type>::value, "an expression can only be stored in its own element type");
+	typedef Simd<T> S;
+	const E& expr = expression.self();
+	size_t index = 0;
+
+	for (; index + S::WIDTH <= length; index += S::WIDTH) {
+		S::store(dst + index, expr.template load<S>(index));
+	}
+
+	for (; index < length; index++) {
+		dst[index] = expr.template load<ScalarOps<T> >(index);
+	}
+}
+
+/**
+ *  @brief constructs a matrix from an expression
+ *
+ *  @param expression the expression (must not be a plain number)
+ */
+template <typename T>
+template <typename E>
+BasicMatrix<T>::BasicMatrix(const Expression<E>& expression) : BasicMatrix(expression.self().getRows(), expression.self().getCols()) {
+	evaluate(data, expression, getSize());
+}
+
+/**
+ *  @brief computes an expression into the matrix
+ *
+ *  @param expression the expression (the matrix is resized to its shape unless it is a plain number)
+ *  @return a reference to the matrix
+ */
+template <typename T>
+template <typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const Expression<E>& expression) {
+	const E& expr = expression.self();
+	if (!expr.isBroadcast() && (rows != expr.getRows() || cols != expr.getCols())) {
+		resize(expr.getRows(), expr.getCols());
+	}
+	evaluate(data, expr, getSize());
+	return *this;
+}
+
+// the type the compound assignments return (Note: has no type, and so takes them out of
+// overload resolution, unless the matching binary operator exists)
+template <typename Op, typename T, typename X, typename = typename BinaryResult<Op, BasicMatrix<T>, X>::type>
+struct AssignResult {
+	typedef BasicMatrix<T>& type;
+};
+
+template <typename T, typename X>
+typename AssignResult<AddOp, T, X>::type operator+=(BasicMatrix<T>& target, const X& operand) {
+	return target = BinaryResult<AddOp, BasicMatrix<T>, X>::make(target, operand);
+}
+
+template <typename T, typename X>
+typename AssignResult<SubtractOp, T, X>::type operator-=(BasicMatrix<T>& target, const X& operand) {
+	return target = BinaryResult<SubtractOp, BasicMatrix<T>, X>::make(target, operand);
+}
+
+template <typename T, typename X>
+typename AssignResult<MultiplyOp, T, X>::type operator*=(BasicMatrix<T>& target, const X& operand) {
+	return target = BinaryResult<MultiplyOp, BasicMatrix<T>, X>::make(target, operand);
+}
+
+template <typename T, typename X>
+typename AssignResult<DivideOp, T, X>::type operator/=(BasicMatrix<T>& target, const X& operand) {
+	return target = BinaryResult<DivideOp, BasicMatrix<T>, X>::make(target, operand);
+}
+
+#endif // !EXPRESSION_H
@@ -0,0 +1,190 @@
+/**
+ *  @file    GzipReader.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief streams the decompressed contents of a gzip file
+ *
+ *  @section DESCRIPTION
+ *
+ *  MNIST is distributed as gzip files. This class reads them without
+ *  an external library: it parses the gzip wrapper (RFC 1952) and
+ *  inflates the deflate stream inside it (RFC 1951) into whatever
+ *  buffer the caller hands to read(), keeping only the last 32 KiB of
+ *  output that back references may point into. The compressed input
+ *  goes through a bounded buffer too, so any file size inflates at
+ *  constant memory.
+ *
+ *  Huffman codes up to FAST_BITS long are decoded with one table
+ *  lookup, longer ones bit by bit. The CRC-32 and length in the
+ *  trailer of every member are checked, and concatenated members are
+ *  read one after another as gzip itself does.
+ *
+ */
+
+#ifndef GZIP_READER_H
+#define GZIP_READER_H
+
+// cpp
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when a gzip file cannot be read or is corrupt
+ */
+class GzipReaderException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	GzipReaderException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Struct that decodes one canonical Huffman code
+ */
+struct HuffmanTable {
+	uint16_t fast[1 << 10]; // indexed by the next FAST_BITS input bits: (length << 9) | symbol, 0 if the code is longer
+	uint16_t counts[16]; // the number of codes of each length
+	uint16_t symbols[288]; // the symbols ordered by code
+
+	// the longest code decoded with one lookup
+	static const uint32_t FAST_BITS = 10;
+};
+
+/**
+ *  @brief The parts of a gzip file the reader can be in the middle of
+ */
+enum class GzipState : uint8_t {
+	HEADER, // before the header of a member
+	BLOCK, // before the header of a deflate block
+	STORED, // inside an uncompressed block
+	HUFFMAN, // inside a compressed block
+	TRAILER, // after the last block of a member
+	END // after the last member
+};
+
+/**
+ *  @brief Class that inflates a gzip file in bounded chunks
+ */
+class GzipReader {
+private:
+	ifstream in; // the compressed file
+	string name; // the full path of the file
+	vector<uint8_t> input; // the bounded buffer of compressed bytes
+	size_t inputPosition = 0; // the next unread byte of input
+	size_t inputSize = 0; // the number of valid bytes in input
+	uint64_t bits = 0; // input bits not consumed yet, the next one lowest
+	uint32_t bitCount = 0; // the number of valid bits in bits
+	vector<uint8_t> window; // the last WINDOW_SIZE bytes handed out by read (circular)
+	uint32_t windowPosition = 0; // where the next byte goes in window
+
+	GzipState state = GzipState::HEADER; // what comes next in the file
+	bool lastBlock = false; // true once the final block of a member has started
+	uint32_t storedRemaining = 0; // the bytes left in the current stored block
+	uint32_t matchLength = 0; // the bytes left to copy of the current back reference
+	uint32_t matchDistance = 0; // how far back the current back reference points
+	HuffmanTable literals; // the literal and length code of the current dynamic block
+	HuffmanTable distances; // the distance code of the current dynamic block
+	HuffmanTable fixedLiterals; // the literal and length code of fixed blocks
+	HuffmanTable fixedDistances; // the distance code of fixed blocks
+	const HuffmanTable* literalTable = nullptr; // the literal code of the current block
+	const HuffmanTable* distanceTable = nullptr; // the distance code of the current block
+
+	uint32_t crc = 0; // the CRC-32 of the current member so far
+	uint64_t memberBytes = 0; // the bytes the current member has produced so far
+	uint64_t position = 0; // the bytes produced since the start of the file
+	uint32_t members = 0; // the number of member headers read
+
+	// reads the next chunk of the file into input and returns false at its end
+	bool fillInput(void);
+
+	// tops the bit buffer up to at least 56 bits while the file has bytes left
+	void refill(void);
+
+	// returns the next byte of the file, from the bit buffer first (Note: throws at the end)
+	uint8_t readByte(void);
+
+	// returns the next count bits (at most 24) and consumes them
+	uint32_t readBits(uint32_t count);
+
+	// drops the bits up to the next byte boundary
+	void alignToByte(void);
+
+	// returns true if the file has bytes left
+	bool hasInput(void);
+
+	// decodes one symbol
+	uint32_t decode(const HuffmanTable& table);
+
+	// copies as much of the pending back reference into destination as fits
+	void copyMatch(uint8_t* destination, size_t& produced, size_t bytes);
+
+	// keeps the end of a read call's output for later back references
+	void remember(const uint8_t* data, size_t count);
+
+	// parses a member header (Note: returns false if the file ends instead)
+	bool readMemberHeader(void);
+
+	// checks the CRC-32 and length of the member that just ended
+	void readMemberTrailer(void);
+
+	// parses a block header and the code tables of dynamic blocks
+	void readBlockHeader(void);
+
+	// reads the code lengths of a dynamic block and builds its tables
+	void readDynamicTables(void);
+
+	// returns to the state right after opening the file
+	void reset(void);
+
+	// static method that builds a table from the code length of every symbol
+	static void buildTable(HuffmanTable& table, const uint8_t* lengths, uint32_t count, const string& name);
+
+public:
+	// Constructor (Note: throws GzipReaderException if the file is missing or not gzip)
+	GzipReader(string name, size_t bufferBytes = DEFAULT_BUFFER_BYTES);
+
+	// A reader owns its file and buffers
+	GzipReader(const GzipReader&) = delete;
+	GzipReader& operator=(const GzipReader&) = delete;
+
+	// inflates up to bytes bytes into out and returns how many were produced (Note: fewer
+	// only at the end of the file; throws GzipReaderException if the file is corrupt)
+	size_t read(void* out, size_t bytes);
+
+	// discards up to bytes bytes of output and returns how many were discarded
+	uint64_t skip(uint64_t bytes);
+
+	// starts over from the beginning of the file
+	void rewind(void);
+
+	// returns the number of bytes produced since the beginning of the file
+	uint64_t tell() const;
+
+	// static method that returns true if the file starts with the gzip magic bytes
+	static bool isGzip(string name);
+
+	// static method that extends a CRC-32 (start from 0) over bytes bytes
+	static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t bytes);
+
+	// the default size of the compressed input buffer in bytes
+	static const size_t DEFAULT_BUFFER_BYTES = 1 << 16;
+
+	// the furthest a back reference can point
+	static const uint32_t WINDOW_SIZE = 1 << 15;
+};
+
+#endif // !GZIP_READER_H
@@ -0,0 +1,152 @@
+/**
+ *  @file    IDXReader.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief streams records out of any IDX formatted file
+ *
+ *  @section DESCRIPTION
+ *
+ *  The IDX format starts with two zero bytes, a dtype byte, a byte
+ *  holding the number of dimensions and then one big endian int32 per
+ *  dimension. The first dimension counts the records and the rest
+ *  describe a single record. This class understands every IDX dtype
+ *  and any number of dimensions, and it reads fixed-size chunks of
+ *  records through a bounded buffer so files larger than RAM can be
+ *  processed at constant memory.
+ *
+ *  Files that start with the gzip magic bytes are inflated on the fly
+ *  by a GzipReader, so the .gz files MNIST is distributed as can be
+ *  read directly. Their records are inflated once more while the
+ *  header is checked, since only then is their length known.
+ *
+ */
+
+#ifndef IDX_READER_H
+#define IDX_READER_H
+
+// cpp
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include <exception>
+
+#include "GzipReader.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that extends exception and used for specific error handling here
+ */
+class IDXReaderException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	IDXReaderException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief The element types an IDX file can hold (the value is the dtype byte)
+ */
+enum class IDXType : uint8_t {
+	UBYTE = 0x08,
+	BYTE = 0x09,
+	SHORT = 0x0B,
+	INT = 0x0C,
+	FLOAT = 0x0D,
+	DOUBLE = 0x0E
+};
+
+/**
+ *  @brief Struct that views a chunk of records decoded into host byte order
+ */
+struct IDXChunk {
+	const void* data = nullptr; // the first element of the first record
+	uint64_t first = 0; // the index of the first record in the file
+	size_t count = 0; // the number of records in the chunk
+
+	// returns the elements reinterpreted as T (T must match the file dtype)
+	template <typename T>
+	const T* as() const { return static_cast<const T*>(data); }
+};
+
+/**
+ *  @brief Class that reads records from an IDX file in bounded chunks
+ */
+class IDXReader {
+private:
+	ifstream in; // the file being read (Note: closed when gzip is used instead)
+	unique_ptr<GzipReader> gzip; // inflates the file if it is gzip compressed
+	string name; // the full path of the file
+	IDXType type = IDXType::UBYTE; // the element type
+	vector<uint32_t> dimensions; // every dimension including the record count
+	uint64_t numRecords = 0; // the number of records in the file
+	size_t recordElements = 1; // the number of elements in one record
+	size_t elementSize = 1; // the size of one element in bytes
+	uint64_t headerSize = 0; // the offset of the first record in the file
+	uint64_t position = 0; // the index of the next record to read
+	size_t chunkRecords = 0; // the number of records next() reads at most
+	vector<char> buffer; // the bounded buffer handed out by next()
+
+	// parses and validates the header
+	void readHeader(void);
+
+	// reads up to bytes bytes of the (decompressed) file and returns how many were read
+	size_t readBytes(char* out, size_t bytes);
+
+	// converts count big endian elements in place to host order
+	void toHostOrder(char* data, size_t count) const;
+
+public:
+	// Constructor (Note: throws IDXReaderException if the header is invalid)
+	IDXReader(string name, size_t bufferBytes = DEFAULT_BUFFER_BYTES);
+
+	// returns the element type
+	IDXType getType() const;
+
+	// returns every dimension including the record count
+	const vector<uint32_t>& getDimensions() const;
+
+	// returns the number of records
+	uint64_t getNumRecords() const;
+
+	// returns the number of elements in one record
+	size_t getRecordElements() const;
+
+	// returns the size of one record in bytes
+	size_t getRecordBytes() const;
+
+	// returns true if the file is gzip compressed
+	bool isCompressed() const;
+
+	// returns the index of the next record that will be read
+	uint64_t tell() const;
+
+	// moves to a record (Note: on a compressed file this inflates everything in between,
+	// and moving backwards starts over from the beginning)
+	void seek(uint64_t record);
+
+	// reads up to count records into out in host order and returns how many were read
+	size_t read(void* out, size_t count);
+
+	// decodes the next chunk into the internal buffer and returns false at the end
+	bool next(IDXChunk& chunk);
+
+	// static method that returns the size of one element of type in bytes
+	static size_t getElementSize(IDXType type);
+
+	// the default size of the chunk buffer in bytes
+	static const size_t DEFAULT_BUFFER_BYTES = 1 << 20;
+};
+
+#endif // !IDX_READER_H
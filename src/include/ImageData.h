@@ -19,6 +19,8 @@
 
 // cpp
 #include <memory>
+#include <cstdint>
+#include <cstring>
 
 using namespace std;
 
@@ -27,35 +29,57 @@ using namespace std;
  */
 class ImageData {
 private:
-	uint8_t* data = 0; // the raw image data
-	uint16_t size = 0; // the size of the array
-	uint16_t width = 0; // the width of the image in pixels
+	const uint8_t* data = 0; // the raw image data
+	uint32_t size = 0; // the size of the array
+	uint32_t width = 0; // the width of the image in pixels
 	uint8_t label = 0; // the label for the image which are the ints 0 - 9 (inclusive)
+	bool ownsData = true; // false if data points into memory owned by someone else
 
 public:
 	// Empty constructor (Note: only useful for initializing a vector container)
 	ImageData(void);
 
 	// Contructor (Note: use this one)
-	ImageData(uint8_t* data, uint16_t width, uint16_t size);
+	ImageData(uint8_t* data, uint32_t width, uint32_t size);
+
+	// Constructor for a view (Note: data must outlive this object and is never freed)
+	ImageData(const uint8_t* data, uint32_t width, uint32_t size, uint8_t label);
+
+	// Copy constructor (Note: owned data is deep copied, views are shared)
+	ImageData(const ImageData& other);
+
+	// Move constructor
+	ImageData(ImageData&& other) noexcept;
 
 	// Destructor
 	~ImageData(void);
 
+	// Copy assignment
+	ImageData& operator=(const ImageData& other);
+
+	// Move assignment
+	ImageData& operator=(ImageData&& other) noexcept;
+
 	// returns the pixel value at that index
-	uint8_t getPixel(uint16_t i) const;
+	uint8_t getPixel(uint32_t i) const;
 
 	// returns the pixel value located at x and y
-	uint8_t getPixel(uint16_t x, uint16_t y) const;
+	uint8_t getPixel(uint32_t x, uint32_t y) const;
 
 	// returns the label
 	uint8_t getLabel() const;
 
 	// returns the width
-	uint16_t getWidth() const;
+	uint32_t getWidth() const;
 
 	// returns the height
-	uint16_t getHeight() const;
+	uint32_t getHeight() const;
+
+	// returns a pointer to the raw pixels
+	const uint8_t* getData() const;
+
+	// returns true if the pixels are freed by this object
+	bool isOwner() const;
 
 	// sets the label
 	void setLabel(uint8_t label);
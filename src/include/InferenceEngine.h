@@ -0,0 +1,170 @@
+/**
+ *  @file    InferenceEngine.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief classifies single images from many threads in batches
+ *
+ *  @section DESCRIPTION
+ *
+ *  Callers submit one image at a time and get a future for its class.
+ *  The images wait in a bounded ring until the engine's thread has
+ *  either a full batch or an image that has waited for the maximum
+ *  latency, then the whole batch goes through one forward pass and
+ *  every future is completed. Batching lets the gemm kernels work on
+ *  many rows at once instead of one matrix vector product per image,
+ *  while the deadline keeps a lone request from waiting for company.
+ *
+ *  The engine keeps the latency of the most recent requests, so
+ *  getStats() can report percentiles alongside the throughput.
+ *
+ */
+
+#ifndef INFERENCE_ENGINE_H
+#define INFERENCE_ENGINE_H
+
+// cpp
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <chrono>
+#include <exception>
+#include <cstdint>
+
+#include "Network.h"
+#include "ImageData.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when a request does not fit the engine
+ */
+class InferenceException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	InferenceException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Struct that summarizes the requests an engine has served
+ */
+struct InferenceStats {
+	uint64_t requests = 0; // the requests completed since the last reset
+	uint64_t batches = 0; // the forward passes run since the last reset
+	double meanBatchSize = 0.0; // requests / batches
+	double p50 = 0.0; // the median latency in microseconds (over the recent window)
+	double p99 = 0.0; // the 99th percentile latency in microseconds (over the recent window)
+	double max = 0.0; // the largest latency in microseconds (over the recent window)
+	double throughput = 0.0; // the requests completed per second since the last reset
+};
+
+/**
+ *  @brief Class that coalesces single image requests into batched forward passes
+ */
+class InferenceEngine {
+private:
+	// one queued image (its pixels live in the matching slot of pixels)
+	struct Request {
+		promise<uint32_t> result; // completed with the class of the image
+		chrono::steady_clock::time_point submitted; // when the request was queued
+	};
+
+	Network& network; // the classifier (only the engine's thread uses it while running)
+	Normalization normalization; // maps the pixels onto the features the network expects
+	uint32_t inputs; // the pixels per image
+	uint32_t maxBatchSize; // the most requests per forward pass
+	chrono::microseconds maxLatency; // how long the oldest request may wait for a batch to fill
+
+	vector<Request> ring; // the queued requests (size is the capacity)
+	vector<uint8_t> pixels; // the pixels of every slot of ring, inputs bytes each
+	size_t head = 0; // the slot of the oldest request
+	size_t count = 0; // the number of queued requests
+	bool stopping = false; // tells the thread to exit once the ring is empty
+	mutex lock; // guards the ring
+	condition_variable arrived; // signalled when a request is queued or stopping is set
+	condition_variable space; // signalled when the thread frees slots
+
+	MatrixF batch; // the features of the current batch
+	vector<uint32_t> classes; // the classes of the current batch
+	vector<promise<uint32_t>> inFlight; // the promises of the current batch
+	vector<chrono::steady_clock::time_point> submitted; // when each request of the batch was queued
+
+	vector<float> latencies; // the latencies of the last STATS_WINDOW requests in microseconds
+	uint64_t requests = 0; // the requests completed since the last reset
+	uint64_t batches = 0; // the forward passes since the last reset
+	chrono::steady_clock::time_point since; // when the stats were last reset
+	mutex statsLock; // guards the stats
+
+	thread worker; // the thread that runs the batches
+
+	// the body of the thread
+	void work(void);
+
+	// turns the oldest size requests into the rows of batch and takes their promises
+	void gather(size_t size);
+
+	// classifies the gathered rows, completes their promises and records the latencies
+	void finish(size_t size);
+
+public:
+	// Constructor (Note: the network must take inputs pixels, must outlive the engine
+	// and must not be used by anyone else until the engine is destroyed)
+	InferenceEngine(
+		Network& network,
+		uint32_t maxBatchSize = DEFAULT_BATCH_SIZE,
+		chrono::microseconds maxLatency = chrono::microseconds(DEFAULT_LATENCY_US),
+		uint32_t capacity = DEFAULT_CAPACITY,
+		const Normalization& normalization = Normalization::unit()
+	);
+
+	// Destructor (Note: serves every queued request before returning)
+	~InferenceEngine(void);
+
+	// The engine owns a thread so it cannot be copied
+	InferenceEngine(const InferenceEngine&) = delete;
+	InferenceEngine& operator=(const InferenceEngine&) = delete;
+
+	// queues the pixels of one image and returns a future for its class (Note: the
+	// pixels are copied; blocks while the queue is full)
+	future<uint32_t> submit(const uint8_t* image);
+
+	// queues one image (Note: throws InferenceException if its size does not match)
+	future<uint32_t> submit(const ImageData& image);
+
+	// returns the latency and throughput of the requests served since the last reset
+	InferenceStats getStats();
+
+	// clears the stats
+	void resetStats(void);
+
+	// returns the most requests per forward pass
+	uint32_t getMaxBatchSize() const;
+
+	// returns how long the oldest request may wait for a batch to fill
+	chrono::microseconds getMaxLatency() const;
+
+	// the batch size used when none is given
+	static const uint32_t DEFAULT_BATCH_SIZE = 64;
+
+	// the latency bound used when none is given in microseconds
+	static const uint32_t DEFAULT_LATENCY_US = 1000;
+
+	// the number of requests that can wait at once when no capacity is given
+	static const uint32_t DEFAULT_CAPACITY = 1024;
+
+	// the number of recent requests the latency percentiles are taken over
+	static const uint32_t STATS_WINDOW = 1 << 16;
+};
+
+#endif // !INFERENCE_ENGINE_H
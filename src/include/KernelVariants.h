@@ -0,0 +1,1069 @@
+/**
+ *  @file    KernelVariants.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief the bodies of the MathUtils kernels, built once per instruction set
+ *
+ *  @section DESCRIPTION
+ *
+ *  This header is included only by the KernelsScalar, KernelsAvx2,
+ *  KernelsAvx512 and KernelsAvx512Vnni translation units. Each one
+ *  defines SIMD_TARGET_* (and, for gcc, switches the code generation
+ *  target) before including it, so Simd<T> below maps onto that level
+ *  and the kernels end up in the level's own namespace. fillTable()
+ *  then points a KernelTable at them.
+ *
+ *  Every kernel is written against Simd<T> (see Simd.h). The
+ *  reductions keep several independent accumulators so consecutive
+ *  adds do not wait on each other, and the tails fall back to
+ *  ScalarOps<T>.
+ *
+ */
+
+#ifndef KERNEL_VARIANTS_H
+#define KERNEL_VARIANTS_H
+
+#ifdef SIMD_H
+#error "KernelVariants.h must be the first include of Simd.h in its translation unit"
+#endif
+
+// cpp
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "Kernels.h"
+#include "MathUtils.h"
+#include "Arena.h"
+#include "Simd.h"
+
+#if defined(SIMD_AVX512) && defined(__GNUC__) && !defined(__clang__)
+// GCC's AVX-512 intrinsics pass _mm512_undefined_* registers through their masked forms
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace SIMD_NAMESPACE {
+
+/**
+ *  @brief Used to calculate the dot product between 2 vectors
+ *
+ *  @param vec1 pointer to the array for the first vector
+ *  @param vec2 pointer to the array for the second vector
+ *  @param length the length of both vectors
+ *  @return the value of the dot product of both vectors
+ */
+template <typename T>
+static T dot(const T* vec1, const T* vec2, uint32_t length) {
+	typedef Simd<T> S;
+	const uint32_t width = S::WIDTH;
+	uint32_t index = 0;
+
+	typename S::reg acc0 = S::zero(), acc1 = S::zero(), acc2 = S::zero(), acc3 = S::zero();
+	for (; index + 4 * width <= length; index += 4 * width) {
+		acc0 = S::fmadd(S::load(vec1 + index), S::load(vec2 + index), acc0);
+		acc1 = S::fmadd(S::load(vec1 + index + width), S::load(vec2 + index + width), acc1);
+		acc2 = S::fmadd(S::load(vec1 + index + 2 * width), S::load(vec2 + index + 2 * width), acc2);
+		acc3 = S::fmadd(S::load(vec1 + index + 3 * width), S::load(vec2 + index + 3 * width), acc3);
+	}
+	for (; index + width <= length; index += width) {
+		acc0 = S::fmadd(S::load(vec1 + index), S::load(vec2 + index), acc0);
+	}
+	T sum = S::reduceAdd(S::add(S::add(acc0, acc1), S::add(acc2, acc3)));
+
+	for (; index < length; index++) {
+		sum += vec1[index] * vec2[index];
+	}
+
+	return sum;
+}
+
+/**
+ *  @brief Used to add a scaled vector to another vector (vec2 = alpha * vec1 + vec2)
+ *
+ *  @param alpha the scale applied to the first vector
+ *  @param vec1 pointer to the array for the first vector
+ *  @param vec2 pointer to the array for the second vector which receives the result
+ *  @param length the length of both vectors
+ *  @return void
+ */
+template <typename T>
+static void axpy(T alpha, const T* vec1, T* vec2, uint32_t length) {
+	typedef Simd<T> S;
+	const uint32_t width = S::WIDTH;
+	uint32_t index = 0;
+
+	const typename S::reg a = S::set1(alpha);
+	for (; index + 2 * width <= length; index += 2 * width) {
+		S::store(vec2 + index, S::fmadd(a, S::load(vec1 + index), S::load(vec2 + index)));
+		S::store(vec2 + index + width, S::fmadd(a, S::load(vec1 + index + width), S::load(vec2 + index + width)));
+	}
+
+	for (; index < length; index++) {
+		vec2[index] += alpha * vec1[index];
+	}
+}
+
+/**
+ *  @brief Used to multiply every element of an array by a constant
+ *
+ *  @param alpha the scale
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return void
+ */
+template <typename T>
+static void scale(T alpha, T* vec, uint32_t length) {
+	typedef Simd<T> S;
+	const uint32_t width = S::WIDTH;
+	uint32_t index = 0;
+
+	const typename S::reg a = S::set1(alpha);
+	for (; index + 2 * width <= length; index += 2 * width) {
+		S::store(vec + index, S::mul(a, S::load(vec + index)));
+		S::store(vec + index + width, S::mul(a, S::load(vec + index + width)));
+	}
+
+	for (; index < length; index++) {
+		vec[index] *= alpha;
+	}
+}
+
+/**
+ *  @brief Used to add up every element of an array
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return the sum of the elements
+ */
+template <typename T>
+static T sum(const T* vec, uint32_t length) {
+	typedef Simd<T> S;
+	const uint32_t width = S::WIDTH;
+	uint32_t index = 0;
+
+	typename S::reg acc0 = S::zero(), acc1 = S::zero(), acc2 = S::zero(), acc3 = S::zero();
+	for (; index + 4 * width <= length; index += 4 * width) {
+		acc0 = S::add(acc0, S::load(vec + index));
+		acc1 = S::add(acc1, S::load(vec + index + width));
+		acc2 = S::add(acc2, S::load(vec + index + 2 * width));
+		acc3 = S::add(acc3, S::load(vec + index + 3 * width));
+	}
+	for (; index + width <= length; index += width) {
+		acc0 = S::add(acc0, S::load(vec + index));
+	}
+	T total = S::reduceAdd(S::add(S::add(acc0, acc1), S::add(acc2, acc3)));
+
+	for (; index < length; index++) {
+		total += vec[index];
+	}
+
+	return total;
+}
+
+// the limits the kernels need (std::numeric_limits would instantiate standard library
+// templates under this level's code generation target)
+template <typename T>
+struct Limits;
+
+template <>
+struct Limits<float> {
+	static float lowest() { return -FLT_MAX; }
+	static float infinity() { return HUGE_VALF; }
+};
+
+template <>
+struct Limits<double> {
+	static double lowest() { return -DBL_MAX; }
+	static double infinity() { return HUGE_VAL; }
+};
+
+/**
+ *  @brief Used to find the max value in an array
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return the max value of the array (-infinity if it is empty)
+ */
+template <typename T>
+static T max(const T* vec, uint32_t length) {
+	typedef Simd<T> S;
+	const uint32_t width = S::WIDTH;
+	uint32_t index = 0;
+	if (length == 0) {
+		return -Limits<T>::infinity();
+	}
+	T best = vec[0];
+
+	if (length >= width) {
+		typename S::reg acc = S::load(vec);
+		for (index = width; index + width <= length; index += width) {
+			acc = S::max(acc, S::load(vec + index));
+		}
+		best = S::reduceMax(acc);
+	}
+
+	for (; index < length; index++) {
+		best = best < vec[index] ? vec[index] : best;
+	}
+	return best;
+}
+
+/**
+ *  @brief computes exp(vec - shift) and its sum in one pass
+ *
+ *  @param vec the array containing elements
+ *  @param out receives the exponentials (may alias vec, or be nullptr to only sum)
+ *  @param shift the value subtracted from every element first
+ *  @param length the size of the array
+ *  @return the sum of the exponentials
+ */
+template <typename T>
+static T expShiftSum(const T* vec, T* out, T shift, uint32_t length) {
+	typedef Simd<T> S;
+	const uint32_t width = S::WIDTH;
+	uint32_t index = 0;
+
+	const typename S::reg s = S::set1(shift);
+	typename S::reg acc = S::zero();
+	for (; index + width <= length; index += width) {
+		const typename S::reg e = expApprox<S>(S::sub(S::load(vec + index), s));
+		if (out) {
+			S::store(out + index, e);
+		}
+		acc = S::add(acc, e);
+	}
+	T total = S::reduceAdd(acc);
+
+	for (; index < length; index++) {
+		const T e = expApprox<ScalarOps<T> >(vec[index] - shift);
+		if (out) {
+			out[index] = e;
+		}
+		total += e;
+	}
+
+	return total;
+}
+
+/**
+ *  @brief finds the max and the sum of exp(vec - max) in one pass
+ *
+ *  The running sum is rescaled whenever the running max grows (the
+ *  online softmax normalizer), so the row is only streamed once. The
+ *  max of a block of registers is taken first (the block stays in L1)
+ *  so the rescale costs one exponential per block rather than one per
+ *  register, and each lane keeps its own max and sum until the end.
+ *  Single lane levels rescale only when an element raises the max.
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @param shift receives the max (the lowest finite value if there is none)
+ *  @return the sum of the exponentials
+ */
+template <typename T>
+static T maxExpSum(const T* vec, uint32_t length, T* shift) {
+	typedef Simd<T> S;
+	typedef ScalarOps<T> O;
+	const uint32_t width = S::WIDTH;
+	const uint32_t block = 8 * width;
+	uint32_t index = 0;
+
+	// starting from the lowest finite value keeps -infinity elements from producing inf - inf
+	T best = Limits<T>::lowest();
+	T total = T(0);
+
+	if (width > 1 && length >= width) {
+		typename S::reg m = S::set1(best);
+		typename S::reg s = S::zero();
+		while (index + width <= length) {
+			const uint32_t end = index + block <= length ? index + block : length - (length - index) % width;
+
+			typename S::reg next = m;
+			for (uint32_t i = index; i < end; i += width) {
+				next = S::max(next, S::load(vec + i));
+			}
+			s = S::mul(s, expApprox<S>(S::sub(m, next)));
+			for (; index < end; index += width) {
+				s = S::add(s, expApprox<S>(S::sub(S::load(vec + index), next)));
+			}
+			m = next;
+		}
+		best = S::reduceMax(m);
+		total = S::reduceAdd(S::mul(s, expApprox<S>(S::sub(m, S::set1(best)))));
+	}
+
+	for (; index < length; index++) {
+		if (vec[index] > best) {
+			total = total * expApprox<O>(best - vec[index]) + T(1);
+			best = vec[index];
+		}
+		else {
+			total += expApprox<O>(vec[index] - best);
+		}
+	}
+
+	*shift = best;
+	return total;
+}
+
+/**
+ *  @brief replaces every element with max(0, x)
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return void
+ */
+template <typename T>
+static void relu(T* vec, uint32_t length) {
+	typedef Simd<T> S;
+	const uint32_t width = S::WIDTH;
+	uint32_t index = 0;
+
+	for (; index + width <= length; index += width) {
+		S::store(vec + index, S::max(S::zero(), S::load(vec + index)));
+	}
+
+	for (; index < length; index++) {
+		vec[index] = vec[index] > T(0) ? vec[index] : T(0);
+	}
+}
+
+/**
+ *  @brief replaces every element with the logistic function 1 / (1 + e^-x)
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return void
+ */
+template <typename T>
+static void sigmoid(T* vec, uint32_t length) {
+	typedef Simd<T> S;
+	const uint32_t width = S::WIDTH;
+	uint32_t index = 0;
+
+	// e^-x underflows to 0 and overflows to infinity, giving exactly 1 and 0
+	const typename S::reg one = S::set1(T(1));
+	for (; index + width <= length; index += width) {
+		const typename S::reg e = expApprox<S>(S::sub(S::zero(), S::load(vec + index)));
+		S::store(vec + index, S::div(one, S::add(one, e)));
+	}
+
+	for (; index < length; index++) {
+		vec[index] = T(1) / (T(1) + expApprox<ScalarOps<T> >(-vec[index]));
+	}
+}
+
+/**
+ *  @brief widens bytes into elements with an affine map (e.g. pixels to network inputs)
+ *
+ *  @param src the bytes
+ *  @param dst receives src[i] * scale + offset
+ *  @param length the number of elements
+ *  @param scale the factor every byte is multiplied by
+ *  @param offset the value added after scaling
+ *  @return void
+ */
+template <typename T>
+static void normalize(const uint8_t* src, T* dst, size_t length, T scale, T offset) {
+	typedef Simd<T> S;
+	const size_t width = S::WIDTH;
+	const typename S::reg factor = S::set1(scale);
+	const typename S::reg shift = S::set1(offset);
+	size_t index = 0;
+
+	// four independent conversions per iteration keep the shuffle and convert ports busy
+	for (; index + 4 * width <= length; index += 4 * width) {
+		S::store(dst + index, S::fmadd(S::loadBytes(src + index), factor, shift));
+		S::store(dst + index + width, S::fmadd(S::loadBytes(src + index + width), factor, shift));
+		S::store(dst + index + 2 * width, S::fmadd(S::loadBytes(src + index + 2 * width), factor, shift));
+		S::store(dst + index + 3 * width, S::fmadd(S::loadBytes(src + index + 3 * width), factor, shift));
+	}
+	for (; index + width <= length; index += width) {
+		S::store(dst + index, S::fmadd(S::loadBytes(src + index), factor, shift));
+	}
+
+	for (; index < length; index++) {
+		dst[index] = ScalarOps<T>::fmadd(static_cast<T>(src[index]), scale, offset);
+	}
+}
+
+/**
+ *  @brief rounds floats to bfloat16 (nearest even, NaNs stay NaN)
+ *
+ *  @param src the floats
+ *  @param dst receives the bfloat16 values
+ *  @param length the number of elements
+ *  @return void
+ */
+static void toBF16(const float* src, BFloat16* dst, size_t length) {
+	size_t index = 0;
+#if defined(SIMD_AVX512)
+	const __m512i one = _mm512_set1_epi32(1);
+	const __m512i bias = _mm512_set1_epi32(0x7fff);
+	const __m512i quietBit = _mm512_set1_epi32(0x40);
+	const __m512i absMask = _mm512_set1_epi32(0x7fffffff);
+	const __m512i infinity = _mm512_set1_epi32(0x7f800000);
+	for (; index + 16 <= length; index += 16) {
+		const __m512i word = _mm512_loadu_si512(src + index);
+		const __m512i high = _mm512_srli_epi32(word, 16);
+		const __m512i rounded = _mm512_srli_epi32(_mm512_add_epi32(word, _mm512_add_epi32(bias, _mm512_and_si512(high, one))), 16);
+		const __mmask16 nan = _mm512_cmpgt_epi32_mask(_mm512_and_si512(word, absMask), infinity);
+		const __m512i bits = _mm512_mask_blend_epi32(nan, rounded, _mm512_or_si512(high, quietBit));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + index), _mm512_cvtepi32_epi16(bits));
+	}
+#elif defined(SIMD_AVX2)
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i bias = _mm256_set1_epi32(0x7fff);
+	const __m256i quietBit = _mm256_set1_epi32(0x40);
+	const __m256i absMask = _mm256_set1_epi32(0x7fffffff);
+	const __m256i infinity = _mm256_set1_epi32(0x7f800000);
+	for (; index + 8 <= length; index += 8) {
+		const __m256i word = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + index));
+		const __m256i high = _mm256_srli_epi32(word, 16);
+		const __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(word, _mm256_add_epi32(bias, _mm256_and_si256(high, one))), 16);
+		const __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(word, absMask), infinity);
+		const __m256i bits = _mm256_blendv_epi8(rounded, _mm256_or_si256(high, quietBit), nan);
+
+		// packus works within 128 bit lanes, so the permute brings the 8 results together
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(bits, bits), 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + index), _mm256_castsi256_si128(packed));
+	}
+#endif
+
+	// same rounding as BFloat16::fromFloat but branch free so the loop vectorizes
+	for (; index < length; index++) {
+		uint32_t word;
+		memcpy(&word, src + index, sizeof(word));
+		const uint32_t rounded = (word + 0x7fff + ((word >> 16) & 1)) >> 16;
+		const uint32_t quiet = (word >> 16) | 0x40;
+		dst[index].bits = static_cast<uint16_t>((word & 0x7fffffff) > 0x7f800000 ? quiet : rounded);
+	}
+}
+
+/**
+ *  @brief widens bfloat16 values to float (exact)
+ *
+ *  @param src the bfloat16 values
+ *  @param dst receives the floats
+ *  @param length the number of elements
+ *  @return void
+ */
+static void fromBF16(const BFloat16* src, float* dst, size_t length) {
+	size_t index = 0;
+#if defined(SIMD_AVX512)
+	for (; index + 16 <= length; index += 16) {
+		const __m512i bits = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + index)));
+		_mm512_storeu_si512(dst + index, _mm512_slli_epi32(bits, 16));
+	}
+#elif defined(SIMD_AVX2)
+	for (; index + 8 <= length; index += 8) {
+		const __m256i bits = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + index), _mm256_slli_epi32(bits, 16));
+	}
+#endif
+
+	for (; index < length; index++) {
+		const uint32_t word = static_cast<uint32_t>(src[index].bits) << 16;
+		memcpy(dst + index, &word, sizeof(word));
+	}
+}
+
+// gemm follows the usual packed layout: op(b) is copied in KC x NC blocks
+// made of NR wide column panels, op(a) in MC x KC blocks made of MR tall row
+// panels, and a register blocked micro kernel multiplies one MR x KC panel
+// by one KC x NR panel. The micro tile is MR rows by two vector registers.
+// Packing also converts the operands to the compute type C (the type of
+// c), which is how BFloat16 weights and activations end up accumulated in
+// float without the kernel knowing about them.
+#if defined(SIMD_AVX512) || defined(SIMD_AVX2)
+template <typename C>
+struct GemmTile {
+	static const uint32_t MR = 6;
+	static const uint32_t NR = 2 * Simd<C>::WIDTH;
+	static const uint32_t MC = 12 * MR;
+};
+#else
+template <typename C>
+struct GemmTile {
+	static const uint32_t MR = 4;
+	static const uint32_t NR = 4;
+	static const uint32_t MC = 12 * MR;
+};
+#endif
+static const uint32_t GEMM_KC = 256;
+static const uint32_t GEMM_NC = 2048;
+
+/**
+ *  @brief copies a contiguous run of elements into the compute type
+ *
+ *  @param src the elements
+ *  @param dst the destination
+ *  @param length the number of elements
+ *  @return void
+ */
+template <typename T>
+static inline void widen(const T* src, T* dst, uint32_t length) {
+	memcpy(dst, src, sizeof(T) * length);
+}
+
+static inline void widen(const BFloat16* src, float* dst, uint32_t length) {
+	fromBF16(src, dst, length);
+}
+
+/**
+ *  @brief copies an mc x kc block of op(a) into MR tall row panels (zero padded)
+ *
+ *  @param transA true if a is stored transposed
+ *  @param mc the number of rows in the block
+ *  @param kc the number of columns in the block
+ *  @param a the first element of the block in op(a)
+ *  @param lda the row stride of a
+ *  @param packed the destination
+ *  @return void
+ */
+template <typename TA, typename C>
+static void packA(bool transA, uint32_t mc, uint32_t kc, const TA* a, uint32_t lda, C* packed) {
+	const uint32_t MR = GemmTile<C>::MR;
+	for (uint32_t ir = 0; ir < mc; ir += MR) {
+		const uint32_t mr = mc - ir < MR ? mc - ir : MR;
+		for (uint32_t p = 0; p < kc; p++) {
+			for (uint32_t i = 0; i < mr; i++) {
+				packed[i] = static_cast<C>(transA ? a[static_cast<size_t>(p) * lda + ir + i] : a[static_cast<size_t>(ir + i) * lda + p]);
+			}
+			for (uint32_t i = mr; i < MR; i++) {
+				packed[i] = C(0);
+			}
+			packed += MR;
+		}
+	}
+}
+
+/**
+ *  @brief copies a kc x nc block of op(b) into NR wide column panels (zero padded)
+ *
+ *  @param transB true if b is stored transposed
+ *  @param kc the number of rows in the block
+ *  @param nc the number of columns in the block
+ *  @param b the first element of the block in op(b)
+ *  @param ldb the row stride of b
+ *  @param packed the destination
+ *  @return void
+ */
+template <typename TB, typename C>
+static void packB(bool transB, uint32_t kc, uint32_t nc, const TB* b, uint32_t ldb, C* packed) {
+	const uint32_t NR = GemmTile<C>::NR;
+	for (uint32_t jr = 0; jr < nc; jr += NR) {
+		const uint32_t nr = nc - jr < NR ? nc - jr : NR;
+		for (uint32_t p = 0; p < kc; p++) {
+			if (!transB && nr == NR) {
+				widen(b + static_cast<size_t>(p) * ldb + jr, packed, NR);
+			}
+			else {
+				for (uint32_t j = 0; j < nr; j++) {
+					packed[j] = static_cast<C>(transB ? b[static_cast<size_t>(jr + j) * ldb + p] : b[static_cast<size_t>(p) * ldb + jr + j]);
+				}
+				for (uint32_t j = nr; j < NR; j++) {
+					packed[j] = C(0);
+				}
+			}
+			packed += NR;
+		}
+	}
+}
+
+/**
+ *  @brief multiplies one packed row panel by one packed column panel into an MR x NR tile
+ *
+ *  @param kc the shared dimension
+ *  @param a the packed row panel
+ *  @param b the packed column panel
+ *  @param tile receives the MR x NR product (row stride NR)
+ *  @return void
+ */
+template <typename C>
+static void gemmKernel(uint32_t kc, const C* a, const C* b, C* tile) {
+	const uint32_t MR = GemmTile<C>::MR;
+	const uint32_t NR = GemmTile<C>::NR;
+#if defined(SIMD_AVX512) || defined(SIMD_AVX2)
+	typedef Simd<C> S;
+	const uint32_t W = S::WIDTH;
+	typename S::reg c00 = S::zero(), c01 = S::zero();
+	typename S::reg c10 = S::zero(), c11 = S::zero();
+	typename S::reg c20 = S::zero(), c21 = S::zero();
+	typename S::reg c30 = S::zero(), c31 = S::zero();
+	typename S::reg c40 = S::zero(), c41 = S::zero();
+	typename S::reg c50 = S::zero(), c51 = S::zero();
+	for (uint32_t p = 0; p < kc; p++, a += MR, b += NR) {
+		const typename S::reg b0 = S::loadAligned(b);
+		const typename S::reg b1 = S::loadAligned(b + W);
+		typename S::reg ai = S::set1(a[0]);
+		c00 = S::fmadd(ai, b0, c00); c01 = S::fmadd(ai, b1, c01);
+		ai = S::set1(a[1]);
+		c10 = S::fmadd(ai, b0, c10); c11 = S::fmadd(ai, b1, c11);
+		ai = S::set1(a[2]);
+		c20 = S::fmadd(ai, b0, c20); c21 = S::fmadd(ai, b1, c21);
+		ai = S::set1(a[3]);
+		c30 = S::fmadd(ai, b0, c30); c31 = S::fmadd(ai, b1, c31);
+		ai = S::set1(a[4]);
+		c40 = S::fmadd(ai, b0, c40); c41 = S::fmadd(ai, b1, c41);
+		ai = S::set1(a[5]);
+		c50 = S::fmadd(ai, b0, c50); c51 = S::fmadd(ai, b1, c51);
+	}
+	S::storeAligned(tile + 0 * NR, c00); S::storeAligned(tile + 0 * NR + W, c01);
+	S::storeAligned(tile + 1 * NR, c10); S::storeAligned(tile + 1 * NR + W, c11);
+	S::storeAligned(tile + 2 * NR, c20); S::storeAligned(tile + 2 * NR + W, c21);
+	S::storeAligned(tile + 3 * NR, c30); S::storeAligned(tile + 3 * NR + W, c31);
+	S::storeAligned(tile + 4 * NR, c40); S::storeAligned(tile + 4 * NR + W, c41);
+	S::storeAligned(tile + 5 * NR, c50); S::storeAligned(tile + 5 * NR + W, c51);
+#else
+	C acc[MR * NR] = { C(0) };
+	for (uint32_t p = 0; p < kc; p++, a += MR, b += NR) {
+		for (uint32_t i = 0; i < MR; i++) {
+			for (uint32_t j = 0; j < NR; j++) {
+				acc[i * NR + j] += a[i] * b[j];
+			}
+		}
+	}
+	memcpy(tile, acc, sizeof(acc));
+#endif
+}
+
+/**
+ *  @brief single threaded, cache blocked gemm that accumulates into c
+ *
+ *  @param transA true if a is stored as k x m
+ *  @param transB true if b is stored as n x k
+ *  @param m the number of rows of op(a) and c
+ *  @param n the number of columns of op(b) and c
+ *  @param k the number of columns of op(a) and rows of op(b)
+ *  @param alpha the scale applied to the product
+ *  @param a the left array
+ *  @param lda the row stride of a
+ *  @param b the right array
+ *  @param ldb the row stride of b
+ *  @param c the result array (already scaled by beta)
+ *  @param ldc the row stride of c
+ *  @return void
+ */
+template <typename TA, typename TB, typename TC>
+static void gemmBlocked(bool transA, bool transB, uint32_t m, uint32_t n, uint32_t k,
+	TC alpha, const TA* a, uint32_t lda, const TB* b, uint32_t ldb, TC* c, uint32_t ldc) {
+	const uint32_t MR = GemmTile<TC>::MR;
+	const uint32_t NR = GemmTile<TC>::NR;
+	const uint32_t MC = GemmTile<TC>::MC;
+
+	// the packing buffers are scratch space on the calling thread's arena
+	Arena& arena = Arena::getLocal();
+	Arena::Scope scope(arena);
+	TC* packedA = static_cast<TC*>(arena.allocate(sizeof(TC) * MC * GEMM_KC));
+	TC* packedB = static_cast<TC*>(arena.allocate(sizeof(TC) * GEMM_KC * GEMM_NC));
+	alignas(64) TC tile[MR * NR];
+
+	for (uint32_t jc = 0; jc < n; jc += GEMM_NC) {
+		const uint32_t nc = n - jc < GEMM_NC ? n - jc : GEMM_NC;
+
+		for (uint32_t pc = 0; pc < k; pc += GEMM_KC) {
+			const uint32_t kc = k - pc < GEMM_KC ? k - pc : GEMM_KC;
+			const TB* bBlock = transB ? b + static_cast<size_t>(jc) * ldb + pc : b + static_cast<size_t>(pc) * ldb + jc;
+			packB(transB, kc, nc, bBlock, ldb, packedB);
+
+			for (uint32_t ic = 0; ic < m; ic += MC) {
+				const uint32_t mc = m - ic < MC ? m - ic : MC;
+				const TA* aBlock = transA ? a + static_cast<size_t>(pc) * lda + ic : a + static_cast<size_t>(ic) * lda + pc;
+				packA(transA, mc, kc, aBlock, lda, packedA);
+
+				for (uint32_t jr = 0; jr < nc; jr += NR) {
+					const uint32_t nr = nc - jr < NR ? nc - jr : NR;
+					const TC* bPanel = packedB + static_cast<size_t>(jr) * kc;
+
+					for (uint32_t ir = 0; ir < mc; ir += MR) {
+						const uint32_t mr = mc - ir < MR ? mc - ir : MR;
+						gemmKernel(kc, packedA + static_cast<size_t>(ir) * kc, bPanel, tile);
+
+						// edge tiles only write the part that lies inside c
+						TC* cTile = c + static_cast<size_t>(ic + ir) * ldc + jc + jr;
+						for (uint32_t i = 0; i < mr; i++) {
+							axpy(alpha, tile + i * NR, cTile + static_cast<size_t>(i) * ldc, nr);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+// The int8 gemm packs b once into panels of Int8Tile::NR columns in which
+// every group of Int8Tile::GROUP consecutive k values of a column is stored
+// together, so one register of the panel holds a group for every column.
+// Every MR tall strip of a is packed into one 32 bit word per row and group,
+// so the micro kernel broadcasts a group of a row straight from memory and
+// multiplies it into a register of the panel, which sums the products of a
+// whole register of columns without any horizontal reduction. With VNNI,
+// vpdpbusd does groups of 4 bytes; otherwise both sides are widened to
+// int16 and vpmaddwd does pairs, since vpmaddubsw would saturate
+// 255 * 127 * 2 in int16. The AVX-512 level without VNNI has no 512 bit
+// byte or word instructions (those are AVX-512BW), so it runs the AVX2 one,
+// and the plain C++ level still uses the SSE2 every x86-64 host has.
+#if !defined(SIMD_AVX512) && !defined(SIMD_AVX2) && \
+	(defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define INT8_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(SIMD_VNNI)
+struct Int8Ops {
+	typedef __m512i reg;
+	static const uint32_t GROUP = 4;
+	static const uint32_t LANES = 16;
+
+	static reg zero(void) { return _mm512_setzero_si512(); }
+	static reg loadWeights(const int8_t* src) { return _mm512_loadu_si512(src); }
+	static reg broadcast(const uint32_t* word) { return _mm512_set1_epi32(static_cast<int32_t>(*word)); }
+	static reg dot(reg acc, reg a, reg b) { return _mm512_dpbusd_epi32(acc, a, b); }
+	static void store(int32_t* dst, reg val) { _mm512_store_si512(dst, val); }
+};
+#elif defined(SIMD_AVX512) || defined(SIMD_AVX2)
+struct Int8Ops {
+	typedef __m256i reg;
+	static const uint32_t GROUP = 2;
+	static const uint32_t LANES = 8;
+
+	static reg zero(void) { return _mm256_setzero_si256(); }
+	static reg loadWeights(const int8_t* src) { return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))); }
+	static reg broadcast(const uint32_t* word) { return _mm256_set1_epi32(static_cast<int32_t>(*word)); }
+	static reg dot(reg acc, reg a, reg b) { return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b)); }
+	static void store(int32_t* dst, reg val) { _mm256_store_si256(reinterpret_cast<__m256i*>(dst), val); }
+};
+#elif defined(INT8_SSE2)
+struct Int8Ops {
+	typedef __m128i reg;
+	static const uint32_t GROUP = 2;
+	static const uint32_t LANES = 4;
+
+	static reg zero(void) { return _mm_setzero_si128(); }
+	static reg broadcast(const uint32_t* word) { return _mm_set1_epi32(static_cast<int32_t>(*word)); }
+	static reg dot(reg acc, reg a, reg b) { return _mm_add_epi32(acc, _mm_madd_epi16(a, b)); }
+	static void store(int32_t* dst, reg val) { _mm_store_si128(reinterpret_cast<__m128i*>(dst), val); }
+
+	// SSE2 has no sign extension, so each byte goes to the high half of a word and is shifted down
+	static reg loadWeights(const int8_t* src) {
+		const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+		return _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+	}
+};
+#else
+struct Int8Ops {
+	static const uint32_t GROUP = 2;
+	static const uint32_t LANES = 4;
+};
+#endif
+
+#if defined(SIMD_AVX512) || defined(SIMD_AVX2) || defined(INT8_SSE2)
+struct Int8Tile {
+	static const uint32_t GROUP = Int8Ops::GROUP;
+	static const uint32_t MR = 6;
+	static const uint32_t NR = 2 * Int8Ops::LANES;
+};
+#else
+struct Int8Tile {
+	static const uint32_t GROUP = Int8Ops::GROUP;
+	static const uint32_t MR = 4;
+	static const uint32_t NR = 2 * Int8Ops::LANES;
+};
+#endif
+
+/**
+ *  @brief rearranges a signed byte matrix into the panels gemmU8S8 reads
+ *
+ *  @param n the number of rows of b
+ *  @param k the length of the rows of b
+ *  @param b the matrix (n x k)
+ *  @param ldb the row stride of b
+ *  @param packed receives the panels (the padding is zeroed)
+ *  @return void
+ */
+static void packS8(uint32_t n, uint32_t k, const int8_t* b, size_t ldb, int8_t* packed) {
+	const uint32_t GROUP = Int8Tile::GROUP;
+	const uint32_t NR = Int8Tile::NR;
+	const size_t groups = (k + GROUP - 1) / GROUP;
+	const size_t panelBytes = groups * NR * GROUP;
+	memset(packed, 0, panelBytes * ((n + NR - 1) / NR));
+
+	for (uint32_t j = 0; j < n; j++) {
+		int8_t* panel = packed + (j / NR) * panelBytes + (j % NR) * GROUP;
+		for (uint32_t p = 0; p < k; p++) {
+			panel[(p / GROUP) * NR * GROUP + p % GROUP] = b[j * ldb + p];
+		}
+	}
+}
+
+/**
+ *  @brief copies up to MR rows of unsigned bytes into one word per row and group
+ *
+ *  @param rows the number of rows (1 to MR, the missing ones repeat the first)
+ *  @param k the length of the rows (the missing values of the last group read as 0)
+ *  @param a the first row
+ *  @param lda the row stride of a
+ *  @param packed receives groups x MR words
+ *  @return void
+ */
+static void packU8(uint32_t rows, uint32_t k, const uint8_t* a, size_t lda, uint32_t* packed) {
+	const uint32_t GROUP = Int8Tile::GROUP;
+	const uint32_t MR = Int8Tile::MR;
+	const uint32_t full = k / GROUP;
+
+	for (uint32_t r = 0; r < MR; r++) {
+		const uint8_t* row = a + (r < rows ? r : 0) * lda;
+		uint32_t* words = packed + r;
+		uint32_t g = 0;
+		for (; g < full; g++, row += GROUP) {
+			// a group is 4 bytes as they are, or 2 bytes widened to the halves of a word
+			words[g * MR] = GROUP == 4 ?
+				static_cast<uint32_t>(row[0]) | (static_cast<uint32_t>(row[1]) << 8) | (static_cast<uint32_t>(row[2]) << 16) | (static_cast<uint32_t>(row[3]) << 24) :
+				static_cast<uint32_t>(row[0]) | (static_cast<uint32_t>(row[1]) << 16);
+		}
+		if (full * GROUP < k) {
+			uint32_t word = 0;
+			for (uint32_t i = 0; full * GROUP + i < k; i++) {
+				word |= static_cast<uint32_t>(row[i]) << (GROUP == 4 ? 8 * i : 16 * i);
+			}
+			words[g * MR] = word;
+		}
+	}
+}
+
+/**
+ *  @brief multiplies one packed strip of a by one packed panel of b into an MR x NR tile
+ *
+ *  @param groups the number of groups of k
+ *  @param a the packed strip
+ *  @param b the packed panel
+ *  @param tile receives the MR x NR sums (row stride NR)
+ *  @return void
+ */
+static void gemmU8S8Kernel(uint32_t groups, const uint32_t* a, const int8_t* b, int32_t* tile) {
+	const uint32_t MR = Int8Tile::MR;
+	const uint32_t NR = Int8Tile::NR;
+	const uint32_t GROUP = Int8Tile::GROUP;
+#if defined(SIMD_AVX512) || defined(SIMD_AVX2) || defined(INT8_SSE2)
+	typedef Int8Ops O;
+	const uint32_t L = O::LANES;
+	O::reg c00 = O::zero(), c01 = O::zero();
+	O::reg c10 = O::zero(), c11 = O::zero();
+	O::reg c20 = O::zero(), c21 = O::zero();
+	O::reg c30 = O::zero(), c31 = O::zero();
+	O::reg c40 = O::zero(), c41 = O::zero();
+	O::reg c50 = O::zero(), c51 = O::zero();
+	for (uint32_t g = 0; g < groups; g++, a += MR, b += NR * GROUP) {
+		const O::reg b0 = O::loadWeights(b);
+		const O::reg b1 = O::loadWeights(b + L * GROUP);
+		O::reg ai = O::broadcast(a + 0);
+		c00 = O::dot(c00, ai, b0); c01 = O::dot(c01, ai, b1);
+		ai = O::broadcast(a + 1);
+		c10 = O::dot(c10, ai, b0); c11 = O::dot(c11, ai, b1);
+		ai = O::broadcast(a + 2);
+		c20 = O::dot(c20, ai, b0); c21 = O::dot(c21, ai, b1);
+		ai = O::broadcast(a + 3);
+		c30 = O::dot(c30, ai, b0); c31 = O::dot(c31, ai, b1);
+		ai = O::broadcast(a + 4);
+		c40 = O::dot(c40, ai, b0); c41 = O::dot(c41, ai, b1);
+		ai = O::broadcast(a + 5);
+		c50 = O::dot(c50, ai, b0); c51 = O::dot(c51, ai, b1);
+	}
+	O::store(tile + 0 * NR, c00); O::store(tile + 0 * NR + L, c01);
+	O::store(tile + 1 * NR, c10); O::store(tile + 1 * NR + L, c11);
+	O::store(tile + 2 * NR, c20); O::store(tile + 2 * NR + L, c21);
+	O::store(tile + 3 * NR, c30); O::store(tile + 3 * NR + L, c31);
+	O::store(tile + 4 * NR, c40); O::store(tile + 4 * NR + L, c41);
+	O::store(tile + 5 * NR, c50); O::store(tile + 5 * NR + L, c51);
+#else
+	int32_t acc[MR * NR] = { 0 };
+	for (uint32_t g = 0; g < groups; g++, a += MR, b += NR * GROUP) {
+		for (uint32_t i = 0; i < MR; i++) {
+			const int16_t low = static_cast<int16_t>(a[i] & 0xffff);
+			const int16_t high = static_cast<int16_t>(a[i] >> 16);
+			for (uint32_t j = 0; j < NR; j++) {
+				acc[i * NR + j] += low * b[j * GROUP] + high * b[j * GROUP + 1];
+			}
+		}
+	}
+	memcpy(tile, acc, sizeof(acc));
+#endif
+}
+
+/**
+ *  @brief single threaded gemm of unsigned bytes by packed signed bytes into int32
+ *
+ *  @param m the number of rows of a and c
+ *  @param n the number of rows of b and columns of c
+ *  @param k the length of the rows of a and b
+ *  @param a the unsigned array (m x k)
+ *  @param lda the row stride of a
+ *  @param packed b (n x k) as written by packS8
+ *  @param c the result (m x n, overwritten)
+ *  @param ldc the row stride of c
+ *  @return void
+ */
+static void gemmU8S8(uint32_t m, uint32_t n, uint32_t k, const uint8_t* a, size_t lda,
+	const int8_t* packed, int32_t* c, size_t ldc) {
+	const uint32_t MR = Int8Tile::MR;
+	const uint32_t NR = Int8Tile::NR;
+	const uint32_t GROUP = Int8Tile::GROUP;
+	const uint32_t groups = (k + GROUP - 1) / GROUP;
+	const size_t panelBytes = static_cast<size_t>(groups) * NR * GROUP;
+
+	// one strip of a is packed at a time and reused by every panel of b
+	Arena& arena = Arena::getLocal();
+	Arena::Scope scope(arena);
+	uint32_t* strip = static_cast<uint32_t*>(arena.allocate(sizeof(uint32_t) * groups * MR));
+	alignas(64) int32_t tile[MR * NR];
+
+	for (uint32_t i = 0; i < m; i += MR) {
+		const uint32_t rows = m - i < MR ? m - i : MR;
+		packU8(rows, k, a + i * lda, lda, strip);
+
+		for (uint32_t j = 0; j < n; j += NR) {
+			const uint32_t cols = n - j < NR ? n - j : NR;
+			gemmU8S8Kernel(groups, strip, packed + (j / NR) * panelBytes, tile);
+			for (uint32_t r = 0; r < rows; r++) {
+				memcpy(c + (i + r) * ldc + j, tile + r * NR, sizeof(int32_t) * cols);
+			}
+		}
+	}
+}
+
+/**
+ *  @brief bilinear interpolation at arbitrary positions
+ *
+ *  @param padded the image with a one pixel border on every side
+ *  @param paddedWidth the width of padded (the image width + 2)
+ *  @param x the column of every position (in [-1, width - 1) of the unpadded image)
+ *  @param y the row of every position (in [-1, height - 1) of the unpadded image)
+ *  @param out receives the interpolated values
+ *  @param count the number of positions
+ *  @return void
+ */
+static void bilinear(const float* padded, uint32_t paddedWidth, const float* x, const float* y, float* out, size_t count) {
+	size_t i = 0;
+#if defined(SIMD_AVX512)
+	const __m512i stride = _mm512_set1_epi32(static_cast<int32_t>(paddedWidth));
+	const __m512i one = _mm512_set1_epi32(1);
+	for (; i + 16 <= count; i += 16) {
+		const __m512 px = _mm512_loadu_ps(x + i);
+		const __m512 py = _mm512_loadu_ps(y + i);
+		const __m512 x0 = _mm512_roundscale_ps(px, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+		const __m512 y0 = _mm512_roundscale_ps(py, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+		const __m512 fx = _mm512_sub_ps(px, x0);
+		const __m512 fy = _mm512_sub_ps(py, y0);
+
+		// the border shifts every index by one row and one column
+		const __m512i column = _mm512_add_epi32(_mm512_cvttps_epi32(x0), one);
+		const __m512i row = _mm512_add_epi32(_mm512_cvttps_epi32(y0), one);
+		const __m512i index = _mm512_add_epi32(_mm512_mullo_epi32(row, stride), column);
+
+		const __m512 p00 = _mm512_i32gather_ps(index, padded, 4);
+		const __m512 p01 = _mm512_i32gather_ps(_mm512_add_epi32(index, one), padded, 4);
+		const __m512 p10 = _mm512_i32gather_ps(_mm512_add_epi32(index, stride), padded, 4);
+		const __m512 p11 = _mm512_i32gather_ps(_mm512_add_epi32(_mm512_add_epi32(index, stride), one), padded, 4);
+
+		const __m512 top = _mm512_fmadd_ps(fx, _mm512_sub_ps(p01, p00), p00);
+		const __m512 bottom = _mm512_fmadd_ps(fx, _mm512_sub_ps(p11, p10), p10);
+		_mm512_storeu_ps(out + i, _mm512_fmadd_ps(fy, _mm512_sub_ps(bottom, top), top));
+	}
+#elif defined(SIMD_AVX2)
+	const __m256i stride = _mm256_set1_epi32(static_cast<int32_t>(paddedWidth));
+	const __m256i one = _mm256_set1_epi32(1);
+	for (; i + 8 <= count; i += 8) {
+		const __m256 px = _mm256_loadu_ps(x + i);
+		const __m256 py = _mm256_loadu_ps(y + i);
+		const __m256 x0 = _mm256_floor_ps(px);
+		const __m256 y0 = _mm256_floor_ps(py);
+		const __m256 fx = _mm256_sub_ps(px, x0);
+		const __m256 fy = _mm256_sub_ps(py, y0);
+
+		// the border shifts every index by one row and one column
+		const __m256i column = _mm256_add_epi32(_mm256_cvttps_epi32(x0), one);
+		const __m256i row = _mm256_add_epi32(_mm256_cvttps_epi32(y0), one);
+		const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(row, stride), column);
+
+		const __m256 p00 = _mm256_i32gather_ps(padded, index, 4);
+		const __m256 p01 = _mm256_i32gather_ps(padded, _mm256_add_epi32(index, one), 4);
+		const __m256 p10 = _mm256_i32gather_ps(padded, _mm256_add_epi32(index, stride), 4);
+		const __m256 p11 = _mm256_i32gather_ps(padded, _mm256_add_epi32(_mm256_add_epi32(index, stride), one), 4);
+
+		const __m256 top = _mm256_fmadd_ps(fx, _mm256_sub_ps(p01, p00), p00);
+		const __m256 bottom = _mm256_fmadd_ps(fx, _mm256_sub_ps(p11, p10), p10);
+		_mm256_storeu_ps(out + i, _mm256_fmadd_ps(fy, _mm256_sub_ps(bottom, top), top));
+	}
+#endif
+	for (; i < count; i++) {
+		const float x0 = std::floor(x[i]);
+		const float y0 = std::floor(y[i]);
+		const float fx = x[i] - x0;
+		const float fy = y[i] - y0;
+		const float* p = padded + (static_cast<int32_t>(y0) + 1) * static_cast<int32_t>(paddedWidth) + static_cast<int32_t>(x0) + 1;
+
+		const float top = p[0] + fx * (p[1] - p[0]);
+		const float bottom = p[paddedWidth] + fx * (p[paddedWidth + 1] - p[paddedWidth]);
+		out[i] = top + fy * (bottom - top);
+	}
+}
+
+/**
+ *  @brief points the kernels of one element type at this level's versions
+ *
+ *  @param set the kernels to fill
+ *  @return void
+ */
+template <typename T>
+static void fillSet(KernelSet<T>& set) {
+	set.dot = dot<T>;
+	set.axpy = axpy<T>;
+	set.scale = scale<T>;
+	set.sum = sum<T>;
+	set.max = max<T>;
+	set.expShiftSum = expShiftSum<T>;
+	set.maxExpSum = maxExpSum<T>;
+	set.relu = relu<T>;
+	set.sigmoid = sigmoid<T>;
+	set.normalize = normalize<T>;
+	set.gemm = gemmBlocked<T, T, T>;
+	set.gemmRows = GemmTile<T>::MR;
+	set.gemmCols = GemmTile<T>::NR;
+}
+
+/**
+ *  @brief points a table at this level's kernels
+ *
+ *  @param table the table to fill
+ *  @param isa the level this translation unit was built for
+ *  @return void
+ */
+static void fillTable(KernelTable& table, Isa isa) {
+	table.isa = isa;
+	fillSet(table.f32);
+	fillSet(table.f64);
+	table.gemmBF16F32 = gemmBlocked<BFloat16, float, float>;
+	table.gemmF32BF16 = gemmBlocked<float, BFloat16, float>;
+	table.gemmBF16BF16 = gemmBlocked<BFloat16, BFloat16, float>;
+	table.s8.packS8 = packS8;
+	table.s8.gemmU8S8 = gemmU8S8;
+	table.s8.group = Int8Tile::GROUP;
+	table.s8.cols = Int8Tile::NR;
+	table.s8.rows = Int8Tile::MR;
+	table.toBF16 = toBF16;
+	table.fromBF16 = fromBF16;
+	table.bilinear = bilinear;
+}
+
+} // namespace SIMD_NAMESPACE
+
+#if defined(SIMD_AVX512) && defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // !KERNEL_VARIANTS_H
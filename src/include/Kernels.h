@@ -0,0 +1,179 @@
+/**
+ *  @file    Kernels.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief picks the MathUtils kernels for the instruction set of the host
+ *
+ *  @section DESCRIPTION
+ *
+ *  The array kernels, the gemms and the bfloat16 conversions of
+ *  MathUtils and the sampler of Augmenter are built once per
+ *  instruction set level (plain C++, AVX2 with FMA, AVX-512, and
+ *  AVX-512 with the VNNI byte dot products), each into a table of
+ *  function pointers. The first kernel call asks CPUID what the host
+ *  supports and keeps the table of the best level for the rest of the
+ *  run, so one binary runs everywhere and still uses the wide
+ *  registers where they exist.
+ *
+ *  Everything outside these tables is built for the baseline target of
+ *  the project (SSE2 on x64), because the compiler may use the target's
+ *  instructions anywhere in a file. That fixes the Expression loops,
+ *  which are instantiated wherever an expression is assigned, and the
+ *  double and float conversions at build time.
+ *
+ *  The NNF_ISA environment variable (scalar, avx2, avx512 or
+ *  avx512vnni) forces a lower level, e.g. to compare results or
+ *  timings between paths, and verify() checks every level the host
+ *  can run against the plain C++ one.
+ *
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+// cpp
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+
+#include "BFloat16.h"
+
+using namespace std;
+
+/**
+ *  @brief The instruction set levels the kernels are built for
+ */
+enum class Isa : uint8_t {
+	SCALAR, // plain C++ (whatever the compiler makes of it for the baseline target)
+	AVX2, // AVX2 and FMA
+	AVX512, // AVX-512 foundation
+	AVX512VNNI // AVX-512 foundation, BW and VNNI (byte dot products for the int8 gemm)
+};
+
+// the number of levels
+static const uint32_t ISA_LEVELS = 4;
+
+// the signature of a blocked single threaded gemm that accumulates alpha * op(a) * op(b) into c
+template <typename TA, typename TB, typename TC>
+using GemmFunction = void (*)(bool transA, bool transB, uint32_t m, uint32_t n, uint32_t k,
+	TC alpha, const TA* a, uint32_t lda, const TB* b, uint32_t ldb, TC* c, uint32_t ldc);
+
+/**
+ *  @brief Struct that holds the kernels of one element type at one level
+ */
+template <typename T>
+struct KernelSet {
+	T (*dot)(const T* vec1, const T* vec2, uint32_t length);
+	void (*axpy)(T alpha, const T* vec1, T* vec2, uint32_t length);
+	void (*scale)(T alpha, T* vec, uint32_t length);
+	T (*sum)(const T* vec, uint32_t length);
+	T (*max)(const T* vec, uint32_t length);
+	T (*expShiftSum)(const T* vec, T* out, T shift, uint32_t length);
+	T (*maxExpSum)(const T* vec, uint32_t length, T* shift);
+	void (*relu)(T* vec, uint32_t length);
+	void (*sigmoid)(T* vec, uint32_t length);
+	void (*normalize)(const uint8_t* src, T* dst, size_t length, T scale, T offset);
+	GemmFunction<T, T, T> gemm;
+	uint32_t gemmRows; // the rows of the gemm micro tile (slices of m are multiples of it)
+	uint32_t gemmCols; // the columns of the gemm micro tile (slices of n are multiples of it)
+};
+
+// the signature of a single threaded gemm that multiplies m rows of unsigned bytes by
+// n rows of signed bytes packed with the same level's packS8 into c (int32, exact)
+using GemmU8S8Function = void (*)(uint32_t m, uint32_t n, uint32_t k, const uint8_t* a, size_t lda,
+	const int8_t* packed, int32_t* c, size_t ldc);
+
+/**
+ *  @brief Struct that holds the int8 kernels of one level and the layout they share
+ */
+struct Int8KernelSet {
+	void (*packS8)(uint32_t n, uint32_t k, const int8_t* b, size_t ldb, int8_t* packed);
+	GemmU8S8Function gemmU8S8;
+	uint32_t group; // the consecutive k values of a column stored together in a packed panel
+	uint32_t cols; // the columns of a packed panel
+	uint32_t rows; // the rows of the gemm micro tile (slices of m are multiples of it)
+};
+
+/**
+ *  @brief Struct that holds every kernel built for one level
+ */
+struct KernelTable {
+	Isa isa = Isa::SCALAR; // the level the kernels were built for
+	KernelSet<float> f32; // the float kernels
+	KernelSet<double> f64; // the double kernels
+	GemmFunction<BFloat16, float, float> gemmBF16F32; // bfloat16 a, float b
+	GemmFunction<float, BFloat16, float> gemmF32BF16; // float a, bfloat16 b
+	GemmFunction<BFloat16, BFloat16, float> gemmBF16BF16; // bfloat16 a and b
+	Int8KernelSet s8; // the int8 gemm and its packing
+	void (*toBF16)(const float* src, BFloat16* dst, size_t length); // rounds to nearest even
+	void (*fromBF16)(const BFloat16* src, float* dst, size_t length); // widens (exact)
+
+	// reads padded (a float image with a one pixel border) at every (x[i], y[i]) with
+	// bilinear interpolation into out (the sampler of Augmenter)
+	void (*bilinear)(const float* padded, uint32_t paddedWidth, const float* x, const float* y, float* out, size_t count);
+
+	// returns the kernels of one element type
+	template <typename T>
+	const KernelSet<T>& get() const;
+
+	// returns the gemm of one combination of operand types
+	template <typename TA, typename TB, typename TC>
+	GemmFunction<TA, TB, TC> getGemm() const;
+};
+
+template <> inline const KernelSet<float>& KernelTable::get<float>() const { return f32; }
+template <> inline const KernelSet<double>& KernelTable::get<double>() const { return f64; }
+
+template <> inline GemmFunction<float, float, float> KernelTable::getGemm<float, float, float>() const { return f32.gemm; }
+template <> inline GemmFunction<double, double, double> KernelTable::getGemm<double, double, double>() const { return f64.gemm; }
+template <> inline GemmFunction<BFloat16, float, float> KernelTable::getGemm<BFloat16, float, float>() const { return gemmBF16F32; }
+template <> inline GemmFunction<float, BFloat16, float> KernelTable::getGemm<float, BFloat16, float>() const { return gemmF32BF16; }
+template <> inline GemmFunction<BFloat16, BFloat16, float> KernelTable::getGemm<BFloat16, BFloat16, float>() const { return gemmBF16BF16; }
+
+/**
+ *  @brief Class that detects the instruction set and hands out the matching kernels
+ */
+class Kernels {
+private:
+	// static methods that fill a table with the kernels of one level, defined in the
+	// translation unit built for it (Note: return false if the level is not built)
+	static bool fillScalar(KernelTable& table);
+	static bool fillAvx2(KernelTable& table);
+	static bool fillAvx512(KernelTable& table);
+	static bool fillAvx512Vnni(KernelTable& table);
+
+	// static method that picks the level on first use
+	static const KernelTable& select(void);
+
+public:
+	// static method that returns the kernels of the selected level
+	static const KernelTable& get(void) {
+		static const KernelTable& table = select();
+		return table;
+	}
+
+	// static method that returns the highest level the host can run
+	static Isa detect(void);
+
+	// static method that returns the selected level
+	static Isa getIsa(void);
+
+	// static method that returns the kernels of a level, or nullptr if the host
+	// cannot run it or it was not built
+	static const KernelTable* getTable(Isa isa);
+
+	// static method that returns the name NNF_ISA uses for a level
+	static const char* getName(Isa isa);
+
+	// static method that reads a level from its name (Note: returns false if unknown)
+	static bool parse(const char* name, Isa& isa);
+
+	// static method that runs every kernel of every level the host supports on random
+	// inputs, compares them with the plain C++ level and prints one line per level
+	// (Note: returns true if they all agree)
+	static bool verify(ostream& out);
+};
+
+#endif // !KERNELS_H
@@ -25,13 +25,16 @@
 
 
 #include "ImageData.h"
+#include "Dataset.h"
+#include "MappedFile.h"
+#include "IDXReader.h"
 
 using namespace std;
 
 /**
  *  @brief Class that extends exception and used for specific error handling here
  */
-class MNISTParserException : std::exception {
+class MNISTParserException : public std::exception {
 private:
 	string message; // The error message
 
@@ -49,18 +52,53 @@ public:
 */
 class MNISTParser {
 public:
-	// static method that parses a MNIST image file
+	// static method that parses a MNIST image file (Note: returns no images if the file is
+	// truncated or corrupt)
 	static vector<ImageData*> parseImageFile(string name);
 	
-	// static method that parses a MNIST label file
+	// static method that parses a MNIST label file (Note: leaves the images untouched if the
+	// file is truncated or corrupt)
 	static void parseLabelFile(vector<ImageData*>& images, string name);
 
+	// static method that parses a MNIST image file straight into a dataset
+	static void parseImageFile(Dataset& dataset, string name);
+
+	// static method that parses a MNIST image file into normalized features while it
+	// reads it (Note: with FEATURES storage the raw pixels are never kept)
+	static void parseImageFile(Dataset& dataset, string name, const Normalization& normalization,
+		DatasetStorage storage = DatasetStorage::FEATURES);
+
+	// static method that parses a MNIST label file straight into a dataset (Note: the file
+	// must hold one label per image)
+	static void parseLabelFile(Dataset& dataset, string name);
+
+	// static method that returns views into a mapped MNIST image file
+	// (Note: the mapped file must outlive the returned images)
+	static vector<ImageData> mapImageFile(const MappedFile& file);
+
+	// static method that assigns labels from a mapped MNIST label file
+	static void mapLabelFile(vector<ImageData>& images, const MappedFile& file);
+
+	// magic numbers found at the start of MNIST files
+	static const uint32_t IMAGE_MAGIC = 0x00000803;
+	static const uint32_t LABEL_MAGIC = 0x00000801;
+
+	// header sizes in bytes
+	static const uint32_t IMAGE_HEADER_SIZE = 16;
+	static const uint32_t LABEL_HEADER_SIZE = 8;
+
 private:
 	// static helper method that converts 4 bytes into a uint32_t
 	static uint32_t convertToUInt(const char* data);
 	
-	// static helper method that checks if the file is opened or empty
-	static void validateStream(ifstream& in, string name);
+	// static helper method that checks if the IDX file holds MNIST images
+	static void validateImageReader(const IDXReader& reader, string name);
+
+	// static helper method that checks if the IDX file holds MNIST labels
+	static void validateLabelReader(const IDXReader& reader, string name);
+
+	// static helper method that deletes every image of a vector and empties it
+	static void deleteImages(vector<ImageData*>& images);
 };
 
 #endif // !MNIST_PARSER_H
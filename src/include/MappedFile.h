@@ -0,0 +1,105 @@
+/**
+ *  @file    MappedFile.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief memory mapping of a whole file
+ *
+ *  @section DESCRIPTION
+ *
+ *  This class maps a file into the address space once so that
+ *  callers can hand out pointers into it instead of copying the
+ *  contents onto the heap. The mapping is shared, so several
+ *  processes reading the same file share the page cache.
+ *
+ *  A copy-on-write mapping can also be written to: the pages start
+ *  out shared, a page that gets written becomes a private copy of this
+ *  process, and the file itself never changes.
+ *
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// cpp
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+
+using namespace std;
+
+/**
+ *  @brief Class that extends exception and used for specific error handling here
+ */
+class MappedFileException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	MappedFileException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief The ways a MappedFile can map a file
+ */
+enum class MappedFileMode : uint8_t {
+	READ, // read-only pages shared with every process mapping the file
+	COPY_ON_WRITE // writable pages that are copied privately on the first write
+};
+
+/**
+ *  @brief Class that owns a mapping of a file
+ */
+class MappedFile {
+private:
+	uint8_t* data = nullptr; // the first byte of the mapping
+	MappedFileMode mode = MappedFileMode::READ; // how the file is mapped
+	size_t size = 0; // the size of the mapping in bytes
+	void* fileHandle = nullptr; // the OS file handle (Windows only)
+	void* mappingHandle = nullptr; // the OS mapping handle (Windows only)
+
+	// releases the mapping and any handles
+	void close(void);
+
+public:
+	// Empty constructor (Note: use open to map a file afterwards)
+	MappedFile(void);
+
+	// Constructor that maps the whole file (Note: throws on failure)
+	MappedFile(string name, MappedFileMode mode = MappedFileMode::READ);
+
+	// Destructor
+	~MappedFile(void);
+
+	// A mapping is owned by exactly one object
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// maps the whole file, replacing any previous mapping
+	void open(string name, MappedFileMode mode = MappedFileMode::READ);
+
+	// returns a pointer to the first byte of the mapping
+	const uint8_t* getData() const;
+
+	// returns a writable pointer to the first byte of the mapping (Note: nullptr unless the
+	// mapping is copy-on-write)
+	uint8_t* getWritableData();
+
+	// returns how the file is mapped
+	MappedFileMode getMode() const;
+
+	// returns the size of the mapping in bytes
+	size_t getSize() const;
+
+	// returns true if a file is currently mapped
+	bool isOpen() const;
+};
+
+#endif // !MAPPED_FILE_H
@@ -21,29 +21,207 @@
 #include <random>
 #include <chrono>
 #include <cmath>
+#include <atomic>
+
+#include "Matrix.h"
+#include "Arena.h"
 
 using namespace std;
 
+// wraps T so that arguments of that type do not take part in template
+// argument deduction (e.g. a double literal alpha passed with float arrays)
+template <typename T>
+struct NonDeduced {
+	typedef T type;
+};
+
 /**
  *  @brief Class that handles some numpy math functions
+ *
+ *  The array kernels are templates over the element type and are
+ *  built for float and double. bfloat16 is a storage format only:
+ *  gemm reads BFloat16 operands and accumulates in float, and the
+ *  convert kernels move data between the formats.
  */
 class MathUtils {
 public:
 	// static method for generating random data from a normal distribution with a mean
-	// of 0 and a variance of 1
+	// of 0 and a variance of 1 (Note: each call continues the stream set by setSeed;
+	// the caller frees the result with delete[])
 	static double* randn(const uint32_t rows, const uint32_t cols);
+
+	// static method for generating normal random data from an explicit seed (Note: the
+	// caller frees the result with delete[])
+	static double* randn(const uint32_t rows, const uint32_t cols, const uint64_t seed);
+
+	// the same two methods allocating from an arena (Note: the result lives until the
+	// arena is reset, so nothing has to be freed)
+	static double* randn(Arena& arena, const uint32_t rows, const uint32_t cols);
+	static double* randn(Arena& arena, const uint32_t rows, const uint32_t cols, const uint64_t seed);
+
+	// static method that fills a matrix with normal random data from an explicit seed
+	template <typename T>
+	static void randn(BasicMatrix<T>& mat, const uint64_t seed);
+
+	// static method that writes elements offset .. offset + length - 1 of the normal
+	// stream for seed (Note: the result never depends on the number of threads)
+	template <typename T>
+	static void fillNormal(T* vec, const size_t length, const uint64_t seed, const uint64_t offset = 0);
+
+	// static method that restarts the stream used by randn(rows, cols)
+	static void setSeed(const uint64_t seed);
 	
 	// static method that computes the dot product of 2 matrices
-	static double dot(const double* vec1, const double* vec2, const uint32_t length);
+	template <typename T>
+	static T dot(const T* vec1, const T* vec2, const uint32_t length);
+
+	// static method that computes vec2 = alpha * vec1 + vec2
+	template <typename T>
+	static void axpy(const typename NonDeduced<T>::type alpha, const T* vec1, T* vec2, const uint32_t length);
 
-	// static method that returns a matrix of zeroes
+	// static method that multiplies every element by alpha in place
+	template <typename T>
+	static T* scale(const typename NonDeduced<T>::type alpha, T* vec, const uint32_t length);
+
+	// static method that returns the sum of the elements
+	template <typename T>
+	static T sum(const T* vec, const uint32_t length);
+
+	// static method that returns the euclidean norm of the array
+	template <typename T>
+	static T norm(const T* vec, const uint32_t length);
+
+	// static method that returns a matrix of zeroes (Note: the caller frees the result
+	// with delete[])
 	static double* zeroes(const uint32_t rows, const uint32_t cols);
 
-	// static method that finds the max value in the array
-	static double argmax(const double* vec, const uint32_t length);
+	// static method that returns a matrix of zeroes that lives until the arena is reset
+	static double* zeroes(Arena& arena, const uint32_t rows, const uint32_t cols);
+
+	// static method that finds the max value in the array (Note: -infinity if it is empty)
+	template <typename T>
+	static T max(const T* vec, const uint32_t length);
+
+	// static method that finds the index of the max value in the array (first one on ties)
+	template <typename T>
+	static uint32_t argmax(const T* vec, const uint32_t length);
+
+	// static method that writes the index of the max value of every row
+	template <typename T>
+	static void argmax(const BasicMatrix<T>& mat, uint32_t* indices);
 
 	// static method that returns an array with the exponential for each element
-	static double* exp(double* vec, const uint32_t length);
+	// (Note: vectorized approximation within 2 ulp of std::exp; zero below -708
+	// for double and below -86.5 for float)
+	template <typename T>
+	static T* exp(T* vec, const uint32_t length);
+
+	// static method that replaces every element with max(0, x)
+	template <typename T>
+	static T* relu(T* vec, const uint32_t length);
+
+	// static method that replaces every element with the logistic function 1 / (1 + e^-x)
+	template <typename T>
+	static T* sigmoid(T* vec, const uint32_t length);
+
+	// static method that widens bytes to elements as dst = src * scale + offset
+	// (Note: used to turn pixels into network inputs)
+	template <typename T>
+	static void normalize(const uint8_t* src, T* dst, const size_t length,
+		const typename NonDeduced<T>::type scale, const typename NonDeduced<T>::type offset = 0);
+
+	// static method that writes the max value of every row
+	template <typename T>
+	static void rowMax(const BasicMatrix<T>& mat, T* maxima);
+
+	// static method that writes log(sum(exp(row))) of every row without overflowing
+	template <typename T>
+	static void logSumExp(const BasicMatrix<T>& mat, T* results);
+
+	// static method that replaces every row with its softmax
+	template <typename T>
+	static void softmax(BasicMatrix<T>& mat);
+
+	// static method that replaces every row with its log softmax
+	template <typename T>
+	static void logSoftmax(BasicMatrix<T>& mat);
+
+	// static method that returns the mean cross entropy of softmax(logits) against the
+	// labels and writes its gradient with respect to the logits
+	template <typename T>
+	static T crossEntropy(const BasicMatrix<T>& logits, const uint8_t* labels, BasicMatrix<T>& gradient);
+
+	// static method that computes c = alpha * op(a) * op(b) + beta * c where op
+	// optionally transposes its argument (Note: c is resized if its shape is wrong)
+	// (Note: TA, TB and TC are all double or all float, except that a and b may
+	// also be BFloat16 when c is float)
+	template <typename TA, typename TB, typename TC>
+	static void gemm(const BasicMatrix<TA>& a, bool transA, const BasicMatrix<TB>& b, bool transB, BasicMatrix<TC>& c,
+		const typename NonDeduced<TC>::type alpha = 1, const typename NonDeduced<TC>::type beta = 0);
+
+	// static method that computes c = alpha * op(a) * op(b) + beta * c on row major
+	// arrays where op(a) is m x k, op(b) is k x n and ld* are the row strides
+	template <typename TA, typename TB, typename TC>
+	static void gemm(bool transA, bool transB, const uint32_t m, const uint32_t n, const uint32_t k,
+		const typename NonDeduced<TC>::type alpha, const TA* a, const uint32_t lda, const TB* b, const uint32_t ldb,
+		const typename NonDeduced<TC>::type beta, TC* c, const uint32_t ldc);
+
+	// static method that returns the bytes packS8 needs for an n x k signed byte matrix
+	static size_t getPackedS8Size(const uint32_t n, const uint32_t k);
+
+	// static method that rearranges an n x k signed byte matrix into the panels
+	// gemmU8S8 reads (Note: the layout belongs to the selected kernel level)
+	static void packS8(const uint32_t n, const uint32_t k, const int8_t* b, const size_t ldb, int8_t* packed);
+
+	// static method that computes c = a * b^T exactly on integers, where a is m x k
+	// unsigned bytes with any row stride, b is n x k signed bytes packed by packS8
+	// and c is m x n (Note: products are accumulated in int32 without saturation)
+	static void gemmU8S8(const uint32_t m, const uint32_t n, const uint32_t k, const uint8_t* a, const size_t lda,
+		const int8_t* packed, int32_t* c, const size_t ldc);
+
+	// static methods that convert length elements between precisions
+	// (Note: narrowing rounds to nearest even)
+	static void convert(const float* src, BFloat16* dst, const size_t length);
+	static void convert(const BFloat16* src, float* dst, const size_t length);
+	static void convert(const double* src, float* dst, const size_t length);
+	static void convert(const float* src, double* dst, const size_t length);
+
+	// static method that converts a whole matrix (Note: dst is resized if its shape is wrong)
+	template <typename From, typename To>
+	static void convert(const BasicMatrix<From>& src, BasicMatrix<To>& dst);
+
+	// static method that sets how many threads gemm and randn may use (0 means all of the
+	// shared ThreadPool)
+	static void setNumThreads(const uint32_t numThreads);
+
+	// static method that returns how many threads gemm and randn may use
+	static uint32_t getNumThreads();
+
+	// the seed randn(rows, cols) starts from until setSeed is called
+	static const uint64_t DEFAULT_SEED = 0x4E4E46756E;
+
+private:
+	// writes out = exp(vec - shift) (skipped if out is nullptr) and returns the sum
+	template <typename T>
+	static T expShiftSum(const T* vec, T* out, const T shift, const uint32_t length);
+
+	// returns the sum of exp(vec - max) and writes the max to shift, reading vec once
+	template <typename T>
+	static T maxExpSum(const T* vec, const uint32_t length, T& shift);
+
+	// splits [0, count) into up to threads contiguous slices and runs body(begin, end)
+	// on each through the shared ThreadPool (the calling thread runs the first slice)
+	template <typename Body>
+	static void parallelFor(const uint64_t count, uint32_t threads, const Body& body);
+
+	// the number of threads gemm may use
+	static uint32_t numThreads;
+
+	// the seed of the stream used by randn(rows, cols)
+	static uint64_t streamSeed;
+
+	// the next unused position in that stream
+	static atomic<uint64_t> streamPosition;
 };
 
 #endif // !MATH_UTILS_H
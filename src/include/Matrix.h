@@ -0,0 +1,116 @@
+/**
+ *  @file    Matrix.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief an owning, cache line aligned, row major matrix
+ *
+ *  @section DESCRIPTION
+ *
+ *  This container replaces the bare double pointer plus rows and
+ *  cols that MathUtils used to pass around. The elements live in one
+ *  64 byte aligned block stored row after row, so getData() can still
+ *  be handed to the array kernels in MathUtils. The element type is a
+ *  template parameter; Matrix (double), MatrixF (float) and MatrixBF16
+ *  (bfloat16 storage) are the instantiations the library provides.
+ *
+ */
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+// cpp
+#include <cstdint>
+#include <cstddef>
+
+#include "BFloat16.h"
+
+using namespace std;
+
+// a lazy element-wise expression (see Expression.h)
+template <typename E>
+class Expression;
+
+/**
+ *  @brief Class that owns a row major matrix of T
+ */
+template <typename T>
+class BasicMatrix {
+private:
+	T* data = nullptr; // rows * cols elements, 64 byte aligned
+	uint32_t rows = 0; // the number of rows
+	uint32_t cols = 0; // the number of columns
+	size_t capacity = 0; // the number of elements data has room for
+
+public:
+	// Empty constructor
+	BasicMatrix(void);
+
+	// Constructor (Note: the elements are zeroed)
+	BasicMatrix(uint32_t rows, uint32_t cols);
+
+	// Copy constructor (Note: deep copies the elements)
+	BasicMatrix(const BasicMatrix& other);
+
+	// Move constructor
+	BasicMatrix(BasicMatrix&& other) noexcept;
+
+	// Constructor that computes an element-wise expression (Note: defined in Expression.h)
+	template <typename E>
+	BasicMatrix(const Expression<E>& expression);
+
+	// Destructor
+	~BasicMatrix(void);
+
+	// Copy assignment
+	BasicMatrix& operator=(const BasicMatrix& other);
+
+	// Move assignment
+	BasicMatrix& operator=(BasicMatrix&& other) noexcept;
+
+	// computes an element-wise expression in one pass (Note: defined in Expression.h, the
+	// matrix is resized to the shape of the expression)
+	template <typename E>
+	BasicMatrix& operator=(const Expression<E>& expression);
+
+	// reshapes the matrix (Note: the elements are zeroed, and the storage is only
+	// reallocated when it has to grow so buffers reused across batches stop allocating)
+	void resize(uint32_t rows, uint32_t cols);
+
+	// sets every element to val
+	void fill(T val);
+
+	// returns the number of rows
+	uint32_t getRows() const;
+
+	// returns the number of columns
+	uint32_t getCols() const;
+
+	// returns rows * cols
+	size_t getSize() const;
+
+	// returns the number of elements the storage has room for
+	size_t getCapacity() const { return capacity; }
+
+	// returns the number of bytes the elements occupy
+	size_t getBytes() const { return getSize() * sizeof(T); }
+
+	// returns the first element
+	T* getData();
+	const T* getData() const;
+
+	// returns the first element of row r
+	T* getRow(uint32_t r) { return data + static_cast<size_t>(r) * cols; }
+	const T* getRow(uint32_t r) const { return data + static_cast<size_t>(r) * cols; }
+
+	// returns the element at row r and column c
+	T& operator()(uint32_t r, uint32_t c) { return data[static_cast<size_t>(r) * cols + c]; }
+	T operator()(uint32_t r, uint32_t c) const { return data[static_cast<size_t>(r) * cols + c]; }
+};
+
+typedef BasicMatrix<double> Matrix;
+typedef BasicMatrix<float> MatrixF;
+typedef BasicMatrix<BFloat16> MatrixBF16;
+
+#endif // !MATRIX_H
@@ -0,0 +1,126 @@
+/**
+ *  @file    Network.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief a fully connected classifier trained with minibatch SGD
+ *
+ *  @section DESCRIPTION
+ *
+ *  A Network is a stack of DenseLayers whose last layer produces
+ *  logits for a softmax head. Training consumes whole batches: the
+ *  forward pass, the fused softmax cross entropy and the backward
+ *  pass are all batched matrix kernels, followed by one gradient
+ *  descent step per batch.
+ *
+ *  With setShards(n) every batch is cut into n contiguous shards that
+ *  run forward and backward as separate tasks on the shared
+ *  ThreadPool. Their gradients are then summed by a pairwise tree in
+ *  a fixed order, so the result depends on n but never on how many
+ *  threads ran the shards or in which order they finished.
+ *
+ */
+
+#ifndef NETWORK_H
+#define NETWORK_H
+
+// cpp
+#include <vector>
+#include <string>
+#include <exception>
+#include <cstdint>
+
+#include "DenseLayer.h"
+#include "BatchLoader.h"
+#include "Dataset.h"
+#include "Checkpoint.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when a network is built or fed incorrectly
+ */
+class NetworkException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	NetworkException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Class that trains and runs a fully connected classifier
+ */
+class Network {
+private:
+	vector<DenseLayer> layers; // the hidden layers followed by the logits layer
+	uint32_t shards = 1; // the number of pieces every training batch is cut into
+	vector<vector<DenseWorkspace>> shardBuffers; // the buffers of shards 1 and up, per layer
+	vector<MatrixF> lossGradients; // per shard, the gradient of the loss with respect to the logits
+	vector<double> shardLosses; // per shard, the summed loss of its rows
+	MatrixF inputs; // scratch rows used by evaluate
+	vector<uint32_t> predictions; // scratch classes used by evaluate
+
+	// returns the buffers shard uses for a layer (shard 0 uses the layer's own)
+	DenseWorkspace& getBuffers(uint32_t shard, uint32_t layer);
+
+	// runs forward and backward on the rows of one shard of a batch
+	void trainShard(uint32_t shard, uint32_t used, const float* input, const uint8_t* labels, uint32_t count, size_t stride);
+
+public:
+	// Constructor that builds layers between consecutive sizes, e.g. { 784, 128, 10 }
+	// (Note: the last layer is linear and feeds the softmax head)
+	Network(const vector<uint32_t>& sizes, Activation hidden = Activation::RELU, uint64_t seed = 0);
+
+	// computes the logits of count rows spaced stride floats apart
+	const MatrixF& forward(const float* input, uint32_t count, size_t stride);
+
+	// runs forward, backward and one SGD step on a batch and returns its mean loss
+	float trainBatch(const float* input, const uint8_t* labels, uint32_t count, size_t stride, float learningRate);
+	float trainBatch(const Batch& batch, float learningRate);
+
+	// trains on every batch of one epoch of the loader and returns the mean loss
+	float trainEpoch(BatchLoader& loader, float learningRate);
+
+	// writes the most likely class of each of count rows
+	void predict(const float* input, uint32_t count, size_t stride, uint32_t* classes);
+
+	// returns the fraction of the dataset classified correctly
+	float evaluate(const Dataset& dataset, uint32_t batchSize = 256);
+
+	// sets how many shards every training batch is cut into (Note: use about one
+	// per core; the trained weights depend on this value and nothing else)
+	void setShards(uint32_t shards);
+
+	// returns the number of shards per training batch
+	uint32_t getShards() const;
+
+	// returns the number of layers
+	uint32_t getLayerCount() const;
+
+	// returns the ith layer
+	DenseLayer& getLayer(uint32_t i);
+	const DenseLayer& getLayer(uint32_t i) const;
+
+	// returns the number of inputs per row
+	uint32_t getInputs() const;
+
+	// returns the number of classes
+	uint32_t getOutputs() const;
+
+	// returns the weights and bias of every layer as "layer<i>.weights" and
+	// "layer<i>.bias" (Note: they point at the live parameters)
+	vector<CheckpointTensor> getTensors() const;
+
+	// copies the parameters of every layer out of a checkpoint (Note: throws
+	// CheckpointException if a tensor is missing or has a different shape)
+	void load(const Checkpoint& checkpoint);
+};
+
+#endif // !NETWORK_H
@@ -0,0 +1,122 @@
+/**
+ *  @file    QuantizedNetwork.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief an int8 copy of a trained Network that classifies raw pixels
+ *
+ *  @section DESCRIPTION
+ *
+ *  Every layer of a trained Network is quantized after training: the
+ *  weights of each output get their own scale and are rounded to
+ *  int8, and the activations between layers are uint8 with a scale
+ *  and zero point measured on calibration images. The first layer
+ *  reads the image bytes as they are, since pixel * scale + offset is
+ *  already an affine uint8 encoding (the offset is folded into the
+ *  bias). Products are summed exactly in int32 by MathUtils::gemmU8S8
+ *  and requantized to the uint8 input of the next layer; the last
+ *  layer dequantizes to float logits.
+ *
+ */
+
+#ifndef QUANTIZED_NETWORK_H
+#define QUANTIZED_NETWORK_H
+
+// cpp
+#include <vector>
+#include <string>
+#include <exception>
+#include <cstdint>
+
+#include "Network.h"
+#include "Dataset.h"
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when a network cannot be quantized or fed
+ */
+class QuantizationException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	QuantizationException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief Class that runs a Network with int8 weights and uint8 activations
+ */
+class QuantizedNetwork {
+private:
+	// one quantized DenseLayer
+	struct Layer {
+		uint32_t inputs = 0; // the number of inputs per row
+		uint32_t outputs = 0; // the number of outputs per row
+		Activation activation = Activation::LINEAR; // applied before requantizing
+		vector<int8_t> weights; // packed by MathUtils::packS8, output o scaled by 127 / max |w[o]|
+		vector<int32_t> weightSums; // per output, the sum of its int8 weights
+		vector<float> scales; // per output, the value of one unit of the int32 sum
+		vector<float> bias; // per output, the float bias (the input offset folded in)
+		int32_t inputZero = 0; // the uint8 value of an input of 0
+		float outputScale = 1.0f; // the value of one unit of the uint8 output
+		int32_t outputZero = 0; // the uint8 value of an output of 0
+	};
+
+	vector<Layer> layers; // the quantized layers in order
+	vector<vector<uint8_t>> activations; // the uint8 outputs of every hidden layer, batch rows each
+	vector<int32_t> sums; // the int32 products of the current layer
+	MatrixF values; // the float outputs of the current layer (the logits after the last one)
+	MatrixF features; // scratch rows used by the calibration
+	vector<uint32_t> predictions; // scratch classes used by evaluate
+
+	// turns the int32 sums of a layer into activated float values
+	void dequantize(const Layer& layer, uint32_t count);
+
+	// turns the float values of a hidden layer into the uint8 input of the next one
+	void requantize(const Layer& layer, uint32_t count, uint8_t* out, size_t outStride) const;
+
+public:
+	// Constructor that quantizes network, measuring the range of every hidden
+	// activation on up to samples images of calibration (Note: normalization must be
+	// the one the network was trained with)
+	QuantizedNetwork(
+		Network& network,
+		const Dataset& calibration,
+		uint32_t samples = CALIBRATION_SAMPLES,
+		const Normalization& normalization = Normalization::unit()
+	);
+
+	// computes the logits of count images of raw pixels spaced stride bytes apart
+	const MatrixF& forward(const uint8_t* pixels, uint32_t count, size_t stride);
+
+	// writes the most likely class of each of count images
+	void predict(const uint8_t* pixels, uint32_t count, size_t stride, uint32_t* classes);
+
+	// returns the fraction of the dataset classified correctly (Note: the dataset
+	// must keep its pixels)
+	float evaluate(const Dataset& dataset, uint32_t batchSize = 256);
+
+	// returns the bytes taken by the quantized weights, scales and biases
+	size_t getWeightBytes() const;
+
+	// returns the number of layers
+	uint32_t getLayerCount() const;
+
+	// returns the number of inputs per row
+	uint32_t getInputs() const;
+
+	// returns the number of classes
+	uint32_t getOutputs() const;
+
+	// the number of calibration images used when none is given
+	static const uint32_t CALIBRATION_SAMPLES = 1024;
+};
+
+#endif // !QUANTIZED_NETWORK_H
@@ -0,0 +1,181 @@
+/**
+ *  @file    Sampler.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief orders the images of a dataset into epochs
+ *
+ *  @section DESCRIPTION
+ *
+ *  This class groups the image indices of a dataset by label once,
+ *  with a counting sort, and then writes the order of every epoch into
+ *  the same index array. Images are never touched, only their indices,
+ *  and nothing is allocated after construction.
+ *
+ *  An epoch is either a plain shuffle, a stratified shuffle whose every
+ *  window of consecutive indices holds the classes in the proportions
+ *  of the whole dataset, or a class-balanced draw in which the classes
+ *  take turns so every batch holds about as many images of each.
+ *  Each drawn index costs at most one random word in every mode, and
+ *  half of one where the ranges are small.
+ *
+ *  The random numbers come from a Philox stream keyed by the seed and
+ *  counted from the epoch, so an epoch's order depends on the seed and
+ *  the epoch number only, and training can resume at any epoch. The
+ *  common classes of a balanced epoch are drawn from passes with their
+ *  own streams, which are counted from the pass instead.
+ *
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+// cpp
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include "Dataset.h"
+#include "Philox.h"
+
+using namespace std;
+
+/**
+ *  @brief The ways a Sampler orders an epoch
+ */
+enum class SamplingMode : uint8_t {
+	SHUFFLE, // every image once, in uniformly random order
+	STRATIFIED, // every image once, with every class spread evenly over the epoch
+	BALANCED // as many draws as images with the classes taking turns (Note: rare classes repeat)
+};
+
+/**
+ *  @brief Class that keeps a per label index and writes shuffled epochs in place
+ */
+class Sampler {
+private:
+	/**
+	 *  @brief Struct that holds one image of a stratified merge block
+	 */
+	struct MergeEntry {
+		double position; // where in the epoch the image belongs, in [0, 1)
+		uint32_t index; // the pool slot of the image
+		uint32_t slot; // the epoch position the image falls on, relative to the block
+	};
+
+	vector<uint32_t> byLabel; // every image index, grouped by label and ascending within a label
+	vector<uint32_t> labelStart; // the images of label c are byLabel[labelStart[c], labelStart[c + 1])
+	vector<uint8_t> classes; // the labels that occur, ascending
+	vector<uint32_t> permutation; // the order of the current epoch
+	vector<uint32_t> pool; // byLabel with every label's run shuffled
+	vector<uint32_t> cursors; // the number of images taken from each label's run so far
+	vector<double> phases; // the random offset of every label's images in the epoch (STRATIFIED)
+	vector<MergeEntry> pending; // the images of a merge block, class by class
+	vector<MergeEntry> merged; // pending ordered by position
+	vector<uint32_t> blockCounts; // the number of pending images in every slot of a merge block
+	vector<uint32_t> openers; // the class that opens every round of a draw block (BALANCED)
+	vector<uint32_t> passes; // the pass every label's run in pool holds (BALANCED, NO_PASS if none)
+	vector<uint32_t> staged; // the draws of a draw block that span two passes, class by class (BALANCED)
+	vector<const uint32_t*> columns; // every class's draws of a draw block, twice over (BALANCED)
+
+	SamplingMode mode; // how epochs are ordered
+	Philox generator; // the stream keyed by the seed
+	uint32_t epoch = 0; // the epoch in permutation
+	uint64_t counter = 0; // the next Philox counter of the epoch
+	uint32_t words[256]; // random words not used yet
+	uint32_t wordsLeft = 0; // the number of valid words at the end of words
+
+	// builds the per label index
+	void buildIndex(const uint8_t* labels, uint32_t count);
+
+	// restarts the random stream at the beginning of an epoch
+	void restart(uint32_t epoch);
+
+	// returns the next random word of the epoch
+	uint32_t nextWord(void);
+
+	// writes the next count random words of the epoch (the same words count nextWord calls give)
+	void takeWords(uint32_t* out, uint32_t count);
+
+	// returns a random number in [0, range) (Note: the bias is below range / 2^32)
+	uint32_t nextBounded(uint32_t range);
+
+	// writes count random numbers in [0, range), several from every word (Note: exact, range at most 256)
+	void nextDigits(uint32_t* out, uint32_t count, uint32_t range);
+
+	// writes a random permutation of source (0, 1, ... if it is nullptr) into target
+	void shuffleInto(const uint32_t* source, uint32_t* target, uint32_t count);
+
+	// writes a pass of a label's run into pool from the pass's own stream
+	void shufflePass(uint8_t label, uint32_t pass);
+
+	// writes the three kinds of epochs into permutation
+	void shuffleAll(void);
+	void shuffleStratified(void);
+	void shuffleBalanced(void);
+
+	// the number of swaps of a shuffle picked (and prefetched) before any of them is made
+	static const uint32_t PLAN_BLOCK = 256;
+
+	// the shuffle steps below this share one random word per two swaps (Note: the product of
+	// two ranges stays below 2^28, so at most one word in 16 is drawn again)
+	static const uint32_t PAIR_RANGE = 1 << 14;
+
+	// the number of values below which a shuffle's swaps stay cached and are not prefetched
+	static const uint32_t PREFETCH_SIZE = 1 << 18;
+
+	// the low half of the counters of a pass stream, which an epoch stream never reaches
+	static const uint32_t PASS_STREAM = 1u << 31;
+
+	// the pass of a label's run in pool when it holds none
+	static const uint32_t NO_PASS = 0xFFFFFFFFu;
+
+	// the number of epoch positions a stratified epoch is merged in at a time
+	static const uint32_t MERGE_BLOCK = 256;
+
+	// the number of draws a balanced epoch plans at a time (Note: at least one round)
+	static const uint32_t DRAW_BLOCK = 1024;
+
+public:
+	// Constructor that indexes the labels of a dataset
+	Sampler(const Dataset& dataset, SamplingMode mode = SamplingMode::SHUFFLE, uint64_t seed = 0);
+
+	// Constructor that indexes count labels (Note: the labels are only read here)
+	Sampler(const uint8_t* labels, uint32_t count, SamplingMode mode = SamplingMode::SHUFFLE, uint64_t seed = 0);
+
+	// writes the order of an epoch into the permutation and returns it (Note: the same seed and
+	// epoch always give the same order, whatever was shuffled before)
+	const vector<uint32_t>& shuffle(uint32_t epoch);
+
+	// writes the order of an epoch into a buffer of the caller's (Note: resized to the
+	// number of images; the permutation and its epoch are left as they were)
+	void shuffle(uint32_t epoch, vector<uint32_t>& order);
+
+	// returns the order of the last shuffled epoch (epoch 0 right after construction)
+	const vector<uint32_t>& getPermutation() const;
+
+	// returns the epoch the permutation belongs to
+	uint32_t getEpoch() const;
+
+	// returns the number of indices in an epoch (the number of images)
+	uint32_t getEpochSize() const;
+
+	// returns how epochs are ordered
+	SamplingMode getMode() const;
+
+	// returns the labels that occur, ascending
+	const vector<uint8_t>& getClasses() const;
+
+	// returns the number of images with a label
+	uint32_t getLabelCount(uint8_t label) const;
+
+	// returns the indices of the images with a label, ascending (Note: getLabelCount of them)
+	const uint32_t* getLabelIndices(uint8_t label) const;
+
+	// the number of distinct values a label can take
+	static const uint32_t NUM_LABELS = 256;
+};
+
+#endif // !SAMPLER_H
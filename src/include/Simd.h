@@ -0,0 +1,388 @@
+/**
+ *  @file    Simd.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief thin per element type wrappers over the vector instructions
+ *
+ *  @section DESCRIPTION
+ *
+ *  The kernels in MathUtils are written once against Simd<T> and
+ *  instantiated for float and double. Simd<T> maps onto the widest
+ *  instruction set the compiler was told it may use (/arch:AVX2,
+ *  /arch:AVX512, -mavx2 -mfma, ...) and onto plain C++ with one
+ *  element per "register" otherwise. ScalarOps<T> is always the plain
+ *  version and is what the kernels use for their tails.
+ *
+ *  The kernel variants Kernels dispatches between pick their level
+ *  explicitly instead, which is why the wrappers of each level are
+ *  kept in a namespace of their own. The project itself builds for the
+ *  baseline target so the binary runs on any x86-64 host.
+ *
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+// cpp
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// a translation unit can ask for a level by defining SIMD_TARGET_SCALAR,
+// SIMD_TARGET_AVX2, SIMD_TARGET_AVX512 or SIMD_TARGET_AVX512VNNI first (see
+// KernelVariants.h); the VNNI level is AVX-512 plus the byte dot products
+#if defined(SIMD_TARGET_SCALAR)
+#define SIMD_NAMESPACE simd_scalar
+#elif defined(SIMD_TARGET_AVX512VNNI)
+#define SIMD_AVX512
+#define SIMD_VNNI
+#define SIMD_NAMESPACE simd_avx512vnni
+#include <immintrin.h>
+#elif defined(SIMD_TARGET_AVX512) || (!defined(SIMD_TARGET_AVX2) && defined(__AVX512F__))
+#define SIMD_AVX512
+#define SIMD_NAMESPACE simd_avx512
+#include <immintrin.h>
+#elif defined(SIMD_TARGET_AVX2) || (defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER)))
+#define SIMD_AVX2
+#define SIMD_NAMESPACE simd_avx2
+#include <immintrin.h>
+#else
+#define SIMD_NAMESPACE simd_scalar
+#endif
+
+using namespace std;
+
+// every level lives in its own namespace, so translation units built for
+// different levels never share (and never merge) a definition
+namespace SIMD_NAMESPACE {
+
+// exp(x) = 2^n * exp(r) with n = round(x / ln 2) and |r| <= ln(2) / 2. The
+// Taylor series of exp(r) is truncated once the next term drops below half an
+// ulp, and ln 2 is split in two so that r is exact, which keeps the result
+// within 2 ulp. Inputs below MIN return 0 and inputs above MAX overflow.
+template <typename T>
+struct ExpConstants;
+
+template <>
+struct ExpConstants<double> {
+	static constexpr double MIN = -708.0;
+	static constexpr double MAX = 709.8;
+	static constexpr double LOG2E = 1.4426950408889634074;
+	static constexpr double LN2_HI = 6.93147180369123816490e-01;
+	static constexpr double LN2_LO = 1.90821492927058770002e-10;
+	static constexpr int DEGREE = 12;
+
+	// returns 1 / i!
+	static double coefficient(int i) {
+		static const double COEFFS[DEGREE + 1] = {
+			1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+			1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600
+		};
+		return COEFFS[i];
+	}
+};
+
+template <>
+struct ExpConstants<float> {
+	// MIN keeps 2^(n - 1) a normal float so it can be built from exponent bits
+	static constexpr float MIN = -86.5f;
+	static constexpr float MAX = 88.8f;
+	static constexpr float LOG2E = 1.44269504f;
+	static constexpr float LN2_HI = 0.693359375f;
+	static constexpr float LN2_LO = -2.12194440e-4f;
+	static constexpr int DEGREE = 7;
+
+	// returns 1 / i!
+	static float coefficient(int i) {
+		static const float COEFFS[DEGREE + 1] = {
+			1.0f, 1.0f, 1.0f / 2, 1.0f / 6, 1.0f / 24, 1.0f / 120, 1.0f / 720, 1.0f / 5040
+		};
+		return COEFFS[i];
+	}
+};
+
+/**
+ *  @brief Struct that treats a single element as a one lane register
+ */
+template <typename T>
+struct ScalarOps {
+	typedef T type;
+	typedef T reg;
+	static const uint32_t WIDTH = 1;
+
+	static reg zero(void) { return T(0); }
+	static reg set1(T val) { return val; }
+	static reg load(const T* src) { return *src; }
+	static reg loadAligned(const T* src) { return *src; }
+	static void store(T* dst, reg val) { *dst = val; }
+	static void storeAligned(T* dst, reg val) { *dst = val; }
+
+	// widens WIDTH unsigned bytes into elements
+	static reg loadBytes(const uint8_t* src) { return static_cast<T>(*src); }
+	static reg add(reg a, reg b) { return a + b; }
+	static reg sub(reg a, reg b) { return a - b; }
+	static reg mul(reg a, reg b) { return a * b; }
+	static reg div(reg a, reg b) { return a / b; }
+	static reg min(reg a, reg b) { return b < a ? b : a; }
+	static reg max(reg a, reg b) { return a < b ? b : a; }
+
+	// a * b + c and c - a * b
+	static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+	static reg fnmadd(reg a, reg b, reg c) { return c - a * b; }
+
+	static T reduceAdd(reg a) { return a; }
+	static T reduceMax(reg a) { return a; }
+
+	// rounds to the nearest integer
+	static reg round(reg a) { return std::nearbyint(a); }
+
+	// returns 2^(n - 1) for an integral n
+	static reg pow2m1(reg n) { return std::ldexp(T(1), static_cast<int>(n) - 1); }
+
+	// returns 0 wherever x < limit and val elsewhere
+	static reg zeroBelow(reg val, reg x, T limit) { return x < limit ? T(0) : val; }
+
+	// returns val wherever x > 0 and 0 elsewhere
+	static reg keepPositive(reg val, reg x) { return x > T(0) ? val : T(0); }
+};
+
+#if defined(SIMD_AVX512)
+// GCC's AVX-512 intrinsics pass _mm512_undefined_* registers through their masked forms
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+template <typename T>
+struct Simd;
+
+template <>
+struct Simd<double> {
+	typedef double type;
+	typedef __m512d reg;
+	static const uint32_t WIDTH = 8;
+
+	static reg zero(void) { return _mm512_setzero_pd(); }
+	static reg set1(double val) { return _mm512_set1_pd(val); }
+	static reg load(const double* src) { return _mm512_loadu_pd(src); }
+	static reg loadAligned(const double* src) { return _mm512_load_pd(src); }
+	static void store(double* dst, reg val) { _mm512_storeu_pd(dst, val); }
+	static void storeAligned(double* dst, reg val) { _mm512_store_pd(dst, val); }
+	static reg loadBytes(const uint8_t* src) { return _mm512_cvtepi32_pd(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)))); }
+	static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+	static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+	static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+	static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+	static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+	static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+	static reg fnmadd(reg a, reg b, reg c) { return _mm512_fnmadd_pd(a, b, c); }
+	static double reduceAdd(reg a) { return _mm512_reduce_add_pd(a); }
+	static double reduceMax(reg a) { return _mm512_reduce_max_pd(a); }
+	static reg round(reg a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEAREST_INT); }
+
+	static reg pow2m1(reg n) {
+		const __m512i bits = _mm512_slli_epi64(
+			_mm512_add_epi64(_mm512_cvtepi32_epi64(_mm512_cvtpd_epi32(n)), _mm512_set1_epi64(1022)), 52
+		);
+		return _mm512_castsi512_pd(bits);
+	}
+
+	static reg zeroBelow(reg val, reg x, double limit) {
+		return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, set1(limit), _CMP_LT_OQ), val, zero());
+	}
+
+	static reg keepPositive(reg val, reg x) {
+		return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(x, zero(), _CMP_GT_OQ), val);
+	}
+};
+
+template <>
+struct Simd<float> {
+	typedef float type;
+	typedef __m512 reg;
+	static const uint32_t WIDTH = 16;
+
+	static reg zero(void) { return _mm512_setzero_ps(); }
+	static reg set1(float val) { return _mm512_set1_ps(val); }
+	static reg load(const float* src) { return _mm512_loadu_ps(src); }
+	static reg loadAligned(const float* src) { return _mm512_load_ps(src); }
+	static void store(float* dst, reg val) { _mm512_storeu_ps(dst, val); }
+	static void storeAligned(float* dst, reg val) { _mm512_store_ps(dst, val); }
+	static reg loadBytes(const uint8_t* src) { return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)))); }
+	static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+	static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+	static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+	static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+	static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+	static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+	static reg fnmadd(reg a, reg b, reg c) { return _mm512_fnmadd_ps(a, b, c); }
+	static float reduceAdd(reg a) { return _mm512_reduce_add_ps(a); }
+	static float reduceMax(reg a) { return _mm512_reduce_max_ps(a); }
+	static reg round(reg a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT); }
+
+	static reg pow2m1(reg n) {
+		const __m512i bits = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(126)), 23);
+		return _mm512_castsi512_ps(bits);
+	}
+
+	static reg zeroBelow(reg val, reg x, float limit) {
+		return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, set1(limit), _CMP_LT_OQ), val, zero());
+	}
+
+	static reg keepPositive(reg val, reg x) {
+		return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, zero(), _CMP_GT_OQ), val);
+	}
+};
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#elif defined(SIMD_AVX2)
+template <typename T>
+struct Simd;
+
+template <>
+struct Simd<double> {
+	typedef double type;
+	typedef __m256d reg;
+	static const uint32_t WIDTH = 4;
+
+	static reg zero(void) { return _mm256_setzero_pd(); }
+	static reg set1(double val) { return _mm256_set1_pd(val); }
+	static reg load(const double* src) { return _mm256_loadu_pd(src); }
+	static reg loadAligned(const double* src) { return _mm256_load_pd(src); }
+	static void store(double* dst, reg val) { _mm256_storeu_pd(dst, val); }
+	static void storeAligned(double* dst, reg val) { _mm256_store_pd(dst, val); }
+
+	static reg loadBytes(const uint8_t* src) {
+		int32_t bytes;
+		memcpy(&bytes, src, sizeof(bytes));
+		return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes)));
+	}
+
+	static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+	static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+	static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+	static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+	static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+	static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+	static reg fnmadd(reg a, reg b, reg c) { return _mm256_fnmadd_pd(a, b, c); }
+	static reg round(reg a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+	static double reduceAdd(reg a) {
+		__m128d low = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+		return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+	}
+
+	static double reduceMax(reg a) {
+		__m128d low = _mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+		return _mm_cvtsd_f64(_mm_max_sd(low, _mm_unpackhi_pd(low, low)));
+	}
+
+	static reg pow2m1(reg n) {
+		const __m256i bits = _mm256_slli_epi64(
+			_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1022)), 52
+		);
+		return _mm256_castsi256_pd(bits);
+	}
+
+	static reg zeroBelow(reg val, reg x, double limit) {
+		return _mm256_andnot_pd(_mm256_cmp_pd(x, set1(limit), _CMP_LT_OQ), val);
+	}
+
+	static reg keepPositive(reg val, reg x) {
+		return _mm256_and_pd(_mm256_cmp_pd(x, zero(), _CMP_GT_OQ), val);
+	}
+};
+
+template <>
+struct Simd<float> {
+	typedef float type;
+	typedef __m256 reg;
+	static const uint32_t WIDTH = 8;
+
+	static reg zero(void) { return _mm256_setzero_ps(); }
+	static reg set1(float val) { return _mm256_set1_ps(val); }
+	static reg load(const float* src) { return _mm256_loadu_ps(src); }
+	static reg loadAligned(const float* src) { return _mm256_load_ps(src); }
+	static void store(float* dst, reg val) { _mm256_storeu_ps(dst, val); }
+	static void storeAligned(float* dst, reg val) { _mm256_store_ps(dst, val); }
+	static reg loadBytes(const uint8_t* src) { return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)))); }
+	static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+	static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+	static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+	static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+	static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+	static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+	static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+	static reg fnmadd(reg a, reg b, reg c) { return _mm256_fnmadd_ps(a, b, c); }
+	static reg round(reg a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+	static float reduceAdd(reg a) {
+		__m128 low = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+		low = _mm_add_ps(low, _mm_movehl_ps(low, low));
+		return _mm_cvtss_f32(_mm_add_ss(low, _mm_movehdup_ps(low)));
+	}
+
+	static float reduceMax(reg a) {
+		__m128 low = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+		low = _mm_max_ps(low, _mm_movehl_ps(low, low));
+		return _mm_cvtss_f32(_mm_max_ss(low, _mm_movehdup_ps(low)));
+	}
+
+	static reg pow2m1(reg n) {
+		const __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(126)), 23);
+		return _mm256_castsi256_ps(bits);
+	}
+
+	static reg zeroBelow(reg val, reg x, float limit) {
+		return _mm256_andnot_ps(_mm256_cmp_ps(x, set1(limit), _CMP_LT_OQ), val);
+	}
+
+	static reg keepPositive(reg val, reg x) {
+		return _mm256_and_ps(_mm256_cmp_ps(x, zero(), _CMP_GT_OQ), val);
+	}
+};
+#else
+template <typename T>
+struct Simd : public ScalarOps<T> {
+};
+#endif
+
+/**
+ *  @brief exponential of every lane of a register
+ *
+ *  @param x the exponents
+ *  @return an approximation of e^x for every lane
+ */
+template <typename S>
+static inline typename S::reg expApprox(typename S::reg x) {
+	typedef typename S::type T;
+	typedef ExpConstants<T> E;
+
+	const typename S::reg input = x;
+	x = S::min(S::max(x, S::set1(E::MIN)), S::set1(E::MAX));
+
+	const typename S::reg n = S::round(S::mul(x, S::set1(E::LOG2E)));
+	typename S::reg r = S::fnmadd(n, S::set1(E::LN2_HI), x);
+	r = S::fnmadd(n, S::set1(E::LN2_LO), r);
+
+	typename S::reg p = S::set1(E::coefficient(E::DEGREE));
+	for (int i = E::DEGREE - 1; i >= 0; i--) {
+		p = S::fmadd(p, r, S::set1(E::coefficient(i)));
+	}
+
+	// 2^n is applied as 2^(n - 1) * 2 so that the largest n still overflows cleanly
+	p = S::mul(S::mul(p, S::pow2m1(n)), S::set1(T(2)));
+	return S::zeroBelow(p, input, E::MIN);
+}
+
+} // namespace SIMD_NAMESPACE
+
+using namespace SIMD_NAMESPACE;
+
+#endif // !SIMD_H
@@ -0,0 +1,123 @@
+/**
+ *  @file    ThreadPool.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief a work stealing thread pool shared by the math and training code
+ *
+ *  @section DESCRIPTION
+ *
+ *  Every worker owns a deque of tasks. A worker pops its own newest
+ *  task first and, when it runs dry, steals the oldest task of
+ *  another deque, so a thread that splits its work keeps the hot half
+ *  and idle threads take the rest. A thread waiting for a parallelFor
+ *  keeps running tasks instead of blocking, which makes nested
+ *  parallel loops (a gemm inside a training shard) safe.
+ *
+ *  Queued tasks are a pointer to the loop plus a slice index and the
+ *  deques are rings that only ever grow, so once they have reached
+ *  their working size a parallelFor does not allocate.
+ *
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// cpp
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ *  @brief Class that runs tasks on a fixed set of work stealing threads
+ */
+class ThreadPool {
+private:
+	// the state shared by the slices of one parallelFor (defined in ThreadPool.cpp)
+	struct Loop;
+
+	// one queued slice of a loop
+	struct Task {
+		Loop* loop;
+		uint32_t slice;
+	};
+
+	// a ring of tasks that grows when full, and the lock that guards it
+	struct Queue {
+		mutex lock;
+		vector<Task> ring; // the storage (its size is a power of two)
+		size_t head = 0; // the position of the oldest task
+		size_t count = 0; // the number of queued tasks
+	};
+
+	// calls a body of type Body on a range
+	template <typename Body>
+	static void callBody(const void* body, uint64_t begin, uint64_t end) {
+		(*static_cast<const Body*>(body))(begin, end);
+	}
+
+	vector<unique_ptr<Queue>> queues; // one per worker plus one shared by outside threads
+	vector<thread> workers; // the worker threads
+	atomic<uint64_t> pending; // the number of queued tasks
+	atomic<bool> stopping; // tells the workers to exit
+	mutex sleepLock; // guards the sleeping workers
+	condition_variable wake; // signalled when a task is queued
+
+	// the body of every worker thread
+	void work(uint32_t index);
+
+	// queues a task on the deque of the calling thread
+	void push(const Task& task);
+
+	// runs one slice of a loop and marks it done
+	static void runSlice(Loop& loop, uint32_t slice);
+
+	// the loop behind parallelFor, with body erased to a function and a pointer
+	void parallelFor(const uint64_t count, uint32_t slices, void (*call)(const void*, uint64_t, uint64_t), const void* body);
+
+	// runs one queued task (own deque first, then stealing) and returns false if none was found
+	bool runOne(void);
+
+	// returns the deque the calling thread pushes to and pops from
+	uint32_t getHome(void) const;
+
+public:
+	// Constructor (Note: the threads that call parallelFor take part as well,
+	// so 0 workers is valid and runs everything on the caller)
+	ThreadPool(uint32_t numWorkers);
+
+	// Destructor (Note: joins the workers)
+	~ThreadPool(void);
+
+	// The pool owns threads so it cannot be copied
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// splits [0, count) into slices contiguous ranges and runs body(begin, end) on
+	// each, returning once all of them are done (Note: the slice boundaries only
+	// depend on count and slices, never on which thread runs them; the first
+	// exception thrown by body is rethrown here)
+	template <typename Body>
+	void parallelFor(const uint64_t count, uint32_t slices, const Body& body) {
+		parallelFor(count, slices, &callBody<Body>, &body);
+	}
+
+	// returns the number of worker threads
+	uint32_t getWorkerCount() const;
+
+	// returns the pool shared by the whole library (the calling thread plus one worker
+	// per extra hardware thread, or NNF_THREADS threads in total if that is set)
+	static ThreadPool& getGlobal(void);
+
+	// the environment variable that overrides the size of the global pool
+	static constexpr const char* THREADS_VARIABLE = "NNF_THREADS";
+};
+
+#endif // !THREAD_POOL_H
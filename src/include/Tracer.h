@@ -0,0 +1,170 @@
+/**
+ *  @file    Tracer.h
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief scoped timers, counters and histograms for the hot paths
+ *
+ *  @section DESCRIPTION
+ *
+ *  The NNF_TRACE_* macros mark the stages worth timing: parsing, label
+ *  assignment, batch gathering, the forward and backward pass of every
+ *  layer and bmp writing. Every thread records into its own buffer, so
+ *  recording never waits on another thread, and nothing is recorded
+ *  until Tracer::enable(true) is called.
+ *
+ *  The events can be written in the Chrome trace_event format (open
+ *  the file in chrome://tracing or ui.perfetto.dev) and summarized as
+ *  a table of counts, totals and percentiles per stage.
+ *
+ *  The macros only expand to code when NNF_ENABLE_TRACING is defined.
+ *  Without it they compile to nothing, so the markers can stay in the
+ *  sources of a release build at no cost. The ReleaseTraced
+ *  configuration of the project is Release with the define added.
+ *
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+// cpp
+#include <vector>
+#include <string>
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ *  @brief Class that gets thrown when a trace cannot be written
+ */
+class TracerException : public std::exception {
+private:
+	string message; // The error message
+
+public:
+
+	// Constructor
+	TracerException(string message);
+
+	// Extracts the error message as a const char pointer
+	const char* what() const noexcept;
+};
+
+/**
+ *  @brief The kinds of trace events
+ */
+enum class TraceType : uint8_t {
+	SCOPE, // a span of time
+	COUNTER, // a value that changes over time
+	SAMPLE // one value of a histogram
+};
+
+/**
+ *  @brief Struct that holds one trace event
+ */
+struct TraceEvent {
+	const char* name = nullptr; // a string literal naming the stage
+	TraceType type = TraceType::SCOPE; // what the event records
+	uint64_t start = 0; // nanoseconds since the tracer was created
+	uint64_t duration = 0; // nanoseconds, for scopes
+	double value = 0.0; // the value, for counters and samples
+};
+
+/**
+ *  @brief Struct that holds the events of one thread
+ */
+struct TraceBuffer {
+	mutex lock; // taken by the owner to record and by the tracer to read (never contended while tracing)
+	vector<TraceEvent> events; // the events in the order they ended
+	uint32_t threadId = 0; // the small number the thread is shown as
+	uint64_t dropped = 0; // the events lost because the buffer was full
+};
+
+/**
+ *  @brief Class that collects the trace events of every thread
+ */
+class Tracer {
+private:
+	static atomic<bool> enabled; // whether the macros record anything
+
+	// returns the buffer of the calling thread, creating it on first use
+	static TraceBuffer& getLocal(void);
+
+	// copies the events of every thread
+	static vector<vector<TraceEvent>> collect(vector<uint32_t>& threadIds, uint64_t& dropped);
+
+public:
+	/**
+	 *  @brief Class that records the time between its construction and destruction
+	 */
+	class Scope {
+	private:
+		const char* name; // the stage, or nullptr when tracing was disabled at construction
+		uint64_t start; // when the scope began
+
+	public:
+		// Constructor (Note: name must be a string literal)
+		Scope(const char* name);
+
+		// Destructor
+		~Scope(void);
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	// static method that turns recording on or off
+	static void enable(bool on);
+
+	// static method that returns true if recording is on
+	static bool isEnabled() { return enabled.load(memory_order_relaxed); }
+
+	// static method that returns the nanoseconds since the tracer was created
+	static uint64_t now(void);
+
+	// static method that records a completed span
+	static void recordScope(const char* name, uint64_t start, uint64_t end);
+
+	// static method that records the current value of a counter
+	static void recordCounter(const char* name, double value);
+
+	// static method that records one value of a histogram
+	static void recordSample(const char* name, double value);
+
+	// static method that discards every recorded event
+	static void clear(void);
+
+	// static method that writes the events as Chrome trace_event JSON (Note: throws
+	// TracerException if the file cannot be written)
+	static void writeChromeTrace(string filename);
+
+	// static method that prints the count, total, mean and percentiles of every scope
+	// and histogram, and the last value of every counter
+	static void printSummary(ostream& out);
+
+	// the most events one thread keeps (later ones are counted as dropped)
+	static const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+};
+
+#define NNF_TRACE_CONCAT_(a, b) a##b
+#define NNF_TRACE_CONCAT(a, b) NNF_TRACE_CONCAT_(a, b)
+
+#ifdef NNF_ENABLE_TRACING
+// times the rest of the enclosing block
+#define NNF_TRACE_SCOPE(name) Tracer::Scope NNF_TRACE_CONCAT(traceScope, __LINE__)(name)
+// records the current value of a counter
+#define NNF_TRACE_COUNTER(name, value) do { if (Tracer::isEnabled()) Tracer::recordCounter(name, static_cast<double>(value)); } while (0)
+// records one value of a histogram
+#define NNF_TRACE_HISTOGRAM(name, value) do { if (Tracer::isEnabled()) Tracer::recordSample(name, static_cast<double>(value)); } while (0)
+#else
+#define NNF_TRACE_SCOPE(name) do { } while (0)
+#define NNF_TRACE_COUNTER(name, value) do { } while (0)
+#define NNF_TRACE_HISTOGRAM(name, value) do { } while (0)
+#endif
+
+#endif // !TRACER_H
@@ -0,0 +1,181 @@
+/**
+ *  @file    Arena.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief a bump allocator for the temporaries of one training or inference step
+ *
+ *  @section DESCRIPTION
+ *
+ *  An Arena hands out aligned pieces of large blocks by moving an
+ *  offset forward, and gives them all back at once with reset() or,
+ *  for nested temporaries, when an Arena::Scope ends. When a step
+ *  needs more than the arena holds, another block is added; the next
+ *  reset() then merges the blocks into one that fits the whole step,
+ *  so after the first step a loop no longer touches the heap.
+ *
+ *  Every thread also has its own arena (getLocal) that the math
+ *  kernels use for scratch space such as the gemm packing buffers.
+ *
+ */
+
+#include "Arena.h"
+
+#include <algorithm>
+#include <new>
+
+// blocks are page aligned so any alignment up to a page can be served from offset 0
+static const size_t BLOCK_ALIGNMENT = 4096;
+
+/**
+ *  @brief constructor
+ *
+ *  @param blockSize the size of the first block
+ */
+Arena::Arena(size_t blockSize):
+	blockSize(max<size_t>(blockSize, BLOCK_ALIGNMENT)) {
+}
+
+/**
+ *  @brief destructor
+ */
+Arena::~Arena(void) {
+	releaseBlocks();
+}
+
+/**
+ *  @brief frees every block
+ *
+ *  @return void
+ */
+void Arena::releaseBlocks(void) {
+	for (Block& block : blocks) {
+		AlignedMemory::release(block.data);
+	}
+	blocks.clear();
+	current = 0;
+	offset = 0;
+}
+
+/**
+ *  @brief hands out a piece of the current block, adding a block if it is full
+ *
+ *  @param bytes the size of the piece
+ *  @param alignment the alignment of the piece (a power of two up to 4096)
+ *  @return the piece (valid until reset or until the enclosing Scope ends)
+ */
+void* Arena::allocate(size_t bytes, size_t alignment) {
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment > BLOCK_ALIGNMENT) {
+		throw std::bad_alloc();
+	}
+
+	// try the current block, then the ones a Scope rewound past
+	for (; current < blocks.size(); current++, offset = 0) {
+		const size_t start = AlignedMemory::roundUp(offset, alignment);
+		if (start <= blocks[current].size && bytes <= blocks[current].size - start) {
+			used += start - offset + bytes;
+			highWater = max(highWater, used);
+			offset = start + bytes;
+			return blocks[current].data + start;
+		}
+	}
+
+	// every block is full: add one at least twice as large as the last
+	const size_t size = AlignedMemory::roundUp(
+		max(bytes, blocks.empty() ? blockSize : 2 * blocks.back().size), BLOCK_ALIGNMENT
+	);
+	Block block = { static_cast<char*>(AlignedMemory::allocate(size, BLOCK_ALIGNMENT)), size };
+	blocks.push_back(block);
+	current = blocks.size() - 1;
+	offset = bytes;
+	used += bytes;
+	highWater = max(highWater, used);
+	return block.data;
+}
+
+/**
+ *  @brief gives back every allocation
+ *
+ *  @return void
+ */
+void Arena::reset(void) {
+	// a step that spilled into several blocks gets one block that holds all of them
+	if (blocks.size() > 1) {
+		size_t total = 0;
+		for (const Block& block : blocks) {
+			total += block.size;
+		}
+		releaseBlocks();
+		Block block = { static_cast<char*>(AlignedMemory::allocate(total, BLOCK_ALIGNMENT)), total };
+		blocks.push_back(block);
+	}
+
+	current = 0;
+	offset = 0;
+	used = 0;
+	highWater = 0;
+}
+
+/**
+ *  @brief returns the bytes handed out since the last reset
+ *
+ *  @return the bytes in use including alignment padding
+ */
+size_t Arena::getUsed() const {
+	return used;
+}
+
+/**
+ *  @brief returns the most bytes in use at once since the last reset
+ *
+ *  @return the high water mark
+ */
+size_t Arena::getHighWater() const {
+	return highWater;
+}
+
+/**
+ *  @brief returns the bytes held in blocks
+ *
+ *  @return the total size of the blocks
+ */
+size_t Arena::getCapacity() const {
+	size_t total = 0;
+	for (const Block& block : blocks) {
+		total += block.size;
+	}
+	return total;
+}
+
+/**
+ *  @brief returns the arena of the calling thread
+ *
+ *  @return an arena that lives as long as the thread (Note: only use it through
+ *          a Scope so callers further up the stack keep their allocations)
+ */
+Arena& Arena::getLocal(void) {
+	thread_local Arena arena;
+	return arena;
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param arena the arena whose position is remembered
+ */
+Arena::Scope::Scope(Arena& arena):
+	arena(arena),
+	current(arena.current),
+	offset(arena.offset),
+	used(arena.used) {
+}
+
+/**
+ *  @brief destructor that gives back what was allocated during the scope
+ */
+Arena::Scope::~Scope(void) {
+	arena.current = current;
+	arena.offset = offset;
+	arena.used = used;
+}
@@ -0,0 +1,239 @@
+/**
+ *  @file    Augmenter.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief random geometric variants of images, computed while batches are gathered
+ *
+ *  @section DESCRIPTION
+ *
+ *  An Augmenter maps every output pixel back into the source image
+ *  through a random rotation, scale and shift plus a smooth random
+ *  elastic displacement, and reads the source there with bilinear
+ *  interpolation. The gathers of the interpolation run at the
+ *  instruction set level Kernels picks for the host.
+ *
+ *  The variant is chosen by a key: the random numbers come from a
+ *  counter based generator, so the same key always gives the same
+ *  image on any thread. BatchLoader keys each row by its position in
+ *  the batch stream, so every epoch sees fresh variants and nothing
+ *  but the original images is ever stored.
+ *
+ *  The elastic field is a grid of random displacements spaced
+ *  elasticSpacing pixels apart and upsampled bilinearly, a cheap
+ *  stand in for the Gaussian smoothed noise of Simard et al., "Best
+ *  Practices for Convolutional Neural Networks Applied to Visual
+ *  Document Analysis" (ICDAR 2003).
+ *
+ */
+
+#include "Augmenter.h"
+#include "Arena.h"
+#include "AlignedMemory.h"
+#include "Kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const float PI = 3.14159265358979f;
+
+/**
+ *  @brief turns random bits into a float in [0, 1)
+ *
+ *  @param word the bits
+ *  @return the float
+ */
+static inline float toUnit(uint32_t word) {
+	return static_cast<float>(word >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ *  @brief turns random bits into a float in [-1, 1)
+ *
+ *  @param word the bits
+ *  @return the float
+ */
+static inline float toSigned(uint32_t word) {
+	return 2.0f * toUnit(word) - 1.0f;
+}
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+AugmenterException::AugmenterException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* AugmenterException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param width the width of the images in pixels
+ *  @param height the height of the images in pixels
+ *  @param params the bounds of the transformations
+ *  @param seed picks the family of variants (together with the key of each image)
+ */
+Augmenter::Augmenter(uint32_t width, uint32_t height, const AugmentationParams& params, uint64_t seed):
+	width(width),
+	height(height),
+	params(params),
+	generator(seed) {
+	if (width == 0 || height == 0) {
+		throw AugmenterException("Images to augment must not be empty");
+	}
+	if (params.minScale <= 0.0f || params.maxScale < params.minScale) {
+		throw AugmenterException("The scale range must be positive and ordered");
+	}
+	if (params.elasticMagnitude > 0.0f && params.elasticSpacing < 1.0f) {
+		throw AugmenterException("The elastic spacing must be at least 1 pixel");
+	}
+
+	// enough control points to cover every pixel, and at least 2 per axis to interpolate between
+	const float spacing = max(1.0f, params.elasticSpacing);
+	gridWidth = max<uint32_t>(2, static_cast<uint32_t>(std::ceil((width - 1) / spacing)) + 1);
+	gridHeight = max<uint32_t>(2, static_cast<uint32_t>(std::ceil((height - 1) / spacing)) + 1);
+	if (2ull * gridWidth * gridHeight > 4 * (COUNTERS_PER_KEY - 1)) {
+		throw AugmenterException("The elastic spacing is too fine for images of this size");
+	}
+}
+
+/**
+ *  @brief bilinear interpolation at arbitrary positions
+ *
+ *  @param padded the image with a one pixel border on every side
+ *  @param paddedWidth the width of padded (the image width + 2)
+ *  @param x the column of every position (in [-1, width - 1) of the unpadded image)
+ *  @param y the row of every position (in [-1, height - 1) of the unpadded image)
+ *  @param out receives the interpolated values
+ *  @param count the number of positions
+ *  @return void
+ */
+void Augmenter::sample(const float* padded, uint32_t paddedWidth, const float* x, const float* y, float* out, size_t count) {
+	Kernels::get().bilinear(padded, paddedWidth, x, y, out, count);
+}
+
+/**
+ *  @brief writes one random variant of an image
+ *
+ *  @param src the image (width x height floats)
+ *  @param dst receives the variant (may be src)
+ *  @param background the value of the pixels outside the image
+ *  @param key picks the variant
+ *  @return void
+ */
+void Augmenter::apply(const float* src, float* dst, float background, uint64_t key) const {
+	const size_t size = static_cast<size_t>(width) * height;
+	const uint32_t paddedWidth = width + 2;
+
+	// scratch space comes from the calling worker's arena and is returned on exit
+	Arena& arena = Arena::getLocal();
+	Arena::Scope scope(arena);
+	float* padded = arena.allocate<float>(static_cast<size_t>(paddedWidth) * (height + 2));
+	float* xs = arena.allocate<float>(size);
+	float* ys = arena.allocate<float>(size);
+
+	// a border of background lets the sampler read one pixel past every edge
+	std::fill(padded, padded + static_cast<size_t>(paddedWidth) * (height + 2), background);
+	for (uint32_t y = 0; y < height; y++) {
+		std::copy(src + static_cast<size_t>(y) * width, src + static_cast<size_t>(y + 1) * width, padded + static_cast<size_t>(y + 1) * paddedWidth + 1);
+	}
+
+	uint32_t words[4];
+	generator.generate(key * COUNTERS_PER_KEY, words);
+	const float angle = params.maxRotation * toSigned(words[0]) * (PI / 180.0f);
+	const float scale = params.minScale + (params.maxScale - params.minScale) * toUnit(words[1]);
+	const float shiftX = params.maxShift * toSigned(words[2]);
+	const float shiftY = params.maxShift * toSigned(words[3]);
+
+	// the inverse of out = c + t + scale * R(angle) * (in - c)
+	const float centerX = 0.5f * (width - 1);
+	const float centerY = 0.5f * (height - 1);
+	const float cosine = std::cos(angle) / scale;
+	const float sine = std::sin(angle) / scale;
+	for (uint32_t y = 0; y < height; y++) {
+		const float v = y - centerY - shiftY;
+		float* rowX = xs + static_cast<size_t>(y) * width;
+		float* rowY = ys + static_cast<size_t>(y) * width;
+		for (uint32_t x = 0; x < width; x++) {
+			const float u = x - centerX - shiftX;
+			rowX[x] = centerX + cosine * u + sine * v;
+			rowY[x] = centerY - sine * u + cosine * v;
+		}
+	}
+
+	if (params.elasticMagnitude > 0.0f) {
+		const uint32_t points = gridWidth * gridHeight;
+		float* grid = arena.allocate<float>(2 * points);
+		uint32_t* bits = arena.allocate<uint32_t>(AlignedMemory::roundUp(2 * points, 4));
+		generator.generate(key * COUNTERS_PER_KEY + 1, (2 * points + 3) / 4, bits);
+		for (uint32_t i = 0; i < 2 * points; i++) {
+			grid[i] = params.elasticMagnitude * toSigned(bits[i]);
+		}
+
+		// the displacement of a pixel blends the 4 control points around it
+		const float inverse = 1.0f / params.elasticSpacing;
+		for (uint32_t y = 0; y < height; y++) {
+			const uint32_t gy = min(static_cast<uint32_t>(y * inverse), gridHeight - 2);
+			const float fy = y * inverse - gy;
+			float* rowX = xs + static_cast<size_t>(y) * width;
+			float* rowY = ys + static_cast<size_t>(y) * width;
+			for (uint32_t x = 0; x < width; x++) {
+				const uint32_t gx = min(static_cast<uint32_t>(x * inverse), gridWidth - 2);
+				const float fx = x * inverse - gx;
+				for (uint32_t axis = 0; axis < 2; axis++) {
+					const float* corner = grid + axis * points + gy * gridWidth + gx;
+					const float top = corner[0] + fx * (corner[1] - corner[0]);
+					const float bottom = corner[gridWidth] + fx * (corner[gridWidth + 1] - corner[gridWidth]);
+					(axis == 0 ? rowX : rowY)[x] += top + fy * (bottom - top);
+				}
+			}
+		}
+	}
+
+	// anything beyond the border reads the border, which is background as well
+	const float maxX = width - 0.001f;
+	const float maxY = height - 0.001f;
+	for (size_t i = 0; i < size; i++) {
+		xs[i] = min(maxX, max(-1.0f, xs[i]));
+		ys[i] = min(maxY, max(-1.0f, ys[i]));
+	}
+
+	sample(padded, paddedWidth, xs, ys, dst, size);
+}
+
+/**
+ *  @brief returns the width of the images
+ *
+ *  @return the width in pixels
+ */
+uint32_t Augmenter::getWidth() const {
+	return width;
+}
+
+/**
+ *  @brief returns the height of the images
+ *
+ *  @return the height in pixels
+ */
+uint32_t Augmenter::getHeight() const {
+	return height;
+}
+
+/**
+ *  @brief returns the bounds of the transformations
+ *
+ *  @return the parameters
+ */
+const AugmentationParams& Augmenter::getParams() const {
+	return params;
+}
@@ -0,0 +1,310 @@
+/**
+ *  @file    BatchLoader.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief prefetches shuffled minibatches on background threads
+ *
+ *  @section DESCRIPTION
+ *
+ *  This class sits between a Dataset and the math code. Every epoch
+ *  a Sampler orders the image indices (shuffled, stratified or class
+ *  balanced), and worker threads gather the
+ *  images of upcoming batches into pinned, aligned float buffers
+ *  while the consumer works on the current one. Batches are handed
+ *  out strictly in order, so a given seed always produces the same
+ *  sequence no matter how many workers run.
+ *
+ *  An optional Augmenter turns every gathered row into a random variant
+ *  on the worker that gathered it. The variant is keyed by the row's
+ *  position in the stream, so each epoch sees new variants while the
+ *  sequence stays reproducible.
+ *
+ */
+
+#include "BatchLoader.h"
+#include "AlignedMemory.h"
+#include "MathUtils.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+BatchLoaderException::BatchLoaderException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* BatchLoaderException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param dataset the images to serve (must outlive the loader)
+ *  @param batchSize the maximum number of rows per batch
+ *  @param prefetch the number of batches kept ready ahead of the consumer
+ *  @param numThreads the number of gathering threads
+ *  @param seed the seed for the epoch shuffles
+ *  @param augmenter distorts every gathered row (null serves the images as they are)
+ *  @param mode how the indices of every epoch are ordered
+ */
+BatchLoader::BatchLoader(
+	const Dataset& dataset,
+	uint32_t batchSize,
+	uint32_t prefetch,
+	uint32_t numThreads,
+	uint64_t seed,
+	const Augmenter* augmenter,
+	SamplingMode mode
+):
+	dataset(dataset),
+	batchSize(max<uint32_t>(1, batchSize)),
+	batchesPerEpoch((dataset.getCount() + max<uint32_t>(1, batchSize) - 1) / max<uint32_t>(1, batchSize)),
+	augmenter(augmenter),
+	slots(max<uint32_t>(1, prefetch) + 1),
+	sampler(dataset, mode, seed) {
+	// without a batch per epoch no worker could ever fill a slot for next() to wait on
+	if (batchesPerEpoch == 0) {
+		throw BatchLoaderException("The dataset has no images to load");
+	}
+	if (augmenter && (augmenter->getWidth() != dataset.getWidth() || augmenter->getHeight() != dataset.getHeight())) {
+		throw AugmenterException("The augmenter does not match the size of the dataset's images");
+	}
+
+	// normalized rows map a blank pixel to the offset, scaled pixels map it to 0
+	if (dataset.hasFeatures()) {
+		background = dataset.getNormalization().offset;
+	}
+
+	// every row starts on a cache line so rows can be read with aligned loads
+	const size_t stride = AlignedMemory::roundUp(dataset.getImageSize() * sizeof(float)) / sizeof(float);
+	const size_t pixelBytes = AlignedMemory::roundUp(stride * this->batchSize * sizeof(float));
+	const size_t labelBytes = AlignedMemory::roundUp(this->batchSize);
+	const size_t indexBytes = AlignedMemory::roundUp(this->batchSize * sizeof(uint32_t));
+	const size_t slotBytes = pixelBytes + labelBytes + indexBytes;
+
+	// one pinned allocation backs every slot
+	blockBytes = slotBytes * slots.size();
+	block = AlignedMemory::allocate(blockBytes);
+	pinned = AlignedMemory::lock(block, blockBytes);
+
+	uint8_t* cursor = static_cast<uint8_t*>(block);
+	for (Slot& slot : slots) {
+		slot.batch.pixels = reinterpret_cast<float*>(cursor);
+		slot.batch.labels = cursor + pixelBytes;
+		slot.batch.indices = reinterpret_cast<uint32_t*>(cursor + pixelBytes + labelBytes);
+		slot.batch.stride = stride;
+		cursor += slotBytes;
+	}
+
+	// the sampler orders the first epoch up front and later ones when their first batch is claimed
+	order = sampler.getPermutation();
+	shuffled.resize(order.size());
+	for (uint32_t i = 0; i < max<uint32_t>(1, numThreads); i++) {
+		workers.emplace_back(&BatchLoader::work, this);
+	}
+}
+
+/**
+ *  @brief destructor
+ */
+BatchLoader::~BatchLoader(void) {
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	changed.notify_all();
+
+	for (thread& worker : workers) {
+		worker.join();
+	}
+
+	if (pinned) {
+		AlignedMemory::unlock(block, blockBytes);
+	}
+	AlignedMemory::release(block);
+}
+
+/**
+ *  @brief the loop every worker runs until the loader is destroyed
+ *
+ *  @return void
+ */
+void BatchLoader::work(void) {
+	unique_lock<mutex> guard(lock);
+
+	while (true) {
+		// batch s always goes into slot s % slots.size(), so a worker can
+		// only claim it once the consumer has handed that slot back, and
+		// only once its epoch is ordered or it is the one to order it
+		changed.wait(guard, [this] {
+			const uint64_t epoch = nextSequence / batchesPerEpoch;
+			return stopping || (slots[nextSequence % slots.size()].state == SlotState::FREE &&
+				(epoch == orderEpoch || (epoch == orderEpoch + 1 && !shuffling)));
+		});
+		if (stopping) {
+			return;
+		}
+
+		const uint64_t sequence = nextSequence++;
+		Slot& slot = slots[sequence % slots.size()];
+		slot.state = SlotState::FILLING;
+
+		// batches are claimed in order, so every batch of the previous epoch has
+		// already copied its indices when the first batch of the next one is
+		// claimed; the shuffle runs without the lock and is swapped in under it
+		const uint32_t epoch = static_cast<uint32_t>(sequence / batchesPerEpoch);
+		if (epoch != orderEpoch) {
+			shuffling = true;
+			guard.unlock();
+			sampler.shuffle(epoch, shuffled);
+			guard.lock();
+			order.swap(shuffled);
+			orderEpoch = epoch;
+			shuffling = false;
+			changed.notify_all();
+		}
+
+		const uint32_t start = static_cast<uint32_t>(sequence % batchesPerEpoch) * batchSize;
+		Batch& batch = slot.batch;
+		batch.count = min(batchSize, dataset.getCount() - start);
+		batch.epoch = epoch;
+		batch.sequence = sequence;
+		copy(order.begin() + start, order.begin() + start + batch.count, batch.indices);
+
+		// the expensive part runs without the lock
+		guard.unlock();
+		gather(batch);
+		guard.lock();
+
+		slot.state = SlotState::READY;
+		changed.notify_all();
+	}
+}
+
+/**
+ *  @brief copies the listed images into the batch as the dataset's features,
+ *         or as floats in [0, 1] if it only holds pixels, then augments them
+ *
+ *  @param batch the batch whose indices are filled in
+ *  @return void
+ */
+void BatchLoader::gather(Batch& batch) const {
+	NNF_TRACE_SCOPE("BatchLoader::gather");
+	const size_t imageSize = dataset.getImageSize();
+	const float scale = 1.0f / 255.0f;
+
+	for (uint32_t row = 0; row < batch.count; row++) {
+		const uint32_t index = batch.indices[row];
+		float* dst = batch.pixels + batch.stride * row;
+
+		// normalized datasets already hold padded rows laid out like the batch
+		if (dataset.hasFeatures()) {
+			memcpy(dst, dataset.getFeatures(index), batch.stride * sizeof(float));
+		}
+		else {
+			MathUtils::normalize(dataset.getPixels(index), dst, imageSize, scale);
+			for (size_t i = imageSize; i < batch.stride; i++) {
+				dst[i] = 0.0f;
+			}
+		}
+
+		// keyed by the position in the stream, not the image, so every epoch gets new variants
+		if (augmenter) {
+			augmenter->apply(dst, dst, background, batch.sequence * batchSize + row);
+		}
+
+		batch.labels[row] = dataset.getLabel(index);
+	}
+}
+
+/**
+ *  @brief returns the next batch in the stream
+ *
+ *  @return the batch (valid until the next call)
+ */
+const Batch& BatchLoader::next(void) {
+	unique_lock<mutex> guard(lock);
+
+	// hand the previous batch back to the workers
+	if (current) {
+		current->state = SlotState::FREE;
+		current = nullptr;
+		changed.notify_all();
+	}
+
+	Slot& slot = slots[consumed % slots.size()];
+	if (slot.state != SlotState::READY) {
+		const auto start = chrono::steady_clock::now();
+		changed.wait(guard, [&slot] { return slot.state == SlotState::READY; });
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		waitSeconds += seconds;
+		waits++;
+		NNF_TRACE_HISTOGRAM("BatchLoader::wait (us)", seconds * 1e6);
+	}
+
+	slot.state = SlotState::IN_USE;
+	current = &slot;
+	consumed++;
+	return slot.batch;
+}
+
+/**
+ *  @brief returns the number of batches in one epoch
+ *
+ *  @return the number of batches (the last one may be partial)
+ */
+uint32_t BatchLoader::getBatchesPerEpoch() const {
+	return batchesPerEpoch;
+}
+
+/**
+ *  @brief returns the time the consumer spent blocked in next()
+ *
+ *  @return the total wait in seconds (a large value means training is input bound)
+ */
+double BatchLoader::getWaitSeconds() {
+	lock_guard<mutex> guard(lock);
+	return waitSeconds;
+}
+
+/**
+ *  @brief returns how many calls to next() had to wait
+ *
+ *  @return the number of blocking calls
+ */
+uint64_t BatchLoader::getWaitCount() {
+	lock_guard<mutex> guard(lock);
+	return waits;
+}
+
+/**
+ *  @brief returns the number of batches handed out
+ *
+ *  @return the number of batches
+ */
+uint64_t BatchLoader::getBatchesServed() {
+	lock_guard<mutex> guard(lock);
+	return consumed;
+}
+
+/**
+ *  @brief checks whether the batch buffers are pinned
+ *
+ *  @return true if the buffers are pinned
+ */
+bool BatchLoader::isPinned() const {
+	return pinned;
+}
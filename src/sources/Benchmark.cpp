@@ -0,0 +1,429 @@
+/**
+ *  @file    Benchmark.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief times the parser, the math kernels and the bmp encoder
+ *
+ *  @section DESCRIPTION
+ *
+ *  A Benchmark repeats an operation until it has run for a minimum
+ *  time and records the nanoseconds per call, the bytes moved per
+ *  second and the heap allocations per call. run() measures any
+ *  operation, and runAll() runs the standard suite: it writes
+ *  synthetic IDX files, so it needs no MNIST download, and then times
+ *  the parser, dot, randn, exp, zeroes and the bmp encoder at a few
+ *  sizes each.
+ *
+ *  The results can be printed as a table or written as JSON, which
+ *  lets two builds be compared to catch regressions.
+ *
+ */
+
+#include "Benchmark.h"
+#include "MNISTParser.h"
+#include "BitMapGenerator.h"
+#include "MathUtils.h"
+#include "AlignedMemory.h"
+#include "Philox.h"
+#include "Kernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <new>
+
+// the number of times the global operator new has run
+static atomic<uint64_t> heapAllocations(0);
+
+// the global allocation functions are replaced so every new can be counted (Note: one
+// relaxed increment per allocation, cheap enough to leave on outside of benchmarks).
+// The nothrow and sized forms are replaced too, so every allocation and release goes
+// through the same malloc and free whichever form the compiler picks
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+	heapAllocations.fetch_add(1, memory_order_relaxed);
+	return malloc(bytes == 0 ? 1 : bytes);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t& tag) noexcept {
+	return operator new(bytes, tag);
+}
+
+void* operator new(size_t bytes) {
+	void* ptr = operator new(bytes, std::nothrow);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t bytes) {
+	return operator new(bytes);
+}
+
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	free(ptr);
+}
+
+// keeps the results of the timed calls alive so the compiler cannot drop them
+static volatile double sink = 0.0;
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+BenchmarkException::BenchmarkException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* BenchmarkException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param directory where the synthetic files are written (must exist)
+ *  @param minSeconds the least time every benchmark runs for
+ */
+Benchmark::Benchmark(string directory, double minSeconds):
+	directory(directory),
+	minSeconds(max(1e-3, minSeconds)) {
+}
+
+/**
+ *  @brief times an operation
+ *
+ *  @param name what is measured
+ *  @param size the problem size reported with the result
+ *  @param bytes the bytes one call reads and writes
+ *  @param op the operation
+ *  @return the result (also kept in getResults)
+ */
+const BenchmarkResult& Benchmark::run(string name, uint64_t size, uint64_t bytes, const function<void()>& op) {
+	// the first call pays for page faults and cold caches
+	op();
+
+	uint64_t iterations = 1;
+	double seconds = 0.0;
+	uint64_t allocations = 0;
+	while (true) {
+		const uint64_t heapBefore = getHeapAllocationCount();
+		const uint64_t alignedBefore = AlignedMemory::getAllocationCount();
+		const auto start = chrono::steady_clock::now();
+		for (uint64_t i = 0; i < iterations; i++) {
+			op();
+		}
+		seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		allocations = (getHeapAllocationCount() - heapBefore) + (AlignedMemory::getAllocationCount() - alignedBefore);
+		if (seconds >= minSeconds) {
+			break;
+		}
+
+		// aim a little past the minimum, growing at least 2x and at most 100x per round
+		const double predicted = iterations * 1.2 * minSeconds / max(seconds, 1e-9);
+		iterations = static_cast<uint64_t>(min(iterations * 100.0, max(iterations * 2.0, predicted)));
+	}
+
+	BenchmarkResult result;
+	result.name = name;
+	result.size = size;
+	result.iterations = iterations;
+	result.nsPerOp = seconds * 1e9 / iterations;
+	result.gbPerSecond = static_cast<double>(bytes) * iterations / seconds * 1e-9;
+	result.allocationsPerOp = static_cast<double>(allocations) / iterations;
+	results.push_back(result);
+	return results.back();
+}
+
+/**
+ *  @brief writes an IDX image file of random pixels
+ *
+ *  @param name the path of the file
+ *  @param count the number of images
+ *  @param width the width of every image
+ *  @param height the height of every image
+ *  @param seed the seed of the pixels
+ *  @return void
+ */
+void Benchmark::writeImageFile(string name, uint32_t count, uint32_t width, uint32_t height, uint64_t seed) {
+	const uint32_t header[4] = { MNISTParser::IMAGE_MAGIC, count, height, width };
+	vector<uint8_t> bytes(MNISTParser::IMAGE_HEADER_SIZE + static_cast<size_t>(count) * width * height);
+	for (uint32_t i = 0; i < 4; i++) {
+		for (uint32_t b = 0; b < 4; b++) {
+			bytes[i * 4 + b] = static_cast<uint8_t>(header[i] >> (24 - 8 * b));
+		}
+	}
+
+	// whole words of random bits, the tail of the last one dropped
+	const size_t pixels = bytes.size() - MNISTParser::IMAGE_HEADER_SIZE;
+	vector<uint32_t> words((pixels + 15) / 16 * 4);
+	Philox(seed).generate(0, words.size() / 4, words.data());
+	memcpy(bytes.data() + MNISTParser::IMAGE_HEADER_SIZE, words.data(), pixels);
+
+	ofstream file(name, ios::binary);
+	file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	if (!file) {
+		throw BenchmarkException("File: " + name + " could not be written!");
+	}
+}
+
+/**
+ *  @brief writes an IDX label file of random digits
+ *
+ *  @param name the path of the file
+ *  @param count the number of labels
+ *  @param seed the seed of the labels
+ *  @return void
+ */
+void Benchmark::writeLabelFile(string name, uint32_t count, uint64_t seed) {
+	const uint32_t header[2] = { MNISTParser::LABEL_MAGIC, count };
+	vector<uint8_t> bytes(MNISTParser::LABEL_HEADER_SIZE + count);
+	for (uint32_t i = 0; i < 2; i++) {
+		for (uint32_t b = 0; b < 4; b++) {
+			bytes[i * 4 + b] = static_cast<uint8_t>(header[i] >> (24 - 8 * b));
+		}
+	}
+
+	vector<uint32_t> words((count + 3) / 4 * 4);
+	Philox(seed).generate(0, words.size() / 4, words.data());
+	for (uint32_t i = 0; i < count; i++) {
+		bytes[MNISTParser::LABEL_HEADER_SIZE + i] = static_cast<uint8_t>(words[i] % 10);
+	}
+
+	ofstream file(name, ios::binary);
+	file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	if (!file) {
+		throw BenchmarkException("File: " + name + " could not be written!");
+	}
+}
+
+/**
+ *  @brief times every way of parsing a MNIST file on synthetic files the size of the training set
+ *
+ *  @return void
+ */
+void Benchmark::runParser(void) {
+	const uint32_t count = 60000, width = 28, height = 28;
+	const string images = directory + "/benchmark-images.idx3-ubyte";
+	const string labels = directory + "/benchmark-labels.idx1-ubyte";
+	writeImageFile(images, count, width, height, 1);
+	writeLabelFile(labels, count, 2);
+	const uint64_t imageBytes = MNISTParser::IMAGE_HEADER_SIZE + static_cast<uint64_t>(count) * width * height;
+	const uint64_t labelBytes = MNISTParser::LABEL_HEADER_SIZE + count;
+
+	run("parseImageFile/dataset", count, imageBytes, [&] {
+		Dataset dataset;
+		MNISTParser::parseImageFile(dataset, images);
+		sink = dataset.getCount();
+	});
+
+	run("parseImageFile/features", count, imageBytes, [&] {
+		Dataset dataset;
+		MNISTParser::parseImageFile(dataset, images, Normalization::standard(Normalization::MNIST_MEAN, Normalization::MNIST_DEVIATION));
+		sink = dataset.getCount();
+	});
+
+	run("parseImageFile/images", count, imageBytes, [&] {
+		vector<ImageData*> parsed = MNISTParser::parseImageFile(images);
+		sink = static_cast<double>(parsed.size());
+		for (ImageData* image : parsed) {
+			delete image;
+		}
+	});
+
+	Dataset dataset;
+	MNISTParser::parseImageFile(dataset, images);
+	run("parseLabelFile/dataset", count, labelBytes, [&] {
+		MNISTParser::parseLabelFile(dataset, labels);
+		sink = dataset.getLabel(0);
+	});
+
+	remove(images.c_str());
+	remove(labels.c_str());
+}
+
+/**
+ *  @brief times the MathUtils kernels from cache sized to memory sized arrays
+ *
+ *  @return void
+ */
+void Benchmark::runMath(void) {
+	for (uint32_t length : { 256u, 4096u, 65536u, 1u << 20 }) {
+		vector<float> floats(length), moreFloats(length), floatSource(length);
+		vector<double> doubles(length), moreDoubles(length), doubleSource(length);
+		for (uint32_t i = 0; i < length; i++) {
+			floatSource[i] = floats[i] = moreFloats[i] = static_cast<float>(i % 17) * 0.25f - 2.0f;
+			doubleSource[i] = doubles[i] = moreDoubles[i] = static_cast<double>(i % 17) * 0.25 - 2.0;
+		}
+
+		run("dot<float>", length, 2ull * length * sizeof(float), [&] {
+			sink = MathUtils::dot(floats.data(), moreFloats.data(), length);
+		});
+		run("dot<double>", length, 2ull * length * sizeof(double), [&] {
+			sink = MathUtils::dot(doubles.data(), moreDoubles.data(), length);
+		});
+
+		// exp works in place, so every call first restores the input (the copy is part of the time)
+		run("exp<float>", length, 2ull * length * sizeof(float), [&] {
+			copy(floatSource.begin(), floatSource.end(), floats.begin());
+			sink = *MathUtils::exp(floats.data(), length);
+		});
+		run("exp<double>", length, 2ull * length * sizeof(double), [&] {
+			copy(doubleSource.begin(), doubleSource.end(), doubles.begin());
+			sink = *MathUtils::exp(doubles.data(), length);
+		});
+
+		run("randn", length, static_cast<uint64_t>(length) * sizeof(double), [&] {
+			double* mat = MathUtils::randn(1, length, 3);
+			sink = mat[0];
+			delete[] mat;
+		});
+		run("zeroes", length, static_cast<uint64_t>(length) * sizeof(double), [&] {
+			double* mat = MathUtils::zeroes(1, length);
+			sink = mat[0];
+			delete[] mat;
+		});
+	}
+}
+
+/**
+ *  @brief times encoding bmps in memory and writing one to disk
+ *
+ *  @return void
+ */
+void Benchmark::runBitMap(void) {
+	for (uint32_t width : { 28u, 256u, 1024u }) {
+		const uint32_t size = width * width;
+		vector<uint32_t> words((size + 15) / 16 * 4);
+		Philox(4).generate(0, words.size() / 4, words.data());
+		vector<uint8_t> pixels(size);
+		memcpy(pixels.data(), words.data(), size);
+		const ImageData image(pixels.data(), width, size, 0);
+
+		for (BitMapFormat format : { BitMapFormat::BGR, BitMapFormat::INDEXED }) {
+			const size_t encoded = BitMapGenerator::getEncodedSize(width, width, format);
+			vector<uint8_t> buffer(encoded);
+			const string name = format == BitMapFormat::BGR ? "encode/bgr" : "encode/indexed";
+			run(name, size, size + encoded, [&] {
+				sink = static_cast<double>(BitMapGenerator::encode(image, buffer.data(), buffer.size(), format));
+			});
+		}
+
+		const string filename = directory + "/benchmark-image.bmp";
+		const uint64_t encoded = BitMapGenerator::getEncodedSize(width, width);
+		run("generate", size, size + encoded, [&] {
+			BitMapGenerator::generate(image, filename);
+		});
+		remove(filename.c_str());
+	}
+}
+
+/**
+ *  @brief runs the standard suite
+ *
+ *  @return void
+ */
+void Benchmark::runAll(void) {
+	runParser();
+	runMath();
+	runBitMap();
+}
+
+/**
+ *  @brief returns the measurements so far
+ *
+ *  @return the results in the order they were run
+ */
+const vector<BenchmarkResult>& Benchmark::getResults() const {
+	return results;
+}
+
+/**
+ *  @brief prints the measurements as a table
+ *
+ *  @param out the stream to print to
+ *  @return void
+ */
+void Benchmark::print(ostream& out) const {
+	// the caller's formatting is put back afterwards
+	const ios::fmtflags flags = out.flags();
+	const streamsize precision = out.precision();
+	out << left << setw(26) << "benchmark" << right << setw(10) << "size" << setw(16) << "ns/op"
+		<< setw(10) << "GB/s" << setw(12) << "allocs/op" << endl;
+	for (const BenchmarkResult& result : results) {
+		out << left << setw(26) << result.name << right << setw(10) << result.size
+			<< fixed << setprecision(1) << setw(16) << result.nsPerOp
+			<< setprecision(2) << setw(10) << result.gbPerSecond
+			<< setw(12) << result.allocationsPerOp << endl;
+	}
+	out.flags(flags);
+	out.precision(precision);
+}
+
+/**
+ *  @brief writes the measurements as JSON, with the kernel level and
+ *         thread count they were taken with
+ *
+ *  @param filename the path of the file
+ *  @return void
+ */
+void Benchmark::writeJson(string filename) const {
+	// the level the kernels actually ran at, which NNF_ISA or the host may lower
+	const char* isa = Kernels::getName(Kernels::getIsa());
+
+	ofstream file(filename);
+	file << "{\n\t\"isa\": \"" << isa << "\",\n\t\"threads\": " << MathUtils::getNumThreads() << ",\n\t\"results\": [";
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& result = results[i];
+		file << (i == 0 ? "\n" : ",\n") << "\t\t{ \"name\": \"" << result.name << "\", \"size\": " << result.size
+			<< ", \"iterations\": " << result.iterations << setprecision(9)
+			<< ", \"nsPerOp\": " << result.nsPerOp << ", \"gbPerSecond\": " << result.gbPerSecond
+			<< ", \"allocationsPerOp\": " << result.allocationsPerOp << " }";
+	}
+	file << "\n\t]\n}\n";
+
+	if (!file) {
+		throw BenchmarkException("File: " + filename + " could not be written!");
+	}
+}
+
+/**
+ *  @brief returns how many times the global operator new has run
+ *
+ *  @return the number of heap allocations since the program started
+ */
+uint64_t Benchmark::getHeapAllocationCount() {
+	return heapAllocations.load(memory_order_relaxed);
+}
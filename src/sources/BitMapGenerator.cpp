@@ -11,118 +11,433 @@
 *  This static class contains one useful function for writing
 *  a ImageData object to a bmp file.
 *
+*  Every bmp is encoded into a memory buffer and written with a
+*  single call. Whole sets of images can be exported to a directory
+*  in parallel, or tiled into one mosaic bmp for a quick look at
+*  thousands of samples at once.
+*
+*  Images can be encoded as 8 bit indexed bmps, whose palette holds
+*  the colors, or as 24 bit BGR bmps, in either case through a color
+*  map. Encoding targets a caller provided buffer or a vector, so
+*  previews can be streamed or embedded without touching the disk.
+*
 */
 
 #include "BitMapGenerator.h"
+#include "MathUtils.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+BitMapGeneratorException::BitMapGeneratorException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* BitMapGeneratorException::what() const noexcept {
+	return message.c_str();
+}
 
 /**
  *  @brief Takes the Buffer stored in the ImageData and writes a bmp file
- *  
- *  @param img reference to a pointer of type ImageData
+ *
+ *  @param img the image (or image view) to write
  *  @param filename the full path of the bmp that will be generated
+ *  @param format the pixel layout of the file
+ *  @param colors the colors the gray values are drawn with
  *  @return void
  */
-void BitMapGenerator::generate(ImageData*& img, string filename) {
+void BitMapGenerator::generate(const ImageData& img, string filename, BitMapFormat format, ColorMap colors) {
+	NNF_TRACE_SCOPE("BitMapGenerator::generate");
+	vector<uint8_t> buffer;
+	BitMapGenerator::encode(img, buffer, format, colors);
+
 	ofstream out(filename.c_str(), std::ofstream::out | std::ofstream::binary);
+	out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+
+	// close the file
+	out.close();
+}
+
+/**
+ *  @brief returns the size of an encoded bmp
+ *
+ *  @param width the width of the image in pixels
+ *  @param height the height of the image in pixels
+ *  @param format the pixel layout
+ *  @return the headers, the palette if any, and height rows padded to 4 bytes
+ */
+size_t BitMapGenerator::getEncodedSize(uint32_t width, uint32_t height, BitMapFormat format) {
+	const bool indexed = format == BitMapFormat::INDEXED;
+	const size_t rowBytes = (static_cast<size_t>(width) * (indexed ? 1 : 3) + 3) & ~static_cast<size_t>(3);
+	return HEADERSIZE + (indexed ? PALETTESIZE : 0) + rowBytes * height;
+}
+
+/**
+ *  @brief fills a palette with the colors of a color map
+ *
+ *  @param colors the color map
+ *  @param palette receives the blue, green and red of every gray value
+ *  @return void
+ */
+void BitMapGenerator::getPalette(ColorMap colors, uint8_t palette[256][3]) {
+	for (uint32_t p = 0; p < 256; p++) {
+		uint32_t red = p, green = p, blue = p;
+
+		if (colors == ColorMap::INVERTED_GRAY) {
+			red = green = blue = 255 - p;
+		}
+		else if (colors == ColorMap::HEAT) {
+			// red rises over the first third, then green, then blue
+			red = min<uint32_t>(255, 3 * p);
+			green = p < 85 ? 0 : min<uint32_t>(255, 3 * p - 255);
+			blue = p < 170 ? 0 : min<uint32_t>(255, 3 * p - 510);
+		}
+		else if (colors == ColorMap::DIVERGING) {
+			// blue fades into white at 128, which then fades into red
+			if (p < 128) {
+				red = green = p * 255 / 128;
+				blue = 255;
+			}
+			else {
+				red = 255;
+				green = blue = (255 - p) * 255 / 127;
+			}
+		}
+
+		palette[p][0] = static_cast<uint8_t>(blue);
+		palette[p][1] = static_cast<uint8_t>(green);
+		palette[p][2] = static_cast<uint8_t>(red);
+	}
+}
+
+/**
+ *  @brief encodes gray pixels as a bmp into a caller provided buffer
+ *
+ *  @param pixels width x height gray values stored row after row
+ *  @param width the width of the image in pixels
+ *  @param height the height of the image in pixels
+ *  @param buffer receives the whole file
+ *  @param capacity the size of buffer in bytes
+ *  @param format the pixel layout
+ *  @param colors the colors the gray values are drawn with
+ *  @return the size of the file, or 0 if it does not fit in capacity
+ */
+size_t BitMapGenerator::encode(const uint8_t* pixels, uint32_t width, uint32_t height, uint8_t* buffer, size_t capacity,
+	BitMapFormat format, ColorMap colors) {
+	const size_t fileSize = BitMapGenerator::getEncodedSize(width, height, format);
+	if (capacity < fileSize) {
+		return 0;
+	}
+
+	const bool indexed = format == BitMapFormat::INDEXED;
+	const uint32_t rowBytes = (width * (indexed ? 1 : 3) + 3) & ~3u;
+	const uint32_t offset = HEADERSIZE + (indexed ? PALETTESIZE : 0);
 
-	uint16_t width = img->getWidth();
-	uint16_t height = img->getHeight();
-	uint16_t size = width * height;
-	
 	// Here is the basic format for bmp files
 	// 2 bytes for BFTYPE which is always set to 19778
 	// 4 bytes for BFSIZE which is set to the total file size
 	// 2 bytes for BFRESERVED1 which is always set to 0
 	// 2 bytes for BFRESERVED2 which is always set to 0
-	// 4 bytes for BFOFFBITS which is set to the sum of bytes of both headers
+	// 4 bytes for BFOFFBITS which is set to the sum of bytes of both headers (and the palette)
 	//
 	// 4 bytes for BISIZE size of bit map info header which is always set to 40
 	// 4 bytes for BIWIDTH which is set to the image width in pixels
 	// 4 bytes for BIHEIGHT which is set to the image height in pixels
 	// 2 bytes for BIPLANES which is set to the number of color planes being used
-	// 2 bytes for BIBITCOUNT which is the number of bits per pixel (24 for RGB)
+	// 2 bytes for BIBITCOUNT which is the number of bits per pixel (24 for RGB, 8 for a palette)
 	// 4 bytes for BICOMPRESSION which is the type of compression (0 for none)
+	// 4 bytes for BISIZEIMAGE which is the size of the padded pixel rows
 	// 4 bytes for BIXPELSPERMETER which is the horizontal pixels per meter
 	// 4 bytes for BIYPELSPERMETER which is the vertical pixels per meter
 	// 4 bytes for BICLRUSED which is the number of colors used (if set to 0 then it is calculated from BIBITCOUNT)
 	// 4 bytes for BICLRIMPORTANT which is the number of color that are important (if set to 0 then all are important)
+	//
+	// An 8 bit file follows the headers with 256 palette entries of BGR plus a reserved byte
+
+	uint8_t* out = buffer;
+	out = BitMapGenerator::write(out, BFTYPE, 19778);
+	out = BitMapGenerator::write(out, BFSIZE, static_cast<uint32_t>(fileSize));
+	out = BitMapGenerator::write(out, BFRESERVED1, 0);
+	out = BitMapGenerator::write(out, BFRESERVED2, 0);
+	out = BitMapGenerator::write(out, BFOFFBITS, offset);
+	out = BitMapGenerator::write(out, BISIZE, 40);
+	out = BitMapGenerator::write(out, BIWIDTH, width);
+	out = BitMapGenerator::write(out, BIHEIGHT, height);
+	out = BitMapGenerator::write(out, BIPLANES, 1);
+	out = BitMapGenerator::write(out, BIBITCOUNT, indexed ? 8 : 24);
+	out = BitMapGenerator::write(out, BICOMPRESSION, 0);
+	out = BitMapGenerator::write(out, BISIZEIMAGE, rowBytes * height);
+	out = BitMapGenerator::write(out, BIXPELSPERMETER, 0);
+	out = BitMapGenerator::write(out, BIYPELSPERMETER, 0);
+	out = BitMapGenerator::write(out, BICLRUSED, indexed ? 256 : 0);
+	out = BitMapGenerator::write(out, BICLRIMPORTANT, 0);
+
+	uint8_t palette[256][3];
+	BitMapGenerator::getPalette(colors, palette);
+	if (indexed) {
+		for (uint32_t p = 0; p < 256; p++) {
+			out[0] = palette[p][0];
+			out[1] = palette[p][1];
+			out[2] = palette[p][2];
+			out[3] = 0;
+			out += 4;
+		}
+	}
+
+	// Begin writing from the bottomost row and work your way up. An
+	// indexed row is the gray values themselves, a BGR row looks every
+	// value up in the palette. Rows are padded with 0 to 4 bytes
+	for (uint32_t y = height - 1; y < height; y--) {
+		const uint8_t* row = pixels + static_cast<size_t>(y) * width;
+		uint8_t* dst = out;
+
+		if (indexed) {
+			memcpy(dst, row, width);
+			dst += width;
+		}
+		else {
+			for (uint32_t x = 0; x < width; x++) {
+				const uint8_t* color = palette[row[x]];
+				dst[0] = color[0];
+				dst[1] = color[1];
+				dst[2] = color[2];
+				dst += 3;
+			}
+		}
+
+		fill(dst, out + rowBytes, static_cast<uint8_t>(0));
+		out += rowBytes;
+	}
+
+	return fileSize;
+}
+
+/**
+ *  @brief encodes an image as a bmp into a caller provided buffer
+ *
+ *  @param img the image (or image view) to encode
+ *  @param buffer receives the whole file
+ *  @param capacity the size of buffer in bytes
+ *  @param format the pixel layout
+ *  @param colors the colors the gray values are drawn with
+ *  @return the size of the file, or 0 if it does not fit in capacity
+ */
+size_t BitMapGenerator::encode(const ImageData& img, uint8_t* buffer, size_t capacity, BitMapFormat format, ColorMap colors) {
+	return BitMapGenerator::encode(img.getData(), img.getWidth(), img.getHeight(), buffer, capacity, format, colors);
+}
 
-	uint16_t remainder = width % 4;
-	uint32_t fileSize = size * 3 + remainder * height + HEADERSIZE;
-
-	BitMapGenerator::write(out, BFTYPE, 19778);
-	BitMapGenerator::write(out, BFSIZE, fileSize);
-	BitMapGenerator::write(out, BFRESERVED1, 0);
-	BitMapGenerator::write(out, BFRESERVED2, 0);
-	BitMapGenerator::write(out, BFOFFBITS, HEADERSIZE);
-	BitMapGenerator::write(out, BISIZE, 40);
-	BitMapGenerator::write(out, BIWIDTH, width);
-	BitMapGenerator::write(out, BIHEIGHT, height);
-	BitMapGenerator::write(out, BIPLANES, 1);
-	BitMapGenerator::write(out, BIBITCOUNT, 24);
-	BitMapGenerator::write(out, BICOMPRESSION, 0);
-	BitMapGenerator::write(out, BISIZEIMAGE, size * 3);
-	BitMapGenerator::write(out, BIXPELSPERMETER, 0);
-	BitMapGenerator::write(out, BIYPELSPERMETER, 0);
-	BitMapGenerator::write(out, BICLRUSED, 0);
-	BitMapGenerator::write(out, BICLRIMPORTANT, 0);
-	
-	// The way to write the pixel data for RGB is to write
-	// BGR. Also begin writing from the bottomost row and work
-	// your way up. If the number of bytes written per row is not
-	// divisible by 4 then pad it with bytes set to 0 until it is
-	for (uint16_t y = height - 1; y < height; y--) {
-		for (uint16_t x = 0; x < width; x++) {
-			uint8_t val = ~img->getPixel(x, y);
-			BitMapGenerator::write(out, RGBBLUE, val);
-			BitMapGenerator::write(out, RGBGREEN, val);
-			BitMapGenerator::write(out, RGBRED, val);
+/**
+ *  @brief encodes an image as a bmp in memory
+ *
+ *  @param img the image (or image view) to encode
+ *  @param buffer receives the whole file (resized to fit)
+ *  @param format the pixel layout
+ *  @param colors the colors the gray values are drawn with
+ *  @return void
+ */
+void BitMapGenerator::encode(const ImageData& img, vector<uint8_t>& buffer, BitMapFormat format, ColorMap colors) {
+	buffer.resize(BitMapGenerator::getEncodedSize(img.getWidth(), img.getHeight(), format));
+	BitMapGenerator::encode(img, buffer.data(), buffer.size(), format, colors);
+}
+
+/**
+ *  @brief writes one bmp per image into a directory in parallel
+ *
+ *  @param images the images (or image views) to write
+ *  @param directory the existing directory that receives the files
+ *  @param prefix the start of every file name
+ *  @param format the pixel layout of the files
+ *  @return the number of files written
+ */
+uint32_t BitMapGenerator::exportImages(const vector<ImageData>& images, string directory, string prefix, BitMapFormat format) {
+	NNF_TRACE_SCOPE("BitMapGenerator::exportImages");
+	const uint32_t count = static_cast<uint32_t>(images.size());
+
+	// every slice reuses one buffer for all of its images
+	ThreadPool::getGlobal().parallelFor(count, MathUtils::getNumThreads(), [&](uint64_t begin, uint64_t end) {
+		vector<uint8_t> buffer;
+		for (uint64_t i = begin; i < end; i++) {
+			const ImageData& img = images[i];
+			BitMapGenerator::encode(img, buffer, format);
+			BitMapGenerator::save(buffer, BitMapGenerator::join(
+				directory, prefix + "_" + to_string(i) + "_" + to_string(img.getLabel()) + ".bmp"
+			));
 		}
+	});
+
+	return count;
+}
+
+/**
+ *  @brief writes one bmp per listed dataset image into a directory in parallel
+ *
+ *  @param dataset the dataset holding the images (it must keep its pixels)
+ *  @param indices the images to write (the index is part of the file name)
+ *  @param directory the existing directory that receives the files
+ *  @param prefix the start of every file name
+ *  @param format the pixel layout of the files
+ *  @return the number of files written
+ */
+uint32_t BitMapGenerator::exportImages(const Dataset& dataset, const vector<uint32_t>& indices, string directory, string prefix, BitMapFormat format) {
+	NNF_TRACE_SCOPE("BitMapGenerator::exportImages");
+	if (!dataset.hasPixels()) {
+		throw BitMapGeneratorException("The dataset does not keep its pixels");
+	}
+	const uint32_t count = static_cast<uint32_t>(indices.size());
 
-		if (remainder == 1) {
-			BitMapGenerator::write(out, RGBRESERVED, 0);
+	ThreadPool::getGlobal().parallelFor(count, MathUtils::getNumThreads(), [&](uint64_t begin, uint64_t end) {
+		vector<uint8_t> buffer;
+		for (uint64_t i = begin; i < end; i++) {
+			const uint32_t index = indices[i];
+			BitMapGenerator::encode(dataset.getImage(index), buffer, format);
+			BitMapGenerator::save(buffer, BitMapGenerator::join(
+				directory, prefix + "_" + to_string(index) + "_" + to_string(dataset.getLabel(index)) + ".bmp"
+			));
 		}
-		else if (remainder == 2) {
-			BitMapGenerator::write(out, RGBRESERVED, 0);
-			BitMapGenerator::write(out, RGBRESERVED, 0);
+	});
+
+	return count;
+}
+
+/**
+ *  @brief tiles images into one grid and writes it as a single bmp
+ *
+ *  @param images the images (or image views) to tile, in row major order
+ *  @param columns the number of cells per row of the grid
+ *  @param filename the full path of the bmp that will be generated
+ *  @param spacing the width in pixels of the grid lines between cells
+ *  @param format the pixel layout of the file
+ *  @return void
+ */
+void BitMapGenerator::generateMosaic(const vector<ImageData>& images, uint32_t columns, string filename, uint32_t spacing, BitMapFormat format) {
+	NNF_TRACE_SCOPE("BitMapGenerator::generateMosaic");
+	if (images.empty()) {
+		throw BitMapGeneratorException("A mosaic needs at least one image");
+	}
+	columns = max<uint32_t>(1, min<uint32_t>(columns, static_cast<uint32_t>(images.size())));
+	const uint32_t rows = static_cast<uint32_t>((images.size() + columns - 1) / columns);
+
+	// every cell is as large as the largest image
+	uint32_t cellWidth = 0, cellHeight = 0;
+	for (const ImageData& img : images) {
+		cellWidth = max(cellWidth, img.getWidth());
+		cellHeight = max(cellHeight, img.getHeight());
+	}
+
+	// the canvas holds raw pixels so the cells are inverted like single images
+	const uint32_t width = columns * cellWidth + (columns + 1) * spacing;
+	const uint32_t height = rows * cellHeight + (rows + 1) * spacing;
+	vector<uint8_t> canvas(static_cast<size_t>(width) * height, MOSAICGRID);
+
+	ThreadPool::getGlobal().parallelFor(images.size(), MathUtils::getNumThreads(), [&](uint64_t begin, uint64_t end) {
+		for (uint64_t i = begin; i < end; i++) {
+			const ImageData& img = images[i];
+			const uint32_t left = static_cast<uint32_t>(i % columns) * (cellWidth + spacing) + spacing;
+			const uint32_t top = static_cast<uint32_t>(i / columns) * (cellHeight + spacing) + spacing;
+
+			// smaller images sit in the top left corner of a blank cell
+			for (uint32_t y = 0; y < cellHeight; y++) {
+				uint8_t* dst = canvas.data() + static_cast<size_t>(top + y) * width + left;
+				fill(dst, dst + cellWidth, static_cast<uint8_t>(0));
+				if (y < img.getHeight()) {
+					memcpy(dst, img.getData() + static_cast<size_t>(y) * img.getWidth(), img.getWidth());
+				}
+			}
 		}
-		else if (remainder == 3) {
-			BitMapGenerator::write(out, RGBRESERVED, 0);
-			BitMapGenerator::write(out, RGBRESERVED, 0);
-			BitMapGenerator::write(out, RGBRESERVED, 0);
+	});
+
+	// cells past the last image stay blank
+	for (size_t i = images.size(); i < static_cast<size_t>(rows) * columns; i++) {
+		const uint32_t left = static_cast<uint32_t>(i % columns) * (cellWidth + spacing) + spacing;
+		const uint32_t top = static_cast<uint32_t>(i / columns) * (cellHeight + spacing) + spacing;
+		for (uint32_t y = 0; y < cellHeight; y++) {
+			uint8_t* dst = canvas.data() + static_cast<size_t>(top + y) * width + left;
+			fill(dst, dst + cellWidth, static_cast<uint8_t>(0));
 		}
 	}
 
-	// close the file
-	out.close();
-};
+	vector<uint8_t> buffer(BitMapGenerator::getEncodedSize(width, height, format));
+	BitMapGenerator::encode(canvas.data(), width, height, buffer.data(), buffer.size(), format);
+	BitMapGenerator::save(buffer, filename);
+}
+
+/**
+ *  @brief tiles the listed images of a dataset into one grid and writes it as a single bmp
+ *
+ *  @param dataset the dataset holding the images (it must keep its pixels)
+ *  @param indices the images to tile, in row major order
+ *  @param columns the number of cells per row of the grid
+ *  @param filename the full path of the bmp that will be generated
+ *  @param spacing the width in pixels of the grid lines between cells
+ *  @param format the pixel layout of the file
+ *  @return void
+ */
+void BitMapGenerator::generateMosaic(const Dataset& dataset, const vector<uint32_t>& indices, uint32_t columns, string filename, uint32_t spacing, BitMapFormat format) {
+	if (!dataset.hasPixels()) {
+		throw BitMapGeneratorException("The dataset does not keep its pixels");
+	}
+
+	vector<ImageData> images;
+	images.reserve(indices.size());
+	for (uint32_t index : indices) {
+		images.push_back(dataset.getImage(index));
+	}
+	BitMapGenerator::generateMosaic(images, columns, filename, spacing, format);
+}
 
 /**
  *  @brief writes n bytes to out
  *
- *  @param out the ofstream containing the bmp file output
+ *  @param out the buffer containing the bmp file output
  *  @param n the number of bytes to be written
  *  @param val the 32 bit integer containing the data to be written
+ *  @return the byte after the ones written
+ */
+uint8_t* BitMapGenerator::write(uint8_t* out, uint8_t n, uint32_t val) {
+	// bmp fields are little endian
+	for (uint8_t i = 0; i < n; i++) {
+		out[i] = static_cast<uint8_t>(val >> (8 * i));
+	}
+	return out + n;
+}
+
+/**
+ *  @brief writes a finished bmp to a file with a single write
+ *
+ *  @param buffer the encoded bmp
+ *  @param filename the full path of the file
  *  @return void
  */
-void BitMapGenerator::write(ofstream& out, uint8_t n, uint32_t val) {
-	unsigned char c1, c2, c3, c4;
-	switch (n) {
-		case 1:
-			c1 = c1 = (val & 0x000000ff);
-			out << c1;
-			break;
-		case 2:
-			c1 = (val & 0x0000ff00) >> 8;
-			c2 = (val & 0x000000ff);
-			out << c2 << c1;
-			break;
-		case 4:
-			c1 = (val & 0xff000000) >> 24;
-			c2 = (val & 0x00ff0000) >> 16;
-			c3 = (val & 0x0000ff00) >> 8;
-			c4 = (val & 0x000000ff);
-			out << c4 << c3 << c2 << c1;
-			break;
+void BitMapGenerator::save(const vector<uint8_t>& buffer, const string& filename) {
+	NNF_TRACE_SCOPE("BitMapGenerator::save");
+	ofstream out(filename.c_str(), std::ofstream::out | std::ofstream::binary);
+	out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+	if (!out) {
+		throw BitMapGeneratorException("File: " + filename + " could not be written!");
+	}
+}
+
+/**
+ *  @brief joins a directory and a file name
+ *
+ *  @param directory the directory (with or without a trailing separator)
+ *  @param name the file name
+ *  @return the full path
+ */
+string BitMapGenerator::join(const string& directory, const string& name) {
+	if (directory.empty() || directory.back() == '/' || directory.back() == '\\') {
+		return directory + name;
 	}
-}
\ No newline at end of file
+	return directory + "/" + name;
+}
@@ -0,0 +1,422 @@
+/**
+ *  @file    Checkpoint.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief a versioned binary file of named weight matrices that loads by mmap
+ *
+ *  @section DESCRIPTION
+ *
+ *  A checkpoint starts with a 64 byte header, followed by one 64 byte
+ *  entry per tensor holding its name, element type, shape and the
+ *  offset of its elements. Every tensor starts on a 64 byte boundary,
+ *  so once the file is mapped the entries and the weights are used in
+ *  place: opening a checkpoint only checks that the header and the
+ *  entries are consistent, it never parses or copies the data.
+ *
+ *  Files are written to a temporary name and renamed over the target,
+ *  so a reader only ever sees a complete checkpoint.
+ *
+ */
+
+#include "Checkpoint.h"
+#include "AlignedMemory.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(CheckpointHeader) == 64, "the checkpoint header must be 64 bytes");
+static_assert(sizeof(CheckpointEntry) == 64, "a checkpoint entry must be 64 bytes");
+
+/**
+ *  @brief FNV-1a taken over 64 bit words instead of bytes
+ *
+ *  @param data the first byte (8 byte aligned)
+ *  @param bytes the number of bytes (a multiple of 8)
+ *  @return the hash
+ */
+static uint64_t checksum(const uint8_t* data, size_t bytes) {
+	const uint64_t* words = reinterpret_cast<const uint64_t*>(data);
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < bytes / sizeof(uint64_t); i++) {
+		hash = (hash ^ words[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+CheckpointException::CheckpointException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* CheckpointException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief returns the size of the elements in bytes
+ *
+ *  @return rows * cols * the element size
+ */
+size_t CheckpointTensor::getBytes() const {
+	return static_cast<size_t>(rows) * cols * Checkpoint::getElementSize(type);
+}
+
+/**
+ *  @brief empty constructor
+ */
+Checkpoint::Checkpoint(void) {
+}
+
+/**
+ *  @brief constructor that maps a checkpoint
+ *
+ *  @param name the name of the file
+ */
+Checkpoint::Checkpoint(string name) {
+	open(name);
+}
+
+/**
+ *  @brief maps a checkpoint and checks its header and entries
+ *
+ *  @param name the name of the file
+ *  @return void
+ */
+void Checkpoint::open(string name) {
+	header = nullptr;
+	entries = nullptr;
+
+	try {
+		file.open(name);
+	}
+	catch (const MappedFileException& e) {
+		throw CheckpointException(e.what());
+	}
+
+	if (file.getSize() < sizeof(CheckpointHeader)) {
+		throw CheckpointException("File: " + name + " is too small to be a checkpoint!");
+	}
+
+	// the mapping is page aligned and everything in the file is laid out for in place use
+	header = reinterpret_cast<const CheckpointHeader*>(file.getData());
+	entries = reinterpret_cast<const CheckpointEntry*>(file.getData() + sizeof(CheckpointHeader));
+	try {
+		validate(name);
+	}
+	catch (...) {
+		header = nullptr;
+		entries = nullptr;
+		throw;
+	}
+}
+
+/**
+ *  @brief checks that the header and entries describe a well formed file
+ *
+ *  @param name the name of the file (for the error messages)
+ *  @return void
+ */
+void Checkpoint::validate(const string& name) const {
+	char magic[sizeof(header->magic)] = {};
+	strncpy(magic, MAGIC, sizeof(magic));
+	if (memcmp(header->magic, magic, sizeof(magic)) != 0) {
+		throw CheckpointException("File: " + name + " is not a checkpoint!");
+	}
+	if (header->endianTag != ENDIAN_TAG) {
+		throw CheckpointException("File: " + name + " was written with a different byte order!");
+	}
+	if (header->version == 0 || header->version > VERSION) {
+		throw CheckpointException("File: " + name + " has unsupported version " + to_string(header->version) + "!");
+	}
+	if (header->fileSize != file.getSize() || header->alignment != ALIGNMENT) {
+		throw CheckpointException("File: " + name + " is truncated or corrupt!");
+	}
+
+	const uint64_t size = file.getSize();
+	if (header->tensorCount > (size - sizeof(CheckpointHeader)) / sizeof(CheckpointEntry)) {
+		throw CheckpointException("File: " + name + " has more entries than fit in it!");
+	}
+
+	for (uint32_t i = 0; i < header->tensorCount; i++) {
+		const CheckpointEntry& entry = entries[i];
+		const CheckpointType type = static_cast<CheckpointType>(entry.type);
+		if (type != CheckpointType::FLOAT64 && type != CheckpointType::FLOAT32 && type != CheckpointType::BFLOAT16) {
+			throw CheckpointException("File: " + name + " has an entry of unknown type!");
+		}
+		if (entry.name[sizeof(entry.name) - 1] != '\0') {
+			throw CheckpointException("File: " + name + " has an unterminated entry name!");
+		}
+
+		const uint64_t bytes = static_cast<uint64_t>(entry.rows) * entry.cols * getElementSize(type);
+		if (entry.offset % ALIGNMENT != 0 || entry.offset > size || bytes > size - entry.offset) {
+			throw CheckpointException("File: " + name + " has an entry outside the file!");
+		}
+	}
+}
+
+/**
+ *  @brief checks whether a checkpoint is mapped
+ *
+ *  @return true if a checkpoint is mapped
+ */
+bool Checkpoint::isOpen() const {
+	return header != nullptr;
+}
+
+/**
+ *  @brief returns the format version of the file
+ *
+ *  @return the version
+ */
+uint32_t Checkpoint::getVersion() const {
+	return header ? header->version : 0;
+}
+
+/**
+ *  @brief returns the counter the checkpoint was saved with
+ *
+ *  @return the step
+ */
+uint64_t Checkpoint::getStep() const {
+	return header ? header->step : 0;
+}
+
+/**
+ *  @brief returns the number of tensors
+ *
+ *  @return the tensor count
+ */
+uint32_t Checkpoint::getTensorCount() const {
+	return header ? header->tensorCount : 0;
+}
+
+/**
+ *  @brief returns the ith tensor
+ *
+ *  @param i the index of the tensor
+ *  @return the tensor, pointing into the mapping
+ */
+CheckpointTensor Checkpoint::getTensor(uint32_t i) const {
+	if (i >= getTensorCount()) {
+		throw CheckpointException("Checkpoint: tensor " + to_string(i) + " does not exist!");
+	}
+
+	const CheckpointEntry& entry = entries[i];
+	CheckpointTensor tensor;
+	tensor.name = entry.name;
+	tensor.type = static_cast<CheckpointType>(entry.type);
+	tensor.rows = entry.rows;
+	tensor.cols = entry.cols;
+	tensor.data = file.getData() + entry.offset;
+	return tensor;
+}
+
+/**
+ *  @brief returns the tensor with a given name
+ *
+ *  @param name the name of the tensor
+ *  @return the tensor, pointing into the mapping
+ */
+CheckpointTensor Checkpoint::getTensor(const string& name) const {
+	for (uint32_t i = 0; i < getTensorCount(); i++) {
+		if (name == entries[i].name) {
+			return getTensor(i);
+		}
+	}
+	throw CheckpointException("Checkpoint: tensor " + name + " does not exist!");
+}
+
+/**
+ *  @brief checks whether a tensor has a given name
+ *
+ *  @param name the name of the tensor
+ *  @return true if the checkpoint holds it
+ */
+bool Checkpoint::contains(const string& name) const {
+	for (uint32_t i = 0; i < getTensorCount(); i++) {
+		if (name == entries[i].name) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ *  @brief copies a tensor into a matrix of the same type and shape
+ *
+ *  @param name the name of the tensor
+ *  @param mat the matrix to overwrite
+ *  @return void
+ */
+template <typename T>
+void Checkpoint::load(const string& name, BasicMatrix<T>& mat) const {
+	const CheckpointTensor tensor = getTensor(name);
+	if (tensor.type != CheckpointTypeOf<T>::value) {
+		throw CheckpointException("Checkpoint: tensor " + name + " has a different element type!");
+	}
+	if (tensor.rows != mat.getRows() || tensor.cols != mat.getCols()) {
+		throw CheckpointException(
+			"Checkpoint: tensor " + name + " is " + to_string(tensor.rows) + "x" + to_string(tensor.cols) +
+			" but the matrix is " + to_string(mat.getRows()) + "x" + to_string(mat.getCols()) + "!"
+		);
+	}
+	memcpy(mat.getData(), tensor.data, tensor.getBytes());
+}
+
+template void Checkpoint::load<double>(const string& name, BasicMatrix<double>& mat) const;
+template void Checkpoint::load<float>(const string& name, BasicMatrix<float>& mat) const;
+template void Checkpoint::load<BFloat16>(const string& name, BasicMatrix<BFloat16>& mat) const;
+
+/**
+ *  @brief recomputes the checksum of the file
+ *
+ *  @return true if it matches the one in the header
+ */
+bool Checkpoint::verify() const {
+	if (!header) {
+		return false;
+	}
+	return checksum(file.getData() + sizeof(CheckpointHeader), file.getSize() - sizeof(CheckpointHeader)) == header->checksum;
+}
+
+/**
+ *  @brief lays out a whole checkpoint file in memory
+ *
+ *  @param tensors the tensors to store, in order
+ *  @param step a counter stored in the header
+ *  @param image the file contents (resized to fit; its capacity is reused)
+ *  @return void
+ */
+void Checkpoint::encode(const vector<CheckpointTensor>& tensors, uint64_t step, vector<uint8_t>& image) {
+	uint64_t offset = AlignedMemory::roundUp(sizeof(CheckpointHeader) + tensors.size() * sizeof(CheckpointEntry), ALIGNMENT);
+	vector<uint64_t> offsets(tensors.size());
+	for (size_t i = 0; i < tensors.size(); i++) {
+		if (tensors[i].name.size() > CheckpointTensor::MAX_NAME) {
+			throw CheckpointException("Checkpoint: tensor name " + tensors[i].name + " is too long!");
+		}
+		if (!tensors[i].data && tensors[i].getBytes() > 0) {
+			throw CheckpointException("Checkpoint: tensor " + tensors[i].name + " has no data!");
+		}
+		offsets[i] = offset;
+		offset = AlignedMemory::roundUp(offset + tensors[i].getBytes(), ALIGNMENT);
+	}
+
+	// the padding between tensors is zeroed so equal weights give equal files
+	image.assign(static_cast<size_t>(offset), 0);
+
+	CheckpointHeader* header = reinterpret_cast<CheckpointHeader*>(image.data());
+	strncpy(header->magic, MAGIC, sizeof(header->magic));
+	header->version = VERSION;
+	header->tensorCount = static_cast<uint32_t>(tensors.size());
+	header->fileSize = offset;
+	header->step = step;
+	header->endianTag = ENDIAN_TAG;
+	header->alignment = ALIGNMENT;
+
+	CheckpointEntry* entries = reinterpret_cast<CheckpointEntry*>(image.data() + sizeof(CheckpointHeader));
+	for (size_t i = 0; i < tensors.size(); i++) {
+		memcpy(entries[i].name, tensors[i].name.data(), tensors[i].name.size());
+		entries[i].type = static_cast<uint32_t>(tensors[i].type);
+		entries[i].rows = tensors[i].rows;
+		entries[i].cols = tensors[i].cols;
+		entries[i].offset = offsets[i];
+		if (tensors[i].getBytes() > 0) {
+			memcpy(image.data() + offsets[i], tensors[i].data, tensors[i].getBytes());
+		}
+	}
+
+	header->checksum = checksum(image.data() + sizeof(CheckpointHeader), image.size() - sizeof(CheckpointHeader));
+}
+
+/**
+ *  @brief writes a file image next to its destination and renames it into place
+ *
+ *  @param image the file contents
+ *  @param name the name of the file
+ *  @return void
+ */
+void Checkpoint::write(const vector<uint8_t>& image, const string& name) {
+	const string temporary = name + ".tmp";
+
+	FILE* out = fopen(temporary.c_str(), "wb");
+	if (!out) {
+		throw CheckpointException("File: " + temporary + " failed to open!");
+	}
+
+	bool written = fwrite(image.data(), 1, image.size(), out) == image.size() && fflush(out) == 0;
+
+	// the data has to be on disk before the rename makes it visible
+#ifdef _WIN32
+	written = written && _commit(_fileno(out)) == 0;
+#else
+	written = written && fsync(fileno(out)) == 0;
+#endif
+	written = fclose(out) == 0 && written;
+
+	if (!written) {
+		remove(temporary.c_str());
+		throw CheckpointException("File: " + temporary + " failed to write!");
+	}
+
+#ifdef _WIN32
+	const bool renamed = MoveFileExA(temporary.c_str(), name.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	const bool renamed = rename(temporary.c_str(), name.c_str()) == 0;
+#endif
+	if (!renamed) {
+		remove(temporary.c_str());
+		throw CheckpointException("File: " + temporary + " failed to replace " + name + "!");
+	}
+}
+
+/**
+ *  @brief encodes and writes a checkpoint on the calling thread
+ *
+ *  @param tensors the tensors to store, in order
+ *  @param step a counter stored in the header
+ *  @param name the name of the file
+ *  @return void
+ */
+void Checkpoint::save(const vector<CheckpointTensor>& tensors, uint64_t step, const string& name) {
+	vector<uint8_t> image;
+	encode(tensors, step, image);
+	write(image, name);
+}
+
+/**
+ *  @brief returns the size of one element
+ *
+ *  @param type the element type
+ *  @return the size in bytes
+ */
+size_t Checkpoint::getElementSize(CheckpointType type) {
+	switch (type) {
+	case CheckpointType::FLOAT64:
+		return sizeof(double);
+	case CheckpointType::FLOAT32:
+		return sizeof(float);
+	case CheckpointType::BFLOAT16:
+		return sizeof(BFloat16);
+	}
+	return 0;
+}
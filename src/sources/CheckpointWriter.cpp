@@ -0,0 +1,139 @@
+/**
+ *  @file    CheckpointWriter.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief saves checkpoints on a background thread
+ *
+ *  @section DESCRIPTION
+ *
+ *  save() only copies the tensors into a file image in memory and
+ *  returns; a thread owned by the writer then writes the image to
+ *  disk and renames it into place, so the training loop never waits
+ *  on the disk. The writer keeps two images: the one being written
+ *  and the newest one waiting. When a save arrives while another one
+ *  is still waiting, the waiting one is replaced, since only the
+ *  latest weights are worth keeping.
+ *
+ */
+
+#include "CheckpointWriter.h"
+
+/**
+ *  @brief constructor
+ */
+CheckpointWriter::CheckpointWriter(void) {
+	worker = thread(&CheckpointWriter::work, this);
+}
+
+/**
+ *  @brief destructor
+ */
+CheckpointWriter::~CheckpointWriter(void) {
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+/**
+ *  @brief the loop the thread runs until the writer is destroyed
+ *
+ *  @return void
+ */
+void CheckpointWriter::work(void) {
+	unique_lock<mutex> guard(lock);
+	while (true) {
+		wake.wait(guard, [this] { return stopping || hasPending; });
+		if (!hasPending) {
+			return;
+		}
+
+		// take the image and let save() fill the other buffer while this one is written
+		writing.swap(pending);
+		const string name = pendingName;
+		hasPending = false;
+		busy = true;
+		guard.unlock();
+
+		exception_ptr failure;
+		try {
+			Checkpoint::write(writing, name);
+		}
+		catch (...) {
+			failure = current_exception();
+		}
+
+		guard.lock();
+		busy = false;
+		if (failure) {
+			if (!error) {
+				error = failure;
+			}
+		}
+		else {
+			saved++;
+		}
+		idle.notify_all();
+	}
+}
+
+/**
+ *  @brief copies tensors into an image and queues it
+ *
+ *  @param tensors the tensors to store, in order
+ *  @param step a counter stored in the header
+ *  @param name the name of the file
+ *  @return void
+ */
+void CheckpointWriter::save(const vector<CheckpointTensor>& tensors, uint64_t step, const string& name) {
+	{
+		lock_guard<mutex> guard(lock);
+		Checkpoint::encode(tensors, step, pending);
+		if (hasPending) {
+			skipped++;
+		}
+		pendingName = name;
+		hasPending = true;
+	}
+	wake.notify_one();
+}
+
+/**
+ *  @brief blocks until nothing is queued or being written
+ *
+ *  @return void
+ */
+void CheckpointWriter::wait(void) {
+	unique_lock<mutex> guard(lock);
+	idle.wait(guard, [this] { return !hasPending && !busy; });
+
+	if (error) {
+		exception_ptr failure = error;
+		error = nullptr;
+		rethrow_exception(failure);
+	}
+}
+
+/**
+ *  @brief returns the number of files written
+ *
+ *  @return the count
+ */
+uint64_t CheckpointWriter::getSavedCount() {
+	lock_guard<mutex> guard(lock);
+	return saved;
+}
+
+/**
+ *  @brief returns the number of images dropped for a newer one
+ *
+ *  @return the count
+ */
+uint64_t CheckpointWriter::getSkippedCount() {
+	lock_guard<mutex> guard(lock);
+	return skipped;
+}
@@ -0,0 +1,498 @@
+/**
+ *  @file    Dataset.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief a contiguous container for a whole set of images and labels
+ *
+ *  @section DESCRIPTION
+ *
+ *  This container keeps every image of a dataset in one aligned
+ *  N x H x W block of pixels and every label in a separate contiguous
+ *  array. Rows and minibatches are handed out as pointer plus stride
+ *  views so nothing has to chase per-image heap allocations.
+ *
+ *  Next to (or instead of) the raw pixels a dataset can hold its
+ *  images already converted to normalized floats, one padded row per
+ *  image, so training reads network inputs straight from memory
+ *  instead of converting every image again each epoch.
+ *
+ *  The blocks can also live inside a mapped file (see DatasetCache),
+ *  in which case the dataset keeps the mapping alive instead of owning
+ *  heap blocks.
+ *
+ */
+
+#include "Dataset.h"
+#include "AlignedMemory.h"
+#include "MathUtils.h"
+#include "ThreadPool.h"
+
+#include <cstring>
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+DatasetException::DatasetException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* DatasetException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief returns the map onto [0, 1]
+ *
+ *  @return a normalization that divides by 255
+ */
+Normalization Normalization::unit(void) {
+	return Normalization();
+}
+
+/**
+ *  @brief returns the map that standardizes pixels
+ *
+ *  @param mean the mean pixel in [0, 1] units
+ *  @param deviation the standard deviation of the pixels in [0, 1] units
+ *  @return a normalization that computes (p / 255 - mean) / deviation
+ */
+Normalization Normalization::standard(float mean, float deviation) {
+	Normalization normalization;
+	normalization.scale = 1.0f / (255.0f * deviation);
+	normalization.offset = -mean / deviation;
+	return normalization;
+}
+
+/**
+ *  @brief empty constructor
+ */
+Dataset::Dataset(void) {
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param count the number of images
+ *  @param width the width of each image in pixels
+ *  @param height the height of each image in pixels
+ *  @param storage the forms in which the images are kept
+ */
+Dataset::Dataset(uint32_t count, uint32_t width, uint32_t height, DatasetStorage storage) {
+	resize(count, width, height, storage);
+}
+
+/**
+ *  @brief destructor
+ */
+Dataset::~Dataset(void) {
+	release();
+}
+
+/**
+ *  @brief move constructor
+ *
+ *  @param other the dataset to take the blocks from
+ */
+Dataset::Dataset(Dataset&& other) noexcept:
+	pixels(other.pixels),
+	features(other.features),
+	labels(other.labels),
+	count(other.count),
+	width(other.width),
+	height(other.height),
+	normalization(other.normalization),
+	mapping(move(other.mapping)) {
+	other.pixels = nullptr;
+	other.features = nullptr;
+	other.labels = nullptr;
+	other.count = 0;
+}
+
+/**
+ *  @brief move assignment
+ *
+ *  @param other the dataset to take the blocks from
+ *  @return this dataset
+ */
+Dataset& Dataset::operator=(Dataset&& other) noexcept {
+	if (this != &other) {
+		release();
+		pixels = other.pixels;
+		features = other.features;
+		labels = other.labels;
+		count = other.count;
+		width = other.width;
+		height = other.height;
+		normalization = other.normalization;
+		mapping = move(other.mapping);
+		other.pixels = nullptr;
+		other.features = nullptr;
+		other.labels = nullptr;
+		other.count = 0;
+	}
+	return *this;
+}
+
+/**
+ *  @brief frees the pixel, feature and label blocks
+ *
+ *  @return void
+ */
+void Dataset::release(void) {
+	if (ownsBlock(pixels)) {
+		AlignedMemory::release(pixels);
+	}
+	if (ownsBlock(features)) {
+		AlignedMemory::release(features);
+	}
+	if (ownsBlock(labels)) {
+		AlignedMemory::release(labels);
+	}
+	pixels = nullptr;
+	features = nullptr;
+	labels = nullptr;
+	count = 0;
+	mapping.reset();
+}
+
+/**
+ *  @brief checks whether a block has to be freed by the dataset
+ *
+ *  @param block the first byte of the block
+ *  @return true if the block is not inside the mapped file
+ */
+bool Dataset::ownsBlock(const void* block) const {
+	if (!block || !mapping) {
+		return block != nullptr;
+	}
+
+	const uint8_t* byte = static_cast<const uint8_t*>(block);
+	return byte < mapping->getData() || byte >= mapping->getData() + mapping->getSize();
+}
+
+/**
+ *  @brief replaces the contents with blocks inside a mapped file
+ *
+ *  @param file the mapping the blocks live in
+ *  @param count the number of images
+ *  @param width the width of each image in pixels
+ *  @param height the height of each image in pixels
+ *  @param pixels count * getStride() pixels (nullptr if not kept)
+ *  @param features count * getFeatureStride() features, 64 byte aligned (nullptr if not kept)
+ *  @param labels count labels
+ *  @param normalization how the features were produced
+ *  @return void
+ */
+void Dataset::attach(shared_ptr<MappedFile> file, uint32_t count, uint32_t width, uint32_t height,
+	uint8_t* pixels, float* features, uint8_t* labels, const Normalization& normalization) {
+	release();
+	mapping = move(file);
+	this->pixels = pixels;
+	this->features = features;
+	this->labels = labels;
+	this->count = count;
+	this->width = width;
+	this->height = height;
+	this->normalization = normalization;
+}
+
+/**
+ *  @brief checks whether the blocks live inside a mapped file
+ *
+ *  @return true if the dataset holds a mapping
+ */
+bool Dataset::isMapped() const {
+	return mapping != nullptr;
+}
+
+/**
+ *  @brief reallocates the dataset
+ *
+ *  @param count the number of images
+ *  @param width the width of each image in pixels
+ *  @param height the height of each image in pixels
+ *  @param storage the forms in which the images are kept
+ *  @return void
+ */
+void Dataset::resize(uint32_t count, uint32_t width, uint32_t height, DatasetStorage storage) {
+	release();
+	this->count = count;
+	this->width = width;
+	this->height = height;
+	normalization = Normalization();
+
+	if (storage != DatasetStorage::FEATURES) {
+		const size_t pixelBytes = static_cast<size_t>(count) * getStride();
+		pixels = static_cast<uint8_t*>(AlignedMemory::allocate(pixelBytes));
+		memset(pixels, 0, pixelBytes);
+	}
+	if (storage != DatasetStorage::PIXELS) {
+		const size_t featureBytes = static_cast<size_t>(count) * getFeatureStride() * sizeof(float);
+		features = static_cast<float*>(AlignedMemory::allocate(featureBytes));
+		memset(features, 0, featureBytes);
+	}
+	labels = static_cast<uint8_t*>(AlignedMemory::allocate(count));
+	memset(labels, 0, count);
+}
+
+/**
+ *  @brief converts the pixels into features
+ *
+ *  @param normalization how every pixel is mapped to a feature
+ *  @param keepPixels false to free the pixels once they are converted
+ *  @return void
+ */
+void Dataset::normalize(const Normalization& normalization, bool keepPixels) {
+	if (!pixels) {
+		return;
+	}
+
+	if (!features) {
+		const size_t featureBytes = static_cast<size_t>(count) * getFeatureStride() * sizeof(float);
+		features = static_cast<float*>(AlignedMemory::allocate(featureBytes));
+		memset(features, 0, featureBytes);
+	}
+	this->normalization = normalization;
+
+	const size_t imageSize = getImageSize();
+	ThreadPool::getGlobal().parallelFor(count, MathUtils::getNumThreads(), [&](uint64_t begin, uint64_t end) {
+		for (uint64_t i = begin; i < end; i++) {
+			MathUtils::normalize(getPixels(static_cast<uint32_t>(i)), getFeatures(static_cast<uint32_t>(i)),
+				imageSize, normalization.scale, normalization.offset);
+		}
+	});
+
+	if (!keepPixels) {
+		if (ownsBlock(pixels)) {
+			AlignedMemory::release(pixels);
+		}
+		pixels = nullptr;
+	}
+}
+
+/**
+ *  @brief records how the features were produced
+ *
+ *  @param normalization the map that was applied to the pixels
+ *  @return void
+ */
+void Dataset::setNormalization(const Normalization& normalization) {
+	this->normalization = normalization;
+}
+
+/**
+ *  @brief returns how the features were produced
+ *
+ *  @return the map that was applied to the pixels
+ */
+const Normalization& Dataset::getNormalization() const {
+	return normalization;
+}
+
+/**
+ *  @brief returns the number of images
+ *
+ *  @return the number of images
+ */
+uint32_t Dataset::getCount() const {
+	return count;
+}
+
+/**
+ *  @brief returns the width of each image
+ *
+ *  @return the width in pixels
+ */
+uint32_t Dataset::getWidth() const {
+	return width;
+}
+
+/**
+ *  @brief returns the height of each image
+ *
+ *  @return the height in pixels
+ */
+uint32_t Dataset::getHeight() const {
+	return height;
+}
+
+/**
+ *  @brief returns the number of pixels in each image
+ *
+ *  @return width * height
+ */
+size_t Dataset::getImageSize() const {
+	return static_cast<size_t>(width) * height;
+}
+
+/**
+ *  @brief returns the distance between two consecutive images
+ *
+ *  @return the stride in bytes
+ */
+size_t Dataset::getStride() const {
+	return getImageSize();
+}
+
+/**
+ *  @brief returns the distance between two consecutive feature rows
+ *
+ *  @return the stride in floats
+ */
+size_t Dataset::getFeatureStride() const {
+	return AlignedMemory::roundUp(getImageSize() * sizeof(float)) / sizeof(float);
+}
+
+/**
+ *  @brief checks whether the raw pixels are kept
+ *
+ *  @return true if getPixels can be used
+ */
+bool Dataset::hasPixels() const {
+	return pixels != nullptr;
+}
+
+/**
+ *  @brief checks whether the normalized features are kept
+ *
+ *  @return true if getFeatures can be used
+ */
+bool Dataset::hasFeatures() const {
+	return features != nullptr;
+}
+
+/**
+ *  @brief checks whether the dataset is empty
+ *
+ *  @return true if there are no images
+ */
+bool Dataset::empty() const {
+	return count == 0;
+}
+
+/**
+ *  @brief returns the pixels of an image
+ *
+ *  @param i the index of the image
+ *  @return a pointer to the first pixel of the image (nullptr without pixels)
+ */
+const uint8_t* Dataset::getPixels(uint32_t i) const {
+	return pixels ? pixels + getStride() * i : nullptr;
+}
+
+/**
+ *  @brief returns the pixels of an image
+ *
+ *  @param i the index of the image
+ *  @return a pointer to the first pixel of the image (nullptr without pixels)
+ */
+uint8_t* Dataset::getPixels(uint32_t i) {
+	return pixels ? pixels + getStride() * i : nullptr;
+}
+
+/**
+ *  @brief returns the features of an image
+ *
+ *  @param i the index of the image
+ *  @return a pointer to the first feature of the image (nullptr without features)
+ */
+const float* Dataset::getFeatures(uint32_t i) const {
+	return features ? features + getFeatureStride() * i : nullptr;
+}
+
+/**
+ *  @brief returns the features of an image
+ *
+ *  @param i the index of the image
+ *  @return a pointer to the first feature of the image (nullptr without features)
+ */
+float* Dataset::getFeatures(uint32_t i) {
+	return features ? features + getFeatureStride() * i : nullptr;
+}
+
+/**
+ *  @brief returns the label array
+ *
+ *  @return a pointer to the first label
+ */
+const uint8_t* Dataset::getLabels() const {
+	return labels;
+}
+
+/**
+ *  @brief returns the label array
+ *
+ *  @return a pointer to the first label
+ */
+uint8_t* Dataset::getLabels() {
+	return labels;
+}
+
+/**
+ *  @brief returns the label of an image
+ *
+ *  @param i the index of the image
+ *  @return the label
+ */
+uint8_t Dataset::getLabel(uint32_t i) const {
+	return labels[i];
+}
+
+/**
+ *  @brief sets the label of an image
+ *
+ *  @param i the index of the image
+ *  @param label the label
+ *  @return void
+ */
+void Dataset::setLabel(uint32_t i, uint8_t label) {
+	labels[i] = label;
+}
+
+/**
+ *  @brief returns a view over consecutive images
+ *
+ *  @param start the index of the first image
+ *  @param count the number of images (clamped to the end of the dataset)
+ *  @return the batch view
+ */
+DatasetBatch Dataset::getBatch(uint32_t start, uint32_t count) const {
+	DatasetBatch batch;
+	if (start >= this->count) {
+		return batch;
+	}
+
+	batch.pixels = getPixels(start);
+	batch.features = getFeatures(start);
+	batch.labels = labels + start;
+	batch.count = count < this->count - start ? count : this->count - start;
+	batch.width = width;
+	batch.height = height;
+	batch.stride = getStride();
+	batch.featureStride = getFeatureStride();
+	return batch;
+}
+
+/**
+ *  @brief returns a non-owning view of an image
+ *
+ *  @param i the index of the image
+ *  @return the view (valid as long as the dataset is alive)
+ */
+ImageData Dataset::getImage(uint32_t i) const {
+	// a dataset that only keeps features has no pixels to view
+	if (!pixels) {
+		throw DatasetException("The dataset does not keep its pixels");
+	}
+	return ImageData(
+		getPixels(i), width, static_cast<uint32_t>(getImageSize()), labels[i]
+	);
+}
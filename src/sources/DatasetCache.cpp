@@ -0,0 +1,437 @@
+/**
+ *  @file    DatasetCache.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief a preprocessed binary copy of a dataset that loads by mapping it
+ *
+ *  @section DESCRIPTION
+ *
+ *  Parsing MNIST means inflating the .gz files, byte swapping headers
+ *  and normalizing every pixel on every start. This static class does
+ *  that work once: the first load parses the source files the usual
+ *  way and writes the resulting Dataset blocks into a cache file laid
+ *  out exactly as they sit in memory, each block page aligned. Every
+ *  later load maps that file copy-on-write and hands the blocks to the
+ *  Dataset in place, so nothing is parsed or copied.
+ *
+ *  The header records the sizes and modification times of the source
+ *  files together with the storage and normalization, and a cache that
+ *  no longer matches them is rebuilt. A checksum over everything after
+ *  the header catches corrupt files. Files are written to a temporary
+ *  name and renamed into place, so a crash never leaves a partial
+ *  cache behind.
+ *
+ */
+
+#include "DatasetCache.h"
+#include "MNISTParser.h"
+#include "AlignedMemory.h"
+#include "MappedFile.h"
+#include "Tracer.h"
+
+#include <iostream>
+#include <memory>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(DatasetCacheHeader) == 128, "the dataset cache header must be 128 bytes");
+
+namespace {
+	// the FNV-1a offset basis and prime
+	const uint64_t FNV_OFFSET = 14695981039346656037ull;
+	const uint64_t FNV_PRIME = 1099511628211ull;
+
+	/**
+	 *  @brief looks up the size and modification time of a file
+	 *
+	 *  @param name the full path of the file
+	 *  @param size receives the size in bytes
+	 *  @param modified receives the modification time in seconds
+	 *  @return false if the file does not exist
+	 */
+	bool describeFile(const string& name, uint64_t& size, uint64_t& modified) {
+#ifdef _WIN32
+		struct _stat64 info;
+		if (_stat64(name.c_str(), &info) != 0) {
+			return false;
+		}
+#else
+		struct stat info;
+		if (stat(name.c_str(), &info) != 0) {
+			return false;
+		}
+#endif
+		size = static_cast<uint64_t>(info.st_size);
+		modified = static_cast<uint64_t>(info.st_mtime);
+		return true;
+	}
+
+	/**
+	 *  @brief mixes a value into an FNV-1a hash one byte at a time
+	 *
+	 *  @param hash the hash so far
+	 *  @param value the value
+	 *  @return the extended hash
+	 */
+	uint64_t mix(uint64_t hash, uint64_t value) {
+		for (int i = 0; i < 8; i++) {
+			hash = (hash ^ ((value >> (8 * i)) & 0xFF)) * FNV_PRIME;
+		}
+		return hash;
+	}
+}
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+DatasetCacheException::DatasetCacheException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* DatasetCacheException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief fills a dataset from its cache or builds the cache from the source files
+ *
+ *  @param dataset the dataset that receives the images and labels
+ *  @param imageName the full path of the (plain or gzip) MNIST image file
+ *  @param labelName the full path of the (plain or gzip) MNIST label file
+ *  @param cacheName the full path of the cache file
+ *  @param storage the forms in which the images are kept
+ *  @param normalization how every pixel is mapped to a feature (unused with PIXELS)
+ *  @param verify true to check the checksum of an existing cache
+ *  @return void
+ */
+void DatasetCache::load(Dataset& dataset, string imageName, string labelName, string cacheName,
+	DatasetStorage storage, const Normalization& normalization, bool verify) {
+	NNF_TRACE_SCOPE("DatasetCache::load");
+	const uint64_t sourceKey = getSourceKey(imageName, labelName, storage, normalization);
+
+	// a missing cache is just the first run, anything else wrong with it gets reported
+	uint64_t size = 0;
+	uint64_t modified = 0;
+	if (describeFile(cacheName, size, modified)) {
+		try {
+			open(dataset, cacheName, sourceKey, verify);
+			return;
+		}
+		catch (const DatasetCacheException& e) {
+			cout << e.what() << " Rebuilding it." << endl;
+		}
+	}
+
+	if (storage == DatasetStorage::PIXELS) {
+		MNISTParser::parseImageFile(dataset, imageName);
+	} else {
+		MNISTParser::parseImageFile(dataset, imageName, normalization, storage);
+	}
+	MNISTParser::parseLabelFile(dataset, labelName);
+	if (dataset.empty()) {
+		return;
+	}
+
+	try {
+		save(dataset, cacheName, sourceKey);
+	}
+	catch (const DatasetCacheException& e) {
+		// the parsed dataset is still good, only the next start will be slow again
+		cout << e.what() << endl;
+	}
+}
+
+/**
+ *  @brief maps a cache file and attaches its blocks to a dataset
+ *
+ *  @param dataset the dataset that receives the blocks
+ *  @param name the full path of the cache file
+ *  @param sourceKey the key the cache has to have been built with (0 for any)
+ *  @param verify true to check the checksum (reads the whole file)
+ *  @return void
+ */
+void DatasetCache::open(Dataset& dataset, string name, uint64_t sourceKey, bool verify) {
+	NNF_TRACE_SCOPE("DatasetCache::open");
+
+	// copy-on-write so the dataset can be written to like a parsed one without touching the file
+	shared_ptr<MappedFile> file = make_shared<MappedFile>();
+	try {
+		file->open(name, MappedFileMode::COPY_ON_WRITE);
+	}
+	catch (const MappedFileException& e) {
+		throw DatasetCacheException(e.what());
+	}
+
+	if (file->getSize() < ALIGNMENT) {
+		throw DatasetCacheException("File: " + name + " is too small to be a dataset cache!");
+	}
+
+	const DatasetCacheHeader& header = *reinterpret_cast<const DatasetCacheHeader*>(file->getData());
+	validate(header, file->getSize(), name);
+	if (sourceKey != 0 && header.sourceKey != sourceKey) {
+		throw DatasetCacheException("File: " + name + " was built from different source files or settings!");
+	}
+	if (verify && checksum(FNV_OFFSET, file->getData() + ALIGNMENT, file->getSize() - ALIGNMENT) != header.checksum) {
+		throw DatasetCacheException("File: " + name + " failed its checksum!");
+	}
+
+	Normalization normalization;
+	normalization.scale = header.scale;
+	normalization.offset = header.offset;
+
+	uint8_t* base = file->getWritableData();
+	dataset.attach(file, header.count, header.width, header.height,
+		header.pixelOffset ? base + header.pixelOffset : nullptr,
+		header.featureOffset ? reinterpret_cast<float*>(base + header.featureOffset) : nullptr,
+		base + header.labelOffset, normalization);
+}
+
+/**
+ *  @brief checks that a header describes a well formed file
+ *
+ *  @param header the header at the start of the file
+ *  @param size the size of the file in bytes
+ *  @param name the name of the file (for the error messages)
+ *  @return void
+ */
+void DatasetCache::validate(const DatasetCacheHeader& header, uint64_t size, const string& name) {
+	char magic[sizeof(header.magic)] = {};
+	strncpy(magic, MAGIC, sizeof(magic));
+	if (memcmp(header.magic, magic, sizeof(magic)) != 0) {
+		throw DatasetCacheException("File: " + name + " is not a dataset cache!");
+	}
+	if (header.endianTag != ENDIAN_TAG) {
+		throw DatasetCacheException("File: " + name + " was written with a different byte order!");
+	}
+	if (header.version == 0 || header.version > VERSION) {
+		throw DatasetCacheException("File: " + name + " has unsupported version " + to_string(header.version) + "!");
+	}
+	if (header.fileSize != size || header.alignment != ALIGNMENT) {
+		throw DatasetCacheException("File: " + name + " is truncated or corrupt!");
+	}
+	if (header.storage > static_cast<uint32_t>(DatasetStorage::BOTH)) {
+		throw DatasetCacheException("File: " + name + " has an unknown storage!");
+	}
+
+	// the features are handed out in place, so their rows must be padded the way Dataset pads them
+	const size_t imageSize = static_cast<size_t>(header.width) * header.height;
+	if (header.featureStride != AlignedMemory::roundUp(imageSize * sizeof(float)) / sizeof(float)) {
+		throw DatasetCacheException("File: " + name + " was written with a different feature stride!");
+	}
+
+	const DatasetStorage storage = static_cast<DatasetStorage>(header.storage);
+	const bool pixels = storage != DatasetStorage::FEATURES;
+	const bool features = storage != DatasetStorage::PIXELS;
+	if ((header.pixelOffset != 0) != pixels || (header.featureOffset != 0) != features) {
+		throw DatasetCacheException("File: " + name + " does not hold the blocks its storage needs!");
+	}
+
+	const uint64_t offsets[3] = { header.labelOffset, header.pixelOffset, header.featureOffset };
+	const uint64_t bytes[3] = {
+		header.count,
+		static_cast<uint64_t>(header.count) * imageSize,
+		static_cast<uint64_t>(header.count) * header.featureStride * sizeof(float)
+	};
+	for (int i = 0; i < 3; i++) {
+		if (i > 0 && offsets[i] == 0) {
+			continue;
+		}
+		if (offsets[i] < ALIGNMENT || offsets[i] % ALIGNMENT != 0 || offsets[i] > size || bytes[i] > size - offsets[i]) {
+			throw DatasetCacheException("File: " + name + " has a block outside the file!");
+		}
+	}
+}
+
+/**
+ *  @brief writes a dataset next to its destination and renames it into place
+ *
+ *  @param dataset the dataset to store
+ *  @param name the full path of the cache file
+ *  @param sourceKey the key load compares against (see getSourceKey)
+ *  @return void
+ */
+void DatasetCache::save(const Dataset& dataset, string name, uint64_t sourceKey) {
+	NNF_TRACE_SCOPE("DatasetCache::save");
+	if (dataset.empty()) {
+		throw DatasetCacheException("There are no images in this dataset.");
+	}
+
+	const uint64_t count = dataset.getCount();
+	const uint64_t labelBytes = count;
+	const uint64_t pixelBytes = dataset.hasPixels() ? count * dataset.getStride() : 0;
+	const uint64_t featureBytes = dataset.hasFeatures() ? count * dataset.getFeatureStride() * sizeof(float) : 0;
+
+	DatasetCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.endianTag = ENDIAN_TAG;
+	header.sourceKey = sourceKey;
+	header.count = dataset.getCount();
+	header.width = dataset.getWidth();
+	header.height = dataset.getHeight();
+	header.storage = static_cast<uint32_t>(!dataset.hasFeatures() ? DatasetStorage::PIXELS :
+		!dataset.hasPixels() ? DatasetStorage::FEATURES : DatasetStorage::BOTH);
+	header.scale = dataset.getNormalization().scale;
+	header.offset = dataset.getNormalization().offset;
+	header.alignment = ALIGNMENT;
+	header.featureStride = static_cast<uint32_t>(dataset.getFeatureStride());
+
+	// the header gets a page to itself, then every block starts on a page of its own
+	uint64_t offset = ALIGNMENT;
+	header.labelOffset = offset;
+	offset += AlignedMemory::roundUp(static_cast<size_t>(labelBytes), ALIGNMENT);
+	if (pixelBytes > 0) {
+		header.pixelOffset = offset;
+		offset += AlignedMemory::roundUp(static_cast<size_t>(pixelBytes), ALIGNMENT);
+	}
+	if (featureBytes > 0) {
+		header.featureOffset = offset;
+		offset += AlignedMemory::roundUp(static_cast<size_t>(featureBytes), ALIGNMENT);
+	}
+	header.fileSize = offset;
+
+	const string temporary = name + ".tmp";
+	FILE* out = fopen(temporary.c_str(), "wb");
+	if (!out) {
+		throw DatasetCacheException("File: " + temporary + " failed to open!");
+	}
+
+	// the blocks are streamed straight from the dataset and hashed on the way, the header
+	// goes in last once the checksum is known
+	uint64_t hash = FNV_OFFSET;
+	bool written = writeBlock(out, nullptr, 0, hash);
+	written = written && writeBlock(out, dataset.getLabels(), static_cast<size_t>(labelBytes), hash);
+	if (pixelBytes > 0) {
+		written = written && writeBlock(out, dataset.getPixels(0), static_cast<size_t>(pixelBytes), hash);
+	}
+	if (featureBytes > 0) {
+		written = written && writeBlock(out, dataset.getFeatures(0), static_cast<size_t>(featureBytes), hash);
+	}
+	header.checksum = hash;
+	written = written && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1 && fflush(out) == 0;
+
+	// the data has to be on disk before the rename makes it visible
+#ifdef _WIN32
+	written = written && _commit(_fileno(out)) == 0;
+#else
+	written = written && fsync(fileno(out)) == 0;
+#endif
+	written = fclose(out) == 0 && written;
+
+	if (!written) {
+		remove(temporary.c_str());
+		throw DatasetCacheException("File: " + temporary + " failed to write!");
+	}
+
+#ifdef _WIN32
+	const bool renamed = MoveFileExA(temporary.c_str(), name.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	const bool renamed = rename(temporary.c_str(), name.c_str()) == 0;
+#endif
+	if (!renamed) {
+		remove(temporary.c_str());
+		throw DatasetCacheException("File: " + temporary + " failed to replace " + name + "!");
+	}
+}
+
+/**
+ *  @brief identifies the source files and the settings a cache is built with
+ *
+ *  @param imageName the full path of the image file
+ *  @param labelName the full path of the label file
+ *  @param storage the forms in which the images are kept
+ *  @param normalization how every pixel is mapped to a feature (ignored with PIXELS)
+ *  @return the key (0 if either file is missing)
+ */
+uint64_t DatasetCache::getSourceKey(string imageName, string labelName, DatasetStorage storage,
+	const Normalization& normalization) {
+	uint64_t imageSize = 0;
+	uint64_t imageModified = 0;
+	uint64_t labelSize = 0;
+	uint64_t labelModified = 0;
+	if (!describeFile(imageName, imageSize, imageModified) || !describeFile(labelName, labelSize, labelModified)) {
+		return 0;
+	}
+
+	uint64_t hash = FNV_OFFSET;
+	hash = mix(hash, VERSION);
+	hash = mix(hash, imageSize);
+	hash = mix(hash, imageModified);
+	hash = mix(hash, labelSize);
+	hash = mix(hash, labelModified);
+	hash = mix(hash, static_cast<uint64_t>(storage));
+	if (storage != DatasetStorage::PIXELS) {
+		uint32_t scale = 0;
+		uint32_t offset = 0;
+		memcpy(&scale, &normalization.scale, sizeof(scale));
+		memcpy(&offset, &normalization.offset, sizeof(offset));
+		hash = mix(hash, (static_cast<uint64_t>(scale) << 32) | offset);
+	}
+
+	// 0 is reserved for unknown sources
+	return hash == 0 ? 1 : hash;
+}
+
+/**
+ *  @brief writes a block followed by zeroes up to the next multiple of ALIGNMENT
+ *
+ *  @param out the file
+ *  @param data the first byte of the block (8 byte aligned)
+ *  @param bytes the size of the block (0 writes a page of zeroes, which holds the header's place)
+ *  @param hash the checksum so far, extended over the block and its padding
+ *  @return true if everything was written
+ */
+bool DatasetCache::writeBlock(FILE* out, const void* data, size_t bytes, uint64_t& hash) {
+	static const uint8_t zeroes[ALIGNMENT] = {};
+	if (bytes == 0) {
+		return fwrite(zeroes, 1, ALIGNMENT, out) == ALIGNMENT;
+	}
+
+	const uint8_t* block = static_cast<const uint8_t*>(data);
+	const size_t whole = bytes / sizeof(uint64_t) * sizeof(uint64_t);
+	hash = checksum(hash, block, whole);
+
+	// the last partial word is hashed as it will sit in the file, followed by zeroes
+	const size_t padding = AlignedMemory::roundUp(bytes, ALIGNMENT) - bytes;
+	uint64_t tail[ALIGNMENT / sizeof(uint64_t) + 1] = {};
+	memcpy(tail, block + whole, bytes - whole);
+	hash = checksum(hash, reinterpret_cast<const uint8_t*>(tail), bytes - whole + padding);
+
+	return fwrite(block, 1, bytes, out) == bytes && fwrite(zeroes, 1, padding, out) == padding;
+}
+
+/**
+ *  @brief FNV-1a taken over 64 bit words instead of bytes
+ *
+ *  @param hash the hash so far (FNV_OFFSET to start)
+ *  @param data the first byte (8 byte aligned)
+ *  @param bytes the number of bytes (a multiple of 8)
+ *  @return the extended hash
+ */
+uint64_t DatasetCache::checksum(uint64_t hash, const uint8_t* data, size_t bytes) {
+	const uint64_t* words = reinterpret_cast<const uint64_t*>(data);
+	for (size_t i = 0; i < bytes / sizeof(uint64_t); i++) {
+		hash = (hash ^ words[i]) * FNV_PRIME;
+	}
+	return hash;
+}
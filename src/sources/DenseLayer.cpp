@@ -0,0 +1,295 @@
+/**
+ *  @file    DenseLayer.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief a fully connected layer that works on whole minibatches
+ *
+ *  @section DESCRIPTION
+ *
+ *  A dense layer computes activation(input * weights^T + bias) for
+ *  every row of a batch with one gemm, and its backward pass turns the
+ *  gradient of the loss with respect to its output into gradients for
+ *  the weights, the bias and the input with two more. The output and
+ *  gradient matrices are kept between calls so a training loop does
+ *  not allocate once the batch size settles.
+ *
+ */
+
+#include "DenseLayer.h"
+#include "Expression.h"
+#include "MathUtils.h"
+#include "Tracer.h"
+
+#include <algorithm>
+
+/**
+ *  @brief constructor
+ *
+ *  @param inputs the number of inputs per row
+ *  @param outputs the number of outputs per row
+ *  @param activation the nonlinearity applied to the outputs
+ *  @param seed the seed of the initial weights
+ */
+DenseLayer::DenseLayer(uint32_t inputs, uint32_t outputs, Activation activation, uint64_t seed):
+	inputs(inputs),
+	outputs(outputs),
+	activation(activation),
+	weights(outputs, inputs),
+	bias(1, outputs) {
+	// He initialization keeps the variance of relu layers from shrinking with depth
+	const double variance = (activation == Activation::RELU ? 2.0 : 1.0) / max<uint32_t>(1, inputs);
+	MathUtils::randn(weights, seed);
+	MathUtils::scale(static_cast<float>(std::sqrt(variance)), weights.getData(), static_cast<uint32_t>(weights.getSize()));
+}
+
+/**
+ *  @brief computes the activations of a batch in the layer's own buffers
+ *
+ *  @param input the first row of the batch
+ *  @param count the number of rows
+ *  @param stride the distance in floats between two rows
+ *  @return the count x outputs activations (valid until the next forward)
+ */
+const MatrixF& DenseLayer::forward(const float* input, uint32_t count, size_t stride) {
+	return forward(input, count, stride, workspace);
+}
+
+/**
+ *  @brief computes the activations of a batch
+ *
+ *  @param input the first row of the batch
+ *  @param count the number of rows
+ *  @param stride the distance in floats between two rows
+ *  @param buffers receives the activations
+ *  @return the count x outputs activations (valid until the next forward on buffers)
+ */
+const MatrixF& DenseLayer::forward(const float* input, uint32_t count, size_t stride, DenseWorkspace& buffers) const {
+	NNF_TRACE_SCOPE("DenseLayer::forward");
+	MatrixF& output = buffers.output;
+	if (output.getRows() != count || output.getCols() != outputs) {
+		output.resize(count, outputs);
+	}
+
+	// every row starts as the bias and the product is accumulated on top
+	for (uint32_t r = 0; r < count; r++) {
+		copy(bias.getData(), bias.getData() + outputs, output.getRow(r));
+	}
+	MathUtils::gemm<float, float, float>(
+		false, true, count, outputs, inputs,
+		1.0f, input, static_cast<uint32_t>(stride), weights.getData(), inputs,
+		1.0f, output.getData(), outputs
+	);
+
+	const uint32_t length = static_cast<uint32_t>(output.getSize());
+	if (activation == Activation::RELU) {
+		MathUtils::relu(output.getData(), length);
+	}
+	else if (activation == Activation::SIGMOID) {
+		MathUtils::sigmoid(output.getData(), length);
+	}
+
+	return output;
+}
+
+/**
+ *  @brief computes the gradients of a batch in the layer's own buffers
+ *
+ *  @param input the rows forward was given
+ *  @param stride the distance in floats between two rows
+ *  @param outputGradient the gradient with respect to the output (overwritten)
+ *  @param propagate true to compute the gradient with respect to the input
+ *  @return the count x inputs gradient with respect to the input (empty if not propagated)
+ */
+MatrixF& DenseLayer::backward(const float* input, size_t stride, MatrixF& outputGradient, bool propagate) {
+	return backward(input, stride, outputGradient, propagate, workspace);
+}
+
+/**
+ *  @brief computes the gradients of a batch
+ *
+ *  @param input the rows forward was given
+ *  @param stride the distance in floats between two rows
+ *  @param outputGradient the gradient with respect to the output (overwritten)
+ *  @param propagate true to compute the gradient with respect to the input
+ *  @param buffers the workspace forward used, receives the gradients
+ *  @return the count x inputs gradient with respect to the input (empty if not propagated)
+ */
+MatrixF& DenseLayer::backward(const float* input, size_t stride, MatrixF& outputGradient, bool propagate, DenseWorkspace& buffers) const {
+	NNF_TRACE_SCOPE("DenseLayer::backward");
+	const uint32_t count = buffers.output.getRows();
+	const float* delta = outputGradient.getData();
+	const MatrixF& activated = buffers.output;
+
+	// chain through the activation, which both derivatives express in terms of its output
+	if (activation == Activation::RELU) {
+		outputGradient = keepPositive(outputGradient, activated);
+	}
+	else if (activation == Activation::SIGMOID) {
+		outputGradient *= activated * (1.0f - activated);
+	}
+
+	if (buffers.weightGradient.getRows() != outputs || buffers.weightGradient.getCols() != inputs) {
+		buffers.weightGradient.resize(outputs, inputs);
+		buffers.biasGradient.resize(1, outputs);
+	}
+
+	// weightGradient = delta^T * input and biasGradient = the column sums of delta
+	MathUtils::gemm<float, float, float>(
+		true, false, outputs, inputs, count,
+		1.0f, delta, outputs, input, static_cast<uint32_t>(stride),
+		0.0f, buffers.weightGradient.getData(), inputs
+	);
+	buffers.biasGradient.fill(0.0f);
+	for (uint32_t r = 0; r < count; r++) {
+		MathUtils::axpy(1.0f, outputGradient.getRow(r), buffers.biasGradient.getData(), outputs);
+	}
+
+	if (propagate) {
+		// inputGradient = delta * weights
+		MathUtils::gemm(outputGradient, false, weights, false, buffers.inputGradient);
+	}
+
+	return buffers.inputGradient;
+}
+
+/**
+ *  @brief takes one gradient descent step
+ *
+ *  @param learningRate the step size
+ *  @return void
+ */
+void DenseLayer::update(float learningRate) {
+	weights -= learningRate * workspace.weightGradient;
+	bias -= learningRate * workspace.biasGradient;
+}
+
+/**
+ *  @brief adds the gradients of one workspace into another
+ *
+ *  @param into receives the sums
+ *  @param from the gradients to add
+ *  @return void
+ */
+void DenseLayer::accumulate(DenseWorkspace& into, const DenseWorkspace& from) {
+	into.weightGradient += from.weightGradient;
+	into.biasGradient += from.biasGradient;
+}
+
+/**
+ *  @brief returns the number of inputs per row
+ *
+ *  @return the number of inputs
+ */
+uint32_t DenseLayer::getInputs() const {
+	return inputs;
+}
+
+/**
+ *  @brief returns the number of outputs per row
+ *
+ *  @return the number of outputs
+ */
+uint32_t DenseLayer::getOutputs() const {
+	return outputs;
+}
+
+/**
+ *  @brief returns the nonlinearity
+ *
+ *  @return the activation
+ */
+Activation DenseLayer::getActivation() const {
+	return activation;
+}
+
+/**
+ *  @brief returns the weights
+ *
+ *  @return the outputs x inputs weights
+ */
+MatrixF& DenseLayer::getWeights() {
+	return weights;
+}
+
+/**
+ *  @brief returns the weights
+ *
+ *  @return the outputs x inputs weights
+ */
+const MatrixF& DenseLayer::getWeights() const {
+	return weights;
+}
+
+/**
+ *  @brief returns the bias
+ *
+ *  @return the 1 x outputs bias
+ */
+MatrixF& DenseLayer::getBias() {
+	return bias;
+}
+
+/**
+ *  @brief returns the bias
+ *
+ *  @return the 1 x outputs bias
+ */
+const MatrixF& DenseLayer::getBias() const {
+	return bias;
+}
+
+/**
+ *  @brief returns the weight gradient of the last backward pass
+ *
+ *  @return the outputs x inputs gradient
+ */
+MatrixF& DenseLayer::getWeightGradient() {
+	return workspace.weightGradient;
+}
+
+/**
+ *  @brief returns the weight gradient of the last backward pass
+ *
+ *  @return the outputs x inputs gradient
+ */
+const MatrixF& DenseLayer::getWeightGradient() const {
+	return workspace.weightGradient;
+}
+
+/**
+ *  @brief returns the bias gradient of the last backward pass
+ *
+ *  @return the 1 x outputs gradient
+ */
+MatrixF& DenseLayer::getBiasGradient() {
+	return workspace.biasGradient;
+}
+
+/**
+ *  @brief returns the bias gradient of the last backward pass
+ *
+ *  @return the 1 x outputs gradient
+ */
+const MatrixF& DenseLayer::getBiasGradient() const {
+	return workspace.biasGradient;
+}
+
+/**
+ *  @brief returns the activations of the last forward pass
+ *
+ *  @return the batch x outputs activations
+ */
+const MatrixF& DenseLayer::getOutput() const {
+	return workspace.output;
+}
+
+/**
+ *  @brief returns the buffers used when no workspace is given
+ *
+ *  @return the layer's own workspace
+ */
+DenseWorkspace& DenseLayer::getWorkspace() {
+	return workspace;
+}
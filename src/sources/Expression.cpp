@@ -0,0 +1,54 @@
+/**
+ *  @file    Expression.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief lazy element-wise arithmetic over BasicMatrix
+ *
+ *  @section DESCRIPTION
+ *
+ *  Arithmetic on matrices (+, -, *, /, unary -, exp, sigmoid, relu
+ *  and keepPositive) does not compute anything. It builds a small
+ *  expression object that only remembers its operands. The work
+ *  happens when the expression is assigned to a matrix (=, +=, -=,
+ *  *=, /=), in one loop that reads every operand once and writes the
+ *  destination once, e.g.
+ *
+ *      weights -= learningRate * gradient;
+ *      delta *= activated * (1.0f - activated);
+ *
+ *  are each a single pass with no temporary matrix. The loop is
+ *  written against Simd<T> (see Simd.h), so it runs at the level the
+ *  compiler was told it may use. Expressions are instantiated wherever
+ *  they are assigned, so unlike the Kernels tables this level is fixed
+ *  at build time: the project builds for the baseline target, and
+ *  wider registers need e.g. /arch:AVX2 and hosts that all have them.
+ *
+ *  Every element of the result only depends on the elements at the
+ *  same position, so the destination may also appear in the
+ *  expression. The operands must all have the same shape, except
+ *  plain numbers, which apply to every element. An expression holds
+ *  pointers into its matrices, so it should be assigned before they
+ *  are resized or destroyed.
+ *
+ */
+
+#include "Expression.h"
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+ExpressionException::ExpressionException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* ExpressionException::what() const noexcept {
+	return message.c_str();
+}
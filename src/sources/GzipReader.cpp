@@ -0,0 +1,753 @@
+/**
+ *  @file    GzipReader.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief streams the decompressed contents of a gzip file
+ *
+ *  @section DESCRIPTION
+ *
+ *  MNIST is distributed as gzip files. This class reads them without
+ *  an external library: it parses the gzip wrapper (RFC 1952) and
+ *  inflates the deflate stream inside it (RFC 1951) into whatever
+ *  buffer the caller hands to read(), keeping only the last 32 KiB of
+ *  output that back references may point into. The compressed input
+ *  goes through a bounded buffer too, so any file size inflates at
+ *  constant memory.
+ *
+ *  Huffman codes up to FAST_BITS long are decoded with one table
+ *  lookup, longer ones bit by bit. The CRC-32 and length in the
+ *  trailer of every member are checked, and concatenated members are
+ *  read one after another as gzip itself does.
+ *
+ */
+
+#include "GzipReader.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	// the base length and extra bits of length symbols 257 to 285
+	const uint16_t LENGTH_BASE[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+	const uint8_t LENGTH_EXTRA[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+
+	// the base distance and extra bits of distance symbols 0 to 29
+	const uint16_t DISTANCE_BASE[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+	};
+	const uint8_t DISTANCE_EXTRA[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+
+	// the order in which a dynamic block lists the code lengths of the code length code
+	const uint8_t CODE_LENGTH_ORDER[19] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+	/**
+	 *  @brief Struct that holds the slicing-by-8 CRC-32 tables
+	 */
+	struct CrcTables {
+		uint32_t entries[8][256]; // entries[k][b] is the CRC of b followed by k zero bytes
+
+		CrcTables(void) {
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t value = i;
+				for (int bit = 0; bit < 8; bit++) {
+					value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+				}
+				entries[0][i] = value;
+			}
+			for (uint32_t i = 0; i < 256; i++) {
+				for (int k = 1; k < 8; k++) {
+					entries[k][i] = (entries[k - 1][i] >> 8) ^ entries[0][entries[k - 1][i] & 0xFF];
+				}
+			}
+		}
+	};
+}
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+GzipReaderException::GzipReaderException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* GzipReaderException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param name the full path of the gzip file
+ *  @param bufferBytes the size of the compressed input buffer
+ */
+GzipReader::GzipReader(string name, size_t bufferBytes):
+	in(name.c_str(), std::ifstream::in | std::ifstream::binary),
+	name(name),
+	input(max<size_t>(1, bufferBytes)),
+	window(WINDOW_SIZE) {
+	if (!in.is_open()) {
+		throw GzipReaderException("File: " + name + " failed to open!");
+	}
+
+	// the fixed codes of RFC 1951 section 3.2.6
+	uint8_t lengths[288];
+	memset(lengths, 8, 144);
+	memset(lengths + 144, 9, 112);
+	memset(lengths + 256, 7, 24);
+	memset(lengths + 280, 8, 8);
+	buildTable(fixedLiterals, lengths, 288, name);
+	memset(lengths, 5, 30);
+	buildTable(fixedDistances, lengths, 30, name);
+
+	if (!readMemberHeader()) {
+		throw GzipReaderException("File: " + name + " is empty!");
+	}
+}
+
+/**
+ *  @brief reads the next chunk of the file into the input buffer
+ *
+ *  @return false at the end of the file
+ */
+bool GzipReader::fillInput(void) {
+	in.read(reinterpret_cast<char*>(input.data()), static_cast<streamsize>(input.size()));
+	inputSize = static_cast<size_t>(in.gcount());
+	inputPosition = 0;
+	return inputSize > 0;
+}
+
+/**
+ *  @brief tops the bit buffer up to at least 56 bits while the file has bytes left
+ *
+ *  @return void
+ */
+void GzipReader::refill(void) {
+	if (inputSize - inputPosition >= 8) {
+		// take as many whole bytes as fit with one 8 byte load
+		const uint8_t* next = input.data() + inputPosition;
+		uint64_t word = 0;
+		for (uint32_t i = 0; i < 8; i++) {
+			word |= static_cast<uint64_t>(next[i]) << (8 * i);
+		}
+
+		const uint32_t count = (63 - bitCount) >> 3;
+		bits |= (word & ((1ull << (8 * count)) - 1)) << bitCount;
+		inputPosition += count;
+		bitCount += 8 * count;
+		return;
+	}
+
+	while (bitCount <= 56 && (inputPosition < inputSize || fillInput())) {
+		bits |= static_cast<uint64_t>(input[inputPosition++]) << bitCount;
+		bitCount += 8;
+	}
+}
+
+/**
+ *  @brief returns the next whole byte of the file
+ *
+ *  @return the byte
+ */
+uint8_t GzipReader::readByte(void) {
+	if (bitCount >= 8) {
+		const uint8_t byte = static_cast<uint8_t>(bits);
+		bits >>= 8;
+		bitCount -= 8;
+		return byte;
+	}
+	if (inputPosition == inputSize && !fillInput()) {
+		throw GzipReaderException("File: " + name + " ended early!");
+	}
+	return input[inputPosition++];
+}
+
+/**
+ *  @brief consumes bits from the file, least significant first
+ *
+ *  @param count the number of bits (at most 24)
+ *  @return the bits
+ */
+uint32_t GzipReader::readBits(uint32_t count) {
+	if (bitCount < count) {
+		refill();
+		if (bitCount < count) {
+			throw GzipReaderException("File: " + name + " ended early!");
+		}
+	}
+
+	const uint32_t value = static_cast<uint32_t>(bits & ((1ull << count) - 1));
+	bits >>= count;
+	bitCount -= count;
+	return value;
+}
+
+/**
+ *  @brief drops the bits left in the current byte
+ *
+ *  @return void
+ */
+void GzipReader::alignToByte(void) {
+	bits >>= bitCount & 7;
+	bitCount -= bitCount & 7;
+}
+
+/**
+ *  @brief checks whether the file has bytes left
+ *
+ *  @return true if another byte can be read
+ */
+bool GzipReader::hasInput(void) {
+	return bitCount >= 8 || inputPosition < inputSize || fillInput();
+}
+
+/**
+ *  @brief decodes one symbol
+ *
+ *  @param table the code to decode with
+ *  @return the symbol
+ */
+uint32_t GzipReader::decode(const HuffmanTable& table) {
+	// the last code of a file may be shorter than FAST_BITS, so running out is fine here
+	if (bitCount < 32) {
+		refill();
+	}
+
+	const uint16_t entry = table.fast[bits & ((1u << HuffmanTable::FAST_BITS) - 1)];
+	const uint32_t length = entry >> 9;
+	if (entry != 0 && length <= bitCount) {
+		bits >>= length;
+		bitCount -= length;
+		return entry & 0x1FF;
+	}
+
+	// codes longer than FAST_BITS are walked one bit at a time in canonical order
+	int32_t code = 0;
+	int32_t first = 0;
+	int32_t index = 0;
+	for (uint32_t bit = 1; bit < 16; bit++) {
+		code |= static_cast<int32_t>(readBits(1));
+		const int32_t count = table.counts[bit];
+		if (code - first < count) {
+			return table.symbols[index + code - first];
+		}
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+	throw GzipReaderException("File: " + name + " has an invalid Huffman code!");
+}
+
+/**
+ *  @brief builds a decoding table from the code length of every symbol
+ *
+ *  @param table the table to build
+ *  @param lengths the code length of every symbol (0 if unused)
+ *  @param count the number of symbols
+ *  @param name the name of the file (for error messages)
+ *  @return void
+ */
+void GzipReader::buildTable(HuffmanTable& table, const uint8_t* lengths, uint32_t count, const string& name) {
+	memset(table.counts, 0, sizeof(table.counts));
+	for (uint32_t i = 0; i < count; i++) {
+		table.counts[lengths[i]]++;
+	}
+	table.counts[0] = 0;
+
+	// more codes of some length than the shorter ones leave room for cannot be decoded
+	int32_t left = 1;
+	for (uint32_t bit = 1; bit < 16; bit++) {
+		left = (left << 1) - table.counts[bit];
+		if (left < 0) {
+			throw GzipReaderException("File: " + name + " has an over-subscribed Huffman code!");
+		}
+	}
+
+	uint16_t offsets[16];
+	uint16_t nextCode[16];
+	offsets[1] = 0;
+	nextCode[1] = 0;
+	for (uint32_t bit = 1; bit < 15; bit++) {
+		offsets[bit + 1] = offsets[bit] + table.counts[bit];
+		nextCode[bit + 1] = static_cast<uint16_t>((nextCode[bit] + table.counts[bit]) << 1);
+	}
+
+	memset(table.fast, 0, sizeof(table.fast));
+	for (uint32_t symbol = 0; symbol < count; symbol++) {
+		const uint32_t length = lengths[symbol];
+		if (length == 0) {
+			continue;
+		}
+		table.symbols[offsets[length]++] = static_cast<uint16_t>(symbol);
+
+		const uint32_t code = nextCode[length]++;
+		if (length > HuffmanTable::FAST_BITS) {
+			continue;
+		}
+
+		// deflate sends codes most significant bit first, so the lookup index is reversed
+		uint32_t reversed = 0;
+		for (uint32_t bit = 0; bit < length; bit++) {
+			reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+		}
+		for (uint32_t i = reversed; i < (1u << HuffmanTable::FAST_BITS); i += 1u << length) {
+			table.fast[i] = static_cast<uint16_t>((length << 9) | symbol);
+		}
+	}
+}
+
+/**
+ *  @brief parses the header of the next member
+ *
+ *  @return false if the file ends (or only padding follows) instead
+ */
+bool GzipReader::readMemberHeader(void) {
+	alignToByte();
+	if (!hasInput()) {
+		state = GzipState::END;
+		return false;
+	}
+
+	const uint8_t id1 = readByte();
+	if (members > 0 && id1 == 0) {
+		// some writers pad the file after the last member, gzip ignores it as well
+		state = GzipState::END;
+		return false;
+	}
+	const uint8_t id2 = readByte();
+	if (id1 != 0x1F || id2 != 0x8B) {
+		throw GzipReaderException("File: " + name + " is not a gzip file!");
+	}
+	if (readByte() != 8) {
+		throw GzipReaderException("File: " + name + " uses an unknown compression method!");
+	}
+
+	const uint8_t flags = readByte();
+	for (int i = 0; i < 6; i++) {
+		// mtime, extra flags and OS
+		readByte();
+	}
+	if (flags & 0x04) {
+		uint32_t extraLength = readByte();
+		extraLength |= static_cast<uint32_t>(readByte()) << 8;
+		for (uint32_t i = 0; i < extraLength; i++) {
+			readByte();
+		}
+	}
+	if (flags & 0x08) {
+		// original file name
+		while (readByte() != 0) {
+		}
+	}
+	if (flags & 0x10) {
+		// comment
+		while (readByte() != 0) {
+		}
+	}
+	if (flags & 0x02) {
+		// header CRC-16
+		readByte();
+		readByte();
+	}
+
+	members++;
+	crc = 0;
+	memberBytes = 0;
+	lastBlock = false;
+	state = GzipState::BLOCK;
+	return true;
+}
+
+/**
+ *  @brief checks the trailer of the member that just ended
+ *
+ *  @return void
+ */
+void GzipReader::readMemberTrailer(void) {
+	alignToByte();
+
+	uint32_t expectedCrc = 0;
+	uint32_t expectedSize = 0;
+	for (int i = 0; i < 4; i++) {
+		expectedCrc |= static_cast<uint32_t>(readByte()) << (8 * i);
+	}
+	for (int i = 0; i < 4; i++) {
+		expectedSize |= static_cast<uint32_t>(readByte()) << (8 * i);
+	}
+
+	if (expectedCrc != crc) {
+		throw GzipReaderException("File: " + name + " failed its CRC-32 check!");
+	}
+	if (expectedSize != static_cast<uint32_t>(memberBytes)) {
+		throw GzipReaderException("File: " + name + " has the wrong uncompressed size!");
+	}
+	state = GzipState::HEADER;
+}
+
+/**
+ *  @brief parses the header of the next block
+ *
+ *  @return void
+ */
+void GzipReader::readBlockHeader(void) {
+	lastBlock = readBits(1) == 1;
+	switch (readBits(2)) {
+		case 0: {
+			alignToByte();
+			const uint32_t length = readBits(16);
+			const uint32_t complement = readBits(16);
+			if ((length ^ 0xFFFF) != complement) {
+				throw GzipReaderException("File: " + name + " has a corrupt stored block!");
+			}
+			storedRemaining = length;
+			state = GzipState::STORED;
+			break;
+		}
+		case 1:
+			literalTable = &fixedLiterals;
+			distanceTable = &fixedDistances;
+			state = GzipState::HUFFMAN;
+			break;
+		case 2:
+			readDynamicTables();
+			literalTable = &literals;
+			distanceTable = &distances;
+			state = GzipState::HUFFMAN;
+			break;
+		default:
+			throw GzipReaderException("File: " + name + " has an invalid block type!");
+	}
+}
+
+/**
+ *  @brief reads the code lengths of a dynamic block and builds its tables
+ *
+ *  @return void
+ */
+void GzipReader::readDynamicTables(void) {
+	const uint32_t numLiterals = readBits(5) + 257;
+	const uint32_t numDistances = readBits(5) + 1;
+	const uint32_t numCodeLengths = readBits(4) + 4;
+	if (numLiterals > 286 || numDistances > 30) {
+		throw GzipReaderException("File: " + name + " has too many Huffman codes!");
+	}
+
+	uint8_t lengths[320];
+	memset(lengths, 0, 19);
+	for (uint32_t i = 0; i < numCodeLengths; i++) {
+		lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(readBits(3));
+	}
+
+	// the code length code decodes the rest, and is borrowed from the literal table
+	buildTable(literals, lengths, 19, name);
+
+	uint32_t index = 0;
+	while (index < numLiterals + numDistances) {
+		const uint32_t symbol = decode(literals);
+		if (symbol < 16) {
+			lengths[index++] = static_cast<uint8_t>(symbol);
+			continue;
+		}
+
+		uint8_t value = 0;
+		uint32_t repeat = 0;
+		if (symbol == 16) {
+			if (index == 0) {
+				throw GzipReaderException("File: " + name + " repeats a missing code length!");
+			}
+			value = lengths[index - 1];
+			repeat = 3 + readBits(2);
+		} else if (symbol == 17) {
+			repeat = 3 + readBits(3);
+		} else {
+			repeat = 11 + readBits(7);
+		}
+		if (index + repeat > numLiterals + numDistances) {
+			throw GzipReaderException("File: " + name + " has too many code lengths!");
+		}
+		memset(lengths + index, value, repeat);
+		index += repeat;
+	}
+
+	if (lengths[256] == 0) {
+		throw GzipReaderException("File: " + name + " has a block without an end code!");
+	}
+	buildTable(literals, lengths, numLiterals, name);
+	buildTable(distances, lengths + numLiterals, numDistances, name);
+}
+
+/**
+ *  @brief inflates the next bytes of the file
+ *
+ *  @param out the destination (must hold bytes bytes)
+ *  @param bytes the maximum number of bytes to produce
+ *  @return the number of bytes produced (fewer only at the end of the file)
+ *
+ *  (Note: a trailer is checked once a call runs into it, so the CRC-32 of the
+ *  last member is only verified by a call that asks for more than is left)
+ */
+size_t GzipReader::read(void* out, size_t bytes) {
+	uint8_t* destination = static_cast<uint8_t*>(out);
+	size_t produced = 0;
+
+	// the start of the output the CRC of the current member has not seen yet
+	size_t unchecked = 0;
+
+	while (produced < bytes && state != GzipState::END) {
+		switch (state) {
+			case GzipState::HEADER:
+				readMemberHeader();
+				break;
+			case GzipState::BLOCK:
+				readBlockHeader();
+				break;
+			case GzipState::STORED: {
+				size_t count = min<size_t>(storedRemaining, bytes - produced);
+				storedRemaining -= static_cast<uint32_t>(count);
+				memberBytes += count;
+
+				// whole bytes may still sit in the bit buffer, the rest is copied straight from the input
+				while (count > 0 && bitCount >= 8) {
+					destination[produced++] = readByte();
+					count--;
+				}
+				while (count > 0) {
+					if (inputPosition == inputSize && !fillInput()) {
+						throw GzipReaderException("File: " + name + " ended early!");
+					}
+					const size_t chunk = min<size_t>(count, inputSize - inputPosition);
+					memcpy(destination + produced, input.data() + inputPosition, chunk);
+					inputPosition += chunk;
+					produced += chunk;
+					count -= chunk;
+				}
+
+				if (storedRemaining == 0) {
+					state = lastBlock ? GzipState::TRAILER : GzipState::BLOCK;
+				}
+				break;
+			}
+			case GzipState::HUFFMAN:
+				while (produced < bytes && state == GzipState::HUFFMAN) {
+					if (matchLength > 0) {
+						copyMatch(destination, produced, bytes);
+						continue;
+					}
+
+					const uint32_t symbol = decode(*literalTable);
+					if (symbol < 256) {
+						destination[produced++] = static_cast<uint8_t>(symbol);
+						memberBytes++;
+					} else if (symbol == 256) {
+						state = lastBlock ? GzipState::TRAILER : GzipState::BLOCK;
+					} else {
+						if (symbol > 285) {
+							throw GzipReaderException("File: " + name + " has an invalid length code!");
+						}
+						matchLength = LENGTH_BASE[symbol - 257] + readBits(LENGTH_EXTRA[symbol - 257]);
+
+						const uint32_t distanceSymbol = decode(*distanceTable);
+						if (distanceSymbol > 29) {
+							throw GzipReaderException("File: " + name + " has an invalid distance code!");
+						}
+						matchDistance = DISTANCE_BASE[distanceSymbol] + readBits(DISTANCE_EXTRA[distanceSymbol]);
+						if (matchDistance > memberBytes) {
+							throw GzipReaderException("File: " + name + " refers back past the start of the data!");
+						}
+					}
+				}
+				break;
+			case GzipState::TRAILER:
+				crc = crc32(crc, destination + unchecked, produced - unchecked);
+				unchecked = produced;
+				readMemberTrailer();
+				break;
+			default:
+				break;
+		}
+	}
+
+	crc = crc32(crc, destination + unchecked, produced - unchecked);
+	remember(destination, produced);
+	position += produced;
+	return produced;
+}
+
+/**
+ *  @brief copies as much of the pending back reference as fits
+ *
+ *  @param destination the output of the current read call
+ *  @param produced the bytes of destination written so far (advanced by the copy)
+ *  @param bytes the size of destination
+ *  @return void
+ */
+void GzipReader::copyMatch(uint8_t* destination, size_t& produced, size_t bytes) {
+	const size_t count = min<size_t>(matchLength, bytes - produced);
+	matchLength -= static_cast<uint32_t>(count);
+	memberBytes += count;
+
+	if (matchDistance <= produced) {
+		// the source is all in this call's output
+		const uint8_t* source = destination + produced - matchDistance;
+		if (matchDistance >= count) {
+			memcpy(destination + produced, source, count);
+		} else {
+			// an overlapping copy repeats the last matchDistance bytes
+			for (size_t i = 0; i < count; i++) {
+				destination[produced + i] = source[i];
+			}
+		}
+		produced += count;
+		return;
+	}
+
+	// the source starts in output handed back by an earlier call
+	const uint8_t* history = window.data();
+	for (size_t i = 0; i < count; i++, produced++) {
+		destination[produced] = produced >= matchDistance ? destination[produced - matchDistance] :
+			history[(windowPosition - static_cast<uint32_t>(matchDistance - produced)) & (WINDOW_SIZE - 1)];
+	}
+}
+
+/**
+ *  @brief keeps the end of a read call's output for later back references
+ *
+ *  @param data the output
+ *  @param count the number of bytes
+ *  @return void
+ */
+void GzipReader::remember(const uint8_t* data, size_t count) {
+	uint8_t* history = window.data();
+	if (count >= WINDOW_SIZE) {
+		memcpy(history, data + count - WINDOW_SIZE, WINDOW_SIZE);
+		windowPosition = 0;
+		return;
+	}
+
+	const size_t first = min<size_t>(count, WINDOW_SIZE - windowPosition);
+	memcpy(history + windowPosition, data, first);
+	memcpy(history, data + first, count - first);
+	windowPosition = static_cast<uint32_t>((windowPosition + count) & (WINDOW_SIZE - 1));
+}
+
+/**
+ *  @brief discards output
+ *
+ *  @param bytes the number of bytes to discard
+ *  @return the number of bytes discarded (fewer only at the end of the file)
+ */
+uint64_t GzipReader::skip(uint64_t bytes) {
+	uint8_t scratch[4096];
+	uint64_t skipped = 0;
+	while (skipped < bytes) {
+		const size_t count = read(scratch, static_cast<size_t>(min<uint64_t>(sizeof(scratch), bytes - skipped)));
+		if (count == 0) {
+			break;
+		}
+		skipped += count;
+	}
+	return skipped;
+}
+
+/**
+ *  @brief returns to the state right after opening the file
+ *
+ *  @return void
+ */
+void GzipReader::reset(void) {
+	in.clear();
+	in.seekg(0, in.beg);
+	inputPosition = 0;
+	inputSize = 0;
+	bits = 0;
+	bitCount = 0;
+	windowPosition = 0;
+	state = GzipState::HEADER;
+	storedRemaining = 0;
+	matchLength = 0;
+	matchDistance = 0;
+	position = 0;
+	members = 0;
+}
+
+/**
+ *  @brief starts over from the beginning of the file
+ *
+ *  @return void
+ */
+void GzipReader::rewind(void) {
+	reset();
+	if (!readMemberHeader()) {
+		throw GzipReaderException("File: " + name + " is empty!");
+	}
+}
+
+/**
+ *  @brief returns the current position in the decompressed data
+ *
+ *  @return the number of bytes produced since the beginning of the file
+ */
+uint64_t GzipReader::tell() const {
+	return position;
+}
+
+/**
+ *  @brief checks the first two bytes of a file
+ *
+ *  @param name the full path of the file
+ *  @return true if the file starts with 1f 8b
+ */
+bool GzipReader::isGzip(string name) {
+	ifstream file(name.c_str(), std::ifstream::in | std::ifstream::binary);
+	unsigned char magic[2];
+	if (!file.read(reinterpret_cast<char*>(magic), 2)) {
+		return false;
+	}
+	return magic[0] == 0x1F && magic[1] == 0x8B;
+}
+
+/**
+ *  @brief extends a CRC-32 eight bytes at a time
+ *
+ *  @param crc the CRC of the bytes before data (0 to start)
+ *  @param data the first byte
+ *  @param bytes the number of bytes
+ *  @return the CRC of everything up to the end of data
+ */
+uint32_t GzipReader::crc32(uint32_t crc, const uint8_t* data, size_t bytes) {
+	static const CrcTables tables;
+	const uint32_t (*t)[256] = tables.entries;
+
+	crc = ~crc;
+	while (bytes >= 8) {
+		const uint32_t low = crc ^ (static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+			(static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24));
+		crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+			t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+		data += 8;
+		bytes -= 8;
+	}
+	while (bytes-- > 0) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+	}
+	return ~crc;
+}
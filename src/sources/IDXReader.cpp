@@ -0,0 +1,373 @@
+/**
+ *  @file    IDXReader.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief streams records out of any IDX formatted file
+ *
+ *  @section DESCRIPTION
+ *
+ *  The IDX format starts with two zero bytes, a dtype byte, a byte
+ *  holding the number of dimensions and then one big endian int32 per
+ *  dimension. The first dimension counts the records and the rest
+ *  describe a single record. This class understands every IDX dtype
+ *  and any number of dimensions, and it reads fixed-size chunks of
+ *  records through a bounded buffer so files larger than RAM can be
+ *  processed at constant memory.
+ *
+ *  Files that start with the gzip magic bytes are inflated on the fly
+ *  by a GzipReader, so the .gz files MNIST is distributed as can be
+ *  read directly. Their records are inflated once more while the
+ *  header is checked, since only then is their length known.
+ *
+ */
+
+#include "IDXReader.h"
+
+#include <algorithm>
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+IDXReaderException::IDXReaderException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* IDXReaderException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param name the full path of the IDX file
+ *  @param bufferBytes the upper bound on the memory used by next()
+ */
+IDXReader::IDXReader(string name, size_t bufferBytes):
+	in(name.c_str(), std::ifstream::in | std::ifstream::binary),
+	name(name) {
+	if (!in.is_open()) {
+		throw IDXReaderException("File: " + name + " failed to open!");
+	}
+
+	unsigned char magic[2] = { 0, 0 };
+	in.read(reinterpret_cast<char*>(magic), 2);
+	if (magic[0] == 0x1F && magic[1] == 0x8B) {
+		in.close();
+		try {
+			gzip.reset(new GzipReader(name));
+		} catch (const GzipReaderException& e) {
+			throw IDXReaderException(e.what());
+		}
+	}
+
+	readHeader();
+
+	// always make room for at least one record
+	chunkRecords = max<size_t>(1, bufferBytes / max<size_t>(1, getRecordBytes()));
+	buffer.resize(chunkRecords * getRecordBytes());
+}
+
+/**
+ *  @brief parses and validates the header
+ *
+ *  @return void
+ */
+void IDXReader::readHeader(void) {
+	// the length of a compressed file is only known once it is inflated (below)
+	uint64_t length = UINT64_MAX;
+	if (!gzip) {
+		in.clear();
+		in.seekg(0, in.end);
+		length = static_cast<uint64_t>(in.tellg());
+		in.seekg(0, in.beg);
+	}
+
+	unsigned char magic[4];
+	if (length < 4 || readBytes(reinterpret_cast<char*>(magic), 4) != 4) {
+		throw IDXReaderException("File: " + name + " is empty!");
+	}
+
+	if (magic[0] != 0 || magic[1] != 0 || magic[3] == 0) {
+		throw IDXReaderException("File: " + name + " is not an IDX file!");
+	}
+
+	switch (magic[2]) {
+		case 0x08: case 0x09: case 0x0B: case 0x0C: case 0x0D: case 0x0E:
+			type = static_cast<IDXType>(magic[2]);
+			break;
+		default:
+			throw IDXReaderException("File: " + name + " has an unknown IDX dtype!");
+	}
+	elementSize = getElementSize(type);
+
+	// every dimension is a big endian uint32
+	const uint8_t numDimensions = magic[3];
+	headerSize = 4 + 4 * static_cast<uint64_t>(numDimensions);
+	if (length < headerSize) {
+		throw IDXReaderException("File: " + name + " has a truncated header!");
+	}
+
+	dimensions.resize(numDimensions);
+	for (uint8_t i = 0; i < numDimensions; i++) {
+		unsigned char bytes[4];
+		if (readBytes(reinterpret_cast<char*>(bytes), 4) != 4) {
+			throw IDXReaderException("File: " + name + " has a truncated header!");
+		}
+		dimensions[i] = (static_cast<uint32_t>(bytes[0]) << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+	}
+
+	// the sizes are multiplied in 64 bits, and a header whose records could not
+	// be addressed is rejected rather than wrapped around
+	numRecords = dimensions[0];
+	uint64_t elements = 1;
+	for (uint8_t i = 1; i < numDimensions; i++) {
+		if (dimensions[i] != 0 && elements > UINT64_MAX / dimensions[i]) {
+			throw IDXReaderException("File: " + name + " has records too large to address!");
+		}
+		elements *= dimensions[i];
+	}
+	if (elements > SIZE_MAX / elementSize) {
+		throw IDXReaderException("File: " + name + " has records too large to address!");
+	}
+	recordElements = static_cast<size_t>(elements);
+
+	const uint64_t recordBytes = getRecordBytes();
+	if (recordBytes != 0 && numRecords > (UINT64_MAX - headerSize) / recordBytes) {
+		throw IDXReaderException("File: " + name + " has too many records to address!");
+	}
+	const uint64_t dataBytes = numRecords * recordBytes;
+
+	if (gzip) {
+		// the records are inflated once up front (and the reader rewound), so a header
+		// never claims more records than the file really holds
+		try {
+			length = headerSize + gzip->skip(dataBytes);
+			gzip->rewind();
+			gzip->skip(headerSize);
+		} catch (const GzipReaderException& e) {
+			throw IDXReaderException(e.what());
+		}
+	}
+
+	if (length < headerSize + dataBytes) {
+		throw IDXReaderException("File: " + name + " is truncated!");
+	}
+}
+
+/**
+ *  @brief reads raw bytes from the file, inflating them if it is compressed
+ *
+ *  @param out the destination
+ *  @param bytes the maximum number of bytes to read
+ *  @return the number of bytes read
+ */
+size_t IDXReader::readBytes(char* out, size_t bytes) {
+	if (!gzip) {
+		in.read(out, static_cast<streamsize>(bytes));
+		return static_cast<size_t>(in.gcount());
+	}
+
+	try {
+		return gzip->read(out, bytes);
+	} catch (const GzipReaderException& e) {
+		throw IDXReaderException(e.what());
+	}
+}
+
+/**
+ *  @brief converts big endian elements to host order in place
+ *
+ *  @param data the first byte of the elements
+ *  @param count the number of elements
+ *  @return void
+ */
+void IDXReader::toHostOrder(char* data, size_t count) const {
+	const uint16_t probe = 1;
+	const bool littleEndian = *reinterpret_cast<const uint8_t*>(&probe) == 1;
+	if (!littleEndian || elementSize == 1) {
+		return;
+	}
+
+	uint8_t* bytes = reinterpret_cast<uint8_t*>(data);
+	switch (elementSize) {
+		case 2:
+			for (size_t i = 0; i < count; i++, bytes += 2) {
+				swap(bytes[0], bytes[1]);
+			}
+			break;
+		case 4:
+			for (size_t i = 0; i < count; i++, bytes += 4) {
+				swap(bytes[0], bytes[3]);
+				swap(bytes[1], bytes[2]);
+			}
+			break;
+		case 8:
+			for (size_t i = 0; i < count; i++, bytes += 8) {
+				reverse(bytes, bytes + 8);
+			}
+			break;
+	}
+}
+
+/**
+ *  @brief returns the element type
+ *
+ *  @return the IDX dtype
+ */
+IDXType IDXReader::getType() const {
+	return type;
+}
+
+/**
+ *  @brief returns the dimensions
+ *
+ *  @return every dimension, the first one being the record count
+ */
+const vector<uint32_t>& IDXReader::getDimensions() const {
+	return dimensions;
+}
+
+/**
+ *  @brief returns the number of records
+ *
+ *  @return the size of the first dimension
+ */
+uint64_t IDXReader::getNumRecords() const {
+	return numRecords;
+}
+
+/**
+ *  @brief returns the number of elements in one record
+ *
+ *  @return the product of every dimension but the first
+ */
+size_t IDXReader::getRecordElements() const {
+	return recordElements;
+}
+
+/**
+ *  @brief returns the size of one record
+ *
+ *  @return the size in bytes
+ */
+size_t IDXReader::getRecordBytes() const {
+	return recordElements * elementSize;
+}
+
+/**
+ *  @brief checks whether the file is gzip compressed
+ *
+ *  @return true if the records are inflated as they are read
+ */
+bool IDXReader::isCompressed() const {
+	return gzip != nullptr;
+}
+
+/**
+ *  @brief returns the index of the next record
+ *
+ *  @return the record index
+ */
+uint64_t IDXReader::tell() const {
+	return position;
+}
+
+/**
+ *  @brief moves to a record
+ *
+ *  @param record the index of the record that will be read next
+ *  @return void
+ */
+void IDXReader::seek(uint64_t record) {
+	record = min(record, numRecords);
+	const uint64_t offset = headerSize + record * getRecordBytes();
+
+	if (!gzip) {
+		in.clear();
+		in.seekg(static_cast<streamoff>(offset), in.beg);
+	} else {
+		// deflate streams can only be decoded front to back
+		try {
+			if (offset < gzip->tell()) {
+				gzip->rewind();
+			}
+			const uint64_t distance = offset - gzip->tell();
+			if (gzip->skip(distance) != distance) {
+				throw IDXReaderException("File: " + name + " ended early!");
+			}
+		} catch (const GzipReaderException& e) {
+			throw IDXReaderException(e.what());
+		}
+	}
+	position = record;
+}
+
+/**
+ *  @brief reads records into caller provided memory
+ *
+ *  @param out the destination (must hold count * getRecordBytes() bytes)
+ *  @param count the maximum number of records to read
+ *  @return the number of records read
+ */
+size_t IDXReader::read(void* out, size_t count) {
+	count = static_cast<size_t>(min<uint64_t>(count, numRecords - position));
+	if (count == 0) {
+		return 0;
+	}
+
+	char* bytes = static_cast<char*>(out);
+	if (readBytes(bytes, count * getRecordBytes()) != count * getRecordBytes()) {
+		throw IDXReaderException("File: " + name + " ended early!");
+	}
+
+	toHostOrder(bytes, count * recordElements);
+	position += count;
+
+	// run a compressed file into its trailer so its CRC-32 gets checked
+	if (gzip && position == numRecords) {
+		char rest[16];
+		readBytes(rest, sizeof(rest));
+	}
+	return count;
+}
+
+/**
+ *  @brief decodes the next chunk of records into the internal buffer
+ *
+ *  @param chunk receives a view of the records (valid until the next call)
+ *  @return false once every record has been read
+ */
+bool IDXReader::next(IDXChunk& chunk) {
+	chunk.first = position;
+	chunk.count = read(buffer.data(), chunkRecords);
+	chunk.data = buffer.data();
+	return chunk.count > 0;
+}
+
+/**
+ *  @brief returns the size of one element
+ *
+ *  @param type the IDX dtype
+ *  @return the size in bytes
+ */
+size_t IDXReader::getElementSize(IDXType type) {
+	switch (type) {
+		case IDXType::SHORT:
+			return 2;
+		case IDXType::INT:
+		case IDXType::FLOAT:
+			return 4;
+		case IDXType::DOUBLE:
+			return 8;
+		default:
+			return 1;
+	}
+}
@@ -23,7 +23,8 @@ ImageData::ImageData(void):
 	data(0),
 	size(0),
 	width(0),
-	label(0) {}
+	label(0),
+	ownsData(true) {}
 
 /**
  *  @brief constructor
@@ -32,20 +33,103 @@ ImageData::ImageData(void):
  *  @param width the width of the image in pixels
  *  @param size the total number of pixels
  */
-ImageData::ImageData(uint8_t* data, uint16_t width, uint16_t size):
+ImageData::ImageData(uint8_t* data, uint32_t width, uint32_t size):
 	data(data),
+	size(size),
 	width(width),
-	size(size) {
+	ownsData(true) {
+}
+
+/**
+ *  @brief constructor for a non-owning view
+ *
+ *  @param data pointer to pixels owned elsewhere (e.g. a mapped file)
+ *  @param width the width of the image in pixels
+ *  @param size the total number of pixels
+ *  @param label the label for the image
+ */
+ImageData::ImageData(const uint8_t* data, uint32_t width, uint32_t size, uint8_t label):
+	data(data),
+	size(size),
+	width(width),
+	label(label),
+	ownsData(false) {
+}
+
+/**
+ *  @brief copy constructor
+ *
+ *  @param other the image to copy
+ */
+ImageData::ImageData(const ImageData& other):
+	data(other.data),
+	size(other.size),
+	width(other.width),
+	label(other.label),
+	ownsData(other.ownsData) {
+	if (ownsData && other.data) {
+		uint8_t* copy = new uint8_t[size];
+		memcpy(copy, other.data, size);
+		data = copy;
+	}
+}
+
+/**
+ *  @brief move constructor
+ *
+ *  @param other the image to take the pixels from
+ */
+ImageData::ImageData(ImageData&& other) noexcept:
+	data(other.data),
+	size(other.size),
+	width(other.width),
+	label(other.label),
+	ownsData(other.ownsData) {
+	other.data = 0;
 }
 
 /**
  *  @brief destructor
  */
 ImageData::~ImageData(void) {
-	if (data) {
-		delete data;
-		data = 0;
+	if (data && ownsData) {
+		delete[] data;
+	}
+	data = 0;
+}
+
+/**
+ *  @brief copy assignment
+ *
+ *  @param other the image to copy
+ *  @return this image
+ */
+ImageData& ImageData::operator=(const ImageData& other) {
+	if (this != &other) {
+		*this = ImageData(other);
+	}
+	return *this;
+}
+
+/**
+ *  @brief move assignment
+ *
+ *  @param other the image to take the pixels from
+ *  @return this image
+ */
+ImageData& ImageData::operator=(ImageData&& other) noexcept {
+	if (this != &other) {
+		if (data && ownsData) {
+			delete[] data;
+		}
+		data = other.data;
+		size = other.size;
+		width = other.width;
+		label = other.label;
+		ownsData = other.ownsData;
+		other.data = 0;
 	}
+	return *this;
 }
 
 /**
@@ -54,7 +138,7 @@ ImageData::~ImageData(void) {
  *  @param i the index of the pixel of interest
  *  @return the pixel
  */
-uint8_t ImageData::getPixel(uint16_t i) const {
+uint8_t ImageData::getPixel(uint32_t i) const {
 	return data[i];
 }
 
@@ -65,7 +149,7 @@ uint8_t ImageData::getPixel(uint16_t i) const {
  *  @param y the vertical position of the pixel
  *  @return the pixel
  */
-uint8_t ImageData::getPixel(uint16_t x, uint16_t y) const {
+uint8_t ImageData::getPixel(uint32_t x, uint32_t y) const {
 	return data[x + y * width];
 }
 
@@ -83,7 +167,7 @@ uint8_t ImageData::getLabel() const {
  *
  *  @return the width
  */
-uint16_t ImageData::getWidth() const {
+uint32_t ImageData::getWidth() const {
 	return width;
 }
 
@@ -92,10 +176,28 @@ uint16_t ImageData::getWidth() const {
  *
  *  @return the height
  */
-uint16_t ImageData::getHeight() const {
+uint32_t ImageData::getHeight() const {
 	return size / width;
 }
 
+/**
+ *  @brief returns a pointer to the raw pixels
+ *
+ *  @return the pixels
+ */
+const uint8_t* ImageData::getData() const {
+	return data;
+}
+
+/**
+ *  @brief checks whether the pixels are freed by this object
+ *
+ *  @return true if this object owns its pixels
+ */
+bool ImageData::isOwner() const {
+	return ownsData;
+}
+
 /**
  *  @brief sets the label
  *
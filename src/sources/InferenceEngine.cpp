@@ -0,0 +1,294 @@
+/**
+ *  @file    InferenceEngine.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief classifies single images from many threads in batches
+ *
+ *  @section DESCRIPTION
+ *
+ *  Callers submit one image at a time and get a future for its class.
+ *  The images wait in a bounded ring until the engine's thread has
+ *  either a full batch or an image that has waited for the maximum
+ *  latency, then the whole batch goes through one forward pass and
+ *  every future is completed. Batching lets the gemm kernels work on
+ *  many rows at once instead of one matrix vector product per image,
+ *  while the deadline keeps a lone request from waiting for company.
+ *
+ *  The engine keeps the latency of the most recent requests, so
+ *  getStats() can report percentiles alongside the throughput.
+ *
+ */
+
+#include "InferenceEngine.h"
+#include "MathUtils.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+InferenceException::InferenceException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* InferenceException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param network the classifier
+ *  @param maxBatchSize the most requests per forward pass
+ *  @param maxLatency how long the oldest request may wait for a batch to fill
+ *  @param capacity the number of requests that can wait at once (at least maxBatchSize)
+ *  @param normalization maps the pixels onto the features the network was trained on
+ */
+InferenceEngine::InferenceEngine(
+	Network& network,
+	uint32_t maxBatchSize,
+	chrono::microseconds maxLatency,
+	uint32_t capacity,
+	const Normalization& normalization
+):
+	network(network),
+	normalization(normalization),
+	inputs(network.getInputs()),
+	maxBatchSize(max<uint32_t>(1, maxBatchSize)),
+	maxLatency(maxLatency),
+	since(chrono::steady_clock::now()) {
+	const size_t slots = max(capacity, this->maxBatchSize);
+	ring.resize(slots);
+	pixels.resize(slots * inputs);
+
+	batch.resize(this->maxBatchSize, inputs);
+	classes.resize(this->maxBatchSize);
+	inFlight.reserve(this->maxBatchSize);
+	submitted.reserve(this->maxBatchSize);
+	latencies.reserve(STATS_WINDOW);
+
+	worker = thread(&InferenceEngine::work, this);
+}
+
+/**
+ *  @brief destructor
+ */
+InferenceEngine::~InferenceEngine(void) {
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	arrived.notify_one();
+	worker.join();
+}
+
+/**
+ *  @brief the loop the thread runs until the engine is destroyed
+ *
+ *  @return void
+ */
+void InferenceEngine::work(void) {
+	unique_lock<mutex> guard(lock);
+	while (true) {
+		arrived.wait(guard, [this] { return stopping || count > 0; });
+		if (count == 0) {
+			return;
+		}
+
+		// wait for a full batch, but never past the deadline of the oldest request
+		const chrono::steady_clock::time_point deadline = ring[head].submitted + maxLatency;
+		arrived.wait_until(guard, deadline, [this] { return stopping || count >= maxBatchSize; });
+
+		// submitters only write past head + count, so the batch can be read unlocked
+		const size_t size = min<size_t>(count, maxBatchSize);
+		guard.unlock();
+		gather(size);
+		guard.lock();
+
+		head = (head + size) % ring.size();
+		count -= size;
+		space.notify_all();
+
+		guard.unlock();
+		finish(size);
+		guard.lock();
+	}
+}
+
+/**
+ *  @brief turns the oldest requests into rows of features
+ *
+ *  @param size the number of requests
+ *  @return void
+ */
+void InferenceEngine::gather(size_t size) {
+	inFlight.clear();
+	submitted.clear();
+	batch.resize(static_cast<uint32_t>(size), inputs);
+
+	for (size_t i = 0; i < size; i++) {
+		const size_t slot = (head + i) % ring.size();
+		MathUtils::normalize(
+			pixels.data() + slot * inputs, batch.getData() + i * inputs, inputs,
+			normalization.scale, normalization.offset
+		);
+		inFlight.push_back(move(ring[slot].result));
+		submitted.push_back(ring[slot].submitted);
+	}
+}
+
+/**
+ *  @brief classifies the gathered rows and completes their requests
+ *
+ *  @param size the number of requests
+ *  @return void
+ */
+void InferenceEngine::finish(size_t size) {
+	try {
+		network.predict(batch.getData(), static_cast<uint32_t>(size), inputs, classes.data());
+	}
+	catch (...) {
+		for (promise<uint32_t>& result : inFlight) {
+			result.set_exception(current_exception());
+		}
+		return;
+	}
+
+	// the stats are recorded first so they already include a request whose future is ready
+	const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	{
+		lock_guard<mutex> guard(statsLock);
+		for (size_t i = 0; i < size; i++) {
+			const float latency = chrono::duration<float, micro>(now - submitted[i]).count();
+			if (latencies.size() < STATS_WINDOW) {
+				latencies.push_back(latency);
+			}
+			else {
+				latencies[requests % STATS_WINDOW] = latency;
+			}
+			requests++;
+		}
+		batches++;
+	}
+
+	for (size_t i = 0; i < size; i++) {
+		inFlight[i].set_value(classes[i]);
+	}
+}
+
+/**
+ *  @brief queues the pixels of one image
+ *
+ *  @param image inputs pixels
+ *  @return a future that receives the class of the image
+ */
+future<uint32_t> InferenceEngine::submit(const uint8_t* image) {
+	unique_lock<mutex> guard(lock);
+	space.wait(guard, [this] { return count < ring.size(); });
+
+	const size_t slot = (head + count) % ring.size();
+	copy(image, image + inputs, pixels.data() + slot * inputs);
+	ring[slot].result = promise<uint32_t>();
+	ring[slot].submitted = chrono::steady_clock::now();
+	future<uint32_t> result = ring[slot].result.get_future();
+	count++;
+
+	// the thread only needs waking for the first request or a full batch
+	const bool wake = count == 1 || count == maxBatchSize;
+	guard.unlock();
+	if (wake) {
+		arrived.notify_one();
+	}
+	return result;
+}
+
+/**
+ *  @brief queues one image
+ *
+ *  @param image the image
+ *  @return a future that receives the class of the image
+ */
+future<uint32_t> InferenceEngine::submit(const ImageData& image) {
+	const uint32_t size = image.getWidth() * image.getHeight();
+	if (size != inputs) {
+		throw InferenceException(
+			"The image has " + to_string(size) + " pixels but the network takes " + to_string(inputs)
+		);
+	}
+	return submit(image.getData());
+}
+
+/**
+ *  @brief summarizes the requests served since the last reset
+ *
+ *  @return the counts, the latency percentiles and the throughput
+ */
+InferenceStats InferenceEngine::getStats() {
+	InferenceStats stats;
+	vector<float> window;
+	{
+		lock_guard<mutex> guard(statsLock);
+		window = latencies;
+		stats.requests = requests;
+		stats.batches = batches;
+		stats.throughput = requests / max(1e-9, chrono::duration<double>(chrono::steady_clock::now() - since).count());
+	}
+
+	if (stats.batches > 0) {
+		stats.meanBatchSize = static_cast<double>(stats.requests) / stats.batches;
+	}
+	if (window.empty()) {
+		return stats;
+	}
+
+	// nearest rank percentiles
+	const auto percentile = [&window](double fraction) {
+		const size_t rank = static_cast<size_t>(ceil(fraction * window.size()));
+		nth_element(window.begin(), window.begin() + (max<size_t>(1, rank) - 1), window.end());
+		return static_cast<double>(window[max<size_t>(1, rank) - 1]);
+	};
+	stats.p50 = percentile(0.5);
+	stats.p99 = percentile(0.99);
+	stats.max = *max_element(window.begin(), window.end());
+	return stats;
+}
+
+/**
+ *  @brief clears the stats
+ *
+ *  @return void
+ */
+void InferenceEngine::resetStats(void) {
+	lock_guard<mutex> guard(statsLock);
+	latencies.clear();
+	requests = 0;
+	batches = 0;
+	since = chrono::steady_clock::now();
+}
+
+/**
+ *  @brief returns the most requests per forward pass
+ *
+ *  @return the batch size
+ */
+uint32_t InferenceEngine::getMaxBatchSize() const {
+	return maxBatchSize;
+}
+
+/**
+ *  @brief returns how long the oldest request may wait for a batch to fill
+ *
+ *  @return the latency bound
+ */
+chrono::microseconds InferenceEngine::getMaxLatency() const {
+	return maxLatency;
+}
@@ -0,0 +1,582 @@
+/**
+ *  @file    Kernels.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief picks the MathUtils kernels for the instruction set of the host
+ *
+ *  @section DESCRIPTION
+ *
+ *  The array kernels, the gemms and the bfloat16 conversions of
+ *  MathUtils and the sampler of Augmenter are built once per
+ *  instruction set level (plain C++, AVX2 with FMA, AVX-512, and
+ *  AVX-512 with the VNNI byte dot products), each into a table of
+ *  function pointers. The first kernel call asks CPUID what the host
+ *  supports and keeps the table of the best level for the rest of the
+ *  run, so one binary runs everywhere and still uses the wide
+ *  registers where they exist.
+ *
+ *  Everything outside these tables is built for the baseline target of
+ *  the project (SSE2 on x64), because the compiler may use the target's
+ *  instructions anywhere in a file. That fixes the Expression loops,
+ *  which are instantiated wherever an expression is assigned, and the
+ *  double and float conversions at build time.
+ *
+ *  The NNF_ISA environment variable (scalar, avx2, avx512 or
+ *  avx512vnni) forces a lower level, e.g. to compare results or
+ *  timings between paths, and verify() checks every level the host
+ *  can run against the plain C++ one.
+ *
+ */
+
+#include "Kernels.h"
+#include "Philox.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define KERNELS_X86
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define KERNELS_X86
+#endif
+
+#ifdef KERNELS_X86
+/**
+ *  @brief runs the cpuid instruction
+ *
+ *  @param leaf the leaf (eax)
+ *  @param subleaf the subleaf (ecx)
+ *  @param regs receives eax, ebx, ecx and edx
+ *  @return void
+ */
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#ifdef _MSC_VER
+	int values[4];
+	__cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+	for (int i = 0; i < 4; i++) {
+		regs[i] = static_cast<uint32_t>(values[i]);
+	}
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/**
+ *  @brief reads the register state the OS saves on a context switch
+ *
+ *  @return the low half of XCR0 (only valid if cpuid reports OSXSAVE)
+ */
+static uint32_t xgetbv(void) {
+#ifdef _MSC_VER
+	return static_cast<uint32_t>(_xgetbv(0));
+#else
+	uint32_t low, high;
+	__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return low;
+#endif
+}
+#endif
+
+/**
+ *  @brief returns the highest level the host can run
+ *
+ *  @return the level (the instructions and the OS support for their registers are both checked)
+ */
+Isa Kernels::detect(void) {
+#ifdef KERNELS_X86
+	uint32_t regs[4];
+	cpuid(0, 0, regs);
+	const uint32_t maxLeaf = regs[0];
+	if (maxLeaf < 7) {
+		return Isa::SCALAR;
+	}
+
+	cpuid(1, 0, regs);
+	const bool osxsave = (regs[2] >> 27) & 1;
+	const bool avx = (regs[2] >> 28) & 1;
+	const bool fma = (regs[2] >> 12) & 1;
+	if (!osxsave || !avx || !fma) {
+		return Isa::SCALAR;
+	}
+
+	// bits 1 and 2 are the xmm and ymm state, 5 to 7 the mask and zmm state
+	const uint32_t xcr0 = xgetbv();
+	if ((xcr0 & 0x6) != 0x6) {
+		return Isa::SCALAR;
+	}
+
+	cpuid(7, 0, regs);
+	const bool avx2 = (regs[1] >> 5) & 1;
+	const bool avx512f = (regs[1] >> 16) & 1;
+	const bool avx512bw = (regs[1] >> 30) & 1;
+	const bool avx512vnni = (regs[2] >> 11) & 1;
+	if (avx512f && avx2 && (xcr0 & 0xE0) == 0xE0) {
+		return avx512bw && avx512vnni ? Isa::AVX512VNNI : Isa::AVX512;
+	}
+	return avx2 ? Isa::AVX2 : Isa::SCALAR;
+#else
+	return Isa::SCALAR;
+#endif
+}
+
+/**
+ *  @brief returns the kernels of a level
+ *
+ *  @param isa the level
+ *  @return the table, or nullptr if the host cannot run the level or it was not built
+ */
+const KernelTable* Kernels::getTable(Isa isa) {
+	// filled once, the first time any level is asked for
+	struct Tables {
+		KernelTable tables[ISA_LEVELS];
+		bool built[ISA_LEVELS];
+
+		Tables(void) {
+			const Isa host = Kernels::detect();
+			built[0] = Kernels::fillScalar(tables[0]);
+			built[1] = host >= Isa::AVX2 && Kernels::fillAvx2(tables[1]);
+			built[2] = host >= Isa::AVX512 && Kernels::fillAvx512(tables[2]);
+			built[3] = host >= Isa::AVX512VNNI && Kernels::fillAvx512Vnni(tables[3]);
+		}
+	};
+	static const Tables tables;
+
+	const size_t index = static_cast<size_t>(isa);
+	return index < ISA_LEVELS && tables.built[index] ? &tables.tables[index] : nullptr;
+}
+
+/**
+ *  @brief returns the name NNF_ISA uses for a level
+ *
+ *  @param isa the level
+ *  @return the name
+ */
+const char* Kernels::getName(Isa isa) {
+	switch (isa) {
+	case Isa::AVX2:
+		return "avx2";
+	case Isa::AVX512:
+		return "avx512";
+	case Isa::AVX512VNNI:
+		return "avx512vnni";
+	default:
+		return "scalar";
+	}
+}
+
+/**
+ *  @brief reads a level from its name
+ *
+ *  @param name the name (scalar, avx2, avx512 or avx512vnni)
+ *  @param isa receives the level
+ *  @return true if the name is known
+ */
+bool Kernels::parse(const char* name, Isa& isa) {
+	const Isa levels[] = { Isa::SCALAR, Isa::AVX2, Isa::AVX512, Isa::AVX512VNNI };
+	for (Isa level : levels) {
+		if (strcmp(name, getName(level)) == 0) {
+			isa = level;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ *  @brief picks the level on first use
+ *
+ *  @return the kernels of the best level the host runs, or of the level NNF_ISA asks for
+ */
+const KernelTable& Kernels::select(void) {
+	Isa isa = detect();
+
+	const char* name = getenv("NNF_ISA");
+	if (name && *name) {
+		Isa requested;
+		if (!parse(name, requested)) {
+			cerr << "NNF_ISA=" << name << " is not one of scalar, avx2, avx512 or avx512vnni, using " << getName(isa) << endl;
+		}
+		else if (!getTable(requested)) {
+			cerr << "NNF_ISA=" << name << " is not supported by this host, using " << getName(isa) << endl;
+		}
+		else {
+			isa = requested;
+		}
+	}
+
+	return *getTable(isa);
+}
+
+/**
+ *  @brief returns the selected level
+ *
+ *  @return the level of the kernels get() hands out
+ */
+Isa Kernels::getIsa(void) {
+	return get().isa;
+}
+
+/**
+ *  @brief fills an array with uniform values in [-1, 1)
+ *
+ *  @param vec the array
+ *  @param length the number of elements
+ *  @param seed the seed of the values
+ *  @return void
+ */
+template <typename T>
+static void fillUniform(T* vec, size_t length, uint64_t seed) {
+	const Philox philox(seed);
+	uint32_t words[4];
+	for (size_t i = 0; i < length; i++) {
+		philox.generate(i, words);
+		vec[i] = static_cast<T>(2.0 * Philox::toUniform(words[0], words[1]) - 1.0);
+	}
+}
+
+/**
+ *  @brief returns the largest difference between two arrays relative to a magnitude
+ *
+ *  @param expected the reference values
+ *  @param actual the values to check
+ *  @param length the number of elements
+ *  @param magnitude the size of a typical value (e.g. the length of a dot product)
+ *  @return the largest absolute difference divided by magnitude
+ */
+template <typename T>
+static double difference(const T* expected, const T* actual, size_t length, double magnitude) {
+	double worst = 0.0;
+	for (size_t i = 0; i < length; i++) {
+		const double delta = fabs(static_cast<double>(expected[i]) - static_cast<double>(actual[i]));
+		worst = delta > worst ? delta : worst;
+	}
+	return worst / magnitude;
+}
+
+/**
+ *  @brief compares every kernel of one element type against the reference kernels
+ *
+ *  @param reference the plain C++ kernels
+ *  @param kernels the kernels to check
+ *  @param tolerance the largest relative difference accepted
+ *  @param failure receives the name of the first kernel that disagrees
+ *  @return true if every kernel agrees
+ */
+template <typename T>
+static bool compare(const KernelSet<T>& reference, const KernelSet<T>& kernels, double tolerance, const char*& failure) {
+	// an empty row must not be read
+	T shift = T(0);
+	if (!(kernels.max(nullptr, 0) < T(0)) || kernels.maxExpSum(nullptr, 0, &shift) != T(0)) {
+		failure = "empty max";
+		return false;
+	}
+
+	// the lengths straddle every register width and unroll factor
+	const uint32_t lengths[] = { 1, 3, 7, 8, 15, 16, 17, 33, 64, 100, 1000, 4099 };
+	for (uint32_t length : lengths) {
+		vector<T> x(length), y(length), expected(length), actual(length);
+		vector<uint8_t> bytes(length);
+		fillUniform(x.data(), length, 1 + length);
+		fillUniform(y.data(), length, 2 + length);
+		for (uint32_t i = 0; i < length; i++) {
+			bytes[i] = static_cast<uint8_t>(i * 37 + 11);
+		}
+
+		if (fabs(static_cast<double>(reference.dot(x.data(), y.data(), length) - kernels.dot(x.data(), y.data(), length))) > tolerance * length) {
+			failure = "dot";
+			return false;
+		}
+		if (fabs(static_cast<double>(reference.sum(x.data(), length) - kernels.sum(x.data(), length))) > tolerance * length) {
+			failure = "sum";
+			return false;
+		}
+		if (reference.max(x.data(), length) != kernels.max(x.data(), length)) {
+			failure = "max";
+			return false;
+		}
+
+		expected = y;
+		actual = y;
+		reference.axpy(T(0.75), x.data(), expected.data(), length);
+		kernels.axpy(T(0.75), x.data(), actual.data(), length);
+		if (difference(expected.data(), actual.data(), length, 1.0) > tolerance) {
+			failure = "axpy";
+			return false;
+		}
+
+		expected = x;
+		actual = x;
+		reference.scale(T(-1.5), expected.data(), length);
+		kernels.scale(T(-1.5), actual.data(), length);
+		if (difference(expected.data(), actual.data(), length, 1.0) > tolerance) {
+			failure = "scale";
+			return false;
+		}
+
+		const T expectedTotal = reference.expShiftSum(x.data(), expected.data(), T(0.5), length);
+		const T actualTotal = kernels.expShiftSum(x.data(), actual.data(), T(0.5), length);
+		if (difference(expected.data(), actual.data(), length, 1.0) > tolerance ||
+			fabs(static_cast<double>(expectedTotal - actualTotal)) > tolerance * length) {
+			failure = "expShiftSum";
+			return false;
+		}
+
+		// the online pass has to agree with max followed by expShiftSum
+		const T onlineTotal = kernels.maxExpSum(x.data(), length, &shift);
+		const T expectedShift = reference.max(x.data(), length);
+		if (shift != expectedShift ||
+			fabs(static_cast<double>(reference.expShiftSum(x.data(), nullptr, expectedShift, length) - onlineTotal)) > tolerance * length) {
+			failure = "maxExpSum";
+			return false;
+		}
+
+		expected = x;
+		actual = x;
+		reference.relu(expected.data(), length);
+		kernels.relu(actual.data(), length);
+		if (difference(expected.data(), actual.data(), length, 1.0) > 0.0) {
+			failure = "relu";
+			return false;
+		}
+
+		for (uint32_t i = 0; i < length; i++) {
+			expected[i] = actual[i] = T(8) * x[i];
+		}
+		reference.sigmoid(expected.data(), length);
+		kernels.sigmoid(actual.data(), length);
+		if (difference(expected.data(), actual.data(), length, 1.0) > tolerance) {
+			failure = "sigmoid";
+			return false;
+		}
+
+		reference.normalize(bytes.data(), expected.data(), length, T(1.0 / 255.0), T(-0.5));
+		kernels.normalize(bytes.data(), actual.data(), length, T(1.0 / 255.0), T(-0.5));
+		if (difference(expected.data(), actual.data(), length, 1.0) > tolerance) {
+			failure = "normalize";
+			return false;
+		}
+	}
+
+	// odd shapes leave partial tiles on every edge and k spans several blocks
+	const uint32_t shapes[][3] = { { 1, 1, 1 }, { 7, 13, 5 }, { 37, 29, 300 }, { 64, 70, 33 } };
+	for (const uint32_t* shape : shapes) {
+		const uint32_t m = shape[0], n = shape[1], k = shape[2];
+		vector<T> a(static_cast<size_t>(m) * k), b(static_cast<size_t>(k) * n);
+		fillUniform(a.data(), a.size(), 3 + m);
+		fillUniform(b.data(), b.size(), 4 + n);
+
+		for (int trans = 0; trans < 4; trans++) {
+			const bool transA = (trans & 1) != 0;
+			const bool transB = (trans & 2) != 0;
+			vector<T> expected(static_cast<size_t>(m) * n, T(1)), actual(static_cast<size_t>(m) * n, T(1));
+			reference.gemm(transA, transB, m, n, k, T(0.5), a.data(), transA ? m : k, b.data(), transB ? k : n, expected.data(), n);
+			kernels.gemm(transA, transB, m, n, k, T(0.5), a.data(), transA ? m : k, b.data(), transB ? k : n, actual.data(), n);
+			if (difference(expected.data(), actual.data(), expected.size(), k) > tolerance) {
+				failure = "gemm";
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ *  @brief compares the bfloat16 gemms of a level against the reference
+ *
+ *  @param reference the plain C++ kernels
+ *  @param table the kernels to check
+ *  @return true if every bfloat16 gemm agrees
+ */
+static bool compareBF16(const KernelTable& reference, const KernelTable& table) {
+	const uint32_t m = 19, n = 45, k = 70;
+	vector<float> a(m * k), b(k * n);
+	fillUniform(a.data(), a.size(), 5);
+	fillUniform(b.data(), b.size(), 6);
+	vector<BFloat16> a16(a.size()), b16(b.size());
+	for (size_t i = 0; i < a.size(); i++) {
+		a16[i] = BFloat16(a[i]);
+	}
+	for (size_t i = 0; i < b.size(); i++) {
+		b16[i] = BFloat16(b[i]);
+	}
+
+	for (int trans = 0; trans < 4; trans++) {
+		const bool transA = (trans & 1) != 0;
+		const bool transB = (trans & 2) != 0;
+		const uint32_t lda = transA ? m : k, ldb = transB ? k : n;
+		vector<float> expected(m * n), actual(m * n);
+
+		reference.gemmBF16F32(transA, transB, m, n, k, 1.0f, a16.data(), lda, b.data(), ldb, expected.data(), n);
+		table.gemmBF16F32(transA, transB, m, n, k, 1.0f, a16.data(), lda, b.data(), ldb, actual.data(), n);
+		if (difference(expected.data(), actual.data(), expected.size(), k) > 1e-4) {
+			return false;
+		}
+
+		fill(expected.begin(), expected.end(), 0.0f);
+		fill(actual.begin(), actual.end(), 0.0f);
+		reference.gemmF32BF16(transA, transB, m, n, k, 1.0f, a.data(), lda, b16.data(), ldb, expected.data(), n);
+		table.gemmF32BF16(transA, transB, m, n, k, 1.0f, a.data(), lda, b16.data(), ldb, actual.data(), n);
+		if (difference(expected.data(), actual.data(), expected.size(), k) > 1e-4) {
+			return false;
+		}
+
+		fill(expected.begin(), expected.end(), 0.0f);
+		fill(actual.begin(), actual.end(), 0.0f);
+		reference.gemmBF16BF16(transA, transB, m, n, k, 1.0f, a16.data(), lda, b16.data(), ldb, expected.data(), n);
+		table.gemmBF16BF16(transA, transB, m, n, k, 1.0f, a16.data(), lda, b16.data(), ldb, actual.data(), n);
+		if (difference(expected.data(), actual.data(), expected.size(), k) > 1e-4) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ *  @brief compares the bfloat16 conversions and the bilinear sampler of a level against the reference
+ *
+ *  @param reference the plain C++ kernels
+ *  @param table the kernels to check
+ *  @param failure receives the name of the first kernel that disagrees
+ *  @return true if every kernel agrees
+ */
+static bool compareOthers(const KernelTable& reference, const KernelTable& table, const char*& failure) {
+	// the conversions must match bit for bit, ties, NaNs and infinities included
+	const uint32_t length = 1000;
+	vector<float> values(length), expected(length), actual(length);
+	fillUniform(values.data(), length, 7);
+	const uint32_t specials[] = { 0x7fc00000, 0x7f800001, 0xff800000, 0x7f800000, 0x3f808000, 0x3f818000, 0x80000000, 0x00000001 };
+	for (uint32_t i = 0; i < sizeof(specials) / sizeof(specials[0]); i++) {
+		memcpy(&values[i * 37], &specials[i], sizeof(float));
+	}
+	vector<BFloat16> expected16(length), actual16(length);
+	reference.toBF16(values.data(), expected16.data(), length - 3);
+	table.toBF16(values.data(), actual16.data(), length - 3);
+	reference.fromBF16(expected16.data(), expected.data(), length - 3);
+	table.fromBF16(expected16.data(), actual.data(), length - 3);
+	for (uint32_t i = 0; i + 3 < length; i++) {
+		if (expected16[i].bits != actual16[i].bits) {
+			failure = "toBF16";
+			return false;
+		}
+		if (memcmp(&expected[i], &actual[i], sizeof(float)) != 0) {
+			failure = "fromBF16";
+			return false;
+		}
+	}
+
+	// positions anywhere in [-1, width - 1) of a 28 x 28 image inside its border
+	const uint32_t width = 28, paddedWidth = width + 2;
+	vector<float> padded(paddedWidth * paddedWidth), x(length), y(length);
+	fillUniform(padded.data(), padded.size(), 8);
+	fillUniform(x.data(), length, 9);
+	fillUniform(y.data(), length, 10);
+	for (uint32_t i = 0; i < length; i++) {
+		x[i] = (x[i] + 1.0f) * 0.5f * (width - 0.001f) - 1.0f;
+		y[i] = (y[i] + 1.0f) * 0.5f * (width - 0.001f) - 1.0f;
+	}
+	reference.bilinear(padded.data(), paddedWidth, x.data(), y.data(), expected.data(), length - 3);
+	table.bilinear(padded.data(), paddedWidth, x.data(), y.data(), actual.data(), length - 3);
+	if (difference(expected.data(), actual.data(), length - 3, 1.0) > 1e-5) {
+		failure = "bilinear";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ *  @brief checks the int8 gemm of a level against sums computed here
+ *
+ *  @param table the kernels to check
+ *  @return true if every sum is exact
+ */
+static bool compareS8(const KernelTable& table) {
+	// k straddles every group and register width, n every panel width
+	const uint32_t ks[] = { 1, 3, 4, 15, 64, 65, 784 };
+	const uint32_t ns[] = { 1, 10, 33 };
+	const uint32_t m = 13;
+	for (uint32_t k : ks) {
+		for (uint32_t n : ns) {
+			const uint32_t lda = k + 3, ldb = k + 5;
+			vector<uint8_t> a(static_cast<size_t>(m) * lda);
+			vector<int8_t> b(static_cast<size_t>(n) * ldb);
+			for (size_t i = 0; i < a.size(); i++) {
+				a[i] = static_cast<uint8_t>(i * 151 + 7);
+			}
+			for (size_t i = 0; i < b.size(); i++) {
+				b[i] = static_cast<int8_t>(static_cast<int32_t>((i * 97 + 3) % 255) - 127);
+			}
+
+			const Int8KernelSet& s8 = table.s8;
+			const size_t panels = (n + s8.cols - 1) / s8.cols;
+			const size_t groups = (k + s8.group - 1) / s8.group;
+			vector<int8_t> packed(panels * groups * s8.cols * s8.group);
+			vector<int32_t> c(static_cast<size_t>(m) * n);
+			s8.packS8(n, k, b.data(), ldb, packed.data());
+			s8.gemmU8S8(m, n, k, a.data(), lda, packed.data(), c.data(), n);
+
+			for (uint32_t i = 0; i < m; i++) {
+				for (uint32_t j = 0; j < n; j++) {
+					int32_t expected = 0;
+					for (uint32_t p = 0; p < k; p++) {
+						expected += a[i * lda + p] * b[j * ldb + p];
+					}
+					if (c[i * n + j] != expected) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ *  @brief compares every level the host supports with the plain C++ level
+ *
+ *  @param out receives one line per level
+ *  @return true if every level agrees
+ */
+bool Kernels::verify(ostream& out) {
+	const KernelTable& reference = *getTable(Isa::SCALAR);
+	bool passed = true;
+
+	const Isa levels[] = { Isa::SCALAR, Isa::AVX2, Isa::AVX512, Isa::AVX512VNNI };
+	for (Isa level : levels) {
+		const KernelTable* table = getTable(level);
+		if (!table) {
+			out << getName(level) << ": not supported by this host" << endl;
+			continue;
+		}
+
+		// the levels only differ in summation order and fused rounding
+		const char* failure = nullptr;
+		bool agrees = compare(reference.f64, table->f64, 1e-12, failure) && compare(reference.f32, table->f32, 1e-4, failure);
+		if (agrees && !compareBF16(reference, *table)) {
+			failure = "bfloat16 gemm";
+			agrees = false;
+		}
+		if (agrees && !compareOthers(reference, *table, failure)) {
+			agrees = false;
+		}
+		if (agrees && !compareS8(*table)) {
+			failure = "int8 gemm";
+			agrees = false;
+		}
+		out << getName(level) << (table == &get() ? " (selected)" : "") << ": "
+			<< (agrees ? "matches scalar" : string(failure) + " differs from scalar") << endl;
+		passed = passed && agrees;
+	}
+
+	return passed;
+}
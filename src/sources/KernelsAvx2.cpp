@@ -0,0 +1,64 @@
+/**
+ *  @file    KernelsAvx2.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief the MathUtils kernels built for AVX2 with FMA
+ *
+ *  @section DESCRIPTION
+ *
+ *  This translation unit builds KernelVariants.h with 256 bit
+ *  registers. gcc and clang are told to generate AVX2 and FMA code for
+ *  this file only, while msvc accepts the intrinsics at any /arch
+ *  setting. Kernels only hands these kernels out when CPUID reports
+ *  AVX2, FMA and an OS that saves the ymm registers.
+ *
+ */
+
+#include "Kernels.h"
+#include "MathUtils.h"
+#include "Arena.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+// everything included above keeps the baseline target, so only the kernels
+// below (which use no standard library templates) are built for AVX2
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#define SIMD_TARGET_AVX2
+#include "KernelVariants.h"
+
+/**
+ *  @brief fills a table with the AVX2 kernels
+ *
+ *  @param table the table to fill
+ *  @return true
+ */
+bool Kernels::fillAvx2(KernelTable& table) {
+	simd_avx2::fillTable(table, Isa::AVX2);
+	return true;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#else
+/**
+ *  @brief leaves the table alone since AVX2 does not exist on this architecture
+ *
+ *  @param table the table to fill
+ *  @return false
+ */
+bool Kernels::fillAvx2(KernelTable& table) {
+	return false;
+}
+#endif
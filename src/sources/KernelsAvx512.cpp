@@ -0,0 +1,64 @@
+/**
+ *  @file    KernelsAvx512.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief the MathUtils kernels built for AVX-512
+ *
+ *  @section DESCRIPTION
+ *
+ *  This translation unit builds KernelVariants.h with 512 bit
+ *  registers. gcc and clang are told to generate AVX-512F code for
+ *  this file only, while msvc accepts the intrinsics at any /arch
+ *  setting. Kernels only hands these kernels out when CPUID reports
+ *  AVX-512F and an OS that saves the zmm and mask registers.
+ *
+ */
+
+#include "Kernels.h"
+#include "MathUtils.h"
+#include "Arena.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+// everything included above keeps the baseline target, so only the kernels
+// below (which use no standard library templates) are built for AVX-512
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+#endif
+
+#define SIMD_TARGET_AVX512
+#include "KernelVariants.h"
+
+/**
+ *  @brief fills a table with the AVX-512 kernels
+ *
+ *  @param table the table to fill
+ *  @return true
+ */
+bool Kernels::fillAvx512(KernelTable& table) {
+	simd_avx512::fillTable(table, Isa::AVX512);
+	return true;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#else
+/**
+ *  @brief leaves the table alone since AVX-512 does not exist on this architecture
+ *
+ *  @param table the table to fill
+ *  @return false
+ */
+bool Kernels::fillAvx512(KernelTable& table) {
+	return false;
+}
+#endif
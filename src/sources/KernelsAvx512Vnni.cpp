@@ -0,0 +1,66 @@
+/**
+ *  @file    KernelsAvx512Vnni.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief the MathUtils kernels built for AVX-512 with VNNI
+ *
+ *  @section DESCRIPTION
+ *
+ *  This translation unit builds KernelVariants.h with 512 bit
+ *  registers and the VNNI byte dot product, which only the int8 gemm
+ *  uses; the other kernels match the AVX-512 level. gcc and clang are
+ *  told to generate AVX-512F, BW and VNNI code for this file only,
+ *  while msvc accepts the intrinsics at any /arch setting. Kernels
+ *  only hands these kernels out when CPUID reports all three and an
+ *  OS that saves the zmm and mask registers.
+ *
+ */
+
+#include "Kernels.h"
+#include "MathUtils.h"
+#include "Arena.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+// everything included above keeps the baseline target, so only the kernels
+// below (which use no standard library templates) are built for AVX-512 VNNI
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512bw,avx512vnni,avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512vnni,avx2,fma")
+#endif
+
+#define SIMD_TARGET_AVX512VNNI
+#include "KernelVariants.h"
+
+/**
+ *  @brief fills a table with the AVX-512 VNNI kernels
+ *
+ *  @param table the table to fill
+ *  @return true
+ */
+bool Kernels::fillAvx512Vnni(KernelTable& table) {
+	simd_avx512vnni::fillTable(table, Isa::AVX512VNNI);
+	return true;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#else
+/**
+ *  @brief leaves the table alone since AVX-512 VNNI does not exist on this architecture
+ *
+ *  @param table the table to fill
+ *  @return false
+ */
+bool Kernels::fillAvx512Vnni(KernelTable& table) {
+	return false;
+}
+#endif
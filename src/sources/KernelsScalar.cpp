@@ -0,0 +1,35 @@
+/**
+ *  @file    KernelsScalar.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief the MathUtils kernels built for plain C++
+ *
+ *  @section DESCRIPTION
+ *
+ *  This translation unit builds KernelVariants.h without vector
+ *  intrinsics. It is the level every host can run and the reference
+ *  the other levels are verified against.
+ *
+ */
+
+#include "Kernels.h"
+#include "MathUtils.h"
+#include "Arena.h"
+
+#include <cstring>
+
+#define SIMD_TARGET_SCALAR
+#include "KernelVariants.h"
+
+/**
+ *  @brief fills a table with the plain C++ kernels
+ *
+ *  @param table the table to fill
+ *  @return true (this level is always built)
+ */
+bool Kernels::fillScalar(KernelTable& table) {
+	simd_scalar::fillTable(table, Isa::SCALAR);
+	return true;
+}
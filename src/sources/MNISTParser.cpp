@@ -15,6 +15,11 @@
  */
 
 #include "MNISTParser.h"
+#include "MathUtils.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
+
+#include <algorithm>
 
 /**
  *   @brief  Class constructor
@@ -37,54 +42,53 @@ const char* MNISTParserException::what() const noexcept {
  *   @brief  parses the image file
  *
  *   @param  name the full path to the image file
- *   @return a vector containing pointers of type ImageData for each image
+ *   @return a vector containing pointers of type ImageData for each image (empty if the
+ *           file could not be read)
  */
 vector<ImageData*> MNISTParser::parseImageFile(string name) {
-	ifstream in(name.c_str(), std::ifstream::in | std::ifstream::binary);
-
-	// If the file is not opened or is empty, throw an exception and
-	// return an empty vector
+	NNF_TRACE_SCOPE("MNISTParser::parseImageFile");
+	// If the file is not opened, is empty or is not an image file, throw
+	// an exception and return an empty vector
+	unique_ptr<IDXReader> reader;
 	try {
-		MNISTParser::validateStream(in, name);
+		reader.reset(new IDXReader(name));
+		MNISTParser::validateImageReader(*reader, name);
 	}
 	catch (const exception& e) {
 		cout << e.what() << endl;
 		return vector<ImageData*>();
 	}
-	
+
 	// Every image file from the MNIST Database is formated like so:
 	// int32 magic number
 	// int32 number of images
 	// int32 width in pixels
 	// int32 height in pixels
 	// raw image data
-	unique_ptr<char> magicNumber = unique_ptr<char>(new char[4]);
-	unique_ptr<char> numberOfItems = unique_ptr<char>(new char[4]);
-	unique_ptr<char> widthBytes = unique_ptr<char>(new char[4]);
-	unique_ptr<char> heightBytes = unique_ptr<char>(new char[4]);
-
-	in.read(magicNumber.get(), 4);
-	in.read(numberOfItems.get(), 4);
-	in.read(widthBytes.get(), 4);
-	in.read(heightBytes.get(), 4);
-
-	// Now that we read the header info, lets get width, height, size, and
-	// number of images
-	const uint16_t width = static_cast<uint16_t>(convertToUInt(widthBytes.get()));
-	const uint16_t height = static_cast<uint16_t>(convertToUInt(heightBytes.get()));
-	const uint16_t size = width * height;
-	const uint32_t numImages = convertToUInt(numberOfItems.get());
+	const uint32_t width = reader->getDimensions()[2];
+	const uint32_t size = static_cast<uint32_t>(reader->getRecordElements());
+	const uint32_t numImages = static_cast<uint32_t>(reader->getNumRecords());
 	vector<ImageData*> images(numImages, nullptr);
 
-	// loop through the raw data and store them inside of ImageData objects
-	for (uint32_t i = 0; i < numImages; i++) {
-		char* data = new char[size];
-		in.read(data, size);
-		images[i] = new ImageData((uint8_t*)data, width, size);
+	// loop through the raw data in chunks and store each image inside of
+	// an ImageData object
+	try {
+		IDXChunk chunk;
+		while (reader->next(chunk)) {
+			const uint8_t* pixels = chunk.as<uint8_t>();
+			for (size_t i = 0; i < chunk.count; i++) {
+				uint8_t* data = new uint8_t[size];
+				memcpy(data, pixels + i * size, size);
+				images[chunk.first + i] = new ImageData(data, width, size);
+			}
+		}
+	}
+	catch (const IDXReaderException& e) {
+		// a compressed file only turns out truncated or corrupt while it is inflated,
+		// so the images read before that are freed and none are returned
+		cout << e.what() << endl;
+		MNISTParser::deleteImages(images);
 	}
-
-	// close the file
-	in.close();
 
 	return images;
 }
@@ -92,17 +96,19 @@ vector<ImageData*> MNISTParser::parseImageFile(string name) {
 /**
  *   @brief  parses the label file
  *
- *   @param  images the vector containing ImageData pointers for each image
+ *   @param  images the vector containing ImageData pointers for each image (left as it
+ *           was if the file turns out to be truncated or corrupt)
  *   @param  name the full path to the label file
  *   @return void
  */
 void MNISTParser::parseLabelFile(vector<ImageData*>& images, string name) {
-	ifstream in(name.c_str(), std::ifstream::in | std::ifstream::binary);
-
-	// If the file is not opened or is empty, throw an exception and
-	// return
+	NNF_TRACE_SCOPE("MNISTParser::parseLabelFile");
+	// If the file is not opened, is empty or is not a label file, throw an
+	// exception and return
+	unique_ptr<IDXReader> reader;
 	try {
-		MNISTParser::validateStream(in, name);
+		reader.reset(new IDXReader(name));
+		MNISTParser::validateLabelReader(*reader, name);
 		if (images.size() == 0) {
 			throw MNISTParserException(
 				string("There are no image data objects in this vector.")
@@ -114,60 +120,311 @@ void MNISTParser::parseLabelFile(vector<ImageData*>& images, string name) {
 		return;
 	}
 
-	in.seekg(0, in.end);
-	streampos length = in.tellg();
-	in.seekg(0, in.beg);
-
-	// The header is only 8 bytes long
-	streampos diff = 8;
-
 	// The labels file from the MNIST Database is formated like so:
 	// int32 magic number
 	// int32 number of labels
 	// raw data with values ranging from 0 to 9 (inclusive)
-	unique_ptr<char> magicNumber = unique_ptr<char>(new char[4]);
-	unique_ptr<char> numberOfItems = unique_ptr<char>(new char[4]);
-	unique_ptr<char> labelBytes = unique_ptr<char>(new char[static_cast<uint32_t>(length - diff)]);
+	// The labels are read into a buffer of our own and only assigned once all of
+	// them have been read, so a bad file leaves the caller's images as they were
+	vector<uint8_t> labels(static_cast<size_t>(min<uint64_t>(reader->getNumRecords(), images.size())));
+	try {
+		if (reader->read(labels.data(), labels.size()) != labels.size()) {
+			throw MNISTParserException("File: " + name + " is truncated!");
+		}
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+		return;
+	}
 
-	in.read(magicNumber.get(), 4);
-	in.read(numberOfItems.get(), 4);
-	in.read(labelBytes.get(), length - diff);
+	for (size_t i = 0; i < labels.size(); i++) {
+		images[i]->setLabel(labels[i]);
+	}
+}
 
-	// Let's take the raw data and assign the labels to each ImageData object
-	uint32_t numLabels = convertToUInt(numberOfItems.get());
-	for (uint32_t i = 0; i < numLabels; i++) {
-		images[i]->setLabel(static_cast<uint8_t>(labelBytes.get()[i]));
+/**
+ *   @brief  deletes every image of a vector and empties it
+ *
+ *   @param  images the vector containing ImageData pointers (null entries are skipped)
+ *   @return void
+ */
+void MNISTParser::deleteImages(vector<ImageData*>& images) {
+	for (ImageData* image : images) {
+		delete image;
 	}
+	images.clear();
+}
+
+/**
+ *   @brief  parses the image file into one contiguous block
+ *
+ *   @param  dataset the dataset that receives the pixels (resized to fit)
+ *   @param  name the full path to the image file
+ *   @return void
+ */
+void MNISTParser::parseImageFile(Dataset& dataset, string name) {
+	NNF_TRACE_SCOPE("MNISTParser::parseImageFile");
+	// If the file is not opened, is empty or is not an image file, throw
+	// an exception and leave the dataset empty
+	unique_ptr<IDXReader> reader;
+	try {
+		reader.reset(new IDXReader(name));
+		MNISTParser::validateImageReader(*reader, name);
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+		dataset = Dataset();
+		return;
+	}
+
+	const vector<uint32_t>& dimensions = reader->getDimensions();
+	const uint32_t numImages = static_cast<uint32_t>(reader->getNumRecords());
 
-	// close the file
-	in.close();
+	// every image lands in the same block so one read fills the dataset
+	dataset.resize(numImages, dimensions[2], dimensions[1]);
+	try {
+		reader->read(dataset.getPixels(0), numImages);
+	}
+	catch (const IDXReaderException& e) {
+		// a compressed file only turns out truncated or corrupt while it is inflated
+		cout << e.what() << endl;
+		dataset = Dataset();
+	}
+}
+
+/**
+ *   @brief  parses the image file and normalizes it in the same pass
+ *
+ *   @param  dataset the dataset that receives the images (resized to fit)
+ *   @param  name the full path to the image file
+ *   @param  normalization how every pixel is mapped to a feature
+ *   @param  storage FEATURES to keep only the floats, BOTH to keep the pixels too
+ *   @return void
+ */
+void MNISTParser::parseImageFile(Dataset& dataset, string name, const Normalization& normalization, DatasetStorage storage) {
+	NNF_TRACE_SCOPE("MNISTParser::parseImageFile");
+	unique_ptr<IDXReader> reader;
+	try {
+		reader.reset(new IDXReader(name));
+		MNISTParser::validateImageReader(*reader, name);
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+		dataset = Dataset();
+		return;
+	}
+
+	const vector<uint32_t>& dimensions = reader->getDimensions();
+	const uint32_t numImages = static_cast<uint32_t>(reader->getNumRecords());
+	const size_t imageSize = reader->getRecordElements();
+	dataset.resize(numImages, dimensions[2], dimensions[1], storage);
+	try {
+		if (!dataset.hasFeatures()) {
+			reader->read(dataset.getPixels(0), numImages);
+			return;
+		}
+		dataset.setNormalization(normalization);
+
+		// every chunk is converted while it is still in cache from the read, so
+		// the pixels only ever pass through the reader's bounded buffer
+		ThreadPool& pool = ThreadPool::getGlobal();
+		IDXChunk chunk;
+		while (reader->next(chunk)) {
+			const uint8_t* pixels = chunk.as<uint8_t>();
+			const uint32_t first = static_cast<uint32_t>(chunk.first);
+			if (dataset.hasPixels()) {
+				memcpy(dataset.getPixels(first), pixels, chunk.count * imageSize);
+			}
+
+			pool.parallelFor(chunk.count, MathUtils::getNumThreads(), [&](uint64_t begin, uint64_t end) {
+				for (uint64_t i = begin; i < end; i++) {
+					MathUtils::normalize(pixels + i * imageSize, dataset.getFeatures(first + static_cast<uint32_t>(i)),
+						imageSize, normalization.scale, normalization.offset);
+				}
+			});
+		}
+	}
+	catch (const IDXReaderException& e) {
+		// a compressed file only turns out truncated or corrupt while it is inflated
+		cout << e.what() << endl;
+		dataset = Dataset();
+	}
 }
 
 /**
- *   @brief  checks if the ifstream has been opened or is empty
+ *   @brief  parses the label file into the dataset's label array
  *
- *   @param  in the ifstream object for the file we are attempting to ingest
+ *   @param  dataset the dataset that receives the labels
+ *   @param  name the full path to the label file
+ *   @return void
+ */
+void MNISTParser::parseLabelFile(Dataset& dataset, string name) {
+	NNF_TRACE_SCOPE("MNISTParser::parseLabelFile");
+	// If the file is not opened, is empty or is not a label file, throw an
+	// exception and return
+	unique_ptr<IDXReader> reader;
+	try {
+		reader.reset(new IDXReader(name));
+		MNISTParser::validateLabelReader(*reader, name);
+		if (dataset.empty()) {
+			throw MNISTParserException(
+				string("There are no images in this dataset.")
+			);
+		}
+		if (reader->getNumRecords() != dataset.getCount()) {
+			throw MNISTParserException(
+				"File: " + name + " does not hold one label per image!"
+			);
+		}
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+		return;
+	}
+
+	// the labels are copied straight into the contiguous label array
+	try {
+		if (reader->read(dataset.getLabels(), dataset.getCount()) != dataset.getCount()) {
+			throw MNISTParserException("File: " + name + " is truncated!");
+		}
+	}
+	catch (const exception& e) {
+		// half a label array is worse than none, so the dataset is dropped
+		cout << e.what() << endl;
+		dataset = Dataset();
+	}
+}
+
+/**
+ *   @brief  creates views into a mapped image file without copying any pixels
+ *
+ *   @param  file the mapped image file (must outlive the returned images)
+ *   @return a vector containing one non-owning ImageData per image
+ */
+vector<ImageData> MNISTParser::mapImageFile(const MappedFile& file) {
+	NNF_TRACE_SCOPE("MNISTParser::mapImageFile");
+	const char* bytes = reinterpret_cast<const char*>(file.getData());
+
+	// The header is validated once and then every image is just an
+	// offset into the mapping
+	try {
+		if (!file.isOpen() || file.getSize() < IMAGE_HEADER_SIZE) {
+			throw MNISTParserException(string("The mapped image file is too small."));
+		}
+		if (convertToUInt(bytes) != IMAGE_MAGIC) {
+			throw MNISTParserException(string("The mapped file is not a MNIST image file."));
+		}
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+		return vector<ImageData>();
+	}
+
+	const uint32_t numImages = convertToUInt(bytes + 4);
+	const uint32_t width = convertToUInt(bytes + 8);
+	const uint32_t height = convertToUInt(bytes + 12);
+	const uint64_t size = static_cast<uint64_t>(width) * height;
+
+	try {
+		if (size == 0 || size > UINT32_MAX) {
+			throw MNISTParserException(string("The mapped image file has unsupported dimensions."));
+		}
+		if (file.getSize() < IMAGE_HEADER_SIZE + size * numImages) {
+			throw MNISTParserException(string("The mapped image file is truncated."));
+		}
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+		return vector<ImageData>();
+	}
+
+	vector<ImageData> images;
+	images.reserve(numImages);
+
+	const uint8_t* pixels = file.getData() + IMAGE_HEADER_SIZE;
+	for (uint32_t i = 0; i < numImages; i++) {
+		images.emplace_back(
+			pixels + size * i, width, static_cast<uint32_t>(size), static_cast<uint8_t>(0)
+		);
+	}
+
+	return images;
+}
+
+/**
+ *   @brief  assigns labels from a mapped label file
+ *
+ *   @param  images the vector containing ImageData views for each image
+ *   @param  file the mapped label file
+ *   @return void
+ */
+void MNISTParser::mapLabelFile(vector<ImageData>& images, const MappedFile& file) {
+	NNF_TRACE_SCOPE("MNISTParser::mapLabelFile");
+	const char* bytes = reinterpret_cast<const char*>(file.getData());
+
+	try {
+		if (images.size() == 0) {
+			throw MNISTParserException(
+				string("There are no image data objects in this vector.")
+			);
+		}
+		if (!file.isOpen() || file.getSize() < LABEL_HEADER_SIZE) {
+			throw MNISTParserException(string("The mapped label file is too small."));
+		}
+		if (convertToUInt(bytes) != LABEL_MAGIC) {
+			throw MNISTParserException(string("The mapped file is not a MNIST label file."));
+		}
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+		return;
+	}
+
+	// never read past the mapping or the images
+	uint64_t numLabels = convertToUInt(bytes + 4);
+	numLabels = min<uint64_t>(numLabels, file.getSize() - LABEL_HEADER_SIZE);
+	numLabels = min<uint64_t>(numLabels, images.size());
+
+	const uint8_t* labels = file.getData() + LABEL_HEADER_SIZE;
+	for (uint64_t i = 0; i < numLabels; i++) {
+		images[i].setLabel(labels[i]);
+	}
+}
+
+/**
+ *   @brief  checks that an IDX file holds MNIST style images
+ *
+ *   @param  reader the reader positioned after the header
  *   @param  name the full path of the file
  *   @return void
  */
-void MNISTParser::validateStream(ifstream& in, string name) {
-	// Check if the file is open
-	if (!in.is_open()) {
+void MNISTParser::validateImageReader(const IDXReader& reader, string name) {
+	if (reader.getType() != IDXType::UBYTE || reader.getDimensions().size() != 3) {
 		throw MNISTParserException(
-			"File: " + name + " failed to open!"
+			"File: " + name + " is not a MNIST image file!"
 		);
 	}
 
-	in.seekg(0, in.end);
-	streampos length = in.tellg();
-
-	if (length == static_cast<streampos>(0)) {
+	if (reader.getRecordElements() == 0) {
 		throw MNISTParserException(
-			"File: " + name + " is empty!"
+			"File: " + name + " contains empty images!"
 		);
 	}
+}
 
-	in.seekg(0);
+/**
+ *   @brief  checks that an IDX file holds MNIST style labels
+ *
+ *   @param  reader the reader positioned after the header
+ *   @param  name the full path of the file
+ *   @return void
+ */
+void MNISTParser::validateLabelReader(const IDXReader& reader, string name) {
+	if (reader.getType() != IDXType::UBYTE || reader.getDimensions().size() != 1) {
+		throw MNISTParserException(
+			"File: " + name + " is not a MNIST label file!"
+		);
+	}
 }
 
  /**
@@ -0,0 +1,220 @@
+/**
+ *  @file    MappedFile.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief memory mapping of a whole file
+ *
+ *  @section DESCRIPTION
+ *
+ *  This class maps a file into the address space once so that
+ *  callers can hand out pointers into it instead of copying the
+ *  contents onto the heap. The mapping is shared, so several
+ *  processes reading the same file share the page cache.
+ *
+ *  A copy-on-write mapping can also be written to: the pages start
+ *  out shared, a page that gets written becomes a private copy of this
+ *  process, and the file itself never changes.
+ *
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+MappedFileException::MappedFileException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* MappedFileException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief empty constructor
+ */
+MappedFile::MappedFile(void) {
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param name the full path of the file to map
+ *  @param mode how the file is mapped
+ */
+MappedFile::MappedFile(string name, MappedFileMode mode) {
+	open(name, mode);
+}
+
+/**
+ *  @brief destructor
+ */
+MappedFile::~MappedFile(void) {
+	close();
+}
+
+/**
+ *  @brief maps the whole file
+ *
+ *  @param name the full path of the file to map
+ *  @param mode how the file is mapped
+ *  @return void
+ */
+void MappedFile::open(string name, MappedFileMode mode) {
+	close();
+	const bool copyOnWrite = mode == MappedFileMode::COPY_ON_WRITE;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(
+		name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL
+	);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw MappedFileException("File: " + name + " failed to open!");
+	}
+
+	LARGE_INTEGER length;
+	if (!GetFileSizeEx(file, &length) || length.QuadPart == 0) {
+		CloseHandle(file);
+		throw MappedFileException("File: " + name + " is empty!");
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(file);
+		throw MappedFileException("File: " + name + " failed to map!");
+	}
+
+	void* view = MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		throw MappedFileException("File: " + name + " failed to map!");
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = static_cast<uint8_t*>(view);
+	size = static_cast<size_t>(length.QuadPart);
+#else
+	int fd = ::open(name.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw MappedFileException("File: " + name + " failed to open!");
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		::close(fd);
+		throw MappedFileException("File: " + name + " is empty!");
+	}
+
+	// MAP_SHARED lets every process mapping this file use the same pages, MAP_PRIVATE
+	// does too until a page is written
+	void* view = copyOnWrite ?
+		mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) :
+		mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+	// the mapping keeps its own reference to the file
+	::close(fd);
+
+	if (view == MAP_FAILED) {
+		throw MappedFileException("File: " + name + " failed to map!");
+	}
+
+	// the parsers walk the file front to back
+	madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+	data = static_cast<uint8_t*>(view);
+	size = static_cast<size_t>(info.st_size);
+#endif
+	this->mode = mode;
+}
+
+/**
+ *  @brief unmaps the file and releases any handles
+ *
+ *  @return void
+ */
+void MappedFile::close(void) {
+	if (!data) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(static_cast<HANDLE>(mappingHandle));
+	CloseHandle(static_cast<HANDLE>(fileHandle));
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	munmap(data, size);
+#endif
+
+	data = nullptr;
+	size = 0;
+}
+
+/**
+ *  @brief returns a pointer to the first byte of the mapping
+ *
+ *  @return the pointer (nullptr if nothing is mapped)
+ */
+const uint8_t* MappedFile::getData() const {
+	return data;
+}
+
+/**
+ *  @brief returns a writable pointer to the first byte of the mapping
+ *
+ *  @return the pointer (nullptr if nothing is mapped or the mapping is read-only)
+ */
+uint8_t* MappedFile::getWritableData() {
+	return mode == MappedFileMode::COPY_ON_WRITE ? data : nullptr;
+}
+
+/**
+ *  @brief returns how the file is mapped
+ *
+ *  @return the mode passed to open
+ */
+MappedFileMode MappedFile::getMode() const {
+	return mode;
+}
+
+/**
+ *  @brief returns the size of the mapping
+ *
+ *  @return the size in bytes
+ */
+size_t MappedFile::getSize() const {
+	return size;
+}
+
+/**
+ *  @brief checks whether a file is mapped
+ *
+ *  @return true if a file is mapped
+ */
+bool MappedFile::isOpen() const {
+	return data != nullptr;
+}
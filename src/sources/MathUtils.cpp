@@ -14,6 +14,42 @@
  */
 
 #include "MathUtils.h"
+#include "AlignedMemory.h"
+#include "Kernels.h"
+#include "Philox.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+// The array kernels, the gemms and the bfloat16 conversions live in
+// KernelVariants.h, built once per instruction set level, and the functions
+// here forward to the level Kernels picked at startup. The double and float
+// conversions below are plain loops built for the baseline target.
+
+// normals are produced in pairs by Box-Muller, one Philox counter per pair,
+// and handed to threads in blocks of this many counters
+static const uint32_t RANDN_BLOCK = 256;
+
+// below this many elements the threads cost more than they save
+static const uint64_t RANDN_PARALLEL_THRESHOLD = 1 << 15;
+
+uint64_t MathUtils::streamSeed = MathUtils::DEFAULT_SEED;
+atomic<uint64_t> MathUtils::streamPosition(0);
+
+/**
+ *  @brief runs body over contiguous slices of [0, count) on the shared thread pool
+ *
+ *  @param count the number of items
+ *  @param threads the maximum number of slices to run at once
+ *  @param body called with the half open range of items of each slice
+ *  @return void
+ */
+template <typename Body>
+void MathUtils::parallelFor(const uint64_t count, uint32_t threads, const Body& body) {
+	ThreadPool::getGlobal().parallelFor(count, threads, body);
+}
 
 /**
  *  @brief Used to generate a matrix filled with random numbers form a normal distribution
@@ -23,22 +59,132 @@
  *  @return a double pointer to the array of data
  */
 double* MathUtils::randn(const uint32_t rows, const uint32_t cols) {
-	double* mat = new double[rows * cols];
-	
-	// construct a trivial random generator engine from a time-based seed:
-	// TODO: perhaps use parallelism for such a trivial task here
-	unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-	std::default_random_engine generator(seed);
-	std::normal_distribution<double> distribution(0.0, 1.0);
+	const uint64_t length = static_cast<uint64_t>(rows) * cols;
 
-	const uint32_t length = rows * cols;
-	for (uint32_t index = 0; index < length; index++) {
-		mat[index] = distribution(generator);
-	}
+	// every call reserves its own part of the stream so successive matrices
+	// differ, while the whole run still replays exactly from the seed
+	const uint64_t offset = streamPosition.fetch_add(length + (length & 1));
+
+	double* mat = new double[length];
+	MathUtils::fillNormal(mat, length, streamSeed, offset);
+	return mat;
+}
+
+/**
+ *  @brief Used to generate a matrix of normal random numbers in an arena
+ *
+ *  @param arena the arena that owns the result
+ *  @param rows the number of rows in the matrix
+ *  @param cols the number of cols in the matrix
+ *  @return a double pointer to the array of data (freed when the arena is reset)
+ */
+double* MathUtils::randn(Arena& arena, const uint32_t rows, const uint32_t cols) {
+	const uint64_t length = static_cast<uint64_t>(rows) * cols;
+	const uint64_t offset = streamPosition.fetch_add(length + (length & 1));
 
+	double* mat = arena.allocate<double>(length);
+	MathUtils::fillNormal(mat, length, streamSeed, offset);
+	return mat;
+}
+
+/**
+ *  @brief Used to generate a matrix filled with random numbers form a normal distribution
+ *
+ *  @param rows the number of rows in the matrix
+ *  @param cols the number of cols in the matrix
+ *  @param seed the seed of the stream
+ *  @return a double pointer to the array of data
+ */
+double* MathUtils::randn(const uint32_t rows, const uint32_t cols, const uint64_t seed) {
+	const uint64_t length = static_cast<uint64_t>(rows) * cols;
+	double* mat = new double[length];
+	MathUtils::fillNormal(mat, length, seed);
+	return mat;
+}
+
+/**
+ *  @brief Used to generate a matrix of normal random numbers in an arena
+ *
+ *  @param arena the arena that owns the result
+ *  @param rows the number of rows in the matrix
+ *  @param cols the number of cols in the matrix
+ *  @param seed the seed of the stream
+ *  @return a double pointer to the array of data (freed when the arena is reset)
+ */
+double* MathUtils::randn(Arena& arena, const uint32_t rows, const uint32_t cols, const uint64_t seed) {
+	const uint64_t length = static_cast<uint64_t>(rows) * cols;
+	double* mat = arena.allocate<double>(length);
+	MathUtils::fillNormal(mat, length, seed);
 	return mat;
 }
 
+/**
+ *  @brief Used to fill a matrix with random numbers form a normal distribution
+ *
+ *  @param mat the matrix to fill
+ *  @param seed the seed of the stream
+ *  @return void
+ */
+template <typename T>
+void MathUtils::randn(BasicMatrix<T>& mat, const uint64_t seed) {
+	MathUtils::fillNormal(mat.getData(), mat.getSize(), seed);
+}
+
+/**
+ *  @brief Used to write part of the normal stream for a seed
+ *
+ *  @param vec the destination array
+ *  @param length the number of elements to write
+ *  @param seed the seed of the stream
+ *  @param offset the position in the stream of the first element (rounded down to even)
+ *  @return void
+ */
+template <typename T>
+void MathUtils::fillNormal(T* vec, const size_t length, const uint64_t seed, const uint64_t offset) {
+	const Philox philox(seed);
+	const uint64_t firstCounter = offset / 2;
+	const uint64_t pairs = (length + 1) / 2;
+	const uint64_t blocks = (pairs + RANDN_BLOCK - 1) / RANDN_BLOCK;
+	const uint32_t threads = length < RANDN_PARALLEL_THRESHOLD ? 1 : getNumThreads();
+
+	// element 2c and 2c + 1 always come from counter firstCounter + c, so
+	// the slices threads get have no effect on the values
+	MathUtils::parallelFor(blocks, threads, [&](uint64_t begin, uint64_t end) {
+		uint32_t words[4 * RANDN_BLOCK];
+		const double twoPi = 6.283185307179586476925286766559;
+
+		for (uint64_t block = begin; block < end; block++) {
+			const uint64_t firstPair = block * RANDN_BLOCK;
+			const uint32_t count = static_cast<uint32_t>(min<uint64_t>(RANDN_BLOCK, pairs - firstPair));
+			philox.generate(firstCounter + firstPair, count, words);
+
+			for (uint32_t p = 0; p < count; p++) {
+				const double u1 = Philox::toUniform(words[4 * p], words[4 * p + 1]);
+				const double u2 = Philox::toUniform(words[4 * p + 2], words[4 * p + 3]);
+				const double radius = std::sqrt(-2.0 * std::log(u1));
+				const double angle = twoPi * u2;
+
+				const uint64_t index = 2 * (firstPair + p);
+				vec[index] = static_cast<T>(radius * std::cos(angle));
+				if (index + 1 < length) {
+					vec[index + 1] = static_cast<T>(radius * std::sin(angle));
+				}
+			}
+		}
+	});
+}
+
+/**
+ *  @brief Used to restart the stream that randn(rows, cols) draws from
+ *
+ *  @param seed the new seed
+ *  @return void
+ */
+void MathUtils::setSeed(const uint64_t seed) {
+	streamSeed = seed;
+	streamPosition = 0;
+}
+
 /**
  *  @brief Used to calculate the dot product between 2 vectors
  *
@@ -47,14 +193,61 @@ double* MathUtils::randn(const uint32_t rows, const uint32_t cols) {
  *  @param length the length of both vectors
  *  @return the value of the dot product of both vectors
  */
-double MathUtils::dot(const double* vec1, const double* vec2, const uint32_t length) {
-	// TODO: perhaps use parallelism for such a trivial task here
-	double sum;
-	for (uint32_t index = 0; index < length; index++) {
-		sum += vec1[index] * vec2[index];
-	}
+template <typename T>
+T MathUtils::dot(const T* vec1, const T* vec2, const uint32_t length) {
+	return Kernels::get().get<T>().dot(vec1, vec2, length);
+}
 
-	return sum;
+/**
+ *  @brief Used to add a scaled vector to another vector (vec2 = alpha * vec1 + vec2)
+ *
+ *  @param alpha the scale applied to the first vector
+ *  @param vec1 pointer to the array for the first vector
+ *  @param vec2 pointer to the array for the second vector which receives the result
+ *  @param length the length of both vectors
+ *  @return void
+ */
+template <typename T>
+void MathUtils::axpy(const typename NonDeduced<T>::type alpha, const T* vec1, T* vec2, const uint32_t length) {
+	Kernels::get().get<T>().axpy(alpha, vec1, vec2, length);
+}
+
+/**
+ *  @brief Used to multiply every element of an array by a constant
+ *
+ *  @param alpha the scale
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return the input array with every element scaled
+ */
+template <typename T>
+T* MathUtils::scale(const typename NonDeduced<T>::type alpha, T* vec, const uint32_t length) {
+	Kernels::get().get<T>().scale(alpha, vec, length);
+	return vec;
+}
+
+/**
+ *  @brief Used to add up every element of an array
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return the sum of the elements
+ */
+template <typename T>
+T MathUtils::sum(const T* vec, const uint32_t length) {
+	return Kernels::get().get<T>().sum(vec, length);
+}
+
+/**
+ *  @brief Used to calculate the euclidean (L2) norm of an array
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return the square root of the sum of the squared elements
+ */
+template <typename T>
+T MathUtils::norm(const T* vec, const uint32_t length) {
+	return std::sqrt(MathUtils::dot(vec, vec, length));
 }
 
 /**
@@ -65,13 +258,25 @@ double MathUtils::dot(const double* vec1, const double* vec2, const uint32_t len
  *  @return a matrix of size rows x cols filled with 0's
  */
 double* MathUtils::zeroes(const uint32_t rows, const uint32_t cols) {
-	double* mat = new double[rows * cols];
+	const size_t length = static_cast<size_t>(rows) * cols;
+	double* mat = new double[length];
+	fill(mat, mat + length, 0.0);
 
-	const uint32_t length = rows * cols;
-	for (uint32_t index = 0; index < length; index++) {
-		mat[index] = 0;
-	}
+	return mat;
+}
 
+/**
+ *  @brief Used to generate a matrix filled with 0's in an arena
+ *
+ *  @param arena the arena that owns the result
+ *  @param rows number of rows in the matrix
+ *  @param cols number of cols in the matrix
+ *  @return a matrix of size rows x cols filled with 0's (freed when the arena is reset)
+ */
+double* MathUtils::zeroes(Arena& arena, const uint32_t rows, const uint32_t cols) {
+	const size_t length = static_cast<size_t>(rows) * cols;
+	double* mat = arena.allocate<double>(length);
+	fill(mat, mat + length, 0.0);
 	return mat;
 }
 
@@ -80,14 +285,41 @@ double* MathUtils::zeroes(const uint32_t rows, const uint32_t cols) {
  *
  *  @param vec the array containing elements
  *  @param length the size of the array
- *  @return the max value of the array
+ *  @return the max value of the array (-infinity if it is empty)
  */
-double MathUtils::argmax(const double* vec, const uint32_t length) {
-	double max = vec[0];
+template <typename T>
+T MathUtils::max(const T* vec, const uint32_t length) {
+	return Kernels::get().get<T>().max(vec, length);
+}
+
+/**
+ *  @brief Used to find the index of the max value in an array
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return the index of the first occurrence of the max value
+ */
+template <typename T>
+uint32_t MathUtils::argmax(const T* vec, const uint32_t length) {
+	uint32_t best = 0;
 	for (uint32_t index = 1; index < length; index++) {
-		max = max < vec[index] ? vec[index] : max;
+		best = vec[best] < vec[index] ? index : best;
+	}
+	return best;
+}
+
+/**
+ *  @brief Used to find the index of the max value of every row
+ *
+ *  @param mat the matrix (e.g. a batch of logits)
+ *  @param indices receives one index per row
+ *  @return void
+ */
+template <typename T>
+void MathUtils::argmax(const BasicMatrix<T>& mat, uint32_t* indices) {
+	for (uint32_t r = 0; r < mat.getRows(); r++) {
+		indices[r] = MathUtils::argmax(mat.getRow(r), mat.getCols());
 	}
-	return max;
 }
 
 /**
@@ -97,9 +329,504 @@ double MathUtils::argmax(const double* vec, const uint32_t length) {
  *  @param length the size of the array
  *  @return the input array with the elements replaced with their exponential value
  */
-double* MathUtils::exp(double* vec, const uint32_t length) {
-	for (uint32_t index = 0; index < length; index++) {
-		vec[index] = std::exp(vec[index]);
-	}
+template <typename T>
+T* MathUtils::exp(T* vec, const uint32_t length) {
+	MathUtils::expShiftSum(vec, vec, T(0), length);
+	return vec;
+}
+
+/**
+ *  @brief computes exp(vec - shift) and its sum in one pass
+ *
+ *  @param vec the array containing elements
+ *  @param out receives the exponentials (may alias vec, or be nullptr to only sum)
+ *  @param shift the value subtracted from every element first
+ *  @param length the size of the array
+ *  @return the sum of the exponentials
+ */
+template <typename T>
+T MathUtils::expShiftSum(const T* vec, T* out, const T shift, const uint32_t length) {
+	return Kernels::get().get<T>().expShiftSum(vec, out, shift, length);
+}
+
+/**
+ *  @brief finds the max and the sum of exp(vec - max) in one pass
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @param shift receives the max
+ *  @return the sum of the exponentials
+ */
+template <typename T>
+T MathUtils::maxExpSum(const T* vec, const uint32_t length, T& shift) {
+	return Kernels::get().get<T>().maxExpSum(vec, length, &shift);
+}
+
+/**
+ *  @brief replaces every element with max(0, x)
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return the input array with the negative elements replaced by 0
+ */
+template <typename T>
+T* MathUtils::relu(T* vec, const uint32_t length) {
+	Kernels::get().get<T>().relu(vec, length);
+	return vec;
+}
+
+/**
+ *  @brief widens bytes into elements with an affine map (e.g. pixels to network inputs)
+ *
+ *  @param src the bytes
+ *  @param dst receives src[i] * scale + offset
+ *  @param length the number of elements
+ *  @param scale the factor every byte is multiplied by
+ *  @param offset the value added after scaling
+ *  @return void
+ */
+template <typename T>
+void MathUtils::normalize(const uint8_t* src, T* dst, const size_t length,
+	const typename NonDeduced<T>::type scale, const typename NonDeduced<T>::type offset) {
+	Kernels::get().get<T>().normalize(src, dst, length, scale, offset);
+}
+
+/**
+ *  @brief replaces every element with the logistic function 1 / (1 + e^-x)
+ *
+ *  @param vec the array containing elements
+ *  @param length the size of the array
+ *  @return the input array with every element squashed into [0, 1]
+ */
+template <typename T>
+T* MathUtils::sigmoid(T* vec, const uint32_t length) {
+	Kernels::get().get<T>().sigmoid(vec, length);
 	return vec;
-}
\ No newline at end of file
+}
+
+/**
+ *  @brief Used to find the max value of every row
+ *
+ *  @param mat the matrix
+ *  @param maxima receives one value per row
+ *  @return void
+ */
+template <typename T>
+void MathUtils::rowMax(const BasicMatrix<T>& mat, T* maxima) {
+	for (uint32_t r = 0; r < mat.getRows(); r++) {
+		maxima[r] = MathUtils::max(mat.getRow(r), mat.getCols());
+	}
+}
+
+/**
+ *  @brief computes log(sum(exp(row))) of every row
+ *
+ *  @param mat the matrix
+ *  @param results receives one value per row
+ *  @return void
+ */
+template <typename T>
+void MathUtils::logSumExp(const BasicMatrix<T>& mat, T* results) {
+	const uint32_t cols = mat.getCols();
+	for (uint32_t r = 0; r < mat.getRows(); r++) {
+		// shifting by the max keeps every exponential in [0, 1]
+		T shift;
+		const T total = MathUtils::maxExpSum(mat.getRow(r), cols, shift);
+		results[r] = shift + std::log(total);
+	}
+}
+
+/**
+ *  @brief replaces every row with its softmax
+ *
+ *  @param mat the matrix (e.g. a batch of logits)
+ *  @return void
+ */
+template <typename T>
+void MathUtils::softmax(BasicMatrix<T>& mat) {
+	const uint32_t cols = mat.getCols();
+	for (uint32_t r = 0; r < mat.getRows(); r++) {
+		// the exponentials are written once and normalized in place (the single pass
+		// maxExpSum would have to compute every one of them again for the output)
+		T* row = mat.getRow(r);
+		const T shift = MathUtils::max(row, cols);
+		const T total = MathUtils::expShiftSum(row, row, shift, cols);
+		MathUtils::scale(T(1) / total, row, cols);
+	}
+}
+
+/**
+ *  @brief replaces every row with its log softmax
+ *
+ *  @param mat the matrix (e.g. a batch of logits)
+ *  @return void
+ */
+template <typename T>
+void MathUtils::logSoftmax(BasicMatrix<T>& mat) {
+	const uint32_t cols = mat.getCols();
+	for (uint32_t r = 0; r < mat.getRows(); r++) {
+		T* row = mat.getRow(r);
+		T shift;
+		const T total = MathUtils::maxExpSum<T>(row, cols, shift);
+		const T logTotal = shift + std::log(total);
+		for (uint32_t c = 0; c < cols; c++) {
+			row[c] -= logTotal;
+		}
+	}
+}
+
+/**
+ *  @brief computes the mean cross entropy loss of a batch and its gradient
+ *
+ *  @param logits the batch of unnormalized scores (one row per sample)
+ *  @param labels the index of the correct class of every row
+ *  @param gradient receives (softmax(logits) - onehot(labels)) / rows (resized if needed)
+ *  @return the mean of -log(softmax(logits)[label]) over the rows
+ */
+template <typename T>
+T MathUtils::crossEntropy(const BasicMatrix<T>& logits, const uint8_t* labels, BasicMatrix<T>& gradient) {
+	const uint32_t rows = logits.getRows();
+	const uint32_t cols = logits.getCols();
+	if (gradient.getRows() != rows || gradient.getCols() != cols) {
+		gradient.resize(rows, cols);
+	}
+	if (rows == 0) {
+		return T(0);
+	}
+
+	const T inverseRows = T(1) / rows;
+	double loss = 0.0;
+
+	for (uint32_t r = 0; r < rows; r++) {
+		const T* row = logits.getRow(r);
+		T* grad = gradient.getRow(r);
+
+		// the exponentials land in the gradient row and are normalized in place
+		const T shift = MathUtils::max(row, cols);
+		const T total = MathUtils::expShiftSum(row, grad, shift, cols);
+		MathUtils::scale(inverseRows / total, grad, cols);
+		grad[labels[r]] -= inverseRows;
+
+		// the batch total is kept in double so float logits do not lose small rows
+		loss += static_cast<double>(shift) + std::log(static_cast<double>(total)) - row[labels[r]];
+	}
+
+	return static_cast<T>(loss / rows);
+}
+
+// below this many multiply-adds the threads cost more than they save
+static const double GEMM_PARALLEL_THRESHOLD = 1 << 18;
+
+uint32_t MathUtils::numThreads = 0;
+
+/**
+ *  @brief computes c = alpha * op(a) * op(b) + beta * c
+ *
+ *  @param a the left matrix
+ *  @param transA true to use the transpose of a
+ *  @param b the right matrix
+ *  @param transB true to use the transpose of b
+ *  @param c the result (resized to rows(op(a)) x cols(op(b)) if needed)
+ *  @param alpha the scale applied to the product
+ *  @param beta the scale applied to the previous contents of c
+ *  @return void
+ */
+template <typename TA, typename TB, typename TC>
+void MathUtils::gemm(const BasicMatrix<TA>& a, bool transA, const BasicMatrix<TB>& b, bool transB, BasicMatrix<TC>& c,
+	const typename NonDeduced<TC>::type alpha, const typename NonDeduced<TC>::type beta) {
+	const uint32_t m = transA ? a.getCols() : a.getRows();
+	const uint32_t k = transA ? a.getRows() : a.getCols();
+	const uint32_t n = transB ? b.getRows() : b.getCols();
+
+	// a freshly resized c holds zeroes so beta no longer matters
+	if (c.getRows() != m || c.getCols() != n) {
+		c.resize(m, n);
+	}
+
+	MathUtils::gemm<TA, TB, TC>(
+		transA, transB, m, n, k,
+		alpha, a.getData(), a.getCols(), b.getData(), b.getCols(),
+		beta, c.getData(), c.getCols()
+	);
+}
+
+/**
+ *  @brief computes c = alpha * op(a) * op(b) + beta * c on row major arrays
+ *
+ *  @param transA true if a is stored as k x m
+ *  @param transB true if b is stored as n x k
+ *  @param m the number of rows of op(a) and c
+ *  @param n the number of columns of op(b) and c
+ *  @param k the number of columns of op(a) and rows of op(b)
+ *  @param alpha the scale applied to the product
+ *  @param a the left array
+ *  @param lda the row stride of a
+ *  @param b the right array
+ *  @param ldb the row stride of b
+ *  @param beta the scale applied to the previous contents of c
+ *  @param c the result array
+ *  @param ldc the row stride of c
+ *  @return void
+ */
+template <typename TA, typename TB, typename TC>
+void MathUtils::gemm(bool transA, bool transB, const uint32_t m, const uint32_t n, const uint32_t k,
+	const typename NonDeduced<TC>::type alpha, const TA* a, const uint32_t lda, const TB* b, const uint32_t ldb,
+	const typename NonDeduced<TC>::type beta, TC* c, const uint32_t ldc) {
+	// apply beta once up front so every block can simply accumulate
+	for (uint32_t i = 0; i < m; i++) {
+		TC* row = c + static_cast<size_t>(i) * ldc;
+		if (beta == TC(0)) {
+			std::fill(row, row + n, TC(0));
+		}
+		else if (beta != TC(1)) {
+			MathUtils::scale(beta, row, n);
+		}
+	}
+
+	if (m == 0 || n == 0 || k == 0 || alpha == TC(0)) {
+		return;
+	}
+
+	// the blocked kernel of the selected level, split along its own micro tile
+	const KernelTable& kernels = Kernels::get();
+	const GemmFunction<TA, TB, TC> gemmBlocked = kernels.getGemm<TA, TB, TC>();
+
+	// split the larger of m and n into tile aligned slices, one per thread
+	const double work = static_cast<double>(m) * n * k;
+	const bool splitRows = m >= n;
+	const uint32_t tile = splitRows ? kernels.get<TC>().gemmRows : kernels.get<TC>().gemmCols;
+	const uint32_t tiles = ((splitRows ? m : n) + tile - 1) / tile;
+	uint32_t threads = work < GEMM_PARALLEL_THRESHOLD ? 1 : min(getNumThreads(), tiles);
+	threads = std::max<uint32_t>(1, threads);
+
+	if (threads == 1) {
+		gemmBlocked(transA, transB, m, n, k, static_cast<TC>(alpha), a, lda, b, ldb, c, ldc);
+		return;
+	}
+
+	auto slice = [=](uint32_t t) {
+		const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(tiles) * t / threads) * tile;
+		const uint32_t last = min(
+			static_cast<uint32_t>(static_cast<uint64_t>(tiles) * (t + 1) / threads) * tile, splitRows ? m : n
+		);
+		if (first >= last) {
+			return;
+		}
+
+		if (splitRows) {
+			const TA* aSlice = transA ? a + first : a + static_cast<size_t>(first) * lda;
+			gemmBlocked(transA, transB, last - first, n, k, static_cast<TC>(alpha), aSlice, lda, b, ldb, c + static_cast<size_t>(first) * ldc, ldc);
+		}
+		else {
+			const TB* bSlice = transB ? b + static_cast<size_t>(first) * ldb : b + first;
+			gemmBlocked(transA, transB, m, last - first, k, static_cast<TC>(alpha), a, lda, bSlice, ldb, c + first, ldc);
+		}
+	};
+
+	MathUtils::parallelFor(threads, threads, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t t = begin; t < end; t++) {
+			slice(static_cast<uint32_t>(t));
+		}
+	});
+}
+
+/**
+ *  @brief returns the size of a packed signed byte matrix
+ *
+ *  @param n the number of rows of b
+ *  @param k the length of the rows of b
+ *  @return the bytes packS8 writes
+ */
+size_t MathUtils::getPackedS8Size(const uint32_t n, const uint32_t k) {
+	const Int8KernelSet& s8 = Kernels::get().s8;
+	const size_t panels = (n + s8.cols - 1) / s8.cols;
+	const size_t groups = (k + s8.group - 1) / s8.group;
+	return panels * groups * s8.cols * s8.group;
+}
+
+/**
+ *  @brief rearranges a signed byte matrix into the panels gemmU8S8 reads
+ *
+ *  @param n the number of rows of b
+ *  @param k the length of the rows of b
+ *  @param b the matrix (n x k)
+ *  @param ldb the row stride of b
+ *  @param packed receives getPackedS8Size(n, k) bytes (the padding is zeroed)
+ *  @return void
+ */
+void MathUtils::packS8(const uint32_t n, const uint32_t k, const int8_t* b, const size_t ldb, int8_t* packed) {
+	Kernels::get().s8.packS8(n, k, b, ldb, packed);
+}
+
+/**
+ *  @brief multiplies unsigned bytes by transposed, packed signed bytes into int32
+ *
+ *  @param m the number of rows of a and c
+ *  @param n the number of rows of b and columns of c
+ *  @param k the length of the rows of a and b
+ *  @param a the unsigned array (m x k)
+ *  @param lda the row stride of a
+ *  @param packed b (n x k) as written by packS8
+ *  @param c the result (m x n)
+ *  @param ldc the row stride of c
+ *  @return void
+ */
+void MathUtils::gemmU8S8(const uint32_t m, const uint32_t n, const uint32_t k, const uint8_t* a, const size_t lda,
+	const int8_t* packed, int32_t* c, const size_t ldc) {
+	if (m == 0 || n == 0) {
+		return;
+	}
+
+	// the kernel of the selected level, split into slices of whole micro tiles of rows
+	const Int8KernelSet& s8 = Kernels::get().s8;
+	const uint32_t tile = s8.rows;
+	const uint32_t tiles = (m + tile - 1) / tile;
+	const double work = static_cast<double>(m) * n * k;
+	const uint32_t threads = work < GEMM_PARALLEL_THRESHOLD ? 1 : std::max<uint32_t>(1, min(getNumThreads(), tiles));
+
+	MathUtils::parallelFor(threads, threads, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t t = begin; t < end; t++) {
+			const uint32_t first = static_cast<uint32_t>(tiles * t / threads) * tile;
+			const uint32_t last = min(static_cast<uint32_t>(tiles * (t + 1) / threads) * tile, m);
+			if (first < last) {
+				s8.gemmU8S8(last - first, n, k, a + first * lda, lda, packed, c + first * ldc, ldc);
+			}
+		}
+	});
+}
+
+/**
+ *  @brief rounds floats to bfloat16 (nearest even, NaNs stay NaN)
+ *
+ *  @param src the floats
+ *  @param dst receives the bfloat16 values
+ *  @param length the number of elements
+ *  @return void
+ */
+void MathUtils::convert(const float* src, BFloat16* dst, const size_t length) {
+	Kernels::get().toBF16(src, dst, length);
+}
+
+/**
+ *  @brief widens bfloat16 values to float (exact)
+ *
+ *  @param src the bfloat16 values
+ *  @param dst receives the floats
+ *  @param length the number of elements
+ *  @return void
+ */
+void MathUtils::convert(const BFloat16* src, float* dst, const size_t length) {
+	Kernels::get().fromBF16(src, dst, length);
+}
+
+/**
+ *  @brief rounds doubles to float
+ *
+ *  @param src the doubles
+ *  @param dst receives the floats
+ *  @param length the number of elements
+ *  @return void
+ */
+void MathUtils::convert(const double* src, float* dst, const size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		dst[i] = static_cast<float>(src[i]);
+	}
+}
+
+/**
+ *  @brief widens floats to double (exact)
+ *
+ *  @param src the floats
+ *  @param dst receives the doubles
+ *  @param length the number of elements
+ *  @return void
+ */
+void MathUtils::convert(const float* src, double* dst, const size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		dst[i] = src[i];
+	}
+}
+
+/**
+ *  @brief converts every element of a matrix to another precision
+ *
+ *  @param src the matrix to convert
+ *  @param dst receives the converted elements (resized if needed)
+ *  @return void
+ */
+template <typename From, typename To>
+void MathUtils::convert(const BasicMatrix<From>& src, BasicMatrix<To>& dst) {
+	if (dst.getRows() != src.getRows() || dst.getCols() != src.getCols()) {
+		dst.resize(src.getRows(), src.getCols());
+	}
+	MathUtils::convert(src.getData(), dst.getData(), src.getSize());
+}
+
+/**
+ *  @brief sets how many threads gemm may use
+ *
+ *  @param numThreads the thread count (0 means every thread of the shared pool)
+ *  @return void
+ */
+void MathUtils::setNumThreads(const uint32_t numThreads) {
+	MathUtils::numThreads = numThreads;
+}
+
+/**
+ *  @brief returns how many threads gemm may use
+ *
+ *  @return the thread count
+ */
+uint32_t MathUtils::getNumThreads() {
+	if (numThreads == 0) {
+		return ThreadPool::getGlobal().getWorkerCount() + 1;
+	}
+	return numThreads;
+}
+
+// the element types the kernels are built for
+#define MATH_UTILS_INSTANTIATE(T) \
+	template void MathUtils::randn<T>(BasicMatrix<T>&, const uint64_t); \
+	template void MathUtils::fillNormal<T>(T*, const size_t, const uint64_t, const uint64_t); \
+	template T MathUtils::dot<T>(const T*, const T*, const uint32_t); \
+	template void MathUtils::normalize<T>(const uint8_t*, T*, const size_t, const T, const T); \
+	template void MathUtils::axpy<T>(const T, const T*, T*, const uint32_t); \
+	template T* MathUtils::scale<T>(const T, T*, const uint32_t); \
+	template T MathUtils::sum<T>(const T*, const uint32_t); \
+	template T MathUtils::norm<T>(const T*, const uint32_t); \
+	template T MathUtils::max<T>(const T*, const uint32_t); \
+	template uint32_t MathUtils::argmax<T>(const T*, const uint32_t); \
+	template void MathUtils::argmax<T>(const BasicMatrix<T>&, uint32_t*); \
+	template T* MathUtils::exp<T>(T*, const uint32_t); \
+	template T* MathUtils::relu<T>(T*, const uint32_t); \
+	template T* MathUtils::sigmoid<T>(T*, const uint32_t); \
+	template void MathUtils::rowMax<T>(const BasicMatrix<T>&, T*); \
+	template void MathUtils::logSumExp<T>(const BasicMatrix<T>&, T*); \
+	template void MathUtils::softmax<T>(BasicMatrix<T>&); \
+	template void MathUtils::logSoftmax<T>(BasicMatrix<T>&); \
+	template T MathUtils::crossEntropy<T>(const BasicMatrix<T>&, const uint8_t*, BasicMatrix<T>&);
+
+MATH_UTILS_INSTANTIATE(double)
+MATH_UTILS_INSTANTIATE(float)
+
+#undef MATH_UTILS_INSTANTIATE
+
+// gemm computes in the type of c and reads bfloat16 operands into float
+#define MATH_UTILS_INSTANTIATE_GEMM(TA, TB, TC) \
+	template void MathUtils::gemm<TA, TB, TC>(const BasicMatrix<TA>&, bool, const BasicMatrix<TB>&, bool, BasicMatrix<TC>&, \
+		const TC, const TC); \
+	template void MathUtils::gemm<TA, TB, TC>(bool, bool, const uint32_t, const uint32_t, const uint32_t, \
+		const TC, const TA*, const uint32_t, const TB*, const uint32_t, const TC, TC*, const uint32_t);
+
+MATH_UTILS_INSTANTIATE_GEMM(double, double, double)
+MATH_UTILS_INSTANTIATE_GEMM(float, float, float)
+MATH_UTILS_INSTANTIATE_GEMM(BFloat16, float, float)
+MATH_UTILS_INSTANTIATE_GEMM(float, BFloat16, float)
+MATH_UTILS_INSTANTIATE_GEMM(BFloat16, BFloat16, float)
+
+#undef MATH_UTILS_INSTANTIATE_GEMM
+
+template void MathUtils::convert<double, float>(const BasicMatrix<double>&, BasicMatrix<float>&);
+template void MathUtils::convert<float, double>(const BasicMatrix<float>&, BasicMatrix<double>&);
+template void MathUtils::convert<float, BFloat16>(const BasicMatrix<float>&, BasicMatrix<BFloat16>&);
+template void MathUtils::convert<BFloat16, float>(const BasicMatrix<BFloat16>&, BasicMatrix<float>&);
@@ -0,0 +1,205 @@
+/**
+ *  @file    Matrix.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief an owning, cache line aligned, row major matrix
+ *
+ *  @section DESCRIPTION
+ *
+ *  This container replaces the bare double pointer plus rows and
+ *  cols that MathUtils used to pass around. The elements live in one
+ *  64 byte aligned block stored row after row, so getData() can still
+ *  be handed to the array kernels in MathUtils. The element type is a
+ *  template parameter; Matrix (double), MatrixF (float) and MatrixBF16
+ *  (bfloat16 storage) are the instantiations the library provides.
+ *
+ */
+
+#include "Matrix.h"
+#include "AlignedMemory.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ *  @brief empty constructor
+ */
+template <typename T>
+BasicMatrix<T>::BasicMatrix(void) {
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param rows the number of rows
+ *  @param cols the number of columns
+ */
+template <typename T>
+BasicMatrix<T>::BasicMatrix(uint32_t rows, uint32_t cols) {
+	resize(rows, cols);
+}
+
+/**
+ *  @brief copy constructor
+ *
+ *  @param other the matrix to copy
+ */
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& other) {
+	resize(other.rows, other.cols);
+	memcpy(data, other.data, getSize() * sizeof(T));
+}
+
+/**
+ *  @brief move constructor
+ *
+ *  @param other the matrix to take the elements from
+ */
+template <typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& other) noexcept:
+	data(other.data),
+	rows(other.rows),
+	cols(other.cols),
+	capacity(other.capacity) {
+	other.data = nullptr;
+	other.rows = 0;
+	other.cols = 0;
+	other.capacity = 0;
+}
+
+/**
+ *  @brief destructor
+ */
+template <typename T>
+BasicMatrix<T>::~BasicMatrix(void) {
+	AlignedMemory::release(data);
+}
+
+/**
+ *  @brief copy assignment
+ *
+ *  @param other the matrix to copy
+ *  @return this matrix
+ */
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& other) {
+	if (this != &other) {
+		if (rows != other.rows || cols != other.cols) {
+			resize(other.rows, other.cols);
+		}
+		memcpy(data, other.data, getSize() * sizeof(T));
+	}
+	return *this;
+}
+
+/**
+ *  @brief move assignment
+ *
+ *  @param other the matrix to take the elements from
+ *  @return this matrix
+ */
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& other) noexcept {
+	if (this != &other) {
+		AlignedMemory::release(data);
+		data = other.data;
+		rows = other.rows;
+		cols = other.cols;
+		capacity = other.capacity;
+		other.data = nullptr;
+		other.rows = 0;
+		other.cols = 0;
+		other.capacity = 0;
+	}
+	return *this;
+}
+
+/**
+ *  @brief reshapes the matrix, reallocating only if the storage is too small
+ *
+ *  @param rows the number of rows
+ *  @param cols the number of columns
+ *  @return void
+ */
+template <typename T>
+void BasicMatrix<T>::resize(uint32_t rows, uint32_t cols) {
+	this->rows = rows;
+	this->cols = cols;
+
+	if (!data || getSize() > capacity) {
+		AlignedMemory::release(data);
+		data = nullptr;
+		capacity = 0;
+		data = static_cast<T*>(AlignedMemory::allocate(getSize() * sizeof(T)));
+		capacity = getSize();
+	}
+	fill(T());
+}
+
+/**
+ *  @brief sets every element
+ *
+ *  @param val the value
+ *  @return void
+ */
+template <typename T>
+void BasicMatrix<T>::fill(T val) {
+	std::fill(data, data + getSize(), val);
+}
+
+/**
+ *  @brief returns the number of rows
+ *
+ *  @return the number of rows
+ */
+template <typename T>
+uint32_t BasicMatrix<T>::getRows() const {
+	return rows;
+}
+
+/**
+ *  @brief returns the number of columns
+ *
+ *  @return the number of columns
+ */
+template <typename T>
+uint32_t BasicMatrix<T>::getCols() const {
+	return cols;
+}
+
+/**
+ *  @brief returns the number of elements
+ *
+ *  @return rows * cols
+ */
+template <typename T>
+size_t BasicMatrix<T>::getSize() const {
+	return static_cast<size_t>(rows) * cols;
+}
+
+/**
+ *  @brief returns the first element
+ *
+ *  @return a pointer to the elements
+ */
+template <typename T>
+T* BasicMatrix<T>::getData() {
+	return data;
+}
+
+/**
+ *  @brief returns the first element
+ *
+ *  @return a pointer to the elements
+ */
+template <typename T>
+const T* BasicMatrix<T>::getData() const {
+	return data;
+}
+
+// the element types the library is built for
+template class BasicMatrix<double>;
+template class BasicMatrix<float>;
+template class BasicMatrix<BFloat16>;
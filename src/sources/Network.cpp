@@ -0,0 +1,390 @@
+/**
+ *  @file    Network.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief a fully connected classifier trained with minibatch SGD
+ *
+ *  @section DESCRIPTION
+ *
+ *  A Network is a stack of DenseLayers whose last layer produces
+ *  logits for a softmax head. Training consumes whole batches: the
+ *  forward pass, the fused softmax cross entropy and the backward
+ *  pass are all batched matrix kernels, followed by one gradient
+ *  descent step per batch.
+ *
+ *  With setShards(n) every batch is cut into n contiguous shards that
+ *  run forward and backward as separate tasks on the shared
+ *  ThreadPool. Their gradients are then summed by a pairwise tree in
+ *  a fixed order, so the result depends on n but never on how many
+ *  threads ran the shards or in which order they finished.
+ *
+ */
+
+#include "Network.h"
+#include "MathUtils.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+NetworkException::NetworkException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* NetworkException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param sizes the width of the input, of every hidden layer and of the output
+ *  @param hidden the nonlinearity of the hidden layers
+ *  @param seed the seed of the initial weights (layer i uses seed + i)
+ */
+Network::Network(const vector<uint32_t>& sizes, Activation hidden, uint64_t seed) {
+	if (sizes.size() < 2) {
+		throw NetworkException("A network needs at least an input and an output size");
+	}
+	for (uint32_t size : sizes) {
+		if (size == 0) {
+			throw NetworkException("Layer sizes must be positive");
+		}
+	}
+
+	layers.reserve(sizes.size() - 1);
+	for (size_t i = 0; i + 1 < sizes.size(); i++) {
+		const bool last = i + 2 == sizes.size();
+		layers.emplace_back(sizes[i], sizes[i + 1], last ? Activation::LINEAR : hidden, seed + i);
+	}
+	setShards(1);
+}
+
+/**
+ *  @brief computes the logits of a batch
+ *
+ *  @param input the first row of the batch
+ *  @param count the number of rows
+ *  @param stride the distance in floats between two rows
+ *  @return the count x classes logits (valid until the next forward)
+ */
+const MatrixF& Network::forward(const float* input, uint32_t count, size_t stride) {
+	const MatrixF* activations = &layers[0].forward(input, count, stride);
+	for (size_t i = 1; i < layers.size(); i++) {
+		activations = &layers[i].forward(activations->getData(), count, activations->getCols());
+	}
+	return *activations;
+}
+
+/**
+ *  @brief trains on one batch
+ *
+ *  @param input the first row of the batch
+ *  @param labels the class of every row
+ *  @param count the number of rows
+ *  @param stride the distance in floats between two rows
+ *  @param learningRate the step size
+ *  @return the mean cross entropy of the batch before the step
+ */
+float Network::trainBatch(const float* input, const uint8_t* labels, uint32_t count, size_t stride, float learningRate) {
+	if (count == 0) {
+		return 0.0f;
+	}
+	for (uint32_t r = 0; r < count; r++) {
+		if (labels[r] >= getOutputs()) {
+			throw NetworkException("Label " + to_string(labels[r]) + " is out of range for the output layer");
+		}
+	}
+
+	ThreadPool& pool = ThreadPool::getGlobal();
+	const uint32_t used = min(shards, count);
+	pool.parallelFor(used, used, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t shard = begin; shard < end; shard++) {
+			trainShard(static_cast<uint32_t>(shard), used, input, labels, count, stride);
+		}
+	});
+
+	// sum shard s + step into shard s for step = 1, 2, 4, ... so the order of
+	// the additions is the same every time and shard 0 ends with the total
+	const uint32_t layerCount = getLayerCount();
+	for (uint32_t step = 1; step < used; step *= 2) {
+		const uint32_t pairs = (used + 2 * step - 1) / (2 * step);
+		pool.parallelFor(pairs, pairs, [&](uint64_t begin, uint64_t end) {
+			for (uint64_t pair = begin; pair < end; pair++) {
+				const uint32_t shard = static_cast<uint32_t>(pair) * 2 * step;
+				if (shard + step >= used) {
+					continue;
+				}
+				for (uint32_t l = 0; l < layerCount; l++) {
+					DenseLayer::accumulate(getBuffers(shard, l), getBuffers(shard + step, l));
+				}
+			}
+		});
+	}
+
+	for (DenseLayer& layer : layers) {
+		layer.update(learningRate);
+	}
+
+	double loss = 0.0;
+	for (uint32_t shard = 0; shard < used; shard++) {
+		loss += shardLosses[shard];
+	}
+	return static_cast<float>(loss / count);
+}
+
+/**
+ *  @brief runs forward and backward on one shard of a batch
+ *
+ *  @param shard the index of the shard
+ *  @param used the number of shards the batch is cut into
+ *  @param input the first row of the batch
+ *  @param labels the class of every row of the batch
+ *  @param count the number of rows in the batch
+ *  @param stride the distance in floats between two rows
+ *  @return void
+ */
+void Network::trainShard(uint32_t shard, uint32_t used, const float* input, const uint8_t* labels, uint32_t count, size_t stride) {
+	const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(count) * shard / used);
+	const uint32_t rows = static_cast<uint32_t>(static_cast<uint64_t>(count) * (shard + 1) / used) - first;
+	const float* rowInput = input + first * stride;
+	const uint32_t layerCount = getLayerCount();
+
+	const MatrixF* activations = &layers[0].forward(rowInput, rows, stride, getBuffers(shard, 0));
+	for (uint32_t l = 1; l < layerCount; l++) {
+		activations = &layers[l].forward(activations->getData(), rows, activations->getCols(), getBuffers(shard, l));
+	}
+
+	// crossEntropy averages over the shard, rescale so the shards add up to the batch mean
+	MatrixF& lossGradient = lossGradients[shard];
+	const float loss = MathUtils::crossEntropy(*activations, labels + first, lossGradient);
+	shardLosses[shard] = static_cast<double>(loss) * rows;
+	if (rows != count) {
+		MathUtils::scale(static_cast<float>(rows) / count, lossGradient.getData(), static_cast<uint32_t>(lossGradient.getSize()));
+	}
+
+	// every layer reads the activations of the layer below it as its input
+	MatrixF* gradient = &lossGradient;
+	for (uint32_t l = layerCount; l-- > 0;) {
+		const float* below = l == 0 ? rowInput : getBuffers(shard, l - 1).output.getData();
+		const size_t belowStride = l == 0 ? stride : layers[l - 1].getOutputs();
+		gradient = &layers[l].backward(below, belowStride, *gradient, l > 0, getBuffers(shard, l));
+	}
+}
+
+/**
+ *  @brief trains on one batch from a BatchLoader
+ *
+ *  @param batch the batch
+ *  @param learningRate the step size
+ *  @return the mean cross entropy of the batch before the step
+ */
+float Network::trainBatch(const Batch& batch, float learningRate) {
+	return trainBatch(batch.pixels, batch.labels, batch.count, batch.stride, learningRate);
+}
+
+/**
+ *  @brief trains on one epoch of batches
+ *
+ *  @param loader the source of the batches
+ *  @param learningRate the step size
+ *  @return the mean loss over the samples of the epoch
+ */
+float Network::trainEpoch(BatchLoader& loader, float learningRate) {
+	double total = 0.0;
+	uint64_t samples = 0;
+
+	for (uint32_t b = 0; b < loader.getBatchesPerEpoch(); b++) {
+		const Batch& batch = loader.next();
+		total += static_cast<double>(trainBatch(batch, learningRate)) * batch.count;
+		samples += batch.count;
+	}
+
+	return samples == 0 ? 0.0f : static_cast<float>(total / samples);
+}
+
+/**
+ *  @brief classifies a batch
+ *
+ *  @param input the first row of the batch
+ *  @param count the number of rows
+ *  @param stride the distance in floats between two rows
+ *  @param classes receives the most likely class of every row
+ *  @return void
+ */
+void Network::predict(const float* input, uint32_t count, size_t stride, uint32_t* classes) {
+	if (count == 0) {
+		return;
+	}
+	MathUtils::argmax(forward(input, count, stride), classes);
+}
+
+/**
+ *  @brief measures the accuracy on a dataset
+ *
+ *  @param dataset the labelled images (its features if it has them, otherwise its pixels
+ *         scaled to [0, 1] like BatchLoader does)
+ *  @param batchSize the number of images classified at a time
+ *  @return the fraction of images whose predicted class matches the label
+ */
+float Network::evaluate(const Dataset& dataset, uint32_t batchSize) {
+	if (dataset.empty()) {
+		return 0.0f;
+	}
+	if (dataset.getImageSize() != getInputs()) {
+		throw NetworkException("The images do not match the input size of the network");
+	}
+
+	batchSize = max<uint32_t>(1, batchSize);
+	const uint32_t imageSize = getInputs();
+	const float scale = 1.0f / 255.0f;
+	if (!dataset.hasFeatures() && (inputs.getRows() != batchSize || inputs.getCols() != imageSize)) {
+		inputs.resize(batchSize, imageSize);
+	}
+	predictions.resize(batchSize);
+
+	uint32_t correct = 0;
+	for (uint32_t start = 0; start < dataset.getCount(); start += batchSize) {
+		const DatasetBatch batch = dataset.getBatch(start, batchSize);
+
+		// normalized datasets are classified in place, raw ones are scaled first
+		if (batch.features) {
+			predict(batch.features, batch.count, batch.featureStride, predictions.data());
+		}
+		else {
+			for (uint32_t r = 0; r < batch.count; r++) {
+				MathUtils::normalize(batch.getRow(r), inputs.getRow(r), imageSize, scale);
+			}
+			predict(inputs.getData(), batch.count, imageSize, predictions.data());
+		}
+
+		for (uint32_t r = 0; r < batch.count; r++) {
+			correct += predictions[r] == batch.labels[r] ? 1 : 0;
+		}
+	}
+
+	return static_cast<float>(correct) / dataset.getCount();
+}
+
+/**
+ *  @brief sets how many shards every training batch is cut into
+ *
+ *  @param shards the number of shards (0 is treated as 1)
+ *  @return void
+ */
+void Network::setShards(uint32_t shards) {
+	this->shards = max<uint32_t>(1, shards);
+	shardBuffers.resize(this->shards - 1);
+	for (vector<DenseWorkspace>& buffers : shardBuffers) {
+		buffers.resize(layers.size());
+	}
+	lossGradients.resize(this->shards);
+	shardLosses.resize(this->shards);
+}
+
+/**
+ *  @brief returns the number of shards per training batch
+ *
+ *  @return the shard count
+ */
+uint32_t Network::getShards() const {
+	return shards;
+}
+
+/**
+ *  @brief returns the buffers a shard uses for a layer
+ *
+ *  @param shard the index of the shard
+ *  @param layer the index of the layer
+ *  @return the layer's own workspace for shard 0, a network owned one otherwise
+ */
+DenseWorkspace& Network::getBuffers(uint32_t shard, uint32_t layer) {
+	return shard == 0 ? layers[layer].getWorkspace() : shardBuffers[shard - 1][layer];
+}
+
+/**
+ *  @brief returns the number of layers
+ *
+ *  @return the number of dense layers including the logits layer
+ */
+uint32_t Network::getLayerCount() const {
+	return static_cast<uint32_t>(layers.size());
+}
+
+/**
+ *  @brief returns a layer
+ *
+ *  @param i the index of the layer (0 is closest to the input)
+ *  @return the layer
+ */
+DenseLayer& Network::getLayer(uint32_t i) {
+	return layers[i];
+}
+
+/**
+ *  @brief returns a layer
+ *
+ *  @param i the index of the layer (0 is closest to the input)
+ *  @return the layer
+ */
+const DenseLayer& Network::getLayer(uint32_t i) const {
+	return layers[i];
+}
+
+/**
+ *  @brief returns the number of inputs per row
+ *
+ *  @return the input width of the first layer
+ */
+uint32_t Network::getInputs() const {
+	return layers.front().getInputs();
+}
+
+/**
+ *  @brief returns the number of classes
+ *
+ *  @return the output width of the last layer
+ */
+uint32_t Network::getOutputs() const {
+	return layers.back().getOutputs();
+}
+
+/**
+ *  @brief describes the parameters of every layer for a checkpoint
+ *
+ *  @return two tensors per layer, weights then bias
+ */
+vector<CheckpointTensor> Network::getTensors() const {
+	vector<CheckpointTensor> tensors;
+	tensors.reserve(2 * layers.size());
+	for (size_t l = 0; l < layers.size(); l++) {
+		const string prefix = "layer" + to_string(l);
+		tensors.push_back(CheckpointTensor::from(prefix + ".weights", layers[l].getWeights()));
+		tensors.push_back(CheckpointTensor::from(prefix + ".bias", layers[l].getBias()));
+	}
+	return tensors;
+}
+
+/**
+ *  @brief copies the parameters of every layer out of a checkpoint
+ *
+ *  @param checkpoint a checkpoint saved from a network of the same shape
+ *  @return void
+ */
+void Network::load(const Checkpoint& checkpoint) {
+	for (size_t l = 0; l < layers.size(); l++) {
+		const string prefix = "layer" + to_string(l);
+		checkpoint.load(prefix + ".weights", layers[l].getWeights());
+		checkpoint.load(prefix + ".bias", layers[l].getBias());
+	}
+}
@@ -0,0 +1,317 @@
+/**
+ *  @file    QuantizedNetwork.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief an int8 copy of a trained Network that classifies raw pixels
+ *
+ *  @section DESCRIPTION
+ *
+ *  Every layer of a trained Network is quantized after training: the
+ *  weights of each output get their own scale and are rounded to
+ *  int8, and the activations between layers are uint8 with a scale
+ *  and zero point measured on calibration images. The first layer
+ *  reads the image bytes as they are, since pixel * scale + offset is
+ *  already an affine uint8 encoding (the offset is folded into the
+ *  bias). Products are summed exactly in int32 by MathUtils::gemmU8S8
+ *  and requantized to the uint8 input of the next layer; the last
+ *  layer dequantizes to float logits.
+ *
+ */
+
+#include "QuantizedNetwork.h"
+#include "MathUtils.h"
+#include "AlignedMemory.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+QuantizationException::QuantizationException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* QuantizationException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief constructor that quantizes a trained network
+ *
+ *  @param network the trained network
+ *  @param calibration images whose hidden activations set the uint8 ranges
+ *  @param samples the most calibration images to run
+ *  @param normalization the map from pixels to the features the network was trained on
+ */
+QuantizedNetwork::QuantizedNetwork(Network& network, const Dataset& calibration, uint32_t samples, const Normalization& normalization) {
+	if (calibration.empty()) {
+		throw QuantizationException("Quantization needs calibration images");
+	}
+	if (calibration.getImageSize() != network.getInputs()) {
+		throw QuantizationException("The calibration images do not match the input size of the network");
+	}
+
+	const uint32_t layerCount = network.getLayerCount();
+	vector<float> lowest(layerCount, 0.0f), highest(layerCount, 0.0f);
+
+	// run the float network on the calibration images and record the range of every hidden output
+	const uint32_t imageSize = network.getInputs();
+	const uint32_t batchSize = 256;
+	samples = min(max<uint32_t>(1, samples), calibration.getCount());
+	for (uint32_t start = 0; start < samples; start += batchSize) {
+		const DatasetBatch batch = calibration.getBatch(start, min(batchSize, samples - start));
+		if (batch.features) {
+			network.forward(batch.features, batch.count, batch.featureStride);
+		}
+		else {
+			if (features.getRows() != batch.count || features.getCols() != imageSize) {
+				features.resize(batch.count, imageSize);
+			}
+			for (uint32_t r = 0; r < batch.count; r++) {
+				MathUtils::normalize(batch.getRow(r), features.getRow(r), imageSize, normalization.scale, normalization.offset);
+			}
+			network.forward(features.getData(), batch.count, imageSize);
+		}
+
+		for (uint32_t l = 0; l + 1 < layerCount; l++) {
+			const MatrixF& output = network.getLayer(l).getOutput();
+			const float* first = output.getData();
+			const float* last = first + static_cast<size_t>(batch.count) * output.getCols();
+			lowest[l] = min(lowest[l], *min_element(first, last));
+			highest[l] = max(highest[l], *max_element(first, last));
+		}
+	}
+
+	layers.resize(layerCount);
+	activations.resize(layerCount - 1);
+	float inputScale = normalization.scale;
+	for (uint32_t l = 0; l < layerCount; l++) {
+		const DenseLayer& source = network.getLayer(l);
+		const MatrixF& weights = source.getWeights();
+		Layer& layer = layers[l];
+		layer.inputs = source.getInputs();
+		layer.outputs = source.getOutputs();
+		layer.activation = source.getActivation();
+		vector<int8_t> rows(static_cast<size_t>(layer.outputs) * layer.inputs);
+		layer.weightSums.resize(layer.outputs);
+		layer.scales.resize(layer.outputs);
+		layer.bias.resize(layer.outputs);
+		layer.inputZero = l == 0 ? 0 : layers[l - 1].outputZero;
+
+		// symmetric int8 per output, so a row of small weights keeps its resolution
+		for (uint32_t o = 0; o < layer.outputs; o++) {
+			const float* row = weights.getRow(o);
+			float largest = 0.0f, total = 0.0f;
+			for (uint32_t i = 0; i < layer.inputs; i++) {
+				largest = max(largest, std::fabs(row[i]));
+				total += row[i];
+			}
+			const float weightScale = largest > 0.0f ? largest / 127.0f : 1.0f;
+
+			int32_t sum = 0;
+			int8_t* quantized = rows.data() + static_cast<size_t>(o) * layer.inputs;
+			for (uint32_t i = 0; i < layer.inputs; i++) {
+				const long value = std::lrint(row[i] / weightScale);
+				quantized[i] = static_cast<int8_t>(min<long>(127, max<long>(-127, value)));
+				sum += quantized[i];
+			}
+			layer.weightSums[o] = sum;
+			layer.scales[o] = inputScale * weightScale;
+
+			// the first layer sees pixel * scale + offset, so the offset joins the bias
+			layer.bias[o] = source.getBias().getData()[o] + (l == 0 ? normalization.offset * total : 0.0f);
+		}
+		layer.weights.resize(MathUtils::getPackedS8Size(layer.outputs, layer.inputs));
+		MathUtils::packS8(layer.outputs, layer.inputs, rows.data(), layer.inputs, layer.weights.data());
+
+		// asymmetric uint8 over the calibrated range, which always includes 0
+		if (l + 1 < layerCount) {
+			const float range = highest[l] - lowest[l];
+			layer.outputScale = range > 0.0f ? range / 255.0f : 1.0f;
+			layer.outputZero = static_cast<int32_t>(min<long>(255, max<long>(0, std::lrint(-lowest[l] / layer.outputScale))));
+			inputScale = layer.outputScale;
+		}
+	}
+}
+
+/**
+ *  @brief turns the int32 sums of a layer into activated float values
+ *
+ *  @param layer the layer
+ *  @param count the number of rows
+ *  @return void
+ */
+void QuantizedNetwork::dequantize(const Layer& layer, uint32_t count) {
+	if (values.getRows() != count || values.getCols() != layer.outputs) {
+		values.resize(count, layer.outputs);
+	}
+	for (uint32_t r = 0; r < count; r++) {
+		const int32_t* row = sums.data() + static_cast<size_t>(r) * layer.outputs;
+		float* result = values.getRow(r);
+		for (uint32_t o = 0; o < layer.outputs; o++) {
+			result[o] = (row[o] - layer.inputZero * layer.weightSums[o]) * layer.scales[o] + layer.bias[o];
+		}
+	}
+
+	if (layer.activation == Activation::RELU) {
+		MathUtils::relu(values.getData(), values.getSize());
+	}
+	else if (layer.activation == Activation::SIGMOID) {
+		MathUtils::sigmoid(values.getData(), values.getSize());
+	}
+}
+
+/**
+ *  @brief turns the float values of a hidden layer into uint8 activations
+ *
+ *  @param layer the layer
+ *  @param count the number of rows
+ *  @param out receives the uint8 activations
+ *  @param outStride the distance in bytes between two rows of out
+ *  @return void
+ */
+void QuantizedNetwork::requantize(const Layer& layer, uint32_t count, uint8_t* out, size_t outStride) const {
+	const float inverse = 1.0f / layer.outputScale;
+	const float zero = static_cast<float>(layer.outputZero) + 0.5f;
+	for (uint32_t r = 0; r < count; r++) {
+		const float* row = values.getRow(r);
+		uint8_t* result = out + r * outStride;
+
+		// clamping before the cast lets + 0.5 and truncation round to nearest
+		for (uint32_t o = 0; o < layer.outputs; o++) {
+			const float quantized = min(255.0f, max(0.0f, row[o] * inverse + zero));
+			result[o] = static_cast<uint8_t>(quantized);
+		}
+	}
+}
+
+/**
+ *  @brief computes the logits of a batch of raw images
+ *
+ *  @param pixels the first pixel of the first image
+ *  @param count the number of images
+ *  @param stride the distance in bytes between two images
+ *  @return the count x classes logits (valid until the next forward)
+ */
+const MatrixF& QuantizedNetwork::forward(const uint8_t* pixels, uint32_t count, size_t stride) {
+	const uint8_t* input = pixels;
+	size_t inputStride = stride;
+	for (size_t l = 0; l < layers.size(); l++) {
+		const Layer& layer = layers[l];
+		if (sums.size() < static_cast<size_t>(count) * layer.outputs) {
+			sums.resize(static_cast<size_t>(count) * layer.outputs);
+		}
+		MathUtils::gemmU8S8(count, layer.outputs, layer.inputs, input, inputStride, layer.weights.data(), sums.data(), layer.outputs);
+		dequantize(layer, count);
+		if (l + 1 == layers.size()) {
+			break;
+		}
+
+		const size_t outStride = AlignedMemory::roundUp(layer.outputs);
+		if (activations[l].size() < count * outStride) {
+			activations[l].resize(count * outStride);
+		}
+		requantize(layer, count, activations[l].data(), outStride);
+		input = activations[l].data();
+		inputStride = outStride;
+	}
+	return values;
+}
+
+/**
+ *  @brief classifies a batch of raw images
+ *
+ *  @param pixels the first pixel of the first image
+ *  @param count the number of images
+ *  @param stride the distance in bytes between two images
+ *  @param classes receives the most likely class of every image
+ *  @return void
+ */
+void QuantizedNetwork::predict(const uint8_t* pixels, uint32_t count, size_t stride, uint32_t* classes) {
+	if (count == 0) {
+		return;
+	}
+	MathUtils::argmax(forward(pixels, count, stride), classes);
+}
+
+/**
+ *  @brief measures the accuracy on a dataset
+ *
+ *  @param dataset the labelled images
+ *  @param batchSize the number of images classified at a time
+ *  @return the fraction of images whose predicted class matches the label
+ */
+float QuantizedNetwork::evaluate(const Dataset& dataset, uint32_t batchSize) {
+	if (dataset.empty()) {
+		return 0.0f;
+	}
+	if (dataset.getImageSize() != getInputs()) {
+		throw QuantizationException("The images do not match the input size of the network");
+	}
+	if (!dataset.hasPixels()) {
+		throw QuantizationException("The quantized network reads pixels but the dataset only kept features");
+	}
+
+	batchSize = max<uint32_t>(1, batchSize);
+	predictions.resize(batchSize);
+
+	uint32_t correct = 0;
+	for (uint32_t start = 0; start < dataset.getCount(); start += batchSize) {
+		const DatasetBatch batch = dataset.getBatch(start, batchSize);
+		predict(batch.pixels, batch.count, batch.stride, predictions.data());
+		for (uint32_t r = 0; r < batch.count; r++) {
+			correct += predictions[r] == batch.labels[r] ? 1 : 0;
+		}
+	}
+
+	return static_cast<float>(correct) / dataset.getCount();
+}
+
+/**
+ *  @brief returns the memory taken by the parameters
+ *
+ *  @return the bytes of the int8 weights plus the per output sums, scales and biases
+ */
+size_t QuantizedNetwork::getWeightBytes() const {
+	size_t bytes = 0;
+	for (const Layer& layer : layers) {
+		bytes += layer.weights.size() + layer.outputs * (sizeof(int32_t) + 2 * sizeof(float));
+	}
+	return bytes;
+}
+
+/**
+ *  @brief returns the number of layers
+ *
+ *  @return the layer count
+ */
+uint32_t QuantizedNetwork::getLayerCount() const {
+	return static_cast<uint32_t>(layers.size());
+}
+
+/**
+ *  @brief returns the number of inputs per row
+ *
+ *  @return the input width of the first layer
+ */
+uint32_t QuantizedNetwork::getInputs() const {
+	return layers.front().inputs;
+}
+
+/**
+ *  @brief returns the number of classes
+ *
+ *  @return the output width of the last layer
+ */
+uint32_t QuantizedNetwork::getOutputs() const {
+	return layers.back().outputs;
+}
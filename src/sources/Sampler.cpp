@@ -0,0 +1,623 @@
+/**
+ *  @file    Sampler.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief orders the images of a dataset into epochs
+ *
+ *  @section DESCRIPTION
+ *
+ *  This class groups the image indices of a dataset by label once,
+ *  with a counting sort, and then writes the order of every epoch into
+ *  the same index array. Images are never touched, only their indices,
+ *  and nothing is allocated after construction.
+ *
+ *  An epoch is either a plain shuffle, a stratified shuffle whose every
+ *  window of consecutive indices holds the classes in the proportions
+ *  of the whole dataset, or a class-balanced draw in which the classes
+ *  take turns so every batch holds about as many images of each.
+ *  Each drawn index costs at most one random word in every mode, and
+ *  half of one where the ranges are small.
+ *
+ *  The random numbers come from a Philox stream keyed by the seed and
+ *  counted from the epoch, so an epoch's order depends on the seed and
+ *  the epoch number only, and training can resume at any epoch. The
+ *  common classes of a balanced epoch are drawn from passes with their
+ *  own streams, which are counted from the pass instead.
+ *
+ */
+
+#include "Sampler.h"
+
+#include <algorithm>
+
+// the swaps of a shuffle land anywhere in arrays larger than the caches, so their
+// cache lines are requested a few steps before they are needed
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define SAMPLER_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+#define SAMPLER_PREFETCH(address) ((void)(address))
+#endif
+
+/**
+ *  @brief constructor
+ *
+ *  @param dataset the dataset whose labels are indexed
+ *  @param mode how epochs are ordered
+ *  @param seed the seed of every epoch's order
+ */
+Sampler::Sampler(const Dataset& dataset, SamplingMode mode, uint64_t seed):
+	Sampler(dataset.getLabels(), dataset.getCount(), mode, seed) {
+}
+
+/**
+ *  @brief constructor
+ *
+ *  @param labels the label of every image
+ *  @param count the number of images
+ *  @param mode how epochs are ordered
+ *  @param seed the seed of every epoch's order
+ */
+Sampler::Sampler(const uint8_t* labels, uint32_t count, SamplingMode mode, uint64_t seed):
+	mode(mode),
+	generator(seed) {
+	buildIndex(labels, count);
+
+	// everything shuffle touches is sized here, once (Note: a merge block holds at most
+	// MERGE_BLOCK images plus one or two per class at its edges)
+	permutation.resize(count);
+	cursors.resize(NUM_LABELS);
+	if (mode == SamplingMode::BALANCED) {
+		const uint32_t rounds = max<uint32_t>(1, DRAW_BLOCK / static_cast<uint32_t>(max<size_t>(1, classes.size())));
+		pool.resize(count);
+		openers.resize(rounds);
+		passes.assign(NUM_LABELS, static_cast<uint32_t>(NO_PASS));
+		staged.resize(rounds * classes.size());
+		columns.resize(2 * classes.size());
+	}
+	if (mode == SamplingMode::STRATIFIED) {
+		pool.resize(count);
+		phases.resize(NUM_LABELS);
+		pending.reserve(MERGE_BLOCK + 4 * classes.size());
+		merged.reserve(MERGE_BLOCK + 4 * classes.size());
+		blockCounts.resize(MERGE_BLOCK + 1);
+	}
+
+	shuffle(0);
+}
+
+/**
+ *  @brief groups the image indices by label with a counting sort
+ *
+ *  @param labels the label of every image
+ *  @param count the number of images
+ *  @return void
+ */
+void Sampler::buildIndex(const uint8_t* labels, uint32_t count) {
+	labelStart.assign(NUM_LABELS + 1, 0);
+	for (uint32_t i = 0; i < count; i++) {
+		labelStart[labels[i] + 1]++;
+	}
+	for (uint32_t label = 0; label < NUM_LABELS; label++) {
+		if (labelStart[label + 1] > 0) {
+			classes.push_back(static_cast<uint8_t>(label));
+		}
+		labelStart[label + 1] += labelStart[label];
+	}
+
+	// a second pass drops every index into its label's run, which keeps each run ascending
+	vector<uint32_t> next(labelStart.begin(), labelStart.end() - 1);
+	byLabel.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		byLabel[next[labels[i]]++] = i;
+	}
+}
+
+/**
+ *  @brief restarts the random stream for an epoch
+ *
+ *  @param epoch the epoch about to be written
+ *  @return void
+ */
+void Sampler::restart(uint32_t epoch) {
+	this->epoch = epoch;
+	counter = static_cast<uint64_t>(epoch) << 32;
+	wordsLeft = 0;
+}
+
+/**
+ *  @brief returns the next random word of the epoch
+ *
+ *  @return 32 random bits
+ */
+inline uint32_t Sampler::nextWord(void) {
+	if (wordsLeft == 0) {
+		const size_t length = sizeof(words) / sizeof(words[0]);
+		generator.generate(counter, length / 4, words);
+		counter += length / 4;
+		wordsLeft = static_cast<uint32_t>(length);
+	}
+	return words[sizeof(words) / sizeof(words[0]) - wordsLeft--];
+}
+
+/**
+ *  @brief copies the next random words of the epoch into an array
+ *
+ *  The words left in the buffer come first and whole Philox blocks are
+ *  generated straight into the array, so the stream is the same as count
+ *  calls to nextWord.
+ *
+ *  @param out receives the words
+ *  @param count the number of words
+ *  @return void
+ */
+void Sampler::takeWords(uint32_t* out, uint32_t count) {
+	const uint32_t length = static_cast<uint32_t>(sizeof(words) / sizeof(words[0]));
+	uint32_t i = 0;
+	for (; i < count && wordsLeft > 0; i++) {
+		out[i] = words[length - wordsLeft--];
+	}
+
+	const uint32_t blocks = (count - i) / 4;
+	generator.generate(counter, blocks, out + i);
+	counter += blocks;
+	i += 4 * blocks;
+
+	for (; i < count; i++) {
+		out[i] = nextWord();
+	}
+}
+
+/**
+ *  @brief maps a random word onto a range with a multiply instead of a division
+ *
+ *  @param range the number of possible results
+ *  @return a number in [0, range)
+ */
+inline uint32_t Sampler::nextBounded(uint32_t range) {
+	return static_cast<uint32_t>((static_cast<uint64_t>(nextWord()) * range) >> 32);
+}
+
+/**
+ *  @brief writes random numbers in a small range, several from every word
+ *
+ *  A word is multiplied by the range once per number, each product's
+ *  high half being a number and its low half what is left of the word.
+ *  The word is drawn again when that leftover falls below 2^32 modulo the
+ *  product of the ranges, which makes every number exactly uniform.
+ *
+ *  @param out receives the numbers
+ *  @param count the number of numbers
+ *  @param range the number of possible results (at most 256)
+ *  @return void
+ */
+void Sampler::nextDigits(uint32_t* out, uint32_t count, uint32_t range) {
+	for (uint32_t i = 0; i < count; ) {
+		// as many numbers as keep the product of their ranges within 2^28
+		uint32_t digits = 0;
+		uint32_t product = 1;
+		for (; i + digits < count && digits < 28 && product <= (1u << 28) / range; digits++) {
+			product *= range;
+		}
+
+		for (;;) {
+			uint32_t left = nextWord();
+			for (uint32_t d = 0; d < digits; d++) {
+				const uint64_t m = static_cast<uint64_t>(left) * range;
+				out[i + d] = static_cast<uint32_t>(m >> 32);
+				left = static_cast<uint32_t>(m);
+			}
+			if (left >= product || left >= (0u - product) % product) {
+				break;
+			}
+		}
+		i += digits;
+	}
+}
+
+/**
+ *  @brief writes a uniformly random permutation of an array into another
+ *
+ *  This is the inside-out Fisher-Yates shuffle, which reads the source
+ *  once instead of copying it first. Every step swaps with a random
+ *  earlier slot. The slots of PLAN_BLOCK steps are picked and prefetched
+ *  before the steps are made, so their cache misses overlap instead of
+ *  queuing one behind the other.
+ *
+ *  The first PAIR_RANGE steps pick two slots from one word, as nextDigits
+ *  does, so shuffling a small array takes half the words. Their slots
+ *  stay cached, as do those of any array below PREFETCH_SIZE, and are
+ *  not prefetched.
+ *
+ *  @param source the values to shuffle (nullptr for 0, 1, ..., count - 1)
+ *  @param target receives the permutation (count slots, must not overlap source)
+ *  @param count the number of values
+ *  @return void
+ */
+void Sampler::shuffleInto(const uint32_t* source, uint32_t* target, uint32_t count) {
+	const bool prefetch = count >= PREFETCH_SIZE;
+	uint32_t partners[PLAN_BLOCK];
+	for (uint32_t first = 0; first < count; first += PLAN_BLOCK) {
+		const uint32_t steps = min(PLAN_BLOCK, count - first);
+		if (first + steps < PAIR_RANGE) {
+			// the pairs are spread from the last down, so no word is overwritten before it is used
+			const uint32_t pairs = (steps + 1) / 2;
+			takeWords(partners, pairs);
+			for (uint32_t j = pairs; j-- > 0; ) {
+				const uint32_t range = first + 2 * j + 1;
+				const uint32_t nextRange = 2 * j + 1 < steps ? range + 1 : 1;
+				const uint32_t product = range * nextRange;
+				uint32_t word = partners[j];
+				uint64_t m = static_cast<uint64_t>(word) * range;
+				uint64_t n = static_cast<uint64_t>(static_cast<uint32_t>(m)) * nextRange;
+				while (static_cast<uint32_t>(n) < product && static_cast<uint32_t>(n) < (0u - product) % product) {
+					word = nextWord();
+					m = static_cast<uint64_t>(word) * range;
+					n = static_cast<uint64_t>(static_cast<uint32_t>(m)) * nextRange;
+				}
+				partners[2 * j] = static_cast<uint32_t>(m >> 32);
+				if (2 * j + 1 < steps) {
+					partners[2 * j + 1] = static_cast<uint32_t>(n >> 32);
+				}
+			}
+		} else {
+			takeWords(partners, steps);
+			for (uint32_t t = 0; t < steps; t++) {
+				partners[t] = static_cast<uint32_t>((static_cast<uint64_t>(partners[t]) * (first + t + 1)) >> 32);
+				if (prefetch) {
+					SAMPLER_PREFETCH(target + partners[t]);
+				}
+			}
+		}
+
+		for (uint32_t t = 0; t < steps; t++) {
+			const uint32_t i = first + t;
+			target[i] = target[partners[t]];
+			target[partners[t]] = source ? source[i] : i;
+		}
+	}
+}
+
+/**
+ *  @brief writes every image once in uniformly random order
+ *
+ *  @return void
+ */
+void Sampler::shuffleAll(void) {
+	shuffleInto(nullptr, permutation.data(), static_cast<uint32_t>(permutation.size()));
+}
+
+/**
+ *  @brief writes every image once with every class spread evenly
+ *
+ *  The jth image of a class with n images is placed at (j + u) / n of the
+ *  way through the epoch, u being a random offset per class, and the
+ *  classes are merged in that order. Any run of consecutive indices then
+ *  holds every class in the proportion of the dataset, give or take one.
+ *
+ *  Every image is drawn exactly once, so each label's run is shuffled
+ *  whole up front. The merge then goes MERGE_BLOCK epoch positions at a
+ *  time: the images whose position falls in the block are gathered
+ *  class by class, bucketed by their slot (about one image each) and
+ *  the few that share a slot are put in order, which keeps the cost per
+ *  image constant however many classes there are.
+ *
+ *  @return void
+ */
+void Sampler::shuffleStratified(void) {
+	for (uint8_t label : classes) {
+		const uint32_t high = nextWord();
+		const uint32_t low = nextWord();
+		phases[label] = Philox::toUniform(high, low);
+		cursors[label] = 0;
+	}
+	for (uint8_t label : classes) {
+		const uint32_t start = labelStart[label];
+		shuffleInto(byLabel.data() + start, pool.data() + start, labelStart[label + 1] - start);
+	}
+
+	const uint32_t total = static_cast<uint32_t>(permutation.size());
+	uint32_t* out = permutation.data();
+	for (uint32_t first = 0; first < total; first += MERGE_BLOCK) {
+		// the last block takes everything left, whatever the rounding of the positions
+		const bool last = total - first <= MERGE_BLOCK;
+		const double end = static_cast<double>(first + MERGE_BLOCK) / total;
+
+		fill(blockCounts.begin(), blockCounts.end(), 0);
+		pending.clear();
+		for (uint8_t label : classes) {
+			const uint32_t start = labelStart[label];
+			const uint32_t size = labelStart[label + 1] - start;
+			const double step = 1.0 / size;
+			const double phase = phases[label];
+			uint32_t j = cursors[label];
+			for (; j < size; j++) {
+				MergeEntry image;
+				image.position = (j + phase) * step;
+				if (!last && image.position >= end) {
+					break;
+				}
+
+				// the slot only has to be close, the positions settle the order
+				const double offset = image.position * total - first;
+				image.slot = offset <= 0.0 ? 0 : offset >= MERGE_BLOCK ? MERGE_BLOCK - 1 : static_cast<uint32_t>(offset);
+				image.index = start + j;
+				blockCounts[image.slot + 1]++;
+				pending.push_back(image);
+			}
+			cursors[label] = j;
+		}
+
+		// a counting sort on the slot, then an insertion sort for the images that share one
+		for (uint32_t slot = 0; slot < MERGE_BLOCK; slot++) {
+			blockCounts[slot + 1] += blockCounts[slot];
+		}
+		merged.resize(pending.size());
+		for (const MergeEntry& image : pending) {
+			merged[blockCounts[image.slot]++] = image;
+		}
+		for (size_t i = 1; i < merged.size(); i++) {
+			if (merged[i].position < merged[i - 1].position) {
+				const MergeEntry image = merged[i];
+				size_t k = i;
+				for (; k > 0 && image.position < merged[k - 1].position; k--) {
+					merged[k] = merged[k - 1];
+				}
+				merged[k] = image;
+			}
+		}
+
+		for (const MergeEntry& image : merged) {
+			*out++ = pool[image.index];
+		}
+	}
+}
+
+/**
+ *  @brief writes a pass of a label's run into pool from the pass's own stream
+ *
+ *  The pass is drawn through the epoch's buffer and counter, which are put
+ *  back afterwards (the buffer by generating its words again), so the
+ *  epoch's stream goes on as if the pass had not been drawn.
+ *
+ *  @param label the label whose run is shuffled
+ *  @param pass the pass number (Note: the streams repeat after 2^24 passes)
+ *  @return void
+ */
+void Sampler::shufflePass(uint8_t label, uint32_t pass) {
+	const uint64_t epochCounter = counter;
+	const uint32_t epochWordsLeft = wordsLeft;
+	counter = (static_cast<uint64_t>(pass * NUM_LABELS + label) << 32) | PASS_STREAM;
+	wordsLeft = 0;
+
+	const uint32_t start = labelStart[label];
+	shuffleInto(byLabel.data() + start, pool.data() + start, labelStart[label + 1] - start);
+	passes[label] = pass;
+
+	counter = epochCounter;
+	wordsLeft = epochWordsLeft;
+	if (wordsLeft > 0) {
+		const size_t length = sizeof(words) / sizeof(words[0]);
+		generator.generate(counter - length / 4, length / 4, words);
+	}
+}
+
+/**
+ *  @brief writes as many draws as images with the classes taking turns
+ *
+ *  Every round each class that occurs contributes one image, starting from
+ *  a random class, so a batch of b images holds about b / classes of each.
+ *  A class is drawn by reading its run in pool, which holds a shuffled
+ *  pass of its images, and shuffling the next pass when that one is used
+ *  up. Rare classes (no more images than rounds) cycle through several
+ *  passes per epoch, each shuffled from the epoch's stream. Common ones
+ *  only get through part of a pass, so epoch e carries on at draw
+ *  e * rounds of the class, in passes drawn from their own streams: the
+ *  pass in pool is kept from one epoch to the next, nothing has to be
+ *  reset, and every image of a common class is drawn once before any is
+ *  drawn again.
+ *
+ *  The rounds are written a block at a time: the block's opening classes
+ *  are drawn first, then each class points its column at its draws in the
+ *  block (in pool, or copied into staged if a new pass starts within the
+ *  block), and every round is read across the columns from its opener on,
+ *  so the permutation is written in order.
+ *
+ *  @return void
+ */
+void Sampler::shuffleBalanced(void) {
+	const uint32_t numClasses = static_cast<uint32_t>(classes.size());
+	const uint32_t total = static_cast<uint32_t>(permutation.size());
+	if (total == 0) {
+		return;
+	}
+	const uint32_t rounds = (total + numClasses - 1) / numClasses;
+	const uint32_t blockRounds = static_cast<uint32_t>(openers.size());
+	uint32_t* out = permutation.data();
+
+	for (uint8_t label : classes) {
+		const uint32_t size = labelStart[label + 1] - labelStart[label];
+		if (size > rounds) {
+			const uint64_t first = static_cast<uint64_t>(epoch) * rounds;
+			const uint32_t pass = static_cast<uint32_t>(first / size);
+			if (passes[label] != pass) {
+				shufflePass(label, pass);
+			}
+			cursors[label] = static_cast<uint32_t>(first % size);
+		} else {
+			// a rare class starts a new pass with the epoch's first draw
+			cursors[label] = size;
+		}
+	}
+
+	for (uint32_t firstRound = 0; firstRound < rounds; firstRound += blockRounds) {
+		const uint32_t count = min(blockRounds, rounds - firstRound);
+		nextDigits(openers.data(), count, numClasses);
+
+		// the last round of the epoch only has the turns up to the number of images
+		const bool last = firstRound + count == rounds;
+		const uint32_t lastTurns = total - (rounds - 1) * numClasses;
+		uint32_t* block = out + static_cast<size_t>(firstRound) * numClasses;
+
+		for (uint32_t c = 0; c < numClasses; c++) {
+			const uint8_t label = classes[c];
+			const uint32_t start = labelStart[label];
+			const uint32_t size = labelStart[label + 1] - start;
+			const uint32_t lastOpener = openers[count - 1];
+			const uint32_t lastTurn = c >= lastOpener ? c - lastOpener : c + numClasses - lastOpener;
+			const uint32_t draws = last && lastTurn >= lastTurns ? count - 1 : count;
+			const uint32_t* run = pool.data() + start;
+
+			uint32_t drawn = cursors[label];
+			if (draws <= size - drawn) {
+				// the block's draws are all in the pass, so the rounds read them from pool
+				columns[c] = columns[c + numClasses] = run + drawn;
+				cursors[label] = drawn + draws;
+				continue;
+			}
+			columns[c] = columns[c + numClasses] = staged.data() + c * blockRounds;
+			for (uint32_t r = 0; r < draws; ) {
+				if (drawn == size) {
+					if (size > rounds) {
+						shufflePass(label, passes[label] + 1);
+					} else {
+						shuffleInto(byLabel.data() + start, pool.data() + start, size);
+					}
+					drawn = 0;
+				}
+
+				// the draws up to the end of the pass
+				const uint32_t taken = min(draws - r, size - drawn);
+				copy(run + drawn, run + drawn + taken, staged.data() + c * blockRounds + r);
+				drawn += taken;
+				r += taken;
+			}
+			cursors[label] = drawn;
+		}
+
+		// columns holds every class twice, so a round reads numClasses of them from its opener on
+		const uint32_t turns = total - firstRound * numClasses;
+		const uint32_t full = min(count, turns / numClasses);
+		for (uint32_t r = 0; r < full; r++) {
+			const uint32_t* const* turn = columns.data() + openers[r];
+			for (uint32_t t = 0; t < numClasses; t++) {
+				block[t] = turn[t][r];
+			}
+			block += numClasses;
+		}
+		if (full < count) {
+			const uint32_t* const* turn = columns.data() + openers[full];
+			for (uint32_t t = 0; t < lastTurns; t++) {
+				block[t] = turn[t][full];
+			}
+		}
+	}
+}
+
+/**
+ *  @brief writes the order of an epoch into the permutation
+ *
+ *  @param epoch the epoch number
+ *  @return the permutation (valid until the next call)
+ */
+const vector<uint32_t>& Sampler::shuffle(uint32_t epoch) {
+	restart(epoch);
+	switch (mode) {
+		case SamplingMode::STRATIFIED:
+			shuffleStratified();
+			break;
+		case SamplingMode::BALANCED:
+			shuffleBalanced();
+			break;
+		default:
+			shuffleAll();
+			break;
+	}
+	return permutation;
+}
+
+/**
+ *  @brief writes the order of an epoch into a buffer of the caller's
+ *
+ *  The buffer is swapped in as the permutation while the epoch is written,
+ *  so the order is never copied and the permutation is kept for later.
+ *
+ *  @param epoch the epoch number
+ *  @param order receives the order (resized to the number of images)
+ *  @return void
+ */
+void Sampler::shuffle(uint32_t epoch, vector<uint32_t>& order) {
+	const uint32_t last = this->epoch;
+	order.resize(permutation.size());
+	permutation.swap(order);
+	shuffle(epoch);
+	permutation.swap(order);
+	this->epoch = last;
+}
+
+/**
+ *  @brief returns the order of the last shuffled epoch
+ *
+ *  @return the permutation
+ */
+const vector<uint32_t>& Sampler::getPermutation() const {
+	return permutation;
+}
+
+/**
+ *  @brief returns the epoch the permutation belongs to
+ *
+ *  @return the epoch number
+ */
+uint32_t Sampler::getEpoch() const {
+	return epoch;
+}
+
+/**
+ *  @brief returns the number of indices in an epoch
+ *
+ *  @return the number of images
+ */
+uint32_t Sampler::getEpochSize() const {
+	return static_cast<uint32_t>(permutation.size());
+}
+
+/**
+ *  @brief returns how epochs are ordered
+ *
+ *  @return the sampling mode
+ */
+SamplingMode Sampler::getMode() const {
+	return mode;
+}
+
+/**
+ *  @brief returns the labels that occur
+ *
+ *  @return the labels, ascending
+ */
+const vector<uint8_t>& Sampler::getClasses() const {
+	return classes;
+}
+
+/**
+ *  @brief returns the number of images with a label
+ *
+ *  @param label the label
+ *  @return the count
+ */
+uint32_t Sampler::getLabelCount(uint8_t label) const {
+	return labelStart[label + 1] - labelStart[label];
+}
+
+/**
+ *  @brief returns the images with a label
+ *
+ *  @param label the label
+ *  @return the first of getLabelCount(label) ascending indices
+ */
+const uint32_t* Sampler::getLabelIndices(uint8_t label) const {
+	return byLabel.data() + labelStart[label];
+}
@@ -0,0 +1,273 @@
+/**
+ *  @file    ThreadPool.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/16/2026
+ *  @version 0.0
+ *
+ *  @brief a work stealing thread pool shared by the math and training code
+ *
+ *  @section DESCRIPTION
+ *
+ *  Every worker owns a deque of tasks. A worker pops its own newest
+ *  task first and, when it runs dry, steals the oldest task of
+ *  another deque, so a thread that splits its work keeps the hot half
+ *  and idle threads take the rest. A thread waiting for a parallelFor
+ *  keeps running tasks instead of blocking, which makes nested
+ *  parallel loops (a gemm inside a training shard) safe.
+ *
+ *  Queued tasks are a pointer to the loop plus a slice index and the
+ *  deques are rings that only ever grow, so once they have reached
+ *  their working size a parallelFor does not allocate.
+ *
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+#include <cstdlib>
+
+// the initial room of every deque
+static const size_t INITIAL_QUEUE_SIZE = 64;
+
+/**
+ *  @brief the state shared by the slices of one parallelFor
+ */
+struct ThreadPool::Loop {
+	void (*call)(const void*, uint64_t, uint64_t); // runs the body on a range
+	const void* body; // the body
+	uint64_t count; // the number of items
+	uint32_t slices; // the number of ranges
+	atomic<uint32_t> remaining; // the queued slices that have not finished
+	mutex errorLock; // guards error
+	exception_ptr error; // the first exception a slice threw
+};
+
+// the pool the current thread works for and its index in it (-1 outside workers)
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local int32_t currentIndex = -1;
+
+/**
+ *  @brief constructor
+ *
+ *  @param numWorkers the number of threads to start
+ */
+ThreadPool::ThreadPool(uint32_t numWorkers):
+	pending(0),
+	stopping(false) {
+	for (uint32_t i = 0; i <= numWorkers; i++) {
+		queues.emplace_back(new Queue());
+		queues.back()->ring.resize(INITIAL_QUEUE_SIZE);
+	}
+
+	workers.reserve(numWorkers);
+	for (uint32_t i = 0; i < numWorkers; i++) {
+		workers.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+/**
+ *  @brief destructor
+ */
+ThreadPool::~ThreadPool(void) {
+	{
+		lock_guard<mutex> guard(sleepLock);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (thread& worker : workers) {
+		worker.join();
+	}
+}
+
+/**
+ *  @brief the loop every worker runs until the pool is destroyed
+ *
+ *  @param index the deque owned by this worker
+ *  @return void
+ */
+void ThreadPool::work(uint32_t index) {
+	currentPool = this;
+	currentIndex = static_cast<int32_t>(index);
+
+	while (true) {
+		if (runOne()) {
+			continue;
+		}
+
+		unique_lock<mutex> guard(sleepLock);
+		wake.wait(guard, [this] { return stopping || pending > 0; });
+		if (stopping) {
+			return;
+		}
+	}
+}
+
+/**
+ *  @brief returns the deque the calling thread owns
+ *
+ *  @return a worker's own deque, or the shared one for outside threads
+ */
+uint32_t ThreadPool::getHome(void) const {
+	if (currentPool == this && currentIndex >= 0) {
+		return static_cast<uint32_t>(currentIndex);
+	}
+	return static_cast<uint32_t>(workers.size());
+}
+
+/**
+ *  @brief queues a task
+ *
+ *  @param task the task
+ *  @return void
+ */
+void ThreadPool::push(const Task& task) {
+	Queue& queue = *queues[getHome()];
+	{
+		lock_guard<mutex> guard(queue.lock);
+		const size_t size = queue.ring.size();
+		if (queue.count == size) {
+			// unwrap the ring into storage twice as large
+			vector<Task> grown(2 * size);
+			for (size_t i = 0; i < queue.count; i++) {
+				grown[i] = queue.ring[(queue.head + i) & (size - 1)];
+			}
+			queue.ring.swap(grown);
+			queue.head = 0;
+		}
+		queue.ring[(queue.head + queue.count) & (queue.ring.size() - 1)] = task;
+		queue.count++;
+	}
+	pending++;
+
+	// taking the lock orders the push before any worker's check of pending
+	{
+		lock_guard<mutex> guard(sleepLock);
+	}
+	wake.notify_one();
+}
+
+/**
+ *  @brief runs one queued task
+ *
+ *  @return true if a task was run
+ */
+bool ThreadPool::runOne(void) {
+	const uint32_t home = getHome();
+	const uint32_t count = static_cast<uint32_t>(queues.size());
+	Task task = { nullptr, 0 };
+
+	for (uint32_t offset = 0; offset < count && !task.loop; offset++) {
+		Queue& queue = *queues[(home + offset) % count];
+		lock_guard<mutex> guard(queue.lock);
+		if (queue.count == 0) {
+			continue;
+		}
+
+		// the owner works LIFO on its own deque, thieves take the oldest task
+		const size_t mask = queue.ring.size() - 1;
+		if (offset == 0) {
+			task = queue.ring[(queue.head + queue.count - 1) & mask];
+		}
+		else {
+			task = queue.ring[queue.head];
+			queue.head = (queue.head + 1) & mask;
+		}
+		queue.count--;
+	}
+
+	if (!task.loop) {
+		return false;
+	}
+	pending--;
+	runSlice(*task.loop, task.slice);
+	return true;
+}
+
+/**
+ *  @brief runs one slice of a loop
+ *
+ *  @param loop the loop
+ *  @param slice the index of the slice
+ *  @return void
+ */
+void ThreadPool::runSlice(Loop& loop, uint32_t slice) {
+	try {
+		loop.call(loop.body, loop.count * slice / loop.slices, loop.count * (slice + 1) / loop.slices);
+	}
+	catch (...) {
+		lock_guard<mutex> guard(loop.errorLock);
+		if (!loop.error) {
+			loop.error = current_exception();
+		}
+	}
+	loop.remaining--;
+}
+
+/**
+ *  @brief runs body over contiguous slices of [0, count)
+ *
+ *  @param count the number of items
+ *  @param slices the number of ranges to split the items into
+ *  @param call calls body with the half open range of items of a slice
+ *  @param body the body of the loop
+ *  @return void
+ */
+void ThreadPool::parallelFor(const uint64_t count, uint32_t slices, void (*call)(const void*, uint64_t, uint64_t), const void* body) {
+	slices = static_cast<uint32_t>(max<uint64_t>(1, min<uint64_t>(slices, count)));
+	if (slices == 1) {
+		call(body, 0, count);
+		return;
+	}
+
+	Loop loop;
+	loop.call = call;
+	loop.body = body;
+	loop.count = count;
+	loop.slices = slices;
+	loop.remaining = slices;
+
+	for (uint32_t s = 1; s < slices; s++) {
+		push(Task{ &loop, s });
+	}
+	runSlice(loop, 0);
+
+	// help out instead of blocking so nested loops cannot starve the pool
+	while (loop.remaining > 0) {
+		if (!runOne()) {
+			this_thread::yield();
+		}
+	}
+
+	if (loop.error) {
+		rethrow_exception(loop.error);
+	}
+}
+
+/**
+ *  @brief returns the number of worker threads
+ *
+ *  @return the worker count
+ */
+uint32_t ThreadPool::getWorkerCount() const {
+	return static_cast<uint32_t>(workers.size());
+}
+
+/**
+ *  @brief returns the pool shared by the whole library
+ *
+ *  @return the global pool (created on first use with one thread per hardware
+ *          thread, or as many as the NNF_THREADS environment variable asks for)
+ */
+ThreadPool& ThreadPool::getGlobal(void) {
+	static ThreadPool pool([] {
+		uint32_t threads = thread::hardware_concurrency();
+		const char* requested = getenv(THREADS_VARIABLE);
+		if (requested && atoi(requested) > 0) {
+			threads = static_cast<uint32_t>(atoi(requested));
+		}
+		return max<uint32_t>(1, threads) - 1;
+	}());
+	return pool;
+}
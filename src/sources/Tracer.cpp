@@ -0,0 +1,364 @@
+/**
+ *  @file    Tracer.cpp
+ *  @author  Jonathan Hernandez (jmher019)
+ *  @date    10/17/2026
+ *  @version 0.0
+ *
+ *  @brief scoped timers, counters and histograms for the hot paths
+ *
+ *  @section DESCRIPTION
+ *
+ *  The NNF_TRACE_* macros mark the stages worth timing: parsing, label
+ *  assignment, batch gathering, the forward and backward pass of every
+ *  layer and bmp writing. Every thread records into its own buffer, so
+ *  recording never waits on another thread, and nothing is recorded
+ *  until Tracer::enable(true) is called.
+ *
+ *  The events can be written in the Chrome trace_event format (open
+ *  the file in chrome://tracing or ui.perfetto.dev) and summarized as
+ *  a table of counts, totals and percentiles per stage.
+ *
+ *  The macros only expand to code when NNF_ENABLE_TRACING is defined.
+ *  Without it they compile to nothing, so the markers can stay in the
+ *  sources of a release build at no cost. The ReleaseTraced
+ *  configuration of the project is Release with the define added.
+ *
+ */
+
+#include "Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+
+atomic<bool> Tracer::enabled(false);
+
+/**
+ *  @brief returns every buffer ever created, with the lock that guards the list
+ *
+ *  @param lock receives the lock of the list
+ *  @return the buffers (they outlive their threads so a trace can be written after a join)
+ */
+static vector<unique_ptr<TraceBuffer>>& getBuffers(mutex*& lock) {
+	static mutex registryLock;
+	static vector<unique_ptr<TraceBuffer>> buffers;
+	lock = &registryLock;
+	return buffers;
+}
+
+/**
+ *   @brief  Class constructor
+ *
+ *   @param  message a string that contains a descriptive error
+ */
+TracerException::TracerException(string message) : message(message) {
+}
+
+/**
+ *   @brief  used to extract the error message from the exception
+ *
+ *   @return a const char pointer container the error message
+ */
+const char* TracerException::what() const noexcept {
+	return message.c_str();
+}
+
+/**
+ *  @brief starts timing a scope if tracing is enabled
+ *
+ *  @param name the stage (must be a string literal)
+ */
+Tracer::Scope::Scope(const char* name):
+	name(Tracer::isEnabled() ? name : nullptr),
+	start(this->name ? Tracer::now() : 0) {
+}
+
+/**
+ *  @brief records the scope
+ */
+Tracer::Scope::~Scope(void) {
+	if (name) {
+		Tracer::recordScope(name, start, Tracer::now());
+	}
+}
+
+/**
+ *  @brief returns the buffer of the calling thread
+ *
+ *  @return the buffer, created and registered on the first call from a thread
+ */
+TraceBuffer& Tracer::getLocal(void) {
+	thread_local TraceBuffer* local = nullptr;
+	if (!local) {
+		mutex* lock;
+		vector<unique_ptr<TraceBuffer>>& buffers = getBuffers(lock);
+		lock_guard<mutex> guard(*lock);
+		buffers.emplace_back(new TraceBuffer());
+		local = buffers.back().get();
+		local->threadId = static_cast<uint32_t>(buffers.size());
+		local->events.reserve(4096);
+	}
+	return *local;
+}
+
+/**
+ *  @brief turns recording on or off
+ *
+ *  @param on true to record
+ *  @return void
+ */
+void Tracer::enable(bool on) {
+	now();
+	enabled.store(on, memory_order_relaxed);
+}
+
+/**
+ *  @brief returns the time on the tracer's clock
+ *
+ *  @return the nanoseconds since the first call
+ */
+uint64_t Tracer::now(void) {
+	static const chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+	return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count());
+}
+
+/**
+ *  @brief adds an event to a thread's buffer
+ *
+ *  @param buffer the buffer of the calling thread
+ *  @param event the event
+ *  @return void
+ */
+static void record(TraceBuffer& buffer, const TraceEvent& event) {
+	lock_guard<mutex> guard(buffer.lock);
+	if (buffer.events.size() < Tracer::MAX_EVENTS_PER_THREAD) {
+		buffer.events.push_back(event);
+	}
+	else {
+		buffer.dropped++;
+	}
+}
+
+/**
+ *  @brief records a completed span
+ *
+ *  @param name the stage (must be a string literal)
+ *  @param start when the span began, from now()
+ *  @param end when the span ended, from now()
+ *  @return void
+ */
+void Tracer::recordScope(const char* name, uint64_t start, uint64_t end) {
+	TraceEvent event;
+	event.name = name;
+	event.type = TraceType::SCOPE;
+	event.start = start;
+	event.duration = end - start;
+	record(getLocal(), event);
+}
+
+/**
+ *  @brief records the current value of a counter
+ *
+ *  @param name the counter (must be a string literal)
+ *  @param value the value
+ *  @return void
+ */
+void Tracer::recordCounter(const char* name, double value) {
+	TraceEvent event;
+	event.name = name;
+	event.type = TraceType::COUNTER;
+	event.start = now();
+	event.value = value;
+	record(getLocal(), event);
+}
+
+/**
+ *  @brief records one value of a histogram
+ *
+ *  @param name the histogram (must be a string literal)
+ *  @param value the value
+ *  @return void
+ */
+void Tracer::recordSample(const char* name, double value) {
+	TraceEvent event;
+	event.name = name;
+	event.type = TraceType::SAMPLE;
+	event.start = now();
+	event.value = value;
+	record(getLocal(), event);
+}
+
+/**
+ *  @brief discards every recorded event
+ *
+ *  @return void
+ */
+void Tracer::clear(void) {
+	mutex* lock;
+	vector<unique_ptr<TraceBuffer>>& buffers = getBuffers(lock);
+	lock_guard<mutex> guard(*lock);
+	for (unique_ptr<TraceBuffer>& buffer : buffers) {
+		lock_guard<mutex> bufferGuard(buffer->lock);
+		buffer->events.clear();
+		buffer->dropped = 0;
+	}
+}
+
+/**
+ *  @brief copies the events of every thread
+ *
+ *  @param threadIds receives the id of every thread
+ *  @param dropped receives the number of events lost to full buffers
+ *  @return the events of every thread
+ */
+vector<vector<TraceEvent>> Tracer::collect(vector<uint32_t>& threadIds, uint64_t& dropped) {
+	mutex* lock;
+	vector<unique_ptr<TraceBuffer>>& buffers = getBuffers(lock);
+	lock_guard<mutex> guard(*lock);
+
+	vector<vector<TraceEvent>> events;
+	threadIds.clear();
+	dropped = 0;
+	for (unique_ptr<TraceBuffer>& buffer : buffers) {
+		lock_guard<mutex> bufferGuard(buffer->lock);
+		events.push_back(buffer->events);
+		threadIds.push_back(buffer->threadId);
+		dropped += buffer->dropped;
+	}
+	return events;
+}
+
+/**
+ *  @brief writes the events in the Chrome trace_event format
+ *
+ *  @param filename the path of the JSON file
+ *  @return void
+ */
+void Tracer::writeChromeTrace(string filename) {
+	vector<uint32_t> threadIds;
+	uint64_t dropped;
+	const vector<vector<TraceEvent>> events = collect(threadIds, dropped);
+
+	ofstream file(filename);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	file << fixed << setprecision(3);
+	for (size_t t = 0; t < events.size(); t++) {
+		file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadIds[t]
+			<< ",\"args\":{\"name\":\"thread " << threadIds[t] << "\"}}";
+		first = false;
+
+		// timestamps are in microseconds
+		for (const TraceEvent& event : events[t]) {
+			file << ",\n{\"name\":\"" << event.name << "\",\"pid\":1,\"tid\":" << threadIds[t] << ",\"ts\":" << event.start / 1e3;
+			if (event.type == TraceType::SCOPE) {
+				file << ",\"ph\":\"X\",\"dur\":" << event.duration / 1e3 << "}";
+			}
+			else if (event.type == TraceType::COUNTER) {
+				file << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+			}
+			else {
+				file << ",\"ph\":\"i\",\"s\":\"t\",\"args\":{\"value\":" << event.value << "}}";
+			}
+		}
+	}
+	file << "\n],\"otherData\":{\"dropped\":" << dropped << "}}\n";
+
+	if (!file) {
+		throw TracerException("File: " + filename + " could not be written!");
+	}
+}
+
+/**
+ *  @brief prints a table per event type, the busiest scopes first
+ *
+ *  @param out the stream to print to
+ *  @return void
+ */
+void Tracer::printSummary(ostream& out) {
+	vector<uint32_t> threadIds;
+	uint64_t dropped;
+	const vector<vector<TraceEvent>> events = collect(threadIds, dropped);
+
+	// the same literal may have a different address in every translation unit, so
+	// the events are grouped by text
+	map<string, vector<double>> scopes, samples;
+	map<string, pair<uint64_t, double>> counters;
+	for (const vector<TraceEvent>& thread : events) {
+		for (const TraceEvent& event : thread) {
+			if (event.type == TraceType::SCOPE) {
+				scopes[event.name].push_back(event.duration / 1e3);
+			}
+			else if (event.type == TraceType::SAMPLE) {
+				samples[event.name].push_back(event.value);
+			}
+			else {
+				pair<uint64_t, double>& last = counters[event.name];
+				if (event.start >= last.first) {
+					last = make_pair(event.start, event.value);
+				}
+			}
+		}
+	}
+
+	// nearest rank percentiles of a sorted list
+	const auto percentile = [](const vector<double>& sorted, double fraction) {
+		const size_t rank = static_cast<size_t>(ceil(fraction * sorted.size()));
+		return sorted[max<size_t>(1, rank) - 1];
+	};
+
+	// the caller's formatting is put back afterwards
+	const ios::fmtflags flags = out.flags();
+	const streamsize precision = out.precision();
+	out << fixed << setprecision(1);
+
+	vector<pair<double, string>> order;
+	for (auto& scope : scopes) {
+		sort(scope.second.begin(), scope.second.end());
+		double total = 0.0;
+		for (double duration : scope.second) {
+			total += duration;
+		}
+		order.push_back(make_pair(-total, scope.first));
+	}
+	sort(order.begin(), order.end());
+
+	if (!order.empty()) {
+		out << left << setw(32) << "scope" << right << setw(10) << "count" << setw(12) << "total ms"
+			<< setw(12) << "mean us" << setw(12) << "p50 us" << setw(12) << "p99 us" << setw(12) << "max us" << endl;
+	}
+	for (const pair<double, string>& entry : order) {
+		const vector<double>& durations = scopes[entry.second];
+		out << left << setw(32) << entry.second << right << setw(10) << durations.size() << setw(12) << -entry.first / 1e3
+			<< setw(12) << -entry.first / durations.size() << setw(12) << percentile(durations, 0.5)
+			<< setw(12) << percentile(durations, 0.99) << setw(12) << durations.back() << endl;
+	}
+
+	if (!samples.empty()) {
+		out << left << setw(32) << "histogram" << right << setw(10) << "count" << setw(12) << "mean"
+			<< setw(12) << "p50" << setw(12) << "p99" << setw(12) << "max" << endl;
+	}
+	for (auto& sample : samples) {
+		vector<double>& values = sample.second;
+		sort(values.begin(), values.end());
+		double total = 0.0;
+		for (double value : values) {
+			total += value;
+		}
+		out << left << setw(32) << sample.first << right << setw(10) << values.size() << setw(12) << total / values.size()
+			<< setw(12) << percentile(values, 0.5) << setw(12) << percentile(values, 0.99) << setw(12) << values.back() << endl;
+	}
+
+	for (const auto& counter : counters) {
+		out << left << setw(32) << counter.first << right << " last value " << counter.second.second << endl;
+	}
+	if (dropped > 0) {
+		out << dropped << " events dropped because a thread's buffer was full" << endl;
+	}
+	out.flags(flags);
+	out.precision(precision);
+}
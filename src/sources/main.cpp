@@ -15,23 +15,40 @@
 #include "MNISTParser.h"
 #include "BitMapGenerator.h"
 #include "MathUtils.h"
+#include "Network.h"
+#include "AlignedMemory.h"
+#include "CheckpointWriter.h"
+#include "InferenceEngine.h"
+#include "QuantizedNetwork.h"
+#include "Benchmark.h"
+#include "Tracer.h"
+#include "Kernels.h"
+#include "Expression.h"
+#include "DatasetCache.h"
+#include "Sampler.h"
 
 #include <cstdlib>
 #include <ctime>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+// the directory that holds the MNIST files and receives what the tests write (see main)
+static string dataDirectory("D:\\Dev\\Test\\NeuralNetFun\\testData");
 
 /**
- *  @brief this function will clean up vectors containing pointers of type ImageData
+ *  @brief returns the path of a file in the data directory
  *
- *  @param images the vector object reference
- *  @return void
+ *  @param name the file name
+ *  @return the full path
  */
-void cleanup(vector<ImageData*>& images) {
-	for (size_t i = images.size() - 1; i > -1; i--) {
-		delete images[i];
-		images[i] = nullptr;
+string dataPath(const string& name) {
+	if (dataDirectory.empty() || dataDirectory.back() == '/' || dataDirectory.back() == '\\') {
+		return dataDirectory + name;
 	}
-
-	images.clear();
+	return dataDirectory + "/" + name;
 }
 
 /**
@@ -43,17 +60,18 @@ void cleanup(vector<ImageData*>& images) {
 void testMnistParser() {
 	// First parse the image file
 	cout << "Parsing training images" << endl;
-	vector<ImageData*> images = MNISTParser::parseImageFile(
-		string("D:\\Dev\\Test\\NeuralNetFun\\testData\\train-images.idx3-ubyte")
+	Dataset images;
+	MNISTParser::parseImageFile(
+		images, dataPath("train-images.idx3-ubyte")
 	);
 	cout << "Parsed training images" << endl;
 
-	// if the vector is empty then the parsing was a success
+	// if the dataset is empty then the parsing failed
 	if (!images.empty()) {
 		// parse the label file
 		cout << "Parsing label file" << endl;
 		MNISTParser::parseLabelFile(
-			images, string("D:\\Dev\\Test\\NeuralNetFun\\testData\\train-labels.idx1-ubyte")
+			images, dataPath("train-labels.idx1-ubyte")
 		);
 		cout << "Paresed label file" << endl;
 
@@ -61,21 +79,81 @@ void testMnistParser() {
 		// if you don't initialize the random seed with something new
 		// you will get the exact same index every time
 		srand(static_cast<uint32_t>(time(0)));
-		int randomIndex = rand() % images.size();
+		uint32_t randomIndex = rand() % images.getCount();
 
 		// now write the randomly selected image as a bmp file
 		cout << "Picking an image at random and generating a bmp" << endl;
 		BitMapGenerator::generate(
-			images[randomIndex], string("D:\\Dev\\Test\\NeuralNetFun\\testData\\test-image.bmp")
+			images.getImage(randomIndex), dataPath("test-image.bmp")
 		);
 		cout << "Image generated" << endl;
 	}
 	else {
 		cout << "Parse failed" << endl;
 	}
+}
+
+/**
+ *  @brief this function exports a slice of the training set as separate
+ *         bmps and as one mosaic, and reports the throughput
+ *
+ *  @return void
+ */
+void testBitMapExport() {
+	Dataset train;
+	MNISTParser::parseImageFile(train, dataPath("train-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(train, dataPath("train-labels.idx1-ubyte"));
+	if (train.empty()) {
+		cout << "Bmp export test skipped, MNIST files not found" << endl;
+		return;
+	}
+
+	vector<uint32_t> indices(min<uint32_t>(1000, train.getCount()));
+	for (uint32_t i = 0; i < indices.size(); i++) {
+		indices[i] = i;
+	}
+
+	try {
+		auto start = chrono::steady_clock::now();
+		const uint32_t written = BitMapGenerator::exportImages(train, indices, dataPath("bmp"), "train");
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << "exported " << written << " bmps at " << written / seconds << " images/s" << endl;
+
+		start = chrono::steady_clock::now();
+		BitMapGenerator::generateMosaic(train, indices, 40, dataPath("test-mosaic.bmp"));
+		cout << "mosaic of " << indices.size() << " images in "
+			<< chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e3 << " ms" << endl;
+
+		// the same image in memory as 24 bit BGR and as 8 bit indexed
+		vector<uint8_t> bgr, indexed;
+		BitMapGenerator::encode(train.getImage(0), bgr);
+		BitMapGenerator::encode(train.getImage(0), indexed, BitMapFormat::INDEXED);
+		cout << "one image encodes to " << bgr.size() << " bytes as BGR and " << indexed.size() << " bytes indexed" << endl;
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+	}
+}
 
-	cout << "Cleaning Up" << endl;
-	cleanup(images);
+/**
+ *  @brief this function tests mapping image and label files from the
+ *         MNIST Database without copying them onto the heap
+ *
+ *  @return void
+ */
+void testMappedMnistParser() {
+	try {
+		cout << "Mapping training images" << endl;
+		MappedFile imageFile(dataPath("train-images.idx3-ubyte"));
+		MappedFile labelFile(dataPath("train-labels.idx1-ubyte"));
+
+		vector<ImageData> images = MNISTParser::mapImageFile(imageFile);
+		MNISTParser::mapLabelFile(images, labelFile);
+		cout << "Mapped " << images.size() << " training images" << endl;
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+	}
 }
 
 void testMathUtils() {
@@ -83,23 +161,917 @@ void testMathUtils() {
 	const uint32_t rows = 100000;
 	const uint32_t cols = 1;
 	const uint32_t length = rows * cols;
-	double* mat = MathUtils::randn(rows, cols);
+	Arena arena;
+	double* mat = MathUtils::randn(arena, rows, cols);
 
-	ofstream out("D:\\Dev\\Test\\NeuralNetFun\\testData\\test-randn.csv", std::ofstream::out);
+	ofstream out(dataPath("test-randn.csv"), std::ofstream::out);
 
 	for (uint32_t index = 0; index < length; index++) {
 		out << mat[index] << endl;
 	}
 
-	delete mat;
+	// the arena owns the samples, resetting it frees them all at once
+	arena.reset();
 	mat = nullptr;
 
+	// the same seed has to give the same bits no matter how many threads fill it
+	cout << "Testing randn reproducibility..." << endl;
+	Matrix single(1000, 1000), parallel(1000, 1000);
+	MathUtils::setNumThreads(1);
+	auto start = chrono::steady_clock::now();
+	MathUtils::randn(single, 42);
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	MathUtils::setNumThreads(8);
+	MathUtils::randn(parallel, 42);
+	MathUtils::setNumThreads(0);
+
+	const bool identical = memcmp(single.getData(), parallel.getData(), single.getSize() * sizeof(double)) == 0;
+	const double mean = MathUtils::sum(single.getData(), static_cast<uint32_t>(single.getSize())) / single.getSize();
+	const double norm = MathUtils::norm(single.getData(), static_cast<uint32_t>(single.getSize()));
+	cout << "randn 1000x1000 in " << seconds * 1e3 << " ms, identical across threads: "
+		<< (identical ? "yes" : "no") << ", mean " << mean
+		<< ", variance " << norm * norm / single.getSize() - mean * mean << endl;
+
 	// TODO: add more tests
 }
 
-int main() {
+/**
+ *  @brief this function checks the BLAS-1 kernels against a plain loop and
+ *         prints their throughput
+ *
+ *  @return void
+ */
+void testBlasKernels() {
+	const uint32_t sizes[] = { 784, 1 << 16, 1 << 20 };
+
+	for (uint32_t length : sizes) {
+		double* vec1 = MathUtils::randn(length, 1);
+		double* vec2 = MathUtils::randn(length, 1);
+
+		// the reference is the plain single accumulator loop
+		double expectedDot = 0.0, expectedSum = 0.0;
+		for (uint32_t index = 0; index < length; index++) {
+			expectedDot += vec1[index] * vec2[index];
+			expectedSum += vec1[index];
+		}
+
+		const double dotError = std::abs(MathUtils::dot(vec1, vec2, length) - expectedDot);
+		const double sumError = std::abs(MathUtils::sum(vec1, length) - expectedSum);
+		cout << "length " << length << ": dot error " << dotError << ", sum error " << sumError << endl;
+
+		// time both versions over roughly the same amount of work
+		const uint32_t repeats = max<uint32_t>(1, (1 << 26) / length);
+		volatile double sink = 0.0;
+
+		auto start = chrono::steady_clock::now();
+		for (uint32_t r = 0; r < repeats; r++) {
+			double sum = 0.0;
+			for (uint32_t index = 0; index < length; index++) {
+				sum += vec1[index] * vec2[index];
+			}
+			sink = sum;
+		}
+		const double loopSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		start = chrono::steady_clock::now();
+		for (uint32_t r = 0; r < repeats; r++) {
+			sink = MathUtils::dot(vec1, vec2, length);
+		}
+		const double dotSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		start = chrono::steady_clock::now();
+		for (uint32_t r = 0; r < repeats; r++) {
+			MathUtils::axpy(1e-9, vec1, vec2, length);
+		}
+		const double axpySeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		const double flops = 2.0 * length * repeats;
+		cout << "  loop " << flops / loopSeconds * 1e-9 << " GFLOP/s, dot "
+			<< flops / dotSeconds * 1e-9 << " GFLOP/s, axpy "
+			<< flops / axpySeconds * 1e-9 << " GFLOP/s" << endl;
+		(void)sink;
+
+		delete[] vec1;
+		delete[] vec2;
+	}
+}
+
+/**
+ *  @brief this function checks gemm against a naive triple loop and prints
+ *         its throughput on a dense layer sized product
+ *
+ *  @return void
+ */
+void testGemm() {
+	// batch x 784 inputs times 784 x hidden weights
+	const uint32_t batch = 256, inputs = 784, hidden = 128;
+	Matrix x(batch, inputs), w(hidden, inputs), y;
+	for (size_t index = 0; index < x.getSize(); index++) {
+		x.getData()[index] = static_cast<double>(index % 255) / 255.0;
+	}
+	for (size_t index = 0; index < w.getSize(); index++) {
+		w.getData()[index] = static_cast<double>(index % 17) - 8.0;
+	}
+
+	// y = x * w^T is how a dense layer stores its weights
+	MathUtils::gemm(x, false, w, true, y);
+
+	double error = 0.0;
+	for (uint32_t i = 0; i < batch; i += 37) {
+		for (uint32_t j = 0; j < hidden; j++) {
+			const double expected = MathUtils::dot(x.getRow(i), w.getRow(j), inputs);
+			error = max(error, std::abs(y(i, j) - expected));
+		}
+	}
+	cout << "gemm max error " << error << endl;
+
+	const uint32_t repeats = 50;
+	auto start = chrono::steady_clock::now();
+	for (uint32_t r = 0; r < repeats; r++) {
+		MathUtils::gemm(x, false, w, true, y);
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "gemm " << batch << "x" << inputs << "x" << hidden << ": "
+		<< 2.0 * batch * inputs * hidden * repeats / seconds * 1e-9 << " GFLOP/s on "
+		<< MathUtils::getNumThreads() << " threads" << endl;
+}
+
+/**
+ *  @brief this function compares the double, float and bfloat16 gemm paths
+ *         on the shape of a dense layer
+ *
+ *  @return void
+ */
+void testPrecisions() {
+	const uint32_t batch = 256, inputs = 784, hidden = 128, repeats = 50;
+	Matrix x(batch, inputs), w(hidden, inputs), y;
+	MathUtils::randn(x, 11);
+	MathUtils::randn(w, 12);
+	MathUtils::gemm(x, false, w, true, y);
+
+	MatrixF xf, wf, yf;
+	MatrixBF16 xb, wb;
+	MathUtils::convert(x, xf);
+	MathUtils::convert(w, wf);
+	MathUtils::convert(xf, xb);
+	MathUtils::convert(wf, wb);
+
+	// times repeats calls of run and prints the rate, the operand bytes and the error against y
+	auto report = [&](const char* name, size_t bytes, const function<void(void)>& run) {
+		const auto start = chrono::steady_clock::now();
+		for (uint32_t r = 0; r < repeats; r++) {
+			run();
+		}
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		double error = 0.0;
+		for (size_t index = 0; index < y.getSize(); index++) {
+			error = max(error, std::abs(y.getData()[index] - yf.getData()[index]) / (1.0 + std::abs(y.getData()[index])));
+		}
+		cout << "  " << name << ": " << 2.0 * batch * inputs * hidden * repeats / seconds * 1e-9 << " GFLOP/s, "
+			<< bytes / 1024 << " KiB of operands, max relative error " << error << endl;
+	};
+
+	cout << "gemm " << batch << "x" << inputs << "x" << hidden << " by precision" << endl;
+	report("double", x.getBytes() + w.getBytes(), [&] {
+		Matrix result;
+		MathUtils::gemm(x, false, w, true, result);
+		MathUtils::convert(result, yf);
+	});
+	report("float", xf.getBytes() + wf.getBytes(), [&] { MathUtils::gemm(xf, false, wf, true, yf); });
+	report("bfloat16", xb.getBytes() + wb.getBytes(), [&] { MathUtils::gemm(xb, false, wb, true, yf); });
+}
+
+/**
+ *  @brief this function trains a 784-128-10 network on the MNIST training set
+ *         and reports the epoch time and the test accuracy
+ *
+ *  @return void
+ */
+void testNetwork() {
+	Dataset train, test;
+	MNISTParser::parseImageFile(train, dataPath("train-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(train, dataPath("train-labels.idx1-ubyte"));
+	MNISTParser::parseImageFile(test, dataPath("t10k-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(test, dataPath("t10k-labels.idx1-ubyte"));
+	if (train.empty() || test.empty()) {
+		cout << "Network test skipped, MNIST files not found" << endl;
+		return;
+	}
+
+	Network network({ static_cast<uint32_t>(train.getImageSize()), 128, 10 }, Activation::RELU, 1);
+	BatchLoader loader(train, 64, 2, 1, 1);
+	cout << "accuracy before training " << network.evaluate(test) << endl;
+
+	for (uint32_t epoch = 0; epoch < 3; epoch++) {
+		const auto start = chrono::steady_clock::now();
+		const float loss = network.trainEpoch(loader, 0.05f);
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << "epoch " << epoch << ": loss " << loss << ", " << seconds << " s, test accuracy "
+			<< network.evaluate(test) << endl;
+	}
+}
+
+/**
+ *  @brief this function trains the same network with one shard and with one
+ *         shard per thread, and checks that the sharded weights do not depend
+ *         on how the shards were scheduled
+ *
+ *  @return void
+ */
+void testDataParallel() {
+	Dataset train;
+	MNISTParser::parseImageFile(train, dataPath("train-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(train, dataPath("train-labels.idx1-ubyte"));
+	if (train.empty()) {
+		cout << "Data parallel test skipped, MNIST files not found" << endl;
+		return;
+	}
+
+	const uint32_t threads = MathUtils::getNumThreads();
+	vector<float> firstWeights;
+	for (uint32_t shards : { 1u, threads, threads }) {
+		Network network({ static_cast<uint32_t>(train.getImageSize()), 128, 10 }, Activation::RELU, 1);
+		network.setShards(shards);
+		BatchLoader loader(train, 256, 2, 1, 1);
+
+		const auto start = chrono::steady_clock::now();
+		const float loss = network.trainEpoch(loader, 0.1f);
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << shards << " shard(s) on " << threads << " thread(s): loss " << loss << ", "
+			<< train.getCount() / seconds << " images/s" << endl;
+
+		// a second run with the same shard count has to reproduce the weights bit for bit
+		const MatrixF& weights = network.getLayer(0).getWeights();
+		vector<float> current(weights.getData(), weights.getData() + weights.getSize());
+		if (shards == threads && !firstWeights.empty()) {
+			cout << (current == firstWeights ? "sharded training is reproducible" : "sharded training is NOT reproducible") << endl;
+		}
+		if (shards == threads) {
+			firstWeights = current;
+		}
+	}
+}
+
+/**
+ *  @brief this function warms up a training loop with uneven batch sizes and
+ *         then counts the buffers a steady state step allocates (should be 0)
+ *
+ *  @return void
+ */
+void testSteadyStateAllocations() {
+	const uint32_t inputs = 784, rows = 256;
+	MatrixF batch(rows, inputs);
+	MathUtils::randn(batch, 3);
+	vector<uint8_t> labels(rows);
+	for (uint32_t r = 0; r < rows; r++) {
+		labels[r] = static_cast<uint8_t>(r % 10);
+	}
+
+	Network network({ inputs, 128, 10 }, Activation::RELU, 1);
+	network.setShards(MathUtils::getNumThreads());
+	Arena arena;
+
+	// a full batch followed by the short last batch of an epoch, as a training loop sees them
+	auto step = [&] {
+		for (uint32_t count : { rows, rows / 3 }) {
+			float* scratch = arena.allocate<float>(static_cast<size_t>(count) * inputs);
+			copy(batch.getData(), batch.getData() + static_cast<size_t>(count) * inputs, scratch);
+			network.trainBatch(scratch, labels.data(), count, inputs, 0.01f);
+			arena.reset();
+		}
+	};
+
+	step();
+	const uint64_t before = AlignedMemory::getAllocationCount();
+	for (uint32_t i = 0; i < 10; i++) {
+		step();
+	}
+	cout << "allocations in 10 steady state steps: " << AlignedMemory::getAllocationCount() - before
+		<< " (arena capacity " << arena.getCapacity() / 1024 << " KiB)" << endl;
+}
+
+/**
+ *  @brief this function compares loading raw pixels and converting them
+ *         afterwards with loading straight into normalized features
+ *
+ *  @return void
+ */
+void testNormalizedLoad() {
+	const string name(dataPath("train-images.idx3-ubyte"));
+	const Normalization normalization = Normalization::standard(Normalization::MNIST_MEAN, Normalization::MNIST_DEVIATION);
+
+	auto start = chrono::steady_clock::now();
+	Dataset separate;
+	MNISTParser::parseImageFile(separate, name);
+	separate.normalize(normalization, false);
+	const double separateSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	Dataset fused;
+	MNISTParser::parseImageFile(fused, name, normalization);
+	const double fusedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if (fused.empty()) {
+		cout << "Normalized load test skipped, MNIST files not found" << endl;
+		return;
+	}
+
+	const size_t bytes = static_cast<size_t>(fused.getCount()) * fused.getFeatureStride() * sizeof(float);
+	const bool identical = memcmp(separate.getFeatures(0), fused.getFeatures(0), bytes) == 0;
+	cout << "load then normalize " << separateSeconds * 1e3 << " ms, fused load " << fusedSeconds * 1e3
+		<< " ms, " << bytes / (1024 * 1024) << " MiB of features, identical: " << (identical ? "yes" : "no") << endl;
+}
+
+/**
+ *  @brief this function compares parsing the gzip MNIST files with loading
+ *         them through the dataset cache, and checks that a damaged cache
+ *         is rejected
+ *
+ *  @return void
+ */
+void testDatasetCache() {
+	const string imageName(dataPath("train-images-idx3-ubyte.gz"));
+	const string labelName(dataPath("train-labels-idx1-ubyte.gz"));
+	const string cacheName(dataPath("train.nnfcache"));
+	const Normalization normalization = Normalization::standard(Normalization::MNIST_MEAN, Normalization::MNIST_DEVIATION);
+
+	auto start = chrono::steady_clock::now();
+	Dataset parsed;
+	MNISTParser::parseImageFile(parsed, imageName, normalization, DatasetStorage::BOTH);
+	MNISTParser::parseLabelFile(parsed, labelName);
+	const double parseSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if (parsed.empty()) {
+		cout << "Dataset cache test skipped, MNIST .gz files not found" << endl;
+		return;
+	}
+
+	// the first load parses and writes the cache, the second one only maps it
+	remove(cacheName.c_str());
+	start = chrono::steady_clock::now();
+	Dataset first;
+	DatasetCache::load(first, imageName, labelName, cacheName, DatasetStorage::BOTH, normalization);
+	const double firstSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	Dataset mapped;
+	DatasetCache::load(mapped, imageName, labelName, cacheName, DatasetStorage::BOTH, normalization, false);
+	const double mappedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	Dataset verified;
+	DatasetCache::load(verified, imageName, labelName, cacheName, DatasetStorage::BOTH, normalization);
+	const double verifiedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	const size_t count = parsed.getCount();
+	const bool identical = mapped.isMapped() && mapped.getCount() == parsed.getCount() &&
+		memcmp(mapped.getPixels(0), parsed.getPixels(0), count * parsed.getStride()) == 0 &&
+		memcmp(mapped.getFeatures(0), parsed.getFeatures(0), count * parsed.getFeatureStride() * sizeof(float)) == 0 &&
+		memcmp(mapped.getLabels(), parsed.getLabels(), count) == 0;
+	cout << "gzip parse " << parseSeconds * 1e3 << " ms, first load (parse and write the cache) " << firstSeconds * 1e3
+		<< " ms, mapped load " << mappedSeconds * 1e3 << " ms (" << verifiedSeconds * 1e3 << " ms checksummed), identical: "
+		<< (identical ? "yes" : "no") << endl;
+
+	// flip one label and the checksum has to notice
+	mapped = Dataset();
+	verified = Dataset();
+	{
+		fstream file(cacheName.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
+		char label = 0;
+		file.seekg(DatasetCache::ALIGNMENT);
+		file.get(label);
+		file.seekp(DatasetCache::ALIGNMENT);
+		file.put(label ^ 1);
+	}
+	try {
+		Dataset damaged;
+		DatasetCache::open(damaged, cacheName);
+		cout << "a damaged cache was accepted" << endl;
+	}
+	catch (const DatasetCacheException& e) {
+		cout << "damaged cache rejected: " << e.what() << endl;
+	}
+	remove(cacheName.c_str());
+}
+
+/**
+ *  @brief this function times the three sampling modes on skewed labels
+ *         and checks the class mix of their batches and that a seed and an
+ *         epoch always give the same order
+ *
+ *  @return void
+ */
+void testSampler() {
+	// a million labels where every class is half as common as the one before, down to 1 in 1024
+	const uint32_t count = 1 << 20;
+	const uint32_t batchSize = 100;
+	vector<uint8_t> labels(count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint8_t label = 0;
+		while (label < 9 && ((i * 2654435761u) >> (31 - label)) & 1) {
+			label++;
+		}
+		labels[i] = label;
+	}
+
+	const SamplingMode modes[3] = { SamplingMode::SHUFFLE, SamplingMode::STRATIFIED, SamplingMode::BALANCED };
+	const char* names[3] = { "shuffle", "stratified", "balanced" };
+	for (uint32_t m = 0; m < 3; m++) {
+		Sampler sampler(labels.data(), count, modes[m], 7);
+		const auto start = chrono::steady_clock::now();
+		for (uint32_t epoch = 1; epoch <= 10; epoch++) {
+			sampler.shuffle(epoch);
+		}
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / 10;
+
+		// the fewest and most images of the rarest class in any batch
+		const vector<uint32_t>& permutation = sampler.getPermutation();
+		const uint8_t rarest = sampler.getClasses().back();
+		uint32_t fewest = batchSize, most = 0;
+		for (uint32_t b = 0; b + batchSize <= count; b += batchSize) {
+			uint32_t found = 0;
+			for (uint32_t i = b; i < b + batchSize; i++) {
+				found += labels[permutation[i]] == rarest;
+			}
+			fewest = min(fewest, found);
+			most = max(most, found);
+		}
+
+		Sampler replay(labels.data(), count, modes[m], 7);
+		const bool reproducible = replay.shuffle(10) == permutation;
+		cout << names[m] << ": " << seconds * 1e3 << " ms per epoch, class " << static_cast<int>(rarest) << " ("
+			<< sampler.getLabelCount(rarest) << " images) appears " << fewest << " to " << most << " times per batch of "
+			<< batchSize << ", reproducible: " << (reproducible ? "yes" : "no") << endl;
+	}
+}
+
+/**
+ *  @brief this function checks the vectorized exponential against std::exp,
+ *         times both, and checks the batched softmax head
+ *
+ *  @return void
+ */
+void testSoftmaxKernels() {
+	const uint32_t length = 1 << 20;
+	Matrix inputs(1, length), outputs(1, length);
+	for (uint32_t index = 0; index < length; index++) {
+		inputs(0, index) = -700.0 + 1400.0 * index / length;
+	}
+
+	auto start = chrono::steady_clock::now();
+	outputs = inputs;
+	MathUtils::exp(outputs.getData(), length);
+	const double expSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	double worst = 0.0;
+	for (uint32_t index = 0; index < length; index++) {
+		const double expected = std::exp(inputs(0, index));
+		worst = max(worst, std::abs(outputs(0, index) - expected) / expected);
+	}
+	const double stdSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "exp max relative error " << worst << ", " << length / expSeconds * 1e-6
+		<< " M/s vs std::exp " << length / stdSeconds * 1e-6 << " M/s" << endl;
+
+	// a batch of logits whose softmax rows have to add up to one
+	Matrix logits(256, 10), gradient;
+	MathUtils::randn(logits, 7);
+	vector<uint8_t> labels(logits.getRows());
+	vector<uint32_t> predictions(logits.getRows());
+	for (uint32_t r = 0; r < logits.getRows(); r++) {
+		labels[r] = static_cast<uint8_t>(r % 10);
+	}
+
+	const double loss = MathUtils::crossEntropy(logits, labels.data(), gradient);
+	MathUtils::argmax(logits, predictions.data());
+	MathUtils::softmax(logits);
+
+	double rowError = 0.0;
+	for (uint32_t r = 0; r < logits.getRows(); r++) {
+		rowError = max(rowError, std::abs(MathUtils::sum(logits.getRow(r), logits.getCols()) - 1.0));
+	}
+	cout << "cross entropy " << loss << ", softmax row sum error " << rowError
+		<< ", first prediction " << predictions[0] << endl;
+}
+
+/**
+ *  @brief this function saves a network on the background writer, keeps
+ *         changing it while the file is written, and checks that a network
+ *         loaded from the mapped checkpoint has the weights of the snapshot
+ *
+ *  @return void
+ */
+void testCheckpoint() {
+	Network network({ 784, 128, 10 }, Activation::RELU, 1);
+	const MatrixF& weights = network.getLayer(0).getWeights();
+	const vector<float> snapshot(weights.getData(), weights.getData() + weights.getSize());
+
+	CheckpointWriter writer;
+	const auto start = chrono::steady_clock::now();
+	writer.save(network.getTensors(), 1, "network.nnfc");
+	const double queued = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+	// training goes on while the file is written
+	network.getLayer(0).getWeights().getData()[0] += 1.0f;
+
+	try {
+		writer.wait();
+		Checkpoint checkpoint("network.nnfc");
+		Network loaded({ 784, 128, 10 }, Activation::RELU, 2);
+		loaded.load(checkpoint);
+
+		const MatrixF& loadedWeights = loaded.getLayer(0).getWeights();
+		const bool same = equal(snapshot.begin(), snapshot.end(), loadedWeights.getData());
+		cout << "checkpoint queued in " << queued << " us, version " << checkpoint.getVersion() << ", step "
+			<< checkpoint.getStep() << ", " << checkpoint.getTensorCount() << " tensors, checksum "
+			<< (checkpoint.verify() ? "ok" : "BAD") << endl;
+		cout << (same ? "checkpoint holds the snapshot" : "checkpoint does NOT hold the snapshot") << endl;
+	}
+	catch (const CheckpointException& e) {
+		cout << e.what() << endl;
+	}
+}
+
+/**
+ *  @brief this function classifies random images one forward pass at a time,
+ *         then has several client threads send the same images through an
+ *         InferenceEngine, and reports the latency and throughput of both
+ *
+ *  @return void
+ */
+void testInferenceEngine() {
+	const uint32_t imageSize = 784, imageCount = 4096, clients = 4, window = 32;
+	Network network({ imageSize, 128, 10 }, Activation::RELU, 1);
+
+	vector<uint8_t> images(imageSize * imageCount);
+	srand(1);
+	for (uint8_t& pixel : images) {
+		pixel = static_cast<uint8_t>(rand() % 256);
+	}
+
+	// one image per forward pass
+	vector<uint32_t> expected(imageCount);
+	vector<float> features(imageSize);
+	auto start = chrono::steady_clock::now();
+	for (uint32_t i = 0; i < imageCount; i++) {
+		MathUtils::normalize(images.data() + i * imageSize, features.data(), imageSize, 1.0f / 255.0f);
+		network.predict(features.data(), 1, imageSize, &expected[i]);
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "unbatched: " << imageCount / seconds << " images/s" << endl;
+
+	// every client keeps a window of requests in flight and checks the answers
+	InferenceEngine engine(network, 64, chrono::microseconds(500));
+	atomic<uint32_t> mismatches(0);
+	start = chrono::steady_clock::now();
+	vector<thread> threads;
+	for (uint32_t c = 0; c < clients; c++) {
+		threads.emplace_back([&, c] {
+			vector<future<uint32_t>> results;
+			for (uint32_t first = c * window; first < imageCount; first += clients * window) {
+				const uint32_t last = min(first + window, imageCount);
+				results.clear();
+				for (uint32_t i = first; i < last; i++) {
+					results.push_back(engine.submit(images.data() + i * imageSize));
+				}
+				for (uint32_t i = first; i < last; i++) {
+					if (results[i - first].get() != expected[i]) {
+						mismatches++;
+					}
+				}
+			}
+		});
+	}
+	for (thread& client : threads) {
+		client.join();
+	}
+	seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	const InferenceStats stats = engine.getStats();
+	cout << "batched: " << imageCount / seconds << " images/s, " << stats.batches << " batches of "
+		<< stats.meanBatchSize << " on average, latency p50 " << stats.p50 << " us, p99 " << stats.p99
+		<< " us, " << mismatches << " mismatches" << endl;
+}
+
+/**
+ *  @brief this function trains a network, quantizes it to int8 and reports the
+ *         accuracy and speed of both on the test images
+ *
+ *  @return void
+ */
+void testQuantizedInference() {
+	Dataset train, test;
+	MNISTParser::parseImageFile(train, dataPath("train-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(train, dataPath("train-labels.idx1-ubyte"));
+	MNISTParser::parseImageFile(test, dataPath("t10k-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(test, dataPath("t10k-labels.idx1-ubyte"));
+	if (train.empty() || test.empty()) {
+		cout << "Quantized inference test skipped, MNIST files not found" << endl;
+		return;
+	}
+
+	Network network({ static_cast<uint32_t>(train.getImageSize()), 128, 10 }, Activation::RELU, 1);
+	BatchLoader loader(train, 64, 2, 1, 1);
+	network.trainEpoch(loader, 0.05f);
+	QuantizedNetwork quantized(network, train);
+
+	const uint32_t repeats = 5;
+	auto start = chrono::steady_clock::now();
+	float accuracy = 0.0f;
+	for (uint32_t i = 0; i < repeats; i++) {
+		accuracy = network.evaluate(test);
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	const MatrixF& weights = network.getLayer(0).getWeights();
+	cout << "float: accuracy " << accuracy << ", " << repeats * test.getCount() / seconds << " images/s, first layer "
+		<< weights.getSize() * sizeof(float) << " bytes" << endl;
+
+	start = chrono::steady_clock::now();
+	for (uint32_t i = 0; i < repeats; i++) {
+		accuracy = quantized.evaluate(test);
+	}
+	seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "int8: accuracy " << accuracy << ", " << repeats * test.getCount() / seconds << " images/s, all layers "
+		<< quantized.getWeightBytes() << " bytes" << endl;
+}
+
+/**
+ *  @brief this function trains on augmented batches, reports whether the
+ *         workers keep up with training and writes a mosaic of variants
+ *
+ *  @return void
+ */
+void testAugmentation() {
+	Dataset train, test;
+	MNISTParser::parseImageFile(train, dataPath("train-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(train, dataPath("train-labels.idx1-ubyte"));
+	MNISTParser::parseImageFile(test, dataPath("t10k-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(test, dataPath("t10k-labels.idx1-ubyte"));
+	if (train.empty() || test.empty()) {
+		cout << "Augmentation test skipped, MNIST files not found" << endl;
+		return;
+	}
+
+	const Augmenter augmenter(train.getWidth(), train.getHeight(), AugmentationParams(), 1);
+	const uint32_t workers = max<uint32_t>(1, thread::hardware_concurrency() / 2);
+
+	// one variant costs about as much as gathering the image, so the workers should stay ahead
+	Network network({ static_cast<uint32_t>(train.getImageSize()), 128, 10 }, Activation::RELU, 1);
+	BatchLoader loader(train, 64, 4, workers, 1, &augmenter);
+	for (uint32_t epoch = 0; epoch < 3; epoch++) {
+		const auto start = chrono::steady_clock::now();
+		const float loss = network.trainEpoch(loader, 0.05f);
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << "augmented epoch " << epoch << ": loss " << loss << ", " << seconds << " s, waited "
+			<< loader.getWaitSeconds() << " s in total, test accuracy " << network.evaluate(test) << endl;
+	}
+
+	// 8 variants of the first 8 images, one image per row
+	const uint32_t size = static_cast<uint32_t>(train.getImageSize());
+	vector<float> source(size), variant(size);
+	vector<vector<uint8_t>> pixels;
+	for (uint32_t i = 0; i < 8; i++) {
+		MathUtils::normalize(train.getPixels(i), source.data(), size, 1.0f);
+		for (uint32_t key = 0; key < 8; key++) {
+			augmenter.apply(source.data(), variant.data(), 0.0f, i * 8 + key);
+			pixels.emplace_back(size);
+			for (uint32_t p = 0; p < size; p++) {
+				pixels.back()[p] = static_cast<uint8_t>(min(255.0f, max(0.0f, variant[p] + 0.5f)));
+			}
+		}
+	}
+	vector<ImageData> images;
+	for (vector<uint8_t>& image : pixels) {
+		images.emplace_back(image.data(), train.getWidth(), size, 0);
+	}
+
+	try {
+		BitMapGenerator::generateMosaic(images, 8, dataPath("augmented-mosaic.bmp"));
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+	}
+}
+
+/**
+ *  @brief this function traces parsing, an epoch of training, an epoch drained
+ *         from a loader and a bmp, then prints the summary and writes a Chrome trace
+ *
+ *  @return void
+ */
+void testTracing() {
+#ifdef NNF_ENABLE_TRACING
+	Tracer::clear();
+	Tracer::enable(true);
+
+	Dataset train;
+	MNISTParser::parseImageFile(train, dataPath("train-images.idx3-ubyte"));
+	MNISTParser::parseLabelFile(train, dataPath("train-labels.idx1-ubyte"));
+	if (train.empty()) {
+		Tracer::enable(false);
+		cout << "Tracing test skipped, MNIST files not found" << endl;
+		return;
+	}
+
+	{
+		Network network({ static_cast<uint32_t>(train.getImageSize()), 128, 10 }, Activation::RELU, 1);
+		BatchLoader loader(train, 64, 2, 2, 1);
+		network.trainEpoch(loader, 0.05f);
+	}
+	{
+		// an epoch drained without training outruns a single worker, so next() blocks and
+		// the wait histogram gets samples
+		BatchLoader loader(train, 64, 2, 1, 2);
+		for (uint32_t i = 0; i < loader.getBatchesPerEpoch(); i++) {
+			loader.next();
+		}
+	}
+	try {
+		BitMapGenerator::generate(train.getImage(0), dataPath("trace-image.bmp"));
+		Tracer::enable(false);
+		Tracer::printSummary(cout);
+		Tracer::writeChromeTrace(dataPath("trace.json"));
+	}
+	catch (const exception& e) {
+		Tracer::enable(false);
+		cout << e.what() << endl;
+	}
+#else
+	cout << "Tracing test skipped, NNF_ENABLE_TRACING is not defined" << endl;
+#endif
+}
+
+/**
+ *  @brief this function checks fused expressions against the kernels they
+ *         replace and times a fused chain against one that materializes
+ *         every step
+ *
+ *  @return void
+ */
+void testExpressions() {
+	const uint32_t rows = 256, cols = 1000;
+	MatrixF a(rows, cols), b(rows, cols), c(rows, cols);
+	MathUtils::randn(a, 1);
+	MathUtils::randn(b, 2);
+	MathUtils::randn(c, 3);
+
+	// y = sigmoid(a * b + c) in one pass, and step by step through the kernels
+	MatrixF fused = sigmoid(a * b + c);
+	MatrixF stepwise(c);
+	for (size_t index = 0; index < stepwise.getSize(); index++) {
+		stepwise.getData()[index] += a.getData()[index] * b.getData()[index];
+	}
+	MathUtils::sigmoid(stepwise.getData(), static_cast<uint32_t>(stepwise.getSize()));
+
+	float sigmoidError = 0.0f;
+	for (size_t index = 0; index < fused.getSize(); index++) {
+		sigmoidError = max(sigmoidError, std::abs(fused.getData()[index] - stepwise.getData()[index]));
+	}
+
+	// w -= lr * g against axpy
+	MatrixF w(a), expected(a);
+	w -= 0.01f * b;
+	MathUtils::axpy(-0.01f, b.getData(), expected.getData(), static_cast<uint32_t>(expected.getSize()));
+	float updateError = 0.0f;
+	for (size_t index = 0; index < w.getSize(); index++) {
+		updateError = max(updateError, std::abs(w.getData()[index] - expected.getData()[index]));
+	}
+	cout << "sigmoid(a * b + c) max error " << sigmoidError << ", w -= lr * g max error " << updateError << endl;
+
+	try {
+		MatrixF wrong(rows, cols + 1);
+		w += wrong;
+		cout << "mismatched shapes were not detected!" << endl;
+	}
+	catch (const ExpressionException& e) {
+		cout << "mismatched shapes rejected: " << e.what() << endl;
+	}
+
+	// the sigmoid gradient chain, with a temporary per step and fused
+	const uint32_t repeats = 200;
+	MatrixF delta(rows, cols), temporary(rows, cols);
+	auto start = chrono::steady_clock::now();
+	for (uint32_t r = 0; r < repeats; r++) {
+		temporary = 1.0f - a;
+		temporary *= a;
+		delta = b * temporary;
+	}
+	const double materializedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	for (uint32_t r = 0; r < repeats; r++) {
+		delta = b * a * (1.0f - a);
+	}
+	const double fusedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	// the three passes move 8 arrays, the fused one moves 3
+	const double bytes = static_cast<double>(a.getBytes()) * repeats;
+	cout << "b * a * (1 - a): materialized " << 8.0 * bytes / materializedSeconds * 1e-9 << " GB/s ("
+		<< materializedSeconds * 1e3 << " ms), fused " << 3.0 * bytes / fusedSeconds * 1e-9 << " GB/s ("
+		<< fusedSeconds * 1e3 << " ms)" << endl;
+}
+
+/**
+ *  @brief this function checks every kernel level the host supports against
+ *         the plain C++ one and times a dot product on each
+ *
+ *  @return void
+ */
+void testKernelDispatch() {
+	cout << "selected kernels: " << Kernels::getName(Kernels::getIsa())
+		<< " (host supports " << Kernels::getName(Kernels::detect()) << ")" << endl;
+	if (!Kernels::verify(cout)) {
+		cout << "kernel levels disagree!" << endl;
+	}
+
+	const uint32_t length = 1 << 16;
+	vector<float> vec1(length), vec2(length);
+	for (uint32_t index = 0; index < length; index++) {
+		vec1[index] = static_cast<float>(index % 7) - 3.0f;
+		vec2[index] = static_cast<float>(index % 5) * 0.25f;
+	}
+
+	const Isa levels[] = { Isa::SCALAR, Isa::AVX2, Isa::AVX512, Isa::AVX512VNNI };
+	for (Isa level : levels) {
+		const KernelTable* table = Kernels::getTable(level);
+		if (!table) {
+			continue;
+		}
+
+		const uint32_t repeats = 2000;
+		volatile float sink = 0.0f;
+		const auto start = chrono::steady_clock::now();
+		for (uint32_t r = 0; r < repeats; r++) {
+			sink = table->f32.dot(vec1.data(), vec2.data(), length);
+		}
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << "  " << Kernels::getName(level) << " dot " << 2.0 * length * repeats / seconds * 1e-9 << " GFLOP/s" << endl;
+		(void)sink;
+	}
+}
+
+/**
+ *  @brief this function runs the benchmark suite, prints the results and
+ *         writes them as JSON
+ *
+ *  @param directory where the synthetic files are written
+ *  @param filename the JSON file
+ *  @return 0 on success
+ */
+int runBenchmarks(string directory, string filename) {
+	try {
+		Benchmark benchmark(directory);
+		benchmark.runAll();
+		benchmark.print(cout);
+		benchmark.writeJson(filename);
+		cout << "results written to " << filename << endl;
+	}
+	catch (const exception& e) {
+		cout << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
+
+// usage: NeuralNetFun [data directory] | --benchmark [directory] [results.json]
+// (the data directory can also come from NNF_DATA_DIR)
+int main(int argc, char* argv[]) {
+	if (argc > 1 && string(argv[1]) == "--benchmark") {
+		return runBenchmarks(argc > 2 ? argv[2] : ".", argc > 3 ? argv[3] : "benchmark.json");
+	}
+
+	// every test that needs the MNIST files reads them from here and skips itself without them
+	const char* environment = getenv("NNF_DATA_DIR");
+	if (argc > 1) {
+		dataDirectory = argv[1];
+	}
+	else if (environment && *environment) {
+		dataDirectory = environment;
+	}
+	cout << "data directory: " << dataDirectory << endl;
+
 	testMnistParser();
+	testMappedMnistParser();
+	testNormalizedLoad();
+	testDatasetCache();
+	testBitMapExport();
+	testSampler();
 	testMathUtils();
+	testBlasKernels();
+	testGemm();
+	testSoftmaxKernels();
+	testPrecisions();
+	testNetwork();
+	testDataParallel();
+	testSteadyStateAllocations();
+	testCheckpoint();
+	testInferenceEngine();
+	testQuantizedInference();
+	testAugmentation();
+	testTracing();
+	testKernelDispatch();
+	testExpressions();
+#ifdef _WIN32
 	system("pause");
+#endif
 	return 0;
 }
\ No newline at end of file